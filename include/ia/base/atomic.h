@@ -163,7 +163,7 @@
         ia_atomic_model_seq_cst   = memory_order_seq_cst,
     } ia_atomic_model;
 
-    #define IA_ATOMIC(T) _Atomic T
+    #define IA_ATOMIC(T) _Atomic(T)
 
     #define ia_atomic_init              atomic_init
     #define ia_atomic_thread_fence      atomic_thread_fence
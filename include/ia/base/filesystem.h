@@ -1,6 +1,10 @@
 #pragma once
 /** @file ia/base/filesystem.h
- *  @brief TODO docs
+ *  @brief Unbuffered file access.
+ *
+ *  Files are read with explicit offsets (pread), there is no shared file position, so many
+ *  reads to the same file may be in flight at once from different fibers. No buffering is done
+ *  here, the caller decides where data lands, to avoid an extra copy on the way to its destination.
  */
 #include <ia/base/types.h>
 
@@ -8,7 +12,48 @@
 extern "C" {
 #endif /* __cplusplus */
 
-// TODO
+/** Defines a system file handle. */
+typedef struct { i64 handle; } ia_file;
+
+/** How the file is accessed. */
+typedef enum ia_file_mode : i8 {
+    ia_file_mode_read = 0,  /**< Opens an existing file for reading. */
+    ia_file_mode_write,     /**< Creates or truncates a file for writing. */
+} ia_file_mode;
+
+/** Opens a file at the given path.
+ *  @return `true` on success, otherwise the handle is not written to. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_file_open(
+    char const     *path,
+    ia_file_mode    mode,
+    ia_file        *out_file);
+
+/** Closes a file handle. */
+IA_API void IA_CALL
+ia_file_close(ia_file file);
+
+/** @return Size of the file in bytes, or a negative value on failure. */
+IA_API i64 IA_CALL
+ia_file_size(ia_file file);
+
+/** Reads up to `size` bytes at the file `offset`. Retries partial reads.
+ *  @return Number of bytes read, less than `size` only at the end of file, or a negative value on failure. */
+IA_NONNULL(2) IA_API isize IA_CALL
+ia_file_read(
+    ia_file         file,
+    void           *dst,
+    isize           size,
+    i64             offset);
+
+/** Writes `size` bytes at the file `offset`. Retries partial writes.
+ *  @return Number of bytes written, or a negative value on failure. */
+IA_NONNULL(2) IA_API isize IA_CALL
+ia_file_write(
+    ia_file         file,
+    void const     *src,
+    isize           size,
+    i64             offset);
 
 #ifdef __cplusplus
 }
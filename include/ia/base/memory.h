@@ -22,8 +22,12 @@ IA_HOT_FN IA_API void IA_CALL ia_drift_unshift(void);
 #define ia_drift_alloc_nil(nil, size, align) \
     ia_drift_alloc(size, align)
 
+/** Drift memory is never freed explicitly. */
+#define ia_drift_free_nil(nil, ptr, size) \
+    ((void)(nil), (void)(ptr), (void)(size))
+
 /** Used in macro expansions for allocate/deallocate pairs. */
-#define ia_drift_allocator      ia_drift_alloc_nil, (void)
+#define ia_drift_allocator      ia_drift_alloc_nil, ia_drift_free_nil
 #define ia_drift_allocator_init nullptr
 
 #ifdef __cplusplus
@@ -94,13 +94,158 @@ ia_hugepage_size_from_bytes(usize bytes)
 IA_API ia_hugepage_sizes IA_CALL
 ia_hugetlbinfo(usize *out_total_ram);
 
-/** Queries system info about the CPU. TODO read CPU flags */
+/** Queries system info about the CPU, the instruction set extensions are read by `ia_cpufeatures`. */
 IA_API void IA_CALL
 ia_cpuinfo(
-    i32 *out_thread_count, 
+    i32 *out_thread_count,
     i32 *out_core_count,
     i32 *out_package_count);
 
+/** Instruction set extensions of the host CPU, x86 in the low half, ARM, RISC-V and wasm in the high half.
+ *  A feature is only reported if the operating system also preserves its register state. */
+typedef u64 ia_cpu_features;
+typedef enum ia_cpu_feature_bits : ia_cpu_features {
+    ia_cpu_feature_none                 = 0,
+    ia_cpu_feature_x86_sse2             = (1ull << 0),
+    ia_cpu_feature_x86_sse3             = (1ull << 1),
+    ia_cpu_feature_x86_ssse3            = (1ull << 2),
+    ia_cpu_feature_x86_sse4_1           = (1ull << 3),
+    ia_cpu_feature_x86_sse4_2           = (1ull << 4),
+    ia_cpu_feature_x86_popcnt           = (1ull << 5),
+    ia_cpu_feature_x86_aes              = (1ull << 6),
+    ia_cpu_feature_x86_pclmul           = (1ull << 7),
+    ia_cpu_feature_x86_avx              = (1ull << 8),
+    ia_cpu_feature_x86_f16c             = (1ull << 9),
+    ia_cpu_feature_x86_fma              = (1ull << 10),
+    ia_cpu_feature_x86_avx2             = (1ull << 11),
+    ia_cpu_feature_x86_bmi              = (1ull << 12),
+    ia_cpu_feature_x86_bmi2             = (1ull << 13),
+    ia_cpu_feature_x86_lzcnt            = (1ull << 14),
+    ia_cpu_feature_x86_avx512f          = (1ull << 15),
+    ia_cpu_feature_x86_avx512cd         = (1ull << 16),
+    ia_cpu_feature_x86_avx512dq         = (1ull << 17),
+    ia_cpu_feature_x86_avx512bw         = (1ull << 18),
+    ia_cpu_feature_x86_avx512vl         = (1ull << 19),
+    ia_cpu_feature_arm_neon             = (1ull << 32),
+    ia_cpu_feature_arm_fma              = (1ull << 33),
+    ia_cpu_feature_arm_neon_fp16        = (1ull << 34),
+    ia_cpu_feature_arm_dotprod          = (1ull << 35),
+    ia_cpu_feature_arm_aes              = (1ull << 36),
+    ia_cpu_feature_arm_crc32            = (1ull << 37),
+    ia_cpu_feature_arm_sve              = (1ull << 38),
+    ia_cpu_feature_riscv_v              = (1ull << 48),
+    ia_cpu_feature_wasm_simd128         = (1ull << 56),
+    ia_cpu_feature_wasm_relaxed_simd    = (1ull << 57),
+} ia_cpu_feature_bits;
+
+/** Features the code was compiled for, the host is guaranteed to have all of them. */
+IA_FORCE_INLINE ia_cpu_features
+ia_cpu_features_baseline(void)
+{
+    ia_cpu_features features = ia_cpu_feature_none;
+#ifdef IA_ARCH_X86_SSE2
+    features |= ia_cpu_feature_x86_sse2;
+#endif
+#ifdef IA_ARCH_X86_SSE3
+    features |= ia_cpu_feature_x86_sse3;
+#endif
+#ifdef IA_ARCH_X86_SSSE3
+    features |= ia_cpu_feature_x86_ssse3;
+#endif
+#ifdef IA_ARCH_X86_SSE4_1
+    features |= ia_cpu_feature_x86_sse4_1;
+#endif
+#ifdef IA_ARCH_X86_SSE4_2
+    features |= ia_cpu_feature_x86_sse4_2;
+#endif
+#ifdef __POPCNT__
+    features |= ia_cpu_feature_x86_popcnt;
+#endif
+#ifdef IA_ARCH_X86_AES
+    features |= ia_cpu_feature_x86_aes;
+#endif
+#ifdef IA_ARCH_X86_PCLMUL
+    features |= ia_cpu_feature_x86_pclmul;
+#endif
+#ifdef IA_ARCH_X86_AVX
+    features |= ia_cpu_feature_x86_avx;
+#endif
+#ifdef IA_ARCH_X86_F16C
+    features |= ia_cpu_feature_x86_f16c;
+#endif
+#ifdef IA_ARCH_X86_FMA
+    features |= ia_cpu_feature_x86_fma;
+#endif
+#ifdef IA_ARCH_X86_AVX2
+    features |= ia_cpu_feature_x86_avx2;
+#endif
+#ifdef IA_ARCH_X86_BMI
+    features |= ia_cpu_feature_x86_bmi;
+#endif
+#ifdef IA_ARCH_X86_BMI2
+    features |= ia_cpu_feature_x86_bmi2;
+#endif
+#ifdef __LZCNT__
+    features |= ia_cpu_feature_x86_lzcnt;
+#endif
+#ifdef IA_ARCH_X86_AVX512F
+    features |= ia_cpu_feature_x86_avx512f;
+#endif
+#ifdef IA_ARCH_X86_AVX512CD
+    features |= ia_cpu_feature_x86_avx512cd;
+#endif
+#ifdef IA_ARCH_X86_AVX512DQ
+    features |= ia_cpu_feature_x86_avx512dq;
+#endif
+#ifdef IA_ARCH_X86_AVX512BW
+    features |= ia_cpu_feature_x86_avx512bw;
+#endif
+#ifdef IA_ARCH_X86_AVX512VL
+    features |= ia_cpu_feature_x86_avx512vl;
+#endif
+#ifdef IA_ARCH_ARM_NEON
+    features |= ia_cpu_feature_arm_neon;
+#endif
+#if defined(IA_ARCH_ARM_FMA) || defined(IA_ARCH_AARCH64)
+    features |= ia_cpu_feature_arm_fma;
+#endif
+#ifdef IA_ARCH_ARM_NEON_FP16
+    features |= ia_cpu_feature_arm_neon_fp16;
+#endif
+#ifdef IA_ARCH_ARM_DOTPROD
+    features |= ia_cpu_feature_arm_dotprod;
+#endif
+#ifdef IA_ARCH_ARM_AES
+    features |= ia_cpu_feature_arm_aes;
+#endif
+#ifdef IA_ARCH_ARM_CRC32
+    features |= ia_cpu_feature_arm_crc32;
+#endif
+#ifdef IA_ARCH_ARM_SVE
+    features |= ia_cpu_feature_arm_sve;
+#endif
+#ifdef IA_ARCH_RISCV_V
+    features |= ia_cpu_feature_riscv_v;
+#endif
+#ifdef IA_ARCH_WASM_SIMD128
+    features |= ia_cpu_feature_wasm_simd128;
+#endif
+#ifdef IA_ARCH_WASM_RELAXED_SIMD
+    features |= ia_cpu_feature_wasm_relaxed_simd;
+#endif
+    return features;
+}
+
+/** True if every feature of `required` is in `features`. */
+IA_FORCE_INLINE bool
+ia_cpu_features_has(ia_cpu_features features, ia_cpu_features required)
+{ return (features & required) == required; }
+
+/** Queries the instruction set extensions of the host CPU, the baseline is always included.
+ *  The result is read once per runtime, it's safe to call from hot paths. */
+IA_API ia_cpu_features IA_CALL
+ia_cpufeatures(void);
+
 /** TODO docs */
 IA_API void *IA_CALL
 ia_mmap(void);
@@ -310,7 +310,7 @@ template<class T> class _IncludeInsideExternCNotPortable;
 #if !defined(IA_FORCE_INLINE) && !defined(IA_FORCE_NOINLINE)
     #if defined(IA_CC_CLANG_VERSION) || defined(IA_CC_GNUC_VERSION)
         #define IA_FORCE_INLINE static __attribute__((always_inline)) inline
-        #define IA_FORCE_NOINLINE __attribute__(noinline)
+        #define IA_FORCE_NOINLINE __attribute__((noinline))
     #elif defined(IA_CC_MSVC_VERSION)
         #define IA_FORCE_INLINE __forceinline
         #define IA_FORCE_NOINLINE __declspec(noinline)
@@ -615,6 +615,13 @@ template<class T> class _IncludeInsideExternCNotPortable;
 #if (defined(__F16C__) || IA_CC_MSVC_VERSION_CHECK(19,30,0)) && defined(IA_ARCH_X86_AVX2)
     #define IA_ARCH_X86_F16C 1
 #endif
+#if defined(__BMI__)
+    #define IA_ARCH_X86_BMI 1
+#endif
+#if defined(__BMI2__)
+    #define IA_ARCH_X86_BMI2 1
+    #include <immintrin.h>
+#endif
 #if defined(__AES__)
     #define IA_ARCH_X86_AES 1
 #endif
@@ -672,9 +679,13 @@ template<class T> class _IncludeInsideExternCNotPortable;
 #if defined(__ARM_NEON) || defined(IA_ARCH_AARCH64)
     #if defined(IA_ARCH_AARCH64)
         #define IA_ARCH_ARM_NEON IA_ARCH_AARCH64
-        #include <arm64_neon.h>
     #elif defined(IA_ARCH_ARM)
         #define IA_ARCH_ARM_NEON IA_ARCH_ARM
+    #endif
+    /* only MSVC names the header differently for arm64 */
+    #if defined(IA_CC_MSVC_VERSION) && !defined(__clang__) && defined(IA_ARCH_AARCH64)
+        #include <arm64_neon.h>
+    #else
         #include <arm_neon.h>
     #endif
 #endif
@@ -762,6 +773,7 @@ template<class T> class _IncludeInsideExternCNotPortable;
 #endif
 #if defined(__riscv_v)
     #define IA_ARCH_RISCV_V 1
+    #include <riscv_vector.h>
 #endif
 #if defined(__riscv_zvfh)
     #define IA_ARCH_RISCV_ZVFH 1
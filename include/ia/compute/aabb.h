@@ -0,0 +1,163 @@
+#pragma once
+/** @file ia/compute/aabb.h
+ *  @brief Axis-aligned bounding boxes.
+ *
+ *  A box is stored either as its corners `ia_aabb` (min and max), the cheapest form to merge and
+ *  intersect, or as `ia_aabb_centered` (center and half of the size), the form plane tests and
+ *  transforms want. An empty box has min above max, `ia_aabb_empty` sets it to (+inf, -inf) so that
+ *  merging anything into it gives the other box.
+ *
+ *  A transformed box is the box around the transformed corners. Instead of transforming eight
+ *  corners, the center is transformed as a point and the extent by the absolute values of the 3x3
+ *  part, the result is the same.
+ *
+ *  [Transforming Axis-Aligned Bounding Boxes, Graphics Gems]
+ *  https://github.com/erich666/GraphicsGems/blob/master/gems/TransBox.c
+ *
+ *  Min and max are comparisons, not `fminf` and `fmaxf`, those are libm calls in builders that merge
+ *  boxes millions of times.
+ *
+ *  Culling tests thousands of boxes per frame, `ia_aabb_soa` keeps the centers and extents in
+ *  separate arrays, so a SIMD register holds one coordinate of 4 or 8 boxes. The kernels that
+ *  read it are in `ia/compute/camera.h`.
+ */
+#include <ia/base/types.h>
+#include <ia/compute/vector.h>
+
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct ia_aabb {
+    f32x3   min;
+    f32x3   max;
+} ia_aabb;
+
+typedef struct ia_aabb_centered {
+    f32x3   center;
+    f32x3   extent;     /**< Half of the size, non-negative. */
+} ia_aabb_centered;
+
+/** Boxes in structure-of-arrays, centers and extents. */
+typedef struct ia_aabb_soa {
+    f32    *center_x, *center_y, *center_z;
+    f32    *extent_x, *extent_y, *extent_z;
+} ia_aabb_soa;
+
+IA_FORCE_INLINE void ia_aabb_empty(ia_aabb *dest)
+{
+    dest->min[0] = dest->min[1] = dest->min[2] = INFINITY;
+    dest->max[0] = dest->max[1] = dest->max[2] = -INFINITY;
+}
+
+IA_FORCE_INLINE bool ia_aabb_is_empty(ia_aabb const *a)
+{ return a->min[0] > a->max[0] || a->min[1] > a->max[1] || a->min[2] > a->max[2]; }
+
+IA_FORCE_INLINE void ia_aabb_to_centered(ia_aabb const *a, ia_aabb_centered *dest)
+{
+    for (i32 i = 0; i < 3; i++) {
+        f32 lo = a->min[i], hi = a->max[i];
+        dest->center[i] = (lo + hi) * 0.5f;
+        dest->extent[i] = (hi - lo) * 0.5f;
+    }
+}
+
+IA_FORCE_INLINE void ia_aabb_from_centered(ia_aabb_centered const *a, ia_aabb *dest)
+{
+    for (i32 i = 0; i < 3; i++) {
+        f32 c = a->center[i], e = a->extent[i];
+        dest->min[i] = c - e;
+        dest->max[i] = c + e;
+    }
+}
+
+/** dest = box around both boxes */
+IA_FORCE_INLINE void ia_aabb_merge(ia_aabb const *a, ia_aabb const *b, ia_aabb *dest)
+{
+    for (i32 i = 0; i < 3; i++) {
+        dest->min[i] = ia_min(a->min[i], b->min[i]);
+        dest->max[i] = ia_max(a->max[i], b->max[i]);
+    }
+}
+
+/** dest = box around the box and the point */
+IA_FORCE_INLINE void ia_aabb_merge_point(ia_aabb const *a, f32x3 const p, ia_aabb *dest)
+{
+    for (i32 i = 0; i < 3; i++) {
+        dest->min[i] = ia_min(a->min[i], p[i]);
+        dest->max[i] = ia_max(a->max[i], p[i]);
+    }
+}
+
+/** dest = common part of the boxes
+ *  @return `false` if the boxes don't overlap, `dest` is empty then. */
+IA_FORCE_INLINE bool ia_aabb_intersect(ia_aabb const *a, ia_aabb const *b, ia_aabb *dest)
+{
+    for (i32 i = 0; i < 3; i++) {
+        dest->min[i] = ia_max(a->min[i], b->min[i]);
+        dest->max[i] = ia_min(a->max[i], b->max[i]);
+    }
+    return !ia_aabb_is_empty(dest);
+}
+
+/** Boxes that only touch overlap. */
+IA_FORCE_INLINE bool ia_aabb_overlaps(ia_aabb const *a, ia_aabb const *b)
+{
+    return a->min[0] <= b->max[0] && b->min[0] <= a->max[0]
+        && a->min[1] <= b->max[1] && b->min[1] <= a->max[1]
+        && a->min[2] <= b->max[2] && b->min[2] <= a->max[2];
+}
+
+IA_FORCE_INLINE bool ia_aabb_contains_point(ia_aabb const *a, f32x3 const p)
+{
+    return a->min[0] <= p[0] && p[0] <= a->max[0]
+        && a->min[1] <= p[1] && p[1] <= a->max[1]
+        && a->min[2] <= p[2] && p[2] <= a->max[2];
+}
+
+IA_FORCE_INLINE f32 ia_aabb_surface_area(ia_aabb const *a)
+{
+    f32 x = a->max[0] - a->min[0], y = a->max[1] - a->min[1], z = a->max[2] - a->min[2];
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+/* Box around the corners transformed by the columns of a 3x3 part and a translation. */
+IA_FORCE_INLINE void ia_aabb_transform_(
+    f32 const *c0, f32 const *c1, f32 const *c2, f32 const *t,
+    ia_aabb const *a, ia_aabb *dest)
+{
+    ia_aabb_centered b, r;
+    ia_aabb_to_centered(a, &b);
+    for (i32 i = 0; i < 3; i++) {
+        r.center[i] = c0[i] * b.center[0] + c1[i] * b.center[1] + c2[i] * b.center[2] + t[i];
+        r.extent[i] = fabsf(c0[i]) * b.extent[0] + fabsf(c1[i]) * b.extent[1] + fabsf(c2[i]) * b.extent[2];
+    }
+    ia_aabb_from_centered(&r, dest);
+}
+
+/** dest = box around the corners of `a` transformed by an affine transform */
+IA_FORCE_INLINE void ia_aabb_transform(ia_aabb const *a, f32m4x3 const m, ia_aabb *dest)
+{ ia_aabb_transform_(m[0], m[1], m[2], m[3], a, dest); }
+
+/** dest = box around the corners of `a` transformed by a matrix, whose last row must be (0, 0, 0, 1) */
+IA_FORCE_INLINE void ia_aabb_transform_mat4(ia_aabb const *a, f32m4x4 const m, ia_aabb *dest)
+{ ia_aabb_transform_(m[0], m[1], m[2], m[3], a, dest); }
+
+/** Writes a box into element `i` of the arrays. */
+IA_FORCE_INLINE void ia_aabb_soa_write(ia_aabb_soa const *soa, isize i, ia_aabb const *a)
+{
+    ia_aabb_centered b;
+    ia_aabb_to_centered(a, &b);
+    soa->center_x[i] = b.center[0];
+    soa->center_y[i] = b.center[1];
+    soa->center_z[i] = b.center[2];
+    soa->extent_x[i] = b.extent[0];
+    soa->extent_y[i] = b.extent[1];
+    soa->extent_z[i] = b.extent[2];
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
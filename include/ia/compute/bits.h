@@ -1,10 +1,13 @@
 #pragma once
 /** @file ia/compute/bits.h
- *  @brief TODO docs
- * 
- *  TODO docs
+ *  @brief Bit manipulation intrinsics.
+ *
+ *  Wraps compiler builtins for counting and scanning bits, with portable fallbacks. Results for a zero
+ *  input are defined: counts of leading or trailing zeroes return the bit width. Byte swaps are defined
+ *  in `ia/base/endian.h` as `ia_bswap16`, `ia_bswap32` and `ia_bswap64`, included here for convenience.
  */
 #include <ia/base/types.h>
+#include <ia/base/endian.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,7 +18,7 @@ IA_FORCE_INLINE IA_PURE_FN
 i32 ia_ctz(u32 x)
 {
 #if IA_HAS_BUILTIN(__builtin_ctz)
-    return __builtin_ctz(x);
+    return x ? __builtin_ctz(x) : 32;
 #elif defined(IA_CC_MSVC_VERSION)
     u32 index;
     return _BitScanForward(&index, x) ? index : 32;
@@ -31,6 +34,104 @@ i32 ia_ctz(u32 x)
 #endif
 }
 
+/** Count trailing zeroes of a 64-bit integer. */
+IA_FORCE_INLINE IA_PURE_FN
+i32 ia_ctz64(u64 x)
+{
+#if IA_HAS_BUILTIN(__builtin_ctzll)
+    return x ? __builtin_ctzll(x) : 64;
+#elif defined(IA_CC_MSVC_VERSION) && defined(IA_ARCH_AMD64)
+    u32 index;
+    return _BitScanForward64(&index, x) ? index : 64;
+#else
+    u32 lo = (u32)x;
+    return lo ? ia_ctz(lo) : 32 + ia_ctz((u32)(x >> 32));
+#endif
+}
+
+/** Count leading zeroes. */
+IA_FORCE_INLINE IA_PURE_FN
+i32 ia_clz(u32 x)
+{
+#if IA_HAS_BUILTIN(__builtin_clz)
+    return x ? __builtin_clz(x) : 32;
+#elif defined(IA_CC_MSVC_VERSION)
+    u32 index;
+    return _BitScanReverse(&index, x) ? 31 - index : 32;
+#else
+    if (x == 0)
+        return 32;
+    i32 count = 0;
+    while ((x & 0x80000000u) == 0) {
+        count++;
+        x <<= 1;
+    }
+    return count;
+#endif
+}
+
+/** Count leading zeroes of a 64-bit integer. */
+IA_FORCE_INLINE IA_PURE_FN
+i32 ia_clz64(u64 x)
+{
+#if IA_HAS_BUILTIN(__builtin_clzll)
+    return x ? __builtin_clzll(x) : 64;
+#elif defined(IA_CC_MSVC_VERSION) && defined(IA_ARCH_AMD64)
+    u32 index;
+    return _BitScanReverse64(&index, x) ? 63 - index : 64;
+#else
+    u32 hi = (u32)(x >> 32);
+    return hi ? ia_clz(hi) : 32 + ia_clz((u32)x);
+#endif
+}
+
+/** Count set bits. */
+IA_FORCE_INLINE IA_PURE_FN
+i32 ia_popcnt(u32 x)
+{
+#if IA_HAS_BUILTIN(__builtin_popcount)
+    return __builtin_popcount(x);
+#else
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0f0f0f0fu;
+    return (i32)((x * 0x01010101u) >> 24);
+#endif
+}
+
+/** Count set bits of a 64-bit integer. */
+IA_FORCE_INLINE IA_PURE_FN
+i32 ia_popcnt64(u64 x)
+{
+#if IA_HAS_BUILTIN(__builtin_popcountll)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (i32)((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/** Index of the most significant set bit, -1 for zero. */
+IA_FORCE_INLINE IA_PURE_FN
+i32 ia_log2_floor64(u64 x)
+{ return 63 - ia_clz64(x); }
+
+/** Position of the k-th set bit (counting from zero), or 64 if there are not enough set bits. */
+IA_FORCE_INLINE IA_PURE_FN
+i32 ia_select64(u64 x, i32 k)
+{
+#if defined(IA_ARCH_X86_BMI2) && defined(IA_ARCH_AMD64)
+    /* deposit a single bit into the k-th set position */
+    return (u32)k < 64 ? ia_ctz64(_pdep_u64(1ull << k, x)) : 64;
+#else
+    for (; k > 0 && x; k--)
+        x &= x - 1;
+    return ia_ctz64(x);
+#endif
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,149 @@
+#pragma once
+/** @file ia/compute/bvh.h
+ *  @brief Bounding volume hierarchy of boxes, for ray, frustum and box queries on the CPU.
+ *
+ *  Picking, occlusion proxies and audio occlusion rays query a scene of boxes (bounds of objects,
+ *  or triangles) many times per frame. The hierarchy is built once from the boxes and refit when
+ *  they move. Rays hit the boxes unless a callback intersects the primitive inside of them.
+ *
+ *  The builder splits boxes top-down by the surface area heuristic: a split of a node costs the
+ *  areas of both children, weighted by their count of primitives. Candidate splits are evaluated
+ *  at the borders of `IA_BVH_BINS` bins of the centroids along every axis, not at every primitive.
+ *  Subtrees of large nodes are built by separate jobs of the job system.
+ *
+ *  [On fast Construction of SAH-based Bounding Volume Hierarchies]
+ *  https://www.sci.utah.edu/~wald/Publications/2007/ParallelBVHBuild/fastbuild.pdf
+ *
+ *  The binary tree is then collapsed into a wide tree, `IA_BVH_WIDTH` children per node, by opening
+ *  the children with the largest area. A node keeps the bounds of its children in SoA, so one SIMD
+ *  instruction tests a ray, a frustum plane or a box against all of them: 8 children with AVX,
+ *  4 otherwise. Traversal visits hit children nearest first and skips the ones beyond the closest
+ *  hit found so far.
+ *
+ *  [Shallow Bounding Volume Hierarchies for Fast SIMD Ray Tracing of Incoherent Rays]
+ *  https://www.uni-ulm.de/fileadmin/website_uni_ulm/iui.inst.100/institut/Papers/QBVH.pdf
+ *
+ *  Nodes are stored with parents before children, refit walks them backwards and recomputes
+ *  the bounds of every child from the moved boxes, without changing the topology. A tree refit
+ *  after large motion gets slower to traverse, it should be rebuilt then.
+ *
+ *  Memory is allocated through the drift allocator, only when a build has more primitives than the
+ *  hierarchy has room for. Rebuilding it with as many primitives or fewer reuses its storage and the
+ *  scratch of the build, it doesn't allocate.
+ */
+#include <ia/base/types.h>
+#include <ia/compute/aabb.h>
+#include <ia/compute/camera.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Children of a node. */
+#if defined(IA_SIMD_X86) && defined(IA_ARCH_X86_AVX)
+    #define IA_BVH_WIDTH        8
+#else
+    #define IA_BVH_WIDTH        4
+#endif
+
+/** Count of primitives in a leaf, at most. */
+#define IA_BVH_LEAF_MAX         4
+
+/** Count of bins of the SAH split search. */
+#define IA_BVH_BINS             16
+
+/** A node with the bounds of its children. Unused children have empty bounds, nothing hits them,
+ *  and `child` set to `UINT32_MAX`. */
+typedef struct IA_SIMD_ALIGNMENT ia_bvh_node {
+    f32     min_x[IA_BVH_WIDTH], min_y[IA_BVH_WIDTH], min_z[IA_BVH_WIDTH];
+    f32     max_x[IA_BVH_WIDTH], max_y[IA_BVH_WIDTH], max_z[IA_BVH_WIDTH];
+    u32     child[IA_BVH_WIDTH];    /**< Index of a node, or of the first primitive of a leaf in `indices`. */
+    u32     count[IA_BVH_WIDTH];    /**< Primitives of a leaf, 0 for a node. */
+} ia_bvh_node;
+
+typedef struct ia_bvh {
+    ia_bvh_node    *nodes;          /**< The root is `nodes[0]`, parents come before their children. */
+    i32             node_count;
+    isize           count;          /**< Count of primitives. */
+    u32            *indices;        /**< Indices of the primitives in the order of the leaves. */
+    ia_aabb        *boxes;          /**< Boxes of the primitives in the order of the leaves. */
+    ia_aabb         bounds;
+    isize           capacity;       /**< Count of primitives the storage has room for. */
+    void           *scratch;        /**< Binary tree and centroids of a build, kept for rebuilds. */
+} ia_bvh;
+
+/** Closest hit of a ray. */
+typedef struct ia_bvh_hit {
+    u32     primitive;
+    f32     t;                      /**< Distance along the ray, in lengths of its direction. */
+} ia_bvh_hit;
+
+/** Intersects a ray with a primitive, whose box the ray hits.
+ *  @return Distance of the hit along the ray, a value not below `t_max` if there is none. */
+typedef f32 (IA_CALL *ia_bvh_ray_fn)(
+    void       *userdata,
+    u32         primitive,
+    f32x3 const origin,
+    f32x3 const direction,
+    f32         t_max);
+
+/** Builds the hierarchy of `count` boxes, indexed by primitive. With `job_count` above 1, subtrees
+ *  are built in parallel, it must be called from a fiber then, it yields until the build is done.
+ *  The hierarchy must be zero-initialized before its first build, later builds replace the tree. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_bvh_build(
+    ia_bvh         *bvh,
+    isize           count,
+    ia_aabb const  *boxes,
+    i32             job_count);
+
+/** Updates the bounds of the tree to moved `boxes`, indexed by primitive like at the build. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_bvh_refit(
+    ia_bvh         *bvh,
+    ia_aabb const  *boxes);
+
+/** Finds the closest hit of a ray within [0, t_max]. Without `fn` the boxes are the primitives.
+ *  @return `false` if there is no hit, `hit` is left untouched then. */
+IA_NONNULL(1,2,3,7) IA_HOT_FN IA_API bool IA_CALL
+ia_bvh_raycast(
+    ia_bvh const   *bvh,
+    f32x3 const     origin,
+    f32x3 const     direction,
+    f32             t_max,
+    ia_bvh_ray_fn   fn,
+    void           *userdata,
+    ia_bvh_hit     *hit);
+
+/** Tests whether anything is hit by a ray within [0, t_max], it stops at the first hit found.
+ *  Without `fn` the boxes are the primitives. */
+IA_NONNULL(1,2,3) IA_HOT_FN IA_API bool IA_CALL
+ia_bvh_occluded(
+    ia_bvh const   *bvh,
+    f32x3 const     origin,
+    f32x3 const     direction,
+    f32             t_max,
+    ia_bvh_ray_fn   fn,
+    void           *userdata);
+
+/** Finds the primitives whose boxes are not fully behind a plane of the frustum. Up to `capacity`
+ *  primitive indices are written into `out`.
+ *  @return Count of the primitives found, it may exceed `capacity`. */
+IA_NONNULL(1,2) IA_HOT_FN IA_API isize IA_CALL
+ia_bvh_query_frustum(
+    ia_bvh const       *bvh,
+    ia_frustum const   *frustum,
+    u32                *out,
+    isize               capacity);
+
+/** Finds the primitives whose boxes overlap a box, see `ia_bvh_query_frustum`. */
+IA_NONNULL(1,2) IA_HOT_FN IA_API isize IA_CALL
+ia_bvh_query_aabb(
+    ia_bvh const   *bvh,
+    ia_aabb const  *box,
+    u32            *out,
+    isize           capacity);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
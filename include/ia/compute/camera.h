@@ -0,0 +1,268 @@
+#pragma once
+/** @file ia/compute/camera.h
+ *  @brief Projections, view matrices, jitter for temporal antialiasing and view frustums.
+ *
+ *  View space is right-handed, the camera looks down -z with +y up. Projections map it to Vulkan
+ *  clip space: x and y in [-w, w] with +y pointing down the image, and depth in [0, w]. Depth is
+ *  reversed, the near plane maps to 1 and the far plane to 0. A float depth buffer has most of its
+ *  precision near zero, reversing the range spreads it evenly over the distance, so far geometry
+ *  doesn't z-fight and a far plane at infinity costs nothing. Render passes clear depth to 0 and
+ *  test with a greater compare op.
+ *
+ *  [Depth Precision Visualized]
+ *  https://developer.nvidia.com/content/depth-precision-visualized
+ *
+ *  Temporal antialiasing offsets the projection by a different sub-pixel amount every frame and
+ *  resolves the history. The offsets follow the Halton sequence in bases 2 and 3, it covers a pixel
+ *  evenly for any count of phases. The jitter is added to the projection after the view-projection
+ *  used for culling and motion vectors is taken, those stay unjittered.
+ *
+ *  [A Survey of Temporal Antialiasing Techniques]
+ *  http://behindthepixels.io/assets/files/TemporalAA.pdf
+ *
+ *  Multi-view setups (stereo views of `ia_xr_view_info`, split screen, shadow cascades) keep an
+ *  `ia_camera_view` per view. The caller writes the view and projection matrices of every view,
+ *  `ia_camera_views_update` derives the rest for all of them. The views of a frame share the same
+ *  jitter, so the eyes of a stereo pair resolve the same samples.
+ *
+ *  A frustum is six planes (x, y, z, w), a point p is inside of a plane when `dot(xyz, p) + w >= 0`.
+ *  The planes are extracted from the rows of a view-projection matrix, for clip space with x and y
+ *  in [-w, w] and z in [0, w]. That holds for both the standard and the reversed depth range, the near
+ *  and far planes just swap, so the depth planes are named by the clip space z they bound. The planes
+ *  aren't normalized, the tests only look at signs, and a far plane at infinity comes out as a plane
+ *  with a zero normal that contains every point.
+ *
+ *  [Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix]
+ *  https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+ *
+ *  A box is outside when it's fully behind any of the planes: the distance of its center plus its
+ *  extent projected on the plane normal is negative. The test is conservative, a box near an edge
+ *  of the frustum may pass while it's behind two planes at once, never the other way around.
+ *
+ *  `ia_frustum_cull_aabbs` tests boxes in `ia_aabb_soa` arrays, 16 (AVX-512), 8 (AVX) or 4 (SSE) boxes
+ *  per instruction, the widest the host supports. It writes the indices of visible boxes in ascending
+ *  order, a compact list to record a draw per visible object. The parallel version splits the boxes
+ *  into blocks, one per job, and packs the lists of the blocks after the jobs finish.
+ */
+#include <ia/base/types.h>
+#include <ia/compute/vector.h>
+#include <ia/compute/matrix.h>
+#include <ia/compute/quaternion.h>
+#include <ia/compute/aabb.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Upper limit of jobs of a parallel cull. */
+#define IA_FRUSTUM_CULL_MAX_JOBS    32
+
+typedef enum ia_frustum_plane : i8 {
+    ia_frustum_plane_left = 0,
+    ia_frustum_plane_right,
+    ia_frustum_plane_bottom,
+    ia_frustum_plane_top,
+    /** z >= 0, the far plane of the reversed depth range of the projections here. */
+    ia_frustum_plane_z_min,
+    /** z <= w, the near plane of the reversed depth range. */
+    ia_frustum_plane_z_max,
+    ia_frustum_plane_count,
+} ia_frustum_plane;
+
+typedef struct ia_frustum {
+    f32x4   planes[ia_frustum_plane_count];
+} ia_frustum;
+
+/** Extracts the planes of the clip volume of a view-projection matrix, in world space. */
+IA_FORCE_INLINE void ia_frustum_from_mat4(f32m4x4 const view_projection, ia_frustum *dest)
+{
+    for (i32 i = 0; i < 4; i++) {
+        /* column i of the matrix is element i of every row */
+        f32 const *c = view_projection[i];
+        f32 r0 = c[0], r1 = c[1], r2 = c[2], r3 = c[3];
+        dest->planes[ia_frustum_plane_left][i] = r3 + r0;
+        dest->planes[ia_frustum_plane_right][i] = r3 - r0;
+        dest->planes[ia_frustum_plane_bottom][i] = r3 + r1;
+        dest->planes[ia_frustum_plane_top][i] = r3 - r1;
+        dest->planes[ia_frustum_plane_z_min][i] = r2;
+        dest->planes[ia_frustum_plane_z_max][i] = r3 - r2;
+    }
+}
+
+/** @return `false` if the box is fully behind one of the planes. */
+IA_FORCE_INLINE bool ia_frustum_test_aabb(ia_frustum const *frustum, ia_aabb const *a)
+{
+    ia_aabb_centered b;
+    ia_aabb_to_centered(a, &b);
+    for (i32 p = 0; p < ia_frustum_plane_count; p++) {
+        f32 const *n = frustum->planes[p];
+        f32 d = n[0] * b.center[0] + n[1] * b.center[1] + n[2] * b.center[2] + n[3];
+        f32 r = fabsf(n[0]) * b.extent[0] + fabsf(n[1]) * b.extent[1] + fabsf(n[2]) * b.extent[2];
+        if (d + r < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+/** Perspective projection with an infinite far plane, `fov_y` is the vertical field of view in radians. */
+IA_FORCE_INLINE void ia_camera_perspective(f32 fov_y, f32 aspect, f32 z_near, f32m4x4 dest)
+{
+    f32 f = 1.0f / tanf(fov_y * 0.5f);
+    memset(dest, 0, sizeof(f32m4x4));
+    dest[0][0] = f / aspect;
+    dest[1][1] = -f;
+    dest[2][3] = -1.0f;
+    dest[3][2] = z_near; /* depth = z_near / -z */
+}
+
+/** Perspective projection with a far plane, for views that need a finite depth range, e.g. shadows. */
+IA_FORCE_INLINE void ia_camera_perspective_far(f32 fov_y, f32 aspect, f32 z_near, f32 z_far, f32m4x4 dest)
+{
+    ia_camera_perspective(fov_y, aspect, z_near, dest);
+    dest[2][2] = z_near / (z_far - z_near);
+    dest[3][2] = z_far * z_near / (z_far - z_near);
+}
+
+/** Off-center perspective projection with an infinite far plane, from tangents of the angles between
+ *  the view direction and the edges of the view. Left and down are negative for a centered view.
+ *  Head-mounted displays report fields of view like this. */
+IA_FORCE_INLINE void ia_camera_perspective_tangents(
+    f32 tan_left, f32 tan_right, f32 tan_down, f32 tan_up, f32 z_near, f32m4x4 dest)
+{
+    f32 w = tan_right - tan_left, h = tan_up - tan_down;
+    memset(dest, 0, sizeof(f32m4x4));
+    dest[0][0] = 2.0f / w;
+    dest[1][1] = -2.0f / h;
+    dest[2][0] = (tan_right + tan_left) / w;
+    dest[2][1] = -(tan_up + tan_down) / h;
+    dest[2][3] = -1.0f;
+    dest[3][2] = z_near;
+}
+
+/** Orthographic projection of the box [left, right] x [bottom, top] x [-z_far, -z_near] of view space. */
+IA_FORCE_INLINE void ia_camera_orthographic(
+    f32 left, f32 right, f32 bottom, f32 top, f32 z_near, f32 z_far, f32m4x4 dest)
+{
+    memset(dest, 0, sizeof(f32m4x4));
+    dest[0][0] = 2.0f / (right - left);
+    dest[1][1] = -2.0f / (top - bottom);
+    dest[2][2] = 1.0f / (z_far - z_near);
+    dest[3][0] = -(right + left) / (right - left);
+    dest[3][1] = (top + bottom) / (top - bottom);
+    dest[3][2] = z_far / (z_far - z_near); /* depth = (z_far + z) / (z_far - z_near) */
+    dest[3][3] = 1.0f;
+}
+
+/** View matrix of a camera at `eye` looking at `target`, `up` must not be parallel to the view direction. */
+IA_FORCE_INLINE void ia_camera_look_at(f32x3 const eye, f32x3 const target, f32x3 const up, f32m4x4 dest)
+{
+    f32x3 f, s, u;
+    ia_vec3_sub(target, eye, f);
+    ia_vec3_normalize(f, f);
+    ia_vec3_cross(f, up, s);
+    ia_vec3_normalize(s, s);
+    ia_vec3_cross(s, f, u);
+    /* rows are the camera axes, the view looks down -z */
+    for (i32 c = 0; c < 3; c++) {
+        dest[c][0] = s[c];
+        dest[c][1] = u[c];
+        dest[c][2] = -f[c];
+        dest[c][3] = 0.0f;
+    }
+    dest[3][0] = -ia_vec3_dot(s, eye);
+    dest[3][1] = -ia_vec3_dot(u, eye);
+    dest[3][2] = ia_vec3_dot(f, eye);
+    dest[3][3] = 1.0f;
+}
+
+/** View matrix of a camera with a unit quaternion orientation at a position, the pose tracking
+ *  and scene graphs report. */
+IA_FORCE_INLINE void ia_camera_view_from_pose(f32x4 const orientation, f32x3 const position, f32m4x4 dest)
+{
+    f32m4x3 a;
+    f32m4x4 m;
+    ia_quat_to_affine(orientation, position, a);
+    ia_affine_to_mat4(a, m);
+    ia_mat4_inverse_rigid(m, dest);
+}
+
+/** Radical inverse of `index` in `base`, the `index`-th element of the Halton sequence, in [0, 1). */
+IA_FORCE_INLINE f32 ia_halton(u32 index, u32 base)
+{
+    f32 r = 0.0f, f = 1.0f, inv = 1.0f / (f32)base;
+    while (index) {
+        f *= inv;
+        r += f * (f32)(index % base);
+        index /= base;
+    }
+    return r;
+}
+
+/** Sub-pixel offset of a frame in pixels, in [-0.5, 0.5), repeating every `phase_count` frames.
+ *  Index 0 of the sequence is skipped, it's the pixel corner in both bases. */
+IA_FORCE_INLINE void ia_camera_jitter_halton(u32 frame_index, u32 phase_count, f32x2 dest)
+{
+    u32 i = frame_index % phase_count + 1;
+    dest[0] = ia_halton(i, 2) - 0.5f;
+    dest[1] = ia_halton(i, 3) - 0.5f;
+}
+
+/** Offsets a projection by `jitter` pixels of a render target of `resolution` pixels. Works for
+ *  perspective and orthographic projections: the offset in clip space is scaled by w. */
+IA_FORCE_INLINE void ia_camera_jitter_projection(
+    f32m4x4 const projection, f32x2 const jitter, f32x2 const resolution, f32m4x4 dest)
+{
+    f32 ox = 2.0f * jitter[0] / resolution[0];
+    f32 oy = 2.0f * jitter[1] / resolution[1];
+    ia_mat4_copy(projection, dest);
+    for (i32 c = 0; c < 4; c++) {
+        dest[c][0] += ox * dest[c][3];
+        dest[c][1] += oy * dest[c][3];
+    }
+}
+
+/** Matrices of a view, derived from its view and projection. */
+typedef struct ia_camera_view {
+    f32m4x4         view;                       /**< World to view space, written by the caller. */
+    f32m4x4         projection;                 /**< View to clip space without jitter, written by the caller. */
+    f32x2           resolution;                 /**< Size of the render target in pixels, written by the caller. */
+    f32x2           jitter;                     /**< Offset of this frame in pixels. */
+    f32m4x4         view_projection;            /**< With jitter, for rasterization. */
+    f32m4x4         view_projection_unjittered; /**< For culling and motion vectors. */
+    f32m4x4         prev_view_projection;       /**< Unjittered view-projection of the previous update. */
+    ia_frustum      frustum;                    /**< Planes of the unjittered view-projection. */
+} ia_camera_view;
+/** Updates the derived matrices of `view_count` views for a frame, all of them with the jitter of
+ *  `frame_index`. A `jitter_phases` of 0 disables the jitter. Views must be zero-initialized, at the
+ *  first update the previous view-projection is the current one. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_camera_views_update(
+    i32                 view_count,
+    ia_camera_view     *views,
+    u32                 frame_index,
+    u32                 jitter_phases);
+
+/** Tests `count` boxes against the frustum, and writes the indices of the visible ones into `indices`,
+ *  in ascending order. The array must have space for `count` indices, the ones past the result may
+ *  be overwritten.
+ *  @return Count of visible boxes. */
+IA_NONNULL_ALL IA_HOT_FN IA_API isize IA_CALL
+ia_frustum_cull_aabbs(
+    ia_frustum const   *frustum,
+    isize               count,
+    ia_aabb_soa const  *boxes,
+    u32                *indices);
+
+/** Culls boxes like `ia_frustum_cull_aabbs`, using up to `job_count` jobs of the job system. It must be
+ *  called from a fiber, it yields until the cull is done. Small arrays are culled by the calling fiber alone. */
+IA_NONNULL_ALL IA_API isize IA_CALL
+ia_frustum_cull_aabbs_parallel(
+    ia_frustum const   *frustum,
+    isize               count,
+    ia_aabb_soa const  *boxes,
+    u32                *indices,
+    i32                 job_count);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
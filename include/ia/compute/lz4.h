@@ -0,0 +1,167 @@
+#pragma once
+/** @file ia/compute/lz4.h
+ *  @brief LZ4 block and frame compression.
+ *
+ *  LZ4 is a byte-oriented LZ77 compressor with a very fast decoder. The compressed stream is a
+ *  sequence of tokens, each one describing a run of literals followed by a back-reference match
+ *  into the already decoded output. Decompression is mostly memory copies, and our assets loads
+ *  are bound by it, so the decoder is written to move data in wide 8- and 16-byte chunks while
+ *  staying far enough from the buffer ends. Close to the ends it falls back to exact copies.
+ *  Every read and write is bounds checked, malformed or malicious input can't make the decoder
+ *  touch memory outside of the given buffers, it will return a negative value instead.
+ *
+ *  There are two compressors. The fast one is a greedy single-probe hash matcher, it's meant for
+ *  runtime data. The high-compression (HC) one walks hash chains, does lazy matching and is meant
+ *  for offline asset packing. Both produce the same format, decoding speed is not affected.
+ *
+ *  The block format has no header, so the caller must remember both the compressed and decompressed
+ *  sizes. The frame format wraps blocks with a descriptor, optional checksums (xxHash32) and sizes,
+ *  so it's self-contained. Frames written here always use independent blocks, the decoder also
+ *  accepts linked blocks produced by other encoders.
+ *
+ *  [LZ4 Block Format Description]
+ *  https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+ *
+ *  [LZ4 Frame Format Description]
+ *  https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md
+ *
+ *  [xxHash fast digest algorithm]
+ *  https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+ */
+#include <ia/base/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Largest input size accepted by the block compressor. */
+#define IA_LZ4_MAX_INPUT_SIZE   0x7e000000
+
+/** Worst case size of a compressed block, for incompressible input. */
+#define IA_LZ4_COMPRESS_BOUND(src_size) \
+    ((usize)(src_size) > (usize)IA_LZ4_MAX_INPUT_SIZE ? 0 : (src_size) + ((src_size) / 255) + 16)
+
+/** Compression levels. Non-positive levels select the fast compressor, where the absolute value
+ *  acts as acceleration (trades ratio for speed). Positive levels select the HC compressor. */
+enum : i32 {
+    ia_lz4_level_fast       = 0,
+    ia_lz4_level_hc_min     = 1,
+    ia_lz4_level_hc_default = 9,
+    ia_lz4_level_hc_max     = 12,
+};
+
+#define IA_LZ4_HC_HASH_LOG      15
+#define IA_LZ4_HC_DICT_SIZE     (1 << 16)
+
+/** Work memory of the HC compressor. It's ~256KB, so it's not placed on the stack.
+ *  Memory must be externally managed, it doesn't need to be initialized. */
+typedef struct ia_lz4_hc_state {
+    u32     hash_table[1 << IA_LZ4_HC_HASH_LOG];
+    u16     chain_table[IA_LZ4_HC_DICT_SIZE];
+} ia_lz4_hc_state;
+
+/** Compresses `src_size` bytes into a single LZ4 block using the fast compressor.
+ *  An acceleration of 1 is the default, larger values are faster and compress less.
+ *  @return Compressed size in bytes, or 0 if `dst_capacity` was too small. */
+IA_NONNULL(1,3) IA_HOT_FN IA_API isize IA_CALL
+ia_lz4_compress(
+    void const         *src,
+    isize               src_size,
+    void               *dst,
+    isize               dst_capacity,
+    i32                 acceleration);
+
+/** Compresses `src_size` bytes into a single LZ4 block using the HC compressor.
+ *  The level is clamped into [ia_lz4_level_hc_min, ia_lz4_level_hc_max].
+ *  @return Compressed size in bytes, or 0 if `dst_capacity` was too small. */
+IA_NONNULL(1,3,6) IA_API isize IA_CALL
+ia_lz4_compress_hc(
+    void const         *src,
+    isize               src_size,
+    void               *dst,
+    isize               dst_capacity,
+    i32                 level,
+    ia_lz4_hc_state    *state);
+
+/** Decompresses a single LZ4 block. The decoded size doesn't need to be known exactly,
+ *  `dst_capacity` is an upper bound. Safe against malformed input.
+ *  @return Decompressed size in bytes, or a negative value if the input is malformed or
+ *          the output doesn't fit into `dst_capacity`. */
+IA_NONNULL(1,3) IA_HOT_FN IA_API isize IA_CALL
+ia_lz4_decompress(
+    void const         *src,
+    isize               src_size,
+    void               *dst,
+    isize               dst_capacity);
+
+/** Maximum size of an independent block inside of a frame. */
+typedef enum ia_lz4_block_size : u8 {
+    ia_lz4_block_size_64kb  = 4,
+    ia_lz4_block_size_256kb = 5,
+    ia_lz4_block_size_1mb   = 6,
+    ia_lz4_block_size_4mb   = 7,
+} ia_lz4_block_size;
+
+#define ia_lz4_block_size_bytes(bs) (1ll << (8 + 2 * (bs)))
+
+/** Describes how a frame is written. */
+typedef struct ia_lz4_frame_info {
+    ia_lz4_block_size   block_size;
+    bool                block_checksum;     /**< Append xxHash32 of every compressed block. */
+    bool                content_checksum;   /**< Append xxHash32 of the whole decompressed content. */
+    bool                content_size;       /**< Write the decompressed size into the frame header. */
+    i32                 level;              /**< See `ia_lz4_level_*`. */
+} ia_lz4_frame_info;
+
+static constexpr ia_lz4_frame_info ia_lz4_frame_info_init = {
+    .block_size = ia_lz4_block_size_4mb,
+    .block_checksum = false,
+    .content_checksum = true,
+    .content_size = true,
+    .level = ia_lz4_level_fast,
+};
+
+/** Worst case size of a compressed frame. */
+IA_NONNULL_ALL IA_API isize IA_CALL
+ia_lz4_frame_bound(
+    isize                       src_size,
+    ia_lz4_frame_info const    *info);
+
+/** Compresses `src_size` bytes into a complete LZ4 frame. The `hc_state` is only required
+ *  if `info->level` selects the HC compressor, otherwise it may be nullptr.
+ *  @return Frame size in bytes, or 0 if `dst_capacity` was too small. */
+IA_NONNULL(1,3,5) IA_API isize IA_CALL
+ia_lz4_frame_compress(
+    void const                 *src,
+    isize                       src_size,
+    void                       *dst,
+    isize                       dst_capacity,
+    ia_lz4_frame_info const    *info,
+    ia_lz4_hc_state            *hc_state);
+
+/** Reads the frame header and returns the decompressed content size stored within.
+ *  @return Content size in bytes, or a negative value if the header is malformed or has no size. */
+IA_NONNULL_ALL IA_API isize IA_CALL
+ia_lz4_frame_content_size(
+    void const         *src,
+    isize               src_size);
+
+/** Decompresses a LZ4 frame, skippable frames are ignored. Checksums are verified if present.
+ *  @return Decompressed size in bytes, or a negative value on malformed input or small `dst_capacity`. */
+IA_NONNULL(1,3) IA_API isize IA_CALL
+ia_lz4_frame_decompress(
+    void const         *src,
+    isize               src_size,
+    void               *dst,
+    isize               dst_capacity);
+
+/** Computes a xxHash32 digest, used for frame checksums. */
+IA_NONNULL(1) IA_API u32 IA_CALL
+ia_xxh32(
+    void const         *src,
+    isize               src_size,
+    u32                 seed);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,223 @@
+#pragma once
+/** @file ia/compute/matrix.h
+ *  @brief Column-major 4x4 and affine 3x4 float matrices.
+ *
+ *  Matrices are arrays of columns: `f32m4x4` is four `f32x4` columns, and an affine transform
+ *  `f32m4x3` is four `f32x3` columns, the last one being the translation. Element `m[c][r]` is in
+ *  column `c` and row `r`. It's the same layout as `f32m4x4` and `f32m4x3` in `shaders/ipomoeaalba.slang`
+ *  (`matrix<float, 4, 4>` and `matrix<float, 3, 4>`) with column-major packing in storage buffers.
+ *  A `f32m4x4` is uploaded with a plain memcpy. A `f32m4x3` is 48 tightly packed bytes, that matches
+ *  the shader only with the scalar block layout (`ia_render_device_feature_scalar_block_layout`, and
+ *  `-fvk-use-scalar-layout` for slang). Under std140 and std430 every 3-component column is padded
+ *  to 16 bytes, so expand it with `ia_affine_to_mat4` or pad the columns when copying. Vectors are
+ *  columns, a transform is `M * v`, and `A * B` applies `B` first.
+ *
+ *  The 4x4 multiply broadcasts components of the right-hand columns and accumulates the left-hand
+ *  columns, with 128-bit SIMD one column at a time, with AVX two columns at a time. Functions write
+ *  into a `dest` argument that may alias the inputs. Without SIMD, scalar code computes the same
+ *  values up to rounding.
+ *
+ *  Affine inverses don't need the general 4x4 inverse: the rigid inverse of a rotation with
+ *  a translation transposes the rotation, and the affine inverse (with scale and shear) inverts the
+ *  3x3 part from cross products of its columns. The general inverse uses cofactors.
+ */
+#include <ia/base/types.h>
+#include <ia/compute/simd.h>
+#include <ia/compute/vector.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+IA_FORCE_INLINE void ia_mat4_copy(f32m4x4 const m, f32m4x4 dest)
+{ memcpy(dest, m, sizeof(f32m4x4)); }
+
+IA_FORCE_INLINE void ia_mat4_identity(f32m4x4 dest)
+{
+    memset(dest, 0, sizeof(f32m4x4));
+    dest[0][0] = dest[1][1] = dest[2][2] = dest[3][3] = 1.0f;
+}
+
+/** dest = a * b */
+IA_FORCE_INLINE void ia_mat4_mul(f32m4x4 const a, f32m4x4 const b, f32m4x4 dest)
+{
+#if defined(IA_SIMD_X86) && defined(IA_ARCH_X86_AVX)
+    /* columns of `a` in both halves, two columns of `b` and `dest` per register */
+    s256f a0 = _mm256_broadcast_ps((s128f const *)a[0]);
+    s256f a1 = _mm256_broadcast_ps((s128f const *)a[1]);
+    s256f a2 = _mm256_broadcast_ps((s128f const *)a[2]);
+    s256f a3 = _mm256_broadcast_ps((s128f const *)a[3]);
+    s256f b01 = ia_simd256_read(b[0]);
+    s256f b23 = ia_simd256_read(b[2]);
+    s256f r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+    s256f r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+    r01 = ia_simd256_fmadd(a1, _mm256_permute_ps(b01, 0x55), r01);
+    r23 = ia_simd256_fmadd(a1, _mm256_permute_ps(b23, 0x55), r23);
+    r01 = ia_simd256_fmadd(a2, _mm256_permute_ps(b01, 0xaa), r01);
+    r23 = ia_simd256_fmadd(a2, _mm256_permute_ps(b23, 0xaa), r23);
+    r01 = ia_simd256_fmadd(a3, _mm256_permute_ps(b01, 0xff), r01);
+    r23 = ia_simd256_fmadd(a3, _mm256_permute_ps(b23, 0xff), r23);
+    ia_simd256_write(dest[0], r01);
+    ia_simd256_write(dest[2], r23);
+#elif IA_SIMD
+    s128f a0 = ia_simd_read(a[0]), a1 = ia_simd_read(a[1]);
+    s128f a2 = ia_simd_read(a[2]), a3 = ia_simd_read(a[3]);
+    s128f b0 = ia_simd_read(b[0]), b1 = ia_simd_read(b[1]);
+    s128f b2 = ia_simd_read(b[2]), b3 = ia_simd_read(b[3]);
+    s128f r0 = ia_simd_mul(a0, ia_simd_splat_x(b0));
+    s128f r1 = ia_simd_mul(a0, ia_simd_splat_x(b1));
+    s128f r2 = ia_simd_mul(a0, ia_simd_splat_x(b2));
+    s128f r3 = ia_simd_mul(a0, ia_simd_splat_x(b3));
+    r0 = ia_simd_fmadd(a1, ia_simd_splat_y(b0), r0);
+    r1 = ia_simd_fmadd(a1, ia_simd_splat_y(b1), r1);
+    r2 = ia_simd_fmadd(a1, ia_simd_splat_y(b2), r2);
+    r3 = ia_simd_fmadd(a1, ia_simd_splat_y(b3), r3);
+    r0 = ia_simd_fmadd(a2, ia_simd_splat_z(b0), r0);
+    r1 = ia_simd_fmadd(a2, ia_simd_splat_z(b1), r1);
+    r2 = ia_simd_fmadd(a2, ia_simd_splat_z(b2), r2);
+    r3 = ia_simd_fmadd(a2, ia_simd_splat_z(b3), r3);
+    r0 = ia_simd_fmadd(a3, ia_simd_splat_w(b0), r0);
+    r1 = ia_simd_fmadd(a3, ia_simd_splat_w(b1), r1);
+    r2 = ia_simd_fmadd(a3, ia_simd_splat_w(b2), r2);
+    r3 = ia_simd_fmadd(a3, ia_simd_splat_w(b3), r3);
+    ia_simd_write(dest[0], r0);
+    ia_simd_write(dest[1], r1);
+    ia_simd_write(dest[2], r2);
+    ia_simd_write(dest[3], r3);
+#else
+    f32m4x4 r;
+    for (i32 c = 0; c < 4; c++)
+        for (i32 i = 0; i < 4; i++)
+            r[c][i] = a[0][i] * b[c][0] + a[1][i] * b[c][1] + a[2][i] * b[c][2] + a[3][i] * b[c][3];
+    ia_mat4_copy(r, dest);
+#endif
+}
+
+/** dest = m * v */
+IA_FORCE_INLINE void ia_mat4_mul_vec4(f32m4x4 const m, f32x4 const v, f32x4 dest)
+{
+#if IA_SIMD
+    s128f x0 = ia_simd_read(v);
+    s128f r = ia_simd_mul(ia_simd_read(m[0]), ia_simd_splat_x(x0));
+    r = ia_simd_fmadd(ia_simd_read(m[1]), ia_simd_splat_y(x0), r);
+    r = ia_simd_fmadd(ia_simd_read(m[2]), ia_simd_splat_z(x0), r);
+    r = ia_simd_fmadd(ia_simd_read(m[3]), ia_simd_splat_w(x0), r);
+    ia_simd_write(dest, r);
+#else
+    f32x4 r;
+    for (i32 i = 0; i < 4; i++)
+        r[i] = m[0][i] * v[0] + m[1][i] * v[1] + m[2][i] * v[2] + m[3][i] * v[3];
+    ia_vec4_copy(r, dest);
+#endif
+}
+
+IA_FORCE_INLINE void ia_mat4_transpose(f32m4x4 const m, f32m4x4 dest)
+{
+#if IA_SIMD
+    s128f c0 = ia_simd_read(m[0]), c1 = ia_simd_read(m[1]);
+    s128f c2 = ia_simd_read(m[2]), c3 = ia_simd_read(m[3]);
+    ia_simd_transpose(c0, c1, c2, c3);
+    ia_simd_write(dest[0], c0);
+    ia_simd_write(dest[1], c1);
+    ia_simd_write(dest[2], c2);
+    ia_simd_write(dest[3], c3);
+#else
+    f32m4x4 r;
+    for (i32 c = 0; c < 4; c++)
+        for (i32 i = 0; i < 4; i++)
+            r[c][i] = m[i][c];
+    ia_mat4_copy(r, dest);
+#endif
+}
+
+/** Inverse of a matrix with an orthonormal rotation and a translation. */
+IA_FORCE_INLINE void ia_mat4_inverse_rigid(f32m4x4 const m, f32m4x4 dest)
+{
+    f32x3 t = { m[3][0], m[3][1], m[3][2] };
+    f32m4x4 r;
+    for (i32 c = 0; c < 3; c++) {
+        r[c][0] = m[0][c];
+        r[c][1] = m[1][c];
+        r[c][2] = m[2][c];
+        r[c][3] = 0.0f;
+    }
+    /* -R^T * t */
+    for (i32 i = 0; i < 3; i++)
+        r[3][i] = -(r[0][i] * t[0] + r[1][i] * t[1] + r[2][i] * t[2]);
+    r[3][3] = 1.0f;
+    ia_mat4_copy(r, dest);
+}
+
+/** Inverse of a matrix whose last row is (0, 0, 0, 1), with any invertible 3x3 part.
+ *  @return `false` if the 3x3 part is singular, `dest` is left untouched then. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_mat4_inverse_affine(
+    f32m4x4 const   m,
+    f32m4x4         dest);
+
+/** General inverse.
+ *  @return `false` if the matrix is singular, `dest` is left untouched then. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_mat4_inverse(
+    f32m4x4 const   m,
+    f32m4x4         dest);
+
+IA_NONNULL_ALL IA_API f32 IA_CALL
+ia_mat4_determinant(f32m4x4 const m);
+
+/** Transforms `count` points as (x, y, z, 1), the homogeneous results are not divided by w. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_mat4_transform_points(
+    f32m4x4 const   m,
+    isize           count,
+    f32x3 const    *points,
+    f32x4          *dest);
+
+IA_FORCE_INLINE void ia_affine_identity(f32m4x3 dest)
+{
+    memset(dest, 0, sizeof(f32m4x3));
+    dest[0][0] = dest[1][1] = dest[2][2] = 1.0f;
+}
+
+/** Extends an affine transform with the row (0, 0, 0, 1). */
+IA_FORCE_INLINE void ia_affine_to_mat4(f32m4x3 const m, f32m4x4 dest)
+{
+    for (i32 c = 0; c < 4; c++)
+        ia_vec4_from_vec3(m[c], c == 3 ? 1.0f : 0.0f, dest[c]);
+}
+
+/** Drops the last row of a matrix, it must be (0, 0, 0, 1) for the result to be equivalent. */
+IA_FORCE_INLINE void ia_affine_from_mat4(f32m4x4 const m, f32m4x3 dest)
+{
+    for (i32 c = 0; c < 4; c++)
+        ia_vec3_copy(m[c], dest[c]);
+}
+
+/** dest = a * b, as if both were extended to 4x4. */
+IA_FORCE_INLINE void ia_affine_mul(f32m4x3 const a, f32m4x3 const b, f32m4x3 dest)
+{
+    f32m4x3 r;
+    for (i32 c = 0; c < 4; c++)
+        for (i32 i = 0; i < 3; i++)
+            r[c][i] = a[0][i] * b[c][0] + a[1][i] * b[c][1] + a[2][i] * b[c][2] + (c == 3 ? a[3][i] : 0.0f);
+    memcpy(dest, r, sizeof(f32m4x3));
+}
+
+/** Inverse of an affine transform.
+ *  @return `false` if the 3x3 part is singular, `dest` is left untouched then. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_affine_inverse(
+    f32m4x3 const   m,
+    f32m4x3         dest);
+
+/** Transforms `count` points. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_affine_transform_points(
+    f32m4x3 const   m,
+    isize           count,
+    f32x3 const    *points,
+    f32x3          *dest);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,304 @@
+#pragma once
+/** @file ia/compute/pack.h
+ *  @brief Conversions of 32-bit floats to the 16-bit, normalized and packed formats of `ia_format`.
+ *
+ *  Vertex and texture data is authored in 32-bit floats, the GPU reads most of it fine from a half
+ *  of the size or less. Positions and texture coordinates fit `f16`, colors unorm8, normals and
+ *  tangents two snorm16 in an octahedral mapping, HDR colors RGB9E5 or R11G11B10. These are the CPU
+ *  side of `ia_format_r16_sfloat`, `ia_format_r8_unorm`, `ia_format_rg16_snorm`, etc.
+ *
+ *  Halves are stored as `u16` bit patterns, C has no portable 16-bit float. The scalar conversions
+ *  are exact and round to nearest even, NaN payloads are not kept. The array versions use the F16C
+ *  instructions on x86, picked at runtime, and the conversions of NEON on aarch64.
+ *
+ *  [float->half variants, Fabian Giesen]
+ *  https://gist.github.com/rygorous/2156668
+ *
+ *  Normalized values round to the nearest even code, unorm clamps to [0, 1] and snorm to [-1, 1], NaN
+ *  becomes zero. Decoding snorm maps both -MAX and -MAX - 1 to -1, as the graphics APIs do.
+ *
+ *  A unit vector is mapped onto the octahedron |x| + |y| + |z| = 1, the lower half folded over the
+ *  upper one, and then flattened to a square. It uses the whole range of both components. The array
+ *  version picks the one of the four nearest codes that decodes closest to the vector, that keeps
+ *  directions within 0.0025 degrees, rounding each component alone within 0.0037 (measured on 1M
+ *  random unit vectors).
+ *
+ *  [A Survey of Efficient Representations for Independent Unit Vectors, Cigolle et al. 2014]
+ *  http://jcgt.org/published/0003/02/01/
+ *
+ *  RGB9E5 has a 9-bit mantissa per channel and a shared 5-bit exponent, R11G11B10 has a float of its
+ *  own per channel: 5-bit exponent, 6 (red, green) or 5 (blue) bits of mantissa, no sign. Both clamp
+ *  negative values to 0. RGB9E5 clamps to its largest value 65408, R11G11B10 keeps infinity and clamps
+ *  finite values to 65024 and 64512.
+ *
+ *  [EXT_texture_shared_exponent]
+ *  https://registry.khronos.org/OpenGL/extensions/EXT/EXT_texture_shared_exponent.txt
+ */
+#include <ia/base/types.h>
+#include <ia/compute/vector.h>
+
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+IA_FORCE_INLINE IA_CONST_FN f32 ia_pack_from_bits_(u32 bits)
+{ f32 x; memcpy(&x, &bits, 4); return x; }
+
+IA_FORCE_INLINE IA_CONST_FN u32 ia_pack_to_bits_(f32 x)
+{ u32 bits; memcpy(&bits, &x, 4); return bits; }
+
+/* Rounds to the nearest even integer for |x| < 2^22, like `cvtps2dq` does. */
+IA_FORCE_INLINE IA_CONST_FN i32 ia_pack_round_(f32 x)
+{ return (i32)(ia_pack_to_bits_(x + 0x1.8p23f) - 0x4b400000u); }
+
+/* Rounds `x * scale` to the nearest even integer. The product is exact in a double, so the result doesn't
+ * depend on the compiler fusing the multiply with the add that rounds. */
+IA_FORCE_INLINE IA_CONST_FN i32 ia_pack_round_scaled_(f32 x, f32 scale)
+{
+    f64 r = (f64)x * (f64)scale + 0x1.8p52;
+    u64 bits;
+    memcpy(&bits, &r, 8);
+    return (i32)(u32)bits;
+}
+
+/* Clamps to [lo, 1], NaN becomes 0. */
+IA_FORCE_INLINE IA_CONST_FN f32 ia_pack_saturate_(f32 x, f32 lo)
+{
+    x = x == x ? x : 0.0f;
+    x = x > lo ? x : lo;
+    return x < 1.0f ? x : 1.0f;
+}
+
+/** Converts to the bits of a half, rounds to nearest even, overflows to infinity. */
+IA_FORCE_INLINE IA_CONST_FN u16 ia_f16_from_f32(f32 x)
+{
+    u32 f = ia_pack_to_bits_(x);
+    u32 sign = f & 0x80000000u;
+    u32 h;
+    f ^= sign;
+    if (f >= 0x47800000u) {
+        /* 65536 and above, NaN stays NaN */
+        h = f > 0x7f800000u ? 0x7e00u : 0x7c00u;
+    } else if (f < 0x38800000u) {
+        /* below 2^-14 the half is denormal, adding 0.5 aligns the mantissa to the denormal steps */
+        h = ia_pack_to_bits_(ia_pack_from_bits_(f) + 0.5f) - 0x3f000000u;
+    } else {
+        /* rebias the exponent and round, a carry out of the mantissa increments the exponent */
+        u32 mant_odd = (f >> 13) & 1;
+        f += ((u32)(15 - 127) << 23) + 0xfffu + mant_odd;
+        h = f >> 13;
+    }
+    return (u16)(h | (sign >> 16));
+}
+
+/** Converts the bits of a half to a float, exact. */
+IA_FORCE_INLINE IA_CONST_FN f32 ia_f16_to_f32(u16 h)
+{
+    u32 o = (u32)(h & 0x7fffu) << 13;
+    u32 exp = o & 0x0f800000u;
+    o += (u32)(127 - 15) << 23;
+    if (exp == 0x0f800000u) {
+        o += (u32)(128 - 16) << 23; /* infinity and NaN */
+    } else if (exp == 0) {
+        /* denormal, renormalized by subtracting the implicit one that was added */
+        o += 1u << 23;
+        o = ia_pack_to_bits_(ia_pack_from_bits_(o) - 0x1p-14f);
+    }
+    return ia_pack_from_bits_(o | (u32)(h & 0x8000u) << 16);
+}
+
+IA_FORCE_INLINE IA_CONST_FN u8 ia_unorm8_from_f32(f32 x)
+{ return (u8)ia_pack_round_scaled_(ia_pack_saturate_(x, 0.0f), 255.0f); }
+
+IA_FORCE_INLINE IA_CONST_FN u16 ia_unorm16_from_f32(f32 x)
+{ return (u16)ia_pack_round_scaled_(ia_pack_saturate_(x, 0.0f), 65535.0f); }
+
+IA_FORCE_INLINE IA_CONST_FN i8 ia_snorm8_from_f32(f32 x)
+{ return (i8)ia_pack_round_scaled_(ia_pack_saturate_(x, -1.0f), 127.0f); }
+
+IA_FORCE_INLINE IA_CONST_FN i16 ia_snorm16_from_f32(f32 x)
+{ return (i16)ia_pack_round_scaled_(ia_pack_saturate_(x, -1.0f), 32767.0f); }
+
+IA_FORCE_INLINE IA_CONST_FN f32 ia_unorm8_to_f32(u8 v)
+{ return (f32)v * (1.0f / 255.0f); }
+
+IA_FORCE_INLINE IA_CONST_FN f32 ia_unorm16_to_f32(u16 v)
+{ return (f32)v * (1.0f / 65535.0f); }
+
+IA_FORCE_INLINE IA_CONST_FN f32 ia_snorm8_to_f32(i8 v)
+{ f32 x = (f32)v * (1.0f / 127.0f); return x > -1.0f ? x : -1.0f; }
+
+IA_FORCE_INLINE IA_CONST_FN f32 ia_snorm16_to_f32(i16 v)
+{ f32 x = (f32)v * (1.0f / 32767.0f); return x > -1.0f ? x : -1.0f; }
+
+/** Maps a unit vector to the octahedral square [-1, 1]^2. */
+IA_FORCE_INLINE void ia_oct_from_vec3(f32x3 const n, f32x2 dest)
+{
+    f32 l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    f32 x = n[0] / l1, y = n[1] / l1;
+    if (n[2] < 0.0f) {
+        /* fold the lower half over the diagonals */
+        f32 fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        f32 fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx, y = fy;
+    }
+    dest[0] = x;
+    dest[1] = y;
+}
+
+/** Maps a point of the octahedral square back to a unit vector. */
+IA_FORCE_INLINE void ia_oct_to_vec3(f32x2 const e, f32x3 dest)
+{
+    f32 x = e[0], y = e[1], z = 1.0f - fabsf(x) - fabsf(y);
+    f32 t = z < 0.0f ? -z : 0.0f;
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    f32 inv = 1.0f / sqrtf(x * x + y * y + z * z);
+    dest[0] = x * inv;
+    dest[1] = y * inv;
+    dest[2] = z * inv;
+}
+
+/* 9 bits of mantissa, an exponent bias of 15 */
+#define IA_RGB9E5_MAX   65408.0f
+
+/** Packs a non-negative color to RGB9E5, red in the low bits and the exponent in the top 5. */
+IA_FORCE_INLINE u32 ia_rgb9e5_from_vec3(f32x3 const rgb)
+{
+    f32 c[3];
+    for (i32 i = 0; i < 3; i++) {
+        f32 x = rgb[i] == rgb[i] ? rgb[i] : 0.0f;
+        x = x > 0.0f ? x : 0.0f;
+        c[i] = x < IA_RGB9E5_MAX ? x : IA_RGB9E5_MAX;
+    }
+    f32 m = ia_max(c[0], ia_max(c[1], c[2]));
+    /* floor(log2(m)) from the float exponent, denormals and zero take the smallest shared exponent */
+    i32 e = (i32)(ia_pack_to_bits_(m) >> 23) - 127;
+    e = ia_max(e, -16) + 16;
+    /* the largest mantissa may round up to 512, then the exponent must be one higher */
+    f32 scale = ia_pack_from_bits_((u32)(127 - (e - 24)) << 23);
+    if ((u32)ia_pack_round_(m * scale) == 512) {
+        e++;
+        scale *= 0.5f;
+    }
+    u32 r = (u32)ia_pack_round_(c[0] * scale);
+    u32 g = (u32)ia_pack_round_(c[1] * scale);
+    u32 b = (u32)ia_pack_round_(c[2] * scale);
+    return r | (g << 9) | (b << 18) | ((u32)e << 27);
+}
+
+IA_FORCE_INLINE void ia_rgb9e5_to_vec3(u32 v, f32x3 dest)
+{
+    f32 scale = ia_pack_from_bits_((u32)((i32)(v >> 27) - 24 + 127) << 23);
+    dest[0] = (f32)(v & 0x1ffu) * scale;
+    dest[1] = (f32)((v >> 9) & 0x1ffu) * scale;
+    dest[2] = (f32)((v >> 18) & 0x1ffu) * scale;
+}
+
+/* Converts to an unsigned float with a 5-bit exponent and `mant_bits` of mantissa, rounds to nearest even. */
+IA_FORCE_INLINE IA_CONST_FN u32 ia_ufloat_from_f32_(f32 x, i32 mant_bits)
+{
+    u32 f = ia_pack_to_bits_(x);
+    u32 mant_mask = (1u << mant_bits) - 1;
+    if ((f & 0x7fffffffu) > 0x7f800000u)
+        return (0x1fu << mant_bits) | (1u << (mant_bits - 1)); /* NaN */
+    if (f & 0x80000000u)
+        return 0;
+    if (f == 0x7f800000u)
+        return 0x1fu << mant_bits;
+    /* the largest finite value, exponent 30 with every mantissa bit set */
+    u32 max = ((u32)(30 - 15 + 127) << 23) | (mant_mask << (23 - mant_bits));
+    if (f >= max)
+        return (0x1eu << mant_bits) | mant_mask;
+    if (f < 0x38800000u) {
+        /* denormal, the magic number has the ulp of the denormal steps 2^(-14 - mant_bits) */
+        u32 magic = (u32)(127 + 9 - mant_bits) << 23;
+        return ia_pack_to_bits_(ia_pack_from_bits_(f) + ia_pack_from_bits_(magic)) - magic;
+    }
+    u32 mant_odd = (f >> (23 - mant_bits)) & 1;
+    f += ((u32)(15 - 127) << 23) + ((1u << (22 - mant_bits)) - 1) + mant_odd;
+    return f >> (23 - mant_bits);
+}
+
+IA_FORCE_INLINE IA_CONST_FN f32 ia_ufloat_to_f32_(u32 v, i32 mant_bits)
+{
+    u32 e = (v >> mant_bits) & 0x1fu;
+    u32 m = v & ((1u << mant_bits) - 1);
+    if (e == 0x1fu)
+        return m ? NAN : INFINITY;
+    if (e == 0)
+        return (f32)m * ia_pack_from_bits_((u32)(127 - 14 - mant_bits) << 23);
+    return ia_pack_from_bits_(((e - 15 + 127) << 23) | (m << (23 - mant_bits)));
+}
+
+/** Packs a color to R11G11B10, red in the low bits. */
+IA_FORCE_INLINE u32 ia_r11g11b10_from_vec3(f32x3 const rgb)
+{
+    return ia_ufloat_from_f32_(rgb[0], 6)
+         | (ia_ufloat_from_f32_(rgb[1], 6) << 11)
+         | (ia_ufloat_from_f32_(rgb[2], 5) << 22);
+}
+
+IA_FORCE_INLINE void ia_r11g11b10_to_vec3(u32 v, f32x3 dest)
+{
+    dest[0] = ia_ufloat_to_f32_(v & 0x7ffu, 6);
+    dest[1] = ia_ufloat_to_f32_((v >> 11) & 0x7ffu, 6);
+    dest[2] = ia_ufloat_to_f32_(v >> 22, 5);
+}
+
+/** Converts `count` floats to halves. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_f16_encode(
+    isize           count,
+    f32 const      *src,
+    u16            *dest);
+
+/** Converts `count` halves to floats. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_f16_decode(
+    isize           count,
+    u16 const      *src,
+    f32            *dest);
+
+typedef enum ia_norm_format : i8 {
+    ia_norm_format_unorm8 = 0,
+    ia_norm_format_snorm8,
+    ia_norm_format_unorm16,
+    ia_norm_format_snorm16,
+} ia_norm_format;
+
+/** Converts `count` floats to normalized integers, `dest` is an array of the integer type of `format`. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_norm_encode(
+    ia_norm_format  format,
+    isize           count,
+    f32 const      *src,
+    void           *dest);
+
+/** Converts `count` normalized integers to floats. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_norm_decode(
+    ia_norm_format  format,
+    isize           count,
+    void const     *src,
+    f32            *dest);
+
+/** Encodes `count` unit vectors to octahedral snorm16 pairs, in the layout of `ia_format_rg16_snorm`. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_oct_encode_snorm16(
+    isize           count,
+    f32x3 const    *normals,
+    u32            *dest);
+
+/** Decodes `count` octahedral snorm16 pairs to unit vectors. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_oct_decode_snorm16(
+    isize           count,
+    u32 const      *src,
+    f32x3          *dest);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
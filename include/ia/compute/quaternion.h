@@ -0,0 +1,321 @@
+#pragma once
+/** @file ia/compute/quaternion.h
+ *  @brief Rotation quaternions and dual quaternions.
+ *
+ *  A quaternion is an `f32x4` with the vector part in (x, y, z) and the scalar part in w, the same
+ *  layout as a `float4` in shaders and as cglm's `versor`. Rotations are unit quaternions, `q` and
+ *  `-q` are the same rotation. The product `p * q` applies `q` first, like matrices do.
+ *
+ *  A dual quaternion is an `f32m2x4`, the real part `[0]` is the rotation and the dual part `[1]` is
+ *  half of the translation multiplied by the rotation. Skinning with dual quaternions blends joint
+ *  transforms without the volume loss of linear blend skinning.
+ *
+ *  [Geometric Skinning with Approximate Dual Quaternion Blending]
+ *  https://users.cs.utah.edu/~ladislav/kavan08geometric/kavan08geometric.pdf
+ *
+ *  Animation blending interpolates thousands of joint rotations per frame. `ia_quat_nlerp_soa` does it
+ *  on structure-of-arrays rotations, 8 (AVX) or 4 (SSE) joints per instruction, with a refined reciprocal
+ *  square root instead of a division. Normalized lerp is not constant speed like slerp, but it's
+ *  commutative and the error between nearby keyframes is negligible.
+ *
+ *  [Understanding Slerp, Then Not Using It]
+ *  https://number-none.com/product/Understanding%20Slerp,%20Then%20Not%20Using%20It/
+ */
+#include <ia/base/types.h>
+#include <ia/compute/simd.h>
+#include <ia/compute/vector.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+IA_FORCE_INLINE void ia_quat_identity(f32x4 dest)
+{ dest[0] = dest[1] = dest[2] = 0.0f; dest[3] = 1.0f; }
+
+/** Rotation by `angle` radians around a normalized axis. */
+IA_FORCE_INLINE void ia_quat_from_axis_angle(f32x3 const axis, f32 angle, f32x4 dest)
+{
+    f32 s = sinf(0.5f * angle);
+    ia_vec4_from_vec3(axis, cosf(0.5f * angle), dest);
+    dest[0] *= s; dest[1] *= s; dest[2] *= s;
+}
+
+/** dest = p * q, the Hamilton product. */
+IA_FORCE_INLINE void ia_quat_mul(f32x4 const p, f32x4 const q, f32x4 dest)
+{
+#if IA_SIMD
+    s128f xp = ia_simd_read(p);
+    s128f xq = ia_simd_read(q);
+    /* r = pw * q + px * (qw, -qz, qy, -qx) + py * (qz, qw, -qx, -qy) + pz * (-qy, qx, qw, -qz),
+     * sign masks are in the lane order w, z, y, x */
+    s128f x = ia_simd_xor(ia_simd_splat_x(xp), ia_simd_float32x4_SIGNMASK_NPNP);
+    s128f y = ia_simd_xor(ia_simd_splat_y(xp), IA_SIMD_SIGNMASKf(IA_SIMD_NEGZEROf, IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf, IA_SIMD_POSZEROf));
+    s128f z = ia_simd_xor(ia_simd_splat_z(xp), ia_simd_float32x4_SIGNMASK_NPPN);
+    s128f r = ia_simd_mul(ia_simd_splat_w(xp), xq);
+    r = ia_simd_fmadd(x, ia_simd_shuffle1(xq, 0, 1, 2, 3), r);
+    r = ia_simd_fmadd(y, ia_simd_shuffle1(xq, 1, 0, 3, 2), r);
+    r = ia_simd_fmadd(z, ia_simd_shuffle1(xq, 2, 3, 0, 1), r);
+    ia_simd_write(dest, r);
+#else
+    f32x4 r = {
+        p[3] * q[0] + p[0] * q[3] + p[1] * q[2] - p[2] * q[1],
+        p[3] * q[1] - p[0] * q[2] + p[1] * q[3] + p[2] * q[0],
+        p[3] * q[2] + p[0] * q[1] - p[1] * q[0] + p[2] * q[3],
+        p[3] * q[3] - p[0] * q[0] - p[1] * q[1] - p[2] * q[2],
+    };
+    ia_vec4_copy(r, dest);
+#endif
+}
+
+/** Conjugate, the inverse rotation of a unit quaternion. */
+IA_FORCE_INLINE void ia_quat_conjugate(f32x4 const q, f32x4 dest)
+{
+#if IA_SIMD
+    s128f mask = IA_SIMD_SIGNMASKf(IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf, IA_SIMD_NEGZEROf, IA_SIMD_NEGZEROf);
+    ia_simd_write(dest, ia_simd_xor(ia_simd_read(q), mask));
+#else
+    dest[0] = -q[0]; dest[1] = -q[1]; dest[2] = -q[2]; dest[3] = q[3];
+#endif
+}
+
+/** Inverse of any non-zero quaternion. */
+IA_FORCE_INLINE void ia_quat_inverse(f32x4 const q, f32x4 dest)
+{
+    f32 n2 = ia_vec4_norm2(q);
+    ia_quat_conjugate(q, dest);
+    ia_vec4_scale(dest, 1.0f / n2, dest);
+}
+
+IA_FORCE_INLINE void ia_quat_normalize(f32x4 const q, f32x4 dest)
+{ ia_vec4_normalize(q, dest); }
+
+/** Rotates a vector by a unit quaternion. */
+IA_FORCE_INLINE void ia_quat_rotate(f32x4 const q, f32x3 const v, f32x3 dest)
+{
+    /* v + w * t + u x t, where t = 2 * (u x v) */
+    f32x3 u = { q[0], q[1], q[2] }, t, ut;
+    ia_vec3_cross(u, v, t);
+    ia_vec3_scale(t, 2.0f, t);
+    ia_vec3_cross(u, t, ut);
+    for (i32 i = 0; i < 3; i++)
+        dest[i] = v[i] + q[3] * t[i] + ut[i];
+}
+
+/** Normalized lerp along the shorter arc. */
+IA_FORCE_INLINE void ia_quat_nlerp(f32x4 const from, f32x4 const to, f32 t, f32x4 dest)
+{
+#if IA_SIMD
+    s128f a = ia_simd_read(from);
+    s128f b = ia_simd_read(to);
+    /* flip `to` into the hemisphere of `from` with the sign of the dot product */
+    b = ia_simd_xor(b, ia_simd_and(ia_simd_vdot(a, b), ia_simd_float32x4_SIGNMASK_NEG));
+    s128f r = ia_simd_fmadd(ia_simd_sub(b, a), ia_simd_set1_rval(t), a);
+    ia_simd_write(dest, ia_simd_mul(r, ia_simd_rsqrt(ia_simd_vdot(r, r))));
+#else
+    f32 s = ia_vec4_dot(from, to) < 0.0f ? -1.0f : 1.0f;
+    f32x4 r;
+    for (i32 i = 0; i < 4; i++)
+        r[i] = ia_lerpf(from[i], s * to[i], t);
+    ia_vec4_normalize_fast(r, dest);
+#endif
+}
+
+/** Spherical lerp along the shorter arc, with constant angular velocity. Nearly parallel
+ *  rotations fall back to `ia_quat_nlerp`. */
+IA_FORCE_INLINE void ia_quat_slerp(f32x4 const from, f32x4 const to, f32 t, f32x4 dest)
+{
+    f32 cos_theta = ia_vec4_dot(from, to);
+    f32 s = cos_theta < 0.0f ? -1.0f : 1.0f;
+    cos_theta *= s;
+    if (cos_theta > 0.9995f) {
+        ia_quat_nlerp(from, to, t, dest);
+        return;
+    }
+    f32 theta = acosf(cos_theta);
+    f32 inv_sin = 1.0f / sinf(theta);
+    f32 wa = sinf((1.0f - t) * theta) * inv_sin;
+    f32 wb = sinf(t * theta) * inv_sin * s;
+    f32x4 r;
+    ia_vec4_scale(from, wa, r);
+    ia_vec4_muladds(to, wb, r);
+    ia_vec4_copy(r, dest);
+}
+
+/** Rotation of the columns of a 3x3 matrix, they must be orthonormal. */
+IA_FORCE_INLINE void
+ia_quat_from_rotation_(
+    f32 const  *c0,
+    f32 const  *c1,
+    f32 const  *c2,
+    f32x4       dest)
+{
+    /* Shepperd's method, derived from the largest of the diagonal and the trace */
+    f32 trace = c0[0] + c1[1] + c2[2];
+    if (trace > 0.0f) {
+        f32 s = 0.5f / sqrtf(trace + 1.0f);
+        dest[0] = (c1[2] - c2[1]) * s;
+        dest[1] = (c2[0] - c0[2]) * s;
+        dest[2] = (c0[1] - c1[0]) * s;
+        dest[3] = 0.25f / s;
+    } else if (c0[0] > c1[1] && c0[0] > c2[2]) {
+        f32 s = 2.0f * sqrtf(1.0f + c0[0] - c1[1] - c2[2]);
+        f32 inv = 1.0f / s;
+        dest[0] = 0.25f * s;
+        dest[1] = (c1[0] + c0[1]) * inv;
+        dest[2] = (c2[0] + c0[2]) * inv;
+        dest[3] = (c1[2] - c2[1]) * inv;
+    } else if (c1[1] > c2[2]) {
+        f32 s = 2.0f * sqrtf(1.0f + c1[1] - c0[0] - c2[2]);
+        f32 inv = 1.0f / s;
+        dest[0] = (c1[0] + c0[1]) * inv;
+        dest[1] = 0.25f * s;
+        dest[2] = (c2[1] + c1[2]) * inv;
+        dest[3] = (c2[0] - c0[2]) * inv;
+    } else {
+        f32 s = 2.0f * sqrtf(1.0f + c2[2] - c0[0] - c1[1]);
+        f32 inv = 1.0f / s;
+        dest[0] = (c2[0] + c0[2]) * inv;
+        dest[1] = (c2[1] + c1[2]) * inv;
+        dest[2] = 0.25f * s;
+        dest[3] = (c0[1] - c1[0]) * inv;
+    }
+}
+
+/** Rotation of a matrix without scale, the translation is ignored. */
+IA_FORCE_INLINE void ia_quat_from_mat4(f32m4x4 const m, f32x4 dest)
+{ ia_quat_from_rotation_(m[0], m[1], m[2], dest); }
+
+/** Rotation of an affine transform without scale, the translation is ignored. */
+IA_FORCE_INLINE void ia_quat_from_affine(f32m4x3 const m, f32x4 dest)
+{ ia_quat_from_rotation_(m[0], m[1], m[2], dest); }
+
+/** Affine transform of a rotation by a unit quaternion followed by a translation. */
+IA_FORCE_INLINE void ia_quat_to_affine(f32x4 const q, f32x3 const translation, f32m4x3 dest)
+{
+    f32 x = q[0], y = q[1], z = q[2], w = q[3];
+    f32 xx = x * x, yy = y * y, zz = z * z;
+    f32 xy = x * y, xz = x * z, yz = y * z;
+    f32 wx = w * x, wy = w * y, wz = w * z;
+    dest[0][0] = 1.0f - 2.0f * (yy + zz);
+    dest[0][1] = 2.0f * (xy + wz);
+    dest[0][2] = 2.0f * (xz - wy);
+    dest[1][0] = 2.0f * (xy - wz);
+    dest[1][1] = 1.0f - 2.0f * (xx + zz);
+    dest[1][2] = 2.0f * (yz + wx);
+    dest[2][0] = 2.0f * (xz + wy);
+    dest[2][1] = 2.0f * (yz - wx);
+    dest[2][2] = 1.0f - 2.0f * (xx + yy);
+    ia_vec3_copy(translation, dest[3]);
+}
+
+/** Rotation matrix of a unit quaternion. */
+IA_FORCE_INLINE void ia_quat_to_mat4(f32x4 const q, f32m4x4 dest)
+{
+    f32m4x3 m;
+    f32x3 const zero = {0};
+    ia_quat_to_affine(q, zero, m);
+    for (i32 c = 0; c < 4; c++)
+        ia_vec4_from_vec3(m[c], c == 3 ? 1.0f : 0.0f, dest[c]);
+}
+
+/* Dual quaternions */
+
+/** Rigid transform of a rotation by a unit quaternion followed by a translation. */
+IA_FORCE_INLINE void ia_dquat_from_rotation_translation(f32x4 const q, f32x3 const translation, f32m2x4 dest)
+{
+    f32x4 t = { 0.5f * translation[0], 0.5f * translation[1], 0.5f * translation[2], 0.0f };
+    ia_vec4_copy(q, dest[0]);
+    ia_quat_mul(t, dest[0], dest[1]);
+}
+
+/** Translation of a unit dual quaternion, the rotation is `dq[0]`. */
+IA_FORCE_INLINE void ia_dquat_translation(f32m2x4 const dq, f32x3 dest)
+{
+    f32x4 c, t;
+    ia_quat_conjugate(dq[0], c);
+    ia_quat_mul(dq[1], c, t);
+    dest[0] = 2.0f * t[0]; dest[1] = 2.0f * t[1]; dest[2] = 2.0f * t[2];
+}
+
+/** dest = a * b, applies `b` first. */
+IA_FORCE_INLINE void ia_dquat_mul(f32m2x4 const a, f32m2x4 const b, f32m2x4 dest)
+{
+    f32x4 real, dual, t;
+    ia_quat_mul(a[0], b[0], real);
+    ia_quat_mul(a[0], b[1], dual);
+    ia_quat_mul(a[1], b[0], t);
+    ia_vec4_add(dual, t, dest[1]);
+    ia_vec4_copy(real, dest[0]);
+}
+
+/** Scales both parts by the inverse norm of the real part. A blend of unit dual quaternions keeps the parts
+ *  orthogonal, so this makes it a unit dual quaternion again. */
+IA_FORCE_INLINE void ia_dquat_normalize(f32m2x4 const dq, f32m2x4 dest)
+{
+    f32 inv = ia_rsqrtf(ia_vec4_norm2(dq[0]));
+    ia_vec4_scale(dq[0], inv, dest[0]);
+    ia_vec4_scale(dq[1], inv, dest[1]);
+}
+
+/** Transforms a point by a unit dual quaternion. */
+IA_FORCE_INLINE void ia_dquat_transform_point(f32m2x4 const dq, f32x3 const p, f32x3 dest)
+{
+    f32x3 t;
+    ia_dquat_translation(dq, t);
+    ia_quat_rotate(dq[0], p, dest);
+    ia_vec3_add(dest, t, dest);
+}
+
+/** Affine transform of a unit dual quaternion. */
+IA_FORCE_INLINE void ia_dquat_to_affine(f32m2x4 const dq, f32m4x3 dest)
+{
+    f32x3 t;
+    ia_dquat_translation(dq, t);
+    ia_quat_to_affine(dq[0], t, dest);
+}
+
+/** Dual quaternion linear blending of joint transforms for skinning. Every transform is flipped into the
+ *  hemisphere of the first one before it's weighted, the result is normalized. */
+IA_FORCE_INLINE void
+ia_dquat_blend(
+    i32             count,
+    f32m2x4 const  *dqs,
+    f32 const      *weights,
+    f32m2x4         dest)
+{
+    f32m2x4 r = {0};
+    for (i32 i = 0; i < count; i++) {
+        f32 w = ia_vec4_dot(dqs[0][0], dqs[i][0]) < 0.0f ? -weights[i] : weights[i];
+        ia_vec4_muladds(dqs[i][0], w, r[0]);
+        ia_vec4_muladds(dqs[i][1], w, r[1]);
+    }
+    ia_dquat_normalize(r, dest);
+}
+
+/** Rotations in structure-of-arrays layout, one array per component. */
+typedef struct ia_quat_soa {
+    f32    *x, *y, *z, *w;
+} ia_quat_soa;
+
+/** Normalized lerp of `count` rotations along the shorter arc, with the same `t` for all of them.
+ *  `dest` may alias `from` or `to`. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_quat_nlerp_soa(
+    isize               count,
+    ia_quat_soa const  *from,
+    ia_quat_soa const  *to,
+    f32                 t,
+    ia_quat_soa const  *dest);
+
+/** Normalized lerp of `count` rotations along the shorter arc, with a weight per rotation. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_quat_nlerp_soa_weights(
+    isize               count,
+    ia_quat_soa const  *from,
+    ia_quat_soa const  *to,
+    f32 const          *weights,
+    ia_quat_soa const  *dest);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
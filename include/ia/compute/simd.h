@@ -13,16 +13,32 @@
  *  - WebAssembly (128-bit SIMD)
  *
  *  If any of these targets have SIMD intrinsics present, `IA_SIMD` is set to 1. Each backend defines atleast
- *  128-bit (4x32-bit) float operations. Also, 28-bit integer and 256-bit types may be defined if the given
+ *  128-bit (4x32-bit) float operations. Also, 128-bit integer and 256-bit types may be defined if the given
  *  implementation allows for that. Data is required to be aligned (16-byte for 128-bit, 32-byte for 256-bit)
  *  unless `IA_SIMD_UNALIGNED` is defined - then the SIMD macros don't expect the data to be aligned properly.
- * 
- *  TODO docs operations
+ *
+ *  Every backend implements the same operations on `s128f`, code written against them runs on any target
+ *  with `IA_SIMD` set. Lanes are numbered from the lowest address, the arguments of `ia_simd_shuffle1`,
+ *  `ia_simd_shuffle2` and `IA_SIMD_SIGNMASKf` go from the last lane to the first, like `_MM_SHUFFLE`:
+ *  - read, write: `ia_simd_read`, `ia_simd_write`, `ia_simd_read3f`, `ia_simd_write3f` (the fourth lane is 0)
+ *  - splats: `ia_simd_set`, `ia_simd_set1`, `ia_simd_set1_ptr`, `ia_simd_set1_rval`, `ia_simd_zero`,
+ *    `ia_simd_splat`, `ia_simd_splat_x`..`ia_simd_splat_w`, `ia_simd_first`
+ *  - shuffles: `ia_simd_shuffle1`, `ia_simd_shuffle2`, `ia_simd_transpose`
+ *  - sign masks: `IA_SIMD_SIGNMASKf`, `ia_simd_float32x4_SIGNMASK_*`
+ *  - arithmetic: add, sub, mul, div, neg, abs, sqrt, rsqrt, min, max, fmadd, fnmadd, fmsub, fnmsub
+ *  - masks: and, or, xor, cmpeq, cmpneq, cmplt, cmpgt (lanes of all ones or zeros), select
+ *  - horizontal: vhadd, vhadds, hadd, vhmin, hmin, vhmax, hmax, vdot, vdots, dot, norm, norm2,
+ *    norm_one, norm_inf
+ *
+ *  Results match within rounding: a backend without fused multiply-add rounds twice, and `ia_simd_rsqrt`
+ *  refines the estimate of the hardware to around 21 bits, or divides where there is no estimate.
+ *  Min and max of a NaN are not portable. `IA_SIMD_256` and the `ia_simd256_*` operations are only
+ *  defined by the x86 backend with AVX.
  */
 #include <ia/base/targets.h>
 
 /* Do not use SIMD alignment for older visual studio versions. */
-#if defined(IA_CC_MSVC_VERSION_CHECK) && !IA_CC_MSVC_VERSION_CHECK(19,13,0)
+#if defined(IA_CC_MSVC_VERSION) && !IA_CC_MSVC_VERSION_CHECK(19,13,0)
     /* Visual Studio 2017 version 15.6 */
     #ifndef IA_SIMD_UNALIGNED
         #define IA_SIMD_UNALIGNED
@@ -34,11 +50,11 @@
     /* ignore */
 #elif defined(IA_ARCH_X86) || defined(IA_ARCH_AMD64)
     #include <ia/compute/simd/x86.h>
-#elif defined(IA_ARCH_ARM) || defined(IA_ARCH_AARCH64)
+#elif defined(IA_ARCH_ARM_NEON)
     #include <ia/compute/simd/neon.h>
-#elif defined(IA_ARCH_RISCV)
+#elif defined(IA_ARCH_RISCV_V)
     #include <ia/compute/simd/rvv.h>
-#elif defined(IA_ARCH_WASM)
+#elif defined(IA_ARCH_WASM_SIMD128)
     #include <ia/compute/simd/wasm.h>
 #endif
 #undef _IA_SIMD_H_
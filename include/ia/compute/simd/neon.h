@@ -4,3 +4,270 @@
 #define IA_SIMD_NEON 1
 
 #include <ia/base/types.h>
+
+typedef float32x4_t s128f;
+typedef int32x4_t   s128i;
+#if defined(IA_ARCH_AARCH64)
+    typedef float64x2_t s128d;
+#endif /* IA_ARCH_AARCH64 */
+#define IA_SIMD_128 1
+#define IA_SIMD_256 0
+
+/* NEON loads and stores don't care about alignment */
+#define ia_simd_read(p)     vld1q_f32(p)
+#define ia_simd_write(p,a)  vst1q_f32(p,a)
+
+IA_FORCE_INLINE s128f ia_simd_set(f32 x, f32 y, f32 z, f32 w)
+{
+    f32 IA_ALIGNMENT(16) v[4] = { x, y, z, w };
+    return vld1q_f32(v);
+}
+
+#if IA_HAS_BUILTIN(__builtin_shufflevector)
+    #define ia_simd_shuffle1(xmm, z, y, x, w) \
+        __builtin_shufflevector(xmm, xmm, w, x, y, z)
+    #define ia_simd_shuffle2(a, b, z0, y0, x0, w0, z1, y1, x1, w1) \
+        ia_simd_shuffle1(__builtin_shufflevector(a, b, w0, x0, (y0) + 4, (z0) + 4), z1, y1, x1, w1)
+#else
+    /* the compiler folds the stores and loads into lane moves */
+    IA_FORCE_INLINE s128f ia_simd_shuffle_(s128f a, s128f b, i32 i0, i32 i1, i32 i2, i32 i3)
+    {
+        f32 IA_ALIGNMENT(16) v[8];
+        vst1q_f32(&v[0], a);
+        vst1q_f32(&v[4], b);
+        return ia_simd_set(v[i0], v[i1], v[i2], v[i3]);
+    }
+    #define ia_simd_shuffle1(xmm, z, y, x, w) \
+        ia_simd_shuffle_(xmm, xmm, w, x, y, z)
+    #define ia_simd_shuffle2(a, b, z0, y0, x0, w0, z1, y1, x1, w1) \
+        ia_simd_shuffle1(ia_simd_shuffle_(a, b, w0, x0, (y0) + 4, (z0) + 4), z1, y1, x1, w1)
+#endif /* __builtin_shufflevector */
+
+#if defined(IA_ARCH_AARCH64)
+    #define ia_simd_splat(x, lane)  vdupq_laneq_f32(x, lane)
+#else
+    #define ia_simd_splat(x, lane)  vdupq_lane_f32((lane) < 2 ? vget_low_f32(x) : vget_high_f32(x), (lane) & 1)
+#endif /* IA_ARCH_AARCH64 */
+
+#define ia_simd_set1(x)             vdupq_n_f32(x)
+#define ia_simd_set1_ptr(x)         vld1q_dup_f32(x)
+#define ia_simd_set1_rval(x)        vdupq_n_f32(x)
+#define ia_simd_splat_x(x)          ia_simd_splat(x, 0)
+#define ia_simd_splat_y(y)          ia_simd_splat(y, 1)
+#define ia_simd_splat_z(z)          ia_simd_splat(z, 2)
+#define ia_simd_splat_w(w)          ia_simd_splat(w, 3)
+
+#define IA_SIMD_NEGZEROf            ((i32)0x80000000) /* -> -0.0f */
+#define IA_SIMD_POSZEROf            ((i32)0x00000000) /* -> +0.0f */
+
+IA_FORCE_INLINE s128f ia_simd_signmask_(i32 x, i32 y, i32 z, i32 w)
+{
+    i32 IA_ALIGNMENT(16) v[4] = { w, z, y, x };
+    return vreinterpretq_f32_s32(vld1q_s32(v));
+}
+
+#define IA_SIMD_SIGNMASKf(x,y,z,w) \
+    ia_simd_signmask_(x,y,z,w)
+
+#define ia_simd_float32x4_SIGNMASK_PNPN \
+    IA_SIMD_SIGNMASKf(IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf)
+#define ia_simd_float32x4_SIGNMASK_NPNP \
+    IA_SIMD_SIGNMASKf(IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf)
+#define ia_simd_float32x4_SIGNMASK_NPPN \
+    IA_SIMD_SIGNMASKf(IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf, IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf)
+#define ia_simd_float32x4_SIGNMASK_NEG  vreinterpretq_f32_s32(vdupq_n_s32(IA_SIMD_NEGZEROf))
+
+#define ia_simd_zero()              vdupq_n_f32(0.0f)
+#define ia_simd_first(v)            vgetq_lane_f32(v, 0)
+
+IA_FORCE_INLINE s128f ia_simd_add(s128f a, s128f b)
+{ return vaddq_f32(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_sub(s128f a, s128f b)
+{ return vsubq_f32(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_mul(s128f a, s128f b)
+{ return vmulq_f32(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_neg(s128f x)
+{ return vnegq_f32(x); }
+
+/** Reciprocal square root, the 8-bit estimate is refined by two Newton-Raphson steps to ~21 bits. */
+IA_FORCE_INLINE s128f ia_simd_rsqrt(s128f x)
+{
+    s128f r = vrsqrteq_f32(x);
+    /* vrsqrtsq computes (3 - a * b) / 2 */
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+    return vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+}
+
+IA_FORCE_INLINE s128f ia_simd_sqrt(s128f x)
+{
+#if defined(IA_ARCH_AARCH64)
+    return vsqrtq_f32(x);
+#else
+    /* x / sqrt(x), zero stays zero instead of 0 * inf */
+    s128f r = vmulq_f32(x, ia_simd_rsqrt(x));
+    return vbslq_f32(vceqq_f32(x, vdupq_n_f32(0.0f)), x, r);
+#endif /* IA_ARCH_AARCH64 */
+}
+
+IA_FORCE_INLINE s128f ia_simd_div(s128f a, s128f b)
+{
+#if defined(IA_ARCH_AARCH64)
+    return vdivq_f32(a, b);
+#else
+    /* the 8-bit estimate of 1/b refined by two Newton-Raphson steps, vrecpsq computes 2 - a * b */
+    s128f r = vrecpeq_f32(b);
+    r = vmulq_f32(r, vrecpsq_f32(b, r));
+    r = vmulq_f32(r, vrecpsq_f32(b, r));
+    return vmulq_f32(a, r);
+#endif /* IA_ARCH_AARCH64 */
+}
+
+IA_FORCE_INLINE s128f ia_simd_abs(s128f x)
+{ return vabsq_f32(x); }
+
+IA_FORCE_INLINE s128f ia_simd_min(s128f a, s128f b)
+{ return vminq_f32(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_max(s128f a, s128f b)
+{ return vmaxq_f32(a, b); }
+
+/** Lanes of `b` where the lanes of `mask` are all ones, lanes of `a` where they're zero. */
+IA_FORCE_INLINE s128f ia_simd_select(s128f a, s128f b, s128f mask)
+{ return vbslq_f32(vreinterpretq_u32_f32(mask), b, a); }
+
+IA_FORCE_INLINE s128f ia_simd_and(s128f a, s128f b)
+{ return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+
+IA_FORCE_INLINE s128f ia_simd_or(s128f a, s128f b)
+{ return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+
+IA_FORCE_INLINE s128f ia_simd_xor(s128f a, s128f b)
+{ return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpeq(s128f a, s128f b)
+{ return vreinterpretq_f32_u32(vceqq_f32(a, b)); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpneq(s128f a, s128f b)
+{ return vreinterpretq_f32_u32(vmvnq_u32(vceqq_f32(a, b))); }
+
+IA_FORCE_INLINE s128f ia_simd_cmplt(s128f a, s128f b)
+{ return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpgt(s128f a, s128f b)
+{ return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+
+/** Transposes four registers in place, the rows become columns. */
+#define ia_simd_transpose(r0, r1, r2, r3) \
+    do { \
+        float32x4x2_t t01_ = vtrnq_f32(r0, r1); /* [r0.x r1.x r0.z r1.z], [r0.y r1.y r0.w r1.w] */ \
+        float32x4x2_t t23_ = vtrnq_f32(r2, r3); \
+        (r0) = vcombine_f32(vget_low_f32(t01_.val[0]), vget_low_f32(t23_.val[0])); \
+        (r1) = vcombine_f32(vget_low_f32(t01_.val[1]), vget_low_f32(t23_.val[1])); \
+        (r2) = vcombine_f32(vget_high_f32(t01_.val[0]), vget_high_f32(t23_.val[0])); \
+        (r3) = vcombine_f32(vget_high_f32(t01_.val[1]), vget_high_f32(t23_.val[1])); \
+    } while (0)
+
+IA_FORCE_INLINE f32 ia_simd_hadd(s128f v)
+{
+#if defined(IA_ARCH_AARCH64)
+    return vaddvq_f32(v);
+#else
+    float32x2_t x0 = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(x0, x0), 0);
+#endif /* IA_ARCH_AARCH64 */
+}
+
+IA_FORCE_INLINE s128f ia_simd_vhadd(s128f v)
+{ return vdupq_n_f32(ia_simd_hadd(v)); }
+
+IA_FORCE_INLINE s128f ia_simd_vhadds(s128f v)
+{ return ia_simd_vhadd(v); }
+
+IA_FORCE_INLINE f32 ia_simd_hmin(s128f v)
+{
+#if defined(IA_ARCH_AARCH64)
+    return vminvq_f32(v);
+#else
+    float32x2_t x0 = vmin_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpmin_f32(x0, x0), 0);
+#endif /* IA_ARCH_AARCH64 */
+}
+
+IA_FORCE_INLINE s128f ia_simd_vhmin(s128f v)
+{ return vdupq_n_f32(ia_simd_hmin(v)); }
+
+IA_FORCE_INLINE f32 ia_simd_hmax(s128f v)
+{
+#if defined(IA_ARCH_AARCH64)
+    return vmaxvq_f32(v);
+#else
+    float32x2_t x0 = vmax_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpmax_f32(x0, x0), 0);
+#endif /* IA_ARCH_AARCH64 */
+}
+
+IA_FORCE_INLINE s128f ia_simd_vhmax(s128f v)
+{ return vdupq_n_f32(ia_simd_hmax(v)); }
+
+IA_FORCE_INLINE s128f ia_simd_vdots(s128f a, s128f b)
+{ return ia_simd_vhadd(vmulq_f32(a, b)); }
+
+IA_FORCE_INLINE s128f ia_simd_vdot(s128f a, s128f b)
+{ return ia_simd_vhadd(vmulq_f32(a, b)); }
+
+IA_FORCE_INLINE f32 ia_simd_dot(s128f a, s128f b)
+{ return ia_simd_hadd(vmulq_f32(a, b)); }
+
+IA_FORCE_INLINE f32 ia_simd_norm(s128f a)
+{ return ia_simd_first(ia_simd_sqrt(ia_simd_vdot(a, a))); }
+
+IA_FORCE_INLINE f32 ia_simd_norm2(s128f a)
+{ return ia_simd_hadd(vmulq_f32(a, a)); }
+
+IA_FORCE_INLINE f32 ia_simd_norm_one(s128f a)
+{ return ia_simd_hadd(vabsq_f32(a)); }
+
+IA_FORCE_INLINE f32 ia_simd_norm_inf(s128f a)
+{ return ia_simd_hmax(vabsq_f32(a)); }
+
+IA_FORCE_INLINE s128f ia_simd_read3f(f32x3 const v)
+{
+    float32x2_t xy = vld1_f32(v);
+    float32x2_t z0 = vld1_lane_f32(&v[2], vdup_n_f32(0.0f), 0);
+    return vcombine_f32(xy, z0);
+}
+
+IA_FORCE_INLINE void ia_simd_write3f(f32x3 v, s128f vx)
+{
+    vst1_f32(v, vget_low_f32(vx));
+    vst1q_lane_f32(&v[2], vx, 2);
+}
+
+#if defined(IA_ARCH_AARCH64) || defined(IA_ARCH_ARM_FMA)
+IA_FORCE_INLINE s128f ia_simd_fmadd(s128f a, s128f b, s128f c)
+{ return vfmaq_f32(c, a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_fnmadd(s128f a, s128f b, s128f c)
+{ return vfmsq_f32(c, a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_fmsub(s128f a, s128f b, s128f c)
+{ return vnegq_f32(vfmsq_f32(c, a, b)); }
+
+IA_FORCE_INLINE s128f ia_simd_fnmsub(s128f a, s128f b, s128f c)
+{ return vnegq_f32(vfmaq_f32(c, a, b)); }
+#else
+IA_FORCE_INLINE s128f ia_simd_fmadd(s128f a, s128f b, s128f c)
+{ return vmlaq_f32(c, a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_fnmadd(s128f a, s128f b, s128f c)
+{ return vmlsq_f32(c, a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_fmsub(s128f a, s128f b, s128f c)
+{ return vnegq_f32(vmlsq_f32(c, a, b)); }
+
+IA_FORCE_INLINE s128f ia_simd_fnmsub(s128f a, s128f b, s128f c)
+{ return vnegq_f32(vmlaq_f32(c, a, b)); }
+#endif /* IA_ARCH_AARCH64 || IA_ARCH_ARM_FMA */
@@ -4,3 +4,249 @@
 #define IA_SIMD_RVV 1
 
 #include <ia/base/types.h>
+
+/* The V extension guarantees registers of at least 128 bits, a register of LMUL=1 is used with the
+ * vector length fixed to 4 lanes of 32 bits. These types are sizeless, they can't be stored in structures
+ * or arrays, only read and written through memory. */
+typedef vfloat32m1_t s128f;
+typedef vfloat64m1_t s128d;
+typedef vint32m1_t   s128i;
+#define IA_SIMD_128 1
+#define IA_SIMD_256 0
+
+/* vector length of the 128-bit operations */
+#define IA_SIMD_RVV_VL 4
+
+/* vector loads and stores only need the alignment of an element */
+#define ia_simd_read(p)     __riscv_vle32_v_f32m1(p, IA_SIMD_RVV_VL)
+#define ia_simd_write(p,a)  __riscv_vse32_v_f32m1(p, a, IA_SIMD_RVV_VL)
+
+IA_FORCE_INLINE s128f ia_simd_set(f32 x, f32 y, f32 z, f32 w)
+{
+    f32 IA_ALIGNMENT(16) v[4] = { x, y, z, w };
+    return __riscv_vle32_v_f32m1(v, IA_SIMD_RVV_VL);
+}
+
+/* lane i of the result is lane idx[i] of a, or of b for indices above 3 */
+IA_FORCE_INLINE s128f ia_simd_shuffle_(s128f a, s128f b, u32 i0, u32 i1, u32 i2, u32 i3)
+{
+    u32 IA_ALIGNMENT(16) idx[4] = { i0, i1, i2, i3 };
+    vuint32m1_t vi = __riscv_vle32_v_u32m1(idx, IA_SIMD_RVV_VL);
+    vbool32_t from_b = __riscv_vmsgtu_vx_u32m1_b32(vi, 3u, IA_SIMD_RVV_VL);
+    vi = __riscv_vand_vx_u32m1(vi, 3u, IA_SIMD_RVV_VL);
+    s128f ra = __riscv_vrgather_vv_f32m1(a, vi, IA_SIMD_RVV_VL);
+    s128f rb = __riscv_vrgather_vv_f32m1(b, vi, IA_SIMD_RVV_VL);
+    return __riscv_vmerge_vvm_f32m1(ra, rb, from_b, IA_SIMD_RVV_VL);
+}
+
+IA_FORCE_INLINE s128f ia_simd_shuffle1_(s128f a, u32 i0, u32 i1, u32 i2, u32 i3)
+{
+    u32 IA_ALIGNMENT(16) idx[4] = { i0, i1, i2, i3 };
+    return __riscv_vrgather_vv_f32m1(a, __riscv_vle32_v_u32m1(idx, IA_SIMD_RVV_VL), IA_SIMD_RVV_VL);
+}
+
+#define ia_simd_shuffle1(xmm, z, y, x, w) \
+    ia_simd_shuffle1_(xmm, w, x, y, z)
+
+#define ia_simd_shuffle2(a, b, z0, y0, x0, w0, z1, y1, x1, w1) \
+    ia_simd_shuffle1(ia_simd_shuffle_(a, b, w0, x0, (y0) + 4, (z0) + 4), z1, y1, x1, w1)
+
+#define ia_simd_splat(x, lane) \
+    __riscv_vrgather_vx_f32m1(x, lane, IA_SIMD_RVV_VL)
+
+#define ia_simd_set1(x)             __riscv_vfmv_v_f_f32m1(x, IA_SIMD_RVV_VL)
+#define ia_simd_set1_ptr(x)         __riscv_vfmv_v_f_f32m1(*(x), IA_SIMD_RVV_VL)
+#define ia_simd_set1_rval(x)        __riscv_vfmv_v_f_f32m1(x, IA_SIMD_RVV_VL)
+#define ia_simd_splat_x(x)          ia_simd_splat(x, 0)
+#define ia_simd_splat_y(y)          ia_simd_splat(y, 1)
+#define ia_simd_splat_z(z)          ia_simd_splat(z, 2)
+#define ia_simd_splat_w(w)          ia_simd_splat(w, 3)
+
+#define IA_SIMD_NEGZEROf            ((i32)0x80000000) /* -> -0.0f */
+#define IA_SIMD_POSZEROf            ((i32)0x00000000) /* -> +0.0f */
+
+IA_FORCE_INLINE s128f ia_simd_signmask_(i32 x, i32 y, i32 z, i32 w)
+{
+    i32 IA_ALIGNMENT(16) v[4] = { w, z, y, x };
+    return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vle32_v_i32m1(v, IA_SIMD_RVV_VL));
+}
+
+#define IA_SIMD_SIGNMASKf(x,y,z,w) \
+    ia_simd_signmask_(x,y,z,w)
+
+#define ia_simd_float32x4_SIGNMASK_PNPN \
+    IA_SIMD_SIGNMASKf(IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf)
+#define ia_simd_float32x4_SIGNMASK_NPNP \
+    IA_SIMD_SIGNMASKf(IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf)
+#define ia_simd_float32x4_SIGNMASK_NPPN \
+    IA_SIMD_SIGNMASKf(IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf, IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf)
+#define ia_simd_float32x4_SIGNMASK_NEG \
+    __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vmv_v_x_i32m1(IA_SIMD_NEGZEROf, IA_SIMD_RVV_VL))
+
+#define ia_simd_zero()              __riscv_vfmv_v_f_f32m1(0.0f, IA_SIMD_RVV_VL)
+#define ia_simd_first(v)            __riscv_vfmv_f_s_f32m1_f32(v)
+
+IA_FORCE_INLINE s128f ia_simd_add(s128f a, s128f b)
+{ return __riscv_vfadd_vv_f32m1(a, b, IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_sub(s128f a, s128f b)
+{ return __riscv_vfsub_vv_f32m1(a, b, IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_mul(s128f a, s128f b)
+{ return __riscv_vfmul_vv_f32m1(a, b, IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_div(s128f a, s128f b)
+{ return __riscv_vfdiv_vv_f32m1(a, b, IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_neg(s128f x)
+{ return __riscv_vfneg_v_f32m1(x, IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_sqrt(s128f x)
+{ return __riscv_vfsqrt_v_f32m1(x, IA_SIMD_RVV_VL); }
+
+/** Reciprocal square root, the 7-bit estimate is refined by two Newton-Raphson steps to ~21 bits. */
+IA_FORCE_INLINE s128f ia_simd_rsqrt(s128f x)
+{
+    s128f r = __riscv_vfrsqrt7_v_f32m1(x, IA_SIMD_RVV_VL);
+    s128f half_x = __riscv_vfmul_vf_f32m1(x, 0.5f, IA_SIMD_RVV_VL);
+    for (i32 i = 0; i < 2; i++) {
+        /* r' = r * (1.5 - 0.5 * x * r * r) */
+        s128f t = __riscv_vfmul_vv_f32m1(__riscv_vfmul_vv_f32m1(half_x, r, IA_SIMD_RVV_VL), r, IA_SIMD_RVV_VL);
+        r = __riscv_vfmul_vv_f32m1(r, __riscv_vfrsub_vf_f32m1(t, 1.5f, IA_SIMD_RVV_VL), IA_SIMD_RVV_VL);
+    }
+    return r;
+}
+
+IA_FORCE_INLINE s128f ia_simd_abs(s128f x)
+{ return __riscv_vfabs_v_f32m1(x, IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_min(s128f a, s128f b)
+{ return __riscv_vfmin_vv_f32m1(a, b, IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_max(s128f a, s128f b)
+{ return __riscv_vfmax_vv_f32m1(a, b, IA_SIMD_RVV_VL); }
+
+/* masks are kept in float registers like on the other targets, not in mask registers */
+IA_FORCE_INLINE s128f ia_simd_mask_(vbool32_t m)
+{
+    vint32m1_t zero = __riscv_vmv_v_x_i32m1(0, IA_SIMD_RVV_VL);
+    return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vmerge_vxm_i32m1(zero, -1, m, IA_SIMD_RVV_VL));
+}
+
+/** Lanes of `b` where the lanes of `mask` are all ones, lanes of `a` where they're zero. */
+IA_FORCE_INLINE s128f ia_simd_select(s128f a, s128f b, s128f mask)
+{
+    vbool32_t m = __riscv_vmslt_vx_i32m1_b32(__riscv_vreinterpret_v_f32m1_i32m1(mask), 0, IA_SIMD_RVV_VL);
+    return __riscv_vmerge_vvm_f32m1(a, b, m, IA_SIMD_RVV_VL);
+}
+
+IA_FORCE_INLINE s128f ia_simd_and(s128f a, s128f b)
+{
+    return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vand_vv_i32m1(
+        __riscv_vreinterpret_v_f32m1_i32m1(a), __riscv_vreinterpret_v_f32m1_i32m1(b), IA_SIMD_RVV_VL));
+}
+
+IA_FORCE_INLINE s128f ia_simd_or(s128f a, s128f b)
+{
+    return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vor_vv_i32m1(
+        __riscv_vreinterpret_v_f32m1_i32m1(a), __riscv_vreinterpret_v_f32m1_i32m1(b), IA_SIMD_RVV_VL));
+}
+
+IA_FORCE_INLINE s128f ia_simd_xor(s128f a, s128f b)
+{
+    return __riscv_vreinterpret_v_i32m1_f32m1(__riscv_vxor_vv_i32m1(
+        __riscv_vreinterpret_v_f32m1_i32m1(a), __riscv_vreinterpret_v_f32m1_i32m1(b), IA_SIMD_RVV_VL));
+}
+
+IA_FORCE_INLINE s128f ia_simd_cmpeq(s128f a, s128f b)
+{ return ia_simd_mask_(__riscv_vmfeq_vv_f32m1_b32(a, b, IA_SIMD_RVV_VL)); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpneq(s128f a, s128f b)
+{ return ia_simd_mask_(__riscv_vmfne_vv_f32m1_b32(a, b, IA_SIMD_RVV_VL)); }
+
+IA_FORCE_INLINE s128f ia_simd_cmplt(s128f a, s128f b)
+{ return ia_simd_mask_(__riscv_vmflt_vv_f32m1_b32(a, b, IA_SIMD_RVV_VL)); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpgt(s128f a, s128f b)
+{ return ia_simd_mask_(__riscv_vmfgt_vv_f32m1_b32(a, b, IA_SIMD_RVV_VL)); }
+
+/** Transposes four registers in place, the rows become columns. Rows are stored and the columns
+ *  read back with strided loads. */
+#define ia_simd_transpose(r0, r1, r2, r3) \
+    do { \
+        f32 IA_ALIGNMENT(16) t_[16]; \
+        ia_simd_write(&t_[0], r0); \
+        ia_simd_write(&t_[4], r1); \
+        ia_simd_write(&t_[8], r2); \
+        ia_simd_write(&t_[12], r3); \
+        (r0) = __riscv_vlse32_v_f32m1(&t_[0], 4 * sizeof(f32), IA_SIMD_RVV_VL); \
+        (r1) = __riscv_vlse32_v_f32m1(&t_[1], 4 * sizeof(f32), IA_SIMD_RVV_VL); \
+        (r2) = __riscv_vlse32_v_f32m1(&t_[2], 4 * sizeof(f32), IA_SIMD_RVV_VL); \
+        (r3) = __riscv_vlse32_v_f32m1(&t_[3], 4 * sizeof(f32), IA_SIMD_RVV_VL); \
+    } while (0)
+
+IA_FORCE_INLINE f32 ia_simd_hadd(s128f v)
+{
+    s128f zero = __riscv_vfmv_v_f_f32m1(0.0f, IA_SIMD_RVV_VL);
+    return __riscv_vfmv_f_s_f32m1_f32(__riscv_vfredusum_vs_f32m1_f32m1(v, zero, IA_SIMD_RVV_VL));
+}
+
+IA_FORCE_INLINE s128f ia_simd_vhadd(s128f v)
+{ return __riscv_vfmv_v_f_f32m1(ia_simd_hadd(v), IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_vhadds(s128f v)
+{ return ia_simd_vhadd(v); }
+
+IA_FORCE_INLINE f32 ia_simd_hmin(s128f v)
+{ return __riscv_vfmv_f_s_f32m1_f32(__riscv_vfredmin_vs_f32m1_f32m1(v, v, IA_SIMD_RVV_VL)); }
+
+IA_FORCE_INLINE s128f ia_simd_vhmin(s128f v)
+{ return __riscv_vfmv_v_f_f32m1(ia_simd_hmin(v), IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE f32 ia_simd_hmax(s128f v)
+{ return __riscv_vfmv_f_s_f32m1_f32(__riscv_vfredmax_vs_f32m1_f32m1(v, v, IA_SIMD_RVV_VL)); }
+
+IA_FORCE_INLINE s128f ia_simd_vhmax(s128f v)
+{ return __riscv_vfmv_v_f_f32m1(ia_simd_hmax(v), IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_vdots(s128f a, s128f b)
+{ return ia_simd_vhadd(ia_simd_mul(a, b)); }
+
+IA_FORCE_INLINE s128f ia_simd_vdot(s128f a, s128f b)
+{ return ia_simd_vhadd(ia_simd_mul(a, b)); }
+
+IA_FORCE_INLINE f32 ia_simd_dot(s128f a, s128f b)
+{ return ia_simd_hadd(ia_simd_mul(a, b)); }
+
+IA_FORCE_INLINE f32 ia_simd_norm(s128f a)
+{ return ia_simd_first(ia_simd_sqrt(ia_simd_vdot(a, a))); }
+
+IA_FORCE_INLINE f32 ia_simd_norm2(s128f a)
+{ return ia_simd_hadd(ia_simd_mul(a, a)); }
+
+IA_FORCE_INLINE f32 ia_simd_norm_one(s128f a)
+{ return ia_simd_hadd(ia_simd_abs(a)); }
+
+IA_FORCE_INLINE f32 ia_simd_norm_inf(s128f a)
+{ return ia_simd_hmax(ia_simd_abs(a)); }
+
+IA_FORCE_INLINE s128f ia_simd_read3f(f32x3 const v)
+{
+    /* the tail-undisturbed load keeps the fourth lane of zero */
+    return __riscv_vle32_v_f32m1_tu(ia_simd_zero(), v, 3);
+}
+
+IA_FORCE_INLINE void ia_simd_write3f(f32x3 v, s128f vx)
+{ __riscv_vse32_v_f32m1(v, vx, 3); }
+
+IA_FORCE_INLINE s128f ia_simd_fmadd(s128f a, s128f b, s128f c)
+{ return __riscv_vfmacc_vv_f32m1(c, a, b, IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_fnmadd(s128f a, s128f b, s128f c)
+{ return __riscv_vfnmsac_vv_f32m1(c, a, b, IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_fmsub(s128f a, s128f b, s128f c)
+{ return __riscv_vfmsac_vv_f32m1(c, a, b, IA_SIMD_RVV_VL); }
+
+IA_FORCE_INLINE s128f ia_simd_fnmsub(s128f a, s128f b, s128f c)
+{ return __riscv_vfnmacc_vv_f32m1(c, a, b, IA_SIMD_RVV_VL); }
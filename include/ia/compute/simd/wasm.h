@@ -4,3 +4,215 @@
 #define IA_SIMD_WASM 1
 
 #include <ia/base/types.h>
+
+/* WebAssembly has one 128-bit type for every lane type */
+typedef v128_t s128f;
+typedef v128_t s128d;
+typedef v128_t s128i;
+#define IA_SIMD_128 1
+#define IA_SIMD_256 0
+
+/* wasm loads and stores don't care about alignment */
+#define ia_simd_read(p)     wasm_v128_load(p)
+#define ia_simd_write(p,a)  wasm_v128_store(p,a)
+
+#define ia_simd_shuffle1(xmm, z, y, x, w) \
+    wasm_i32x4_shuffle(xmm, xmm, w, x, y, z)
+
+#define ia_simd_shuffle2(a, b, z0, y0, x0, w0, z1, y1, x1, w1) \
+    ia_simd_shuffle1(wasm_i32x4_shuffle(a, b, w0, x0, (y0) + 4, (z0) + 4), z1, y1, x1, w1)
+
+#define ia_simd_splat(x, lane) \
+    ia_simd_shuffle1(x, lane, lane, lane, lane)
+
+#define ia_simd_set1(x)             wasm_f32x4_splat(x)
+#define ia_simd_set1_ptr(x)         wasm_v128_load32_splat(x)
+#define ia_simd_set1_rval(x)        wasm_f32x4_splat(x)
+#define ia_simd_splat_x(x)          ia_simd_splat(x, 0)
+#define ia_simd_splat_y(y)          ia_simd_splat(y, 1)
+#define ia_simd_splat_z(z)          ia_simd_splat(z, 2)
+#define ia_simd_splat_w(w)          ia_simd_splat(w, 3)
+
+#define IA_SIMD_NEGZEROf            ((i32)0x80000000) /* -> -0.0f */
+#define IA_SIMD_POSZEROf            ((i32)0x00000000) /* -> +0.0f */
+
+#define IA_SIMD_SIGNMASKf(x,y,z,w) \
+    wasm_i32x4_make(w,z,y,x)
+
+#define ia_simd_float32x4_SIGNMASK_PNPN \
+    IA_SIMD_SIGNMASKf(IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf)
+#define ia_simd_float32x4_SIGNMASK_NPNP \
+    IA_SIMD_SIGNMASKf(IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf)
+#define ia_simd_float32x4_SIGNMASK_NPPN \
+    IA_SIMD_SIGNMASKf(IA_SIMD_NEGZEROf, IA_SIMD_POSZEROf, IA_SIMD_POSZEROf, IA_SIMD_NEGZEROf)
+#define ia_simd_float32x4_SIGNMASK_NEG  wasm_i32x4_splat(IA_SIMD_NEGZEROf)
+
+#define ia_simd_zero()              wasm_f32x4_splat(0.0f)
+#define ia_simd_set(x, y, z, w)     wasm_f32x4_make(x, y, z, w)
+#define ia_simd_first(v)            wasm_f32x4_extract_lane(v, 0)
+
+IA_FORCE_INLINE s128f ia_simd_add(s128f a, s128f b)
+{ return wasm_f32x4_add(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_sub(s128f a, s128f b)
+{ return wasm_f32x4_sub(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_mul(s128f a, s128f b)
+{ return wasm_f32x4_mul(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_div(s128f a, s128f b)
+{ return wasm_f32x4_div(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_neg(s128f x)
+{ return wasm_f32x4_neg(x); }
+
+IA_FORCE_INLINE s128f ia_simd_sqrt(s128f x)
+{ return wasm_f32x4_sqrt(x); }
+
+/** Reciprocal square root, there is no estimate in wasm so it is exact. */
+IA_FORCE_INLINE s128f ia_simd_rsqrt(s128f x)
+{ return wasm_f32x4_div(wasm_f32x4_splat(1.0f), wasm_f32x4_sqrt(x)); }
+
+IA_FORCE_INLINE s128f ia_simd_abs(s128f x)
+{ return wasm_f32x4_abs(x); }
+
+/* pmin and pmax are the comparisons of minps and maxps with the operands swapped, they are a single
+ * instruction on x86 hosts where min and max need a NaN fixup */
+IA_FORCE_INLINE s128f ia_simd_min(s128f a, s128f b)
+{ return wasm_f32x4_pmin(b, a); }
+
+IA_FORCE_INLINE s128f ia_simd_max(s128f a, s128f b)
+{ return wasm_f32x4_pmax(b, a); }
+
+/** Lanes of `b` where the lanes of `mask` are all ones, lanes of `a` where they're zero. */
+IA_FORCE_INLINE s128f ia_simd_select(s128f a, s128f b, s128f mask)
+{
+#ifdef IA_ARCH_WASM_RELAXED_SIMD
+    return wasm_i32x4_relaxed_laneselect(b, a, mask);
+#else
+    return wasm_v128_bitselect(b, a, mask);
+#endif /* IA_ARCH_WASM_RELAXED_SIMD */
+}
+
+IA_FORCE_INLINE s128f ia_simd_and(s128f a, s128f b)
+{ return wasm_v128_and(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_or(s128f a, s128f b)
+{ return wasm_v128_or(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_xor(s128f a, s128f b)
+{ return wasm_v128_xor(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpeq(s128f a, s128f b)
+{ return wasm_f32x4_eq(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpneq(s128f a, s128f b)
+{ return wasm_f32x4_ne(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_cmplt(s128f a, s128f b)
+{ return wasm_f32x4_lt(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpgt(s128f a, s128f b)
+{ return wasm_f32x4_gt(a, b); }
+
+/** Transposes four registers in place, the rows become columns. */
+#define ia_simd_transpose(r0, r1, r2, r3) \
+    do { \
+        s128f t0_ = wasm_i32x4_shuffle(r0, r1, 0, 4, 1, 5); /* [r0.x r1.x r0.y r1.y] */ \
+        s128f t1_ = wasm_i32x4_shuffle(r2, r3, 0, 4, 1, 5); \
+        s128f t2_ = wasm_i32x4_shuffle(r0, r1, 2, 6, 3, 7); /* [r0.z r1.z r0.w r1.w] */ \
+        s128f t3_ = wasm_i32x4_shuffle(r2, r3, 2, 6, 3, 7); \
+        (r0) = wasm_i32x4_shuffle(t0_, t1_, 0, 1, 4, 5); \
+        (r1) = wasm_i32x4_shuffle(t0_, t1_, 2, 3, 6, 7); \
+        (r2) = wasm_i32x4_shuffle(t2_, t3_, 0, 1, 4, 5); \
+        (r3) = wasm_i32x4_shuffle(t2_, t3_, 2, 3, 6, 7); \
+    } while (0)
+
+IA_FORCE_INLINE s128f ia_simd_vhadd(s128f v)
+{
+    s128f x0;
+    x0 = wasm_f32x4_add(v, ia_simd_shuffle1(v, 1, 0, 3, 2));
+    return wasm_f32x4_add(x0, ia_simd_shuffle1(x0, 2, 3, 0, 1));
+}
+
+IA_FORCE_INLINE s128f ia_simd_vhadds(s128f v)
+{ return ia_simd_vhadd(v); }
+
+IA_FORCE_INLINE f32 ia_simd_hadd(s128f v)
+{ return wasm_f32x4_extract_lane(ia_simd_vhadd(v), 0); }
+
+IA_FORCE_INLINE s128f ia_simd_vhmin(s128f v)
+{
+    s128f x0;
+    x0 = ia_simd_min(v, ia_simd_shuffle1(v, 1, 0, 3, 2));
+    return ia_simd_min(x0, ia_simd_shuffle1(x0, 2, 3, 0, 1));
+}
+
+IA_FORCE_INLINE f32 ia_simd_hmin(s128f v)
+{ return wasm_f32x4_extract_lane(ia_simd_vhmin(v), 0); }
+
+IA_FORCE_INLINE s128f ia_simd_vhmax(s128f v)
+{
+    s128f x0;
+    x0 = ia_simd_max(v, ia_simd_shuffle1(v, 1, 0, 3, 2));
+    return ia_simd_max(x0, ia_simd_shuffle1(x0, 2, 3, 0, 1));
+}
+
+IA_FORCE_INLINE f32 ia_simd_hmax(s128f v)
+{ return wasm_f32x4_extract_lane(ia_simd_vhmax(v), 0); }
+
+IA_FORCE_INLINE s128f ia_simd_vdots(s128f a, s128f b)
+{ return ia_simd_vhadd(wasm_f32x4_mul(a, b)); }
+
+IA_FORCE_INLINE s128f ia_simd_vdot(s128f a, s128f b)
+{ return ia_simd_vhadd(wasm_f32x4_mul(a, b)); }
+
+IA_FORCE_INLINE f32 ia_simd_dot(s128f a, s128f b)
+{ return ia_simd_hadd(wasm_f32x4_mul(a, b)); }
+
+IA_FORCE_INLINE f32 ia_simd_norm(s128f a)
+{ return wasm_f32x4_extract_lane(wasm_f32x4_sqrt(ia_simd_vdot(a, a)), 0); }
+
+IA_FORCE_INLINE f32 ia_simd_norm2(s128f a)
+{ return ia_simd_hadd(wasm_f32x4_mul(a, a)); }
+
+IA_FORCE_INLINE f32 ia_simd_norm_one(s128f a)
+{ return ia_simd_hadd(wasm_f32x4_abs(a)); }
+
+IA_FORCE_INLINE f32 ia_simd_norm_inf(s128f a)
+{ return ia_simd_hmax(wasm_f32x4_abs(a)); }
+
+IA_FORCE_INLINE s128f ia_simd_read3f(f32x3 const v)
+{ return wasm_v128_load32_lane(&v[2], wasm_v128_load64_zero(v), 2); }
+
+IA_FORCE_INLINE void ia_simd_write3f(f32x3 v, s128f vx)
+{
+    wasm_v128_store64_lane(v, vx, 0);
+    wasm_v128_store32_lane(&v[2], vx, 2);
+}
+
+#ifdef IA_ARCH_WASM_RELAXED_SIMD
+IA_FORCE_INLINE s128f ia_simd_fmadd(s128f a, s128f b, s128f c)
+{ return wasm_f32x4_relaxed_madd(a, b, c); }
+
+IA_FORCE_INLINE s128f ia_simd_fnmadd(s128f a, s128f b, s128f c)
+{ return wasm_f32x4_relaxed_nmadd(a, b, c); }
+
+IA_FORCE_INLINE s128f ia_simd_fmsub(s128f a, s128f b, s128f c)
+{ return wasm_f32x4_relaxed_madd(a, b, wasm_f32x4_neg(c)); }
+
+IA_FORCE_INLINE s128f ia_simd_fnmsub(s128f a, s128f b, s128f c)
+{ return wasm_f32x4_relaxed_nmadd(a, b, wasm_f32x4_neg(c)); }
+#else
+IA_FORCE_INLINE s128f ia_simd_fmadd(s128f a, s128f b, s128f c)
+{ return wasm_f32x4_add(c, wasm_f32x4_mul(a, b)); }
+
+IA_FORCE_INLINE s128f ia_simd_fnmadd(s128f a, s128f b, s128f c)
+{ return wasm_f32x4_sub(c, wasm_f32x4_mul(a, b)); }
+
+IA_FORCE_INLINE s128f ia_simd_fmsub(s128f a, s128f b, s128f c)
+{ return wasm_f32x4_sub(wasm_f32x4_mul(a, b), c); }
+
+IA_FORCE_INLINE s128f ia_simd_fnmsub(s128f a, s128f b, s128f c)
+{ return wasm_f32x4_neg(wasm_f32x4_add(wasm_f32x4_mul(a, b), c)); }
+#endif /* IA_ARCH_WASM_RELAXED_SIMD */
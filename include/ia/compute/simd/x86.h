@@ -1,4 +1,3 @@
-#define _IA_SIMD_H_// TODO DELETE
 #ifndef _IA_SIMD_H_
 #error The `x86` SIMD header must not be included outside of `ia/compute/simd.h`
 #endif
@@ -20,6 +19,11 @@ typedef __m128i s128i;
     #define IA_SIMD_256 0
 #endif /* IA_ARCH_X86_AVX */
 
+#ifdef IA_ARCH_X86_AVX512F
+    typedef __m512  s512f;
+    typedef __m512i s512i;
+#endif /* IA_ARCH_X86_AVX512F */
+
 #ifdef IA_SIMD_UNALIGNED
     #define ia_simd_read(p)     _mm_loadu_ps(p)
     #define ia_simd_write(p,a)  _mm_storeu_ps(p,a)
@@ -72,11 +76,12 @@ typedef __m128i s128i;
 
 #ifdef IA_ARCH_X86_AVX
     #ifdef IA_SIMD_UNALIGNED
-        #define ia_simd256_read(p)  _mm256_loadu_ps(p)
-        #define ia_simd256_write(p) _mm256_storeu_ps(p)
+        #define ia_simd256_read(p)      _mm256_loadu_ps(p)
+        #define ia_simd256_write(p,a)   _mm256_storeu_ps(p,a)
+    #else
+        #define ia_simd256_read(p)      _mm256_load_ps(p)
+        #define ia_simd256_write(p,a)   _mm256_store_ps(p,a)
     #endif
-    #define ia_simd256_read(p)      _mm256_load_ps(p)
-    #define ia_simd256_write(p,a)   _mm256_store_ps(p,a)
 #endif /* IA_ARCH_X86_AVX */
 
 /* note that `0x80000000` corresponds to `INT_MIN` for a 32-bit int */
@@ -117,6 +122,34 @@ typedef __m128i s128i;
 #endif /* IA_ARCH_X86_SSE2 */
 #define ia_simd_float32x8_SIGNMASK_NEG      _mm256_castsi256_ps(_mm256_set1_epi32(IA_SIMD_NEGZEROf))
 
+#define ia_simd_zero()              _mm_setzero_ps()
+#define ia_simd_set(x, y, z, w)     _mm_set_ps(w, z, y, x)
+#define ia_simd_first(v)            _mm_cvtss_f32(v)
+
+IA_FORCE_INLINE s128f ia_simd_add(s128f a, s128f b)
+{ return _mm_add_ps(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_sub(s128f a, s128f b)
+{ return _mm_sub_ps(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_mul(s128f a, s128f b)
+{ return _mm_mul_ps(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_neg(s128f x)
+{ return _mm_xor_ps(x, ia_simd_float32x4_SIGNMASK_NEG); }
+
+IA_FORCE_INLINE s128f ia_simd_sqrt(s128f x)
+{ return _mm_sqrt_ps(x); }
+
+/** Reciprocal square root, the 12-bit estimate is refined by one Newton-Raphson step to ~21 bits. */
+IA_FORCE_INLINE s128f ia_simd_rsqrt(s128f x)
+{
+    s128f r = _mm_rsqrt_ps(x);
+    /* r' = r * (1.5 - 0.5 * x * r * r) */
+    s128f half_xr = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), r);
+    return _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half_xr, r)));
+}
+
 IA_FORCE_INLINE s128f ia_simd_abs(s128f x) 
 { return _mm_andnot_ps(ia_simd_float32x4_SIGNMASK_NEG, x); }
 
@@ -126,6 +159,41 @@ IA_FORCE_INLINE s128f ia_simd_min(s128f a, s128f b)
 IA_FORCE_INLINE s128f ia_simd_max(s128f a, s128f b) 
 { return _mm_max_ps(a, b); }
 
+/** Lanes of `b` where the lanes of `mask` are all ones, lanes of `a` where they're zero. */
+IA_FORCE_INLINE s128f ia_simd_select(s128f a, s128f b, s128f mask)
+{
+#ifdef IA_ARCH_X86_SSE4_1
+    return _mm_blendv_ps(a, b, mask);
+#else
+    return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(mask, b));
+#endif /* IA_ARCH_X86_SSE4_1 */
+}
+
+IA_FORCE_INLINE s128f ia_simd_and(s128f a, s128f b)
+{ return _mm_and_ps(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_or(s128f a, s128f b)
+{ return _mm_or_ps(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_xor(s128f a, s128f b)
+{ return _mm_xor_ps(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpeq(s128f a, s128f b)
+{ return _mm_cmpeq_ps(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpneq(s128f a, s128f b)
+{ return _mm_cmpneq_ps(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_cmplt(s128f a, s128f b)
+{ return _mm_cmplt_ps(a, b); }
+
+IA_FORCE_INLINE s128f ia_simd_cmpgt(s128f a, s128f b)
+{ return _mm_cmpgt_ps(a, b); }
+
+/** Transposes four registers in place, the rows become columns. */
+#define ia_simd_transpose(r0, r1, r2, r3) \
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3)
+
 IA_FORCE_INLINE s128f ia_simd_vhadd(s128f v) 
 {
     s128f x0;
@@ -222,18 +290,18 @@ IA_FORCE_INLINE f32 ia_simd_norm_inf(s128f a)
 { return _mm_cvtss_f32(ia_simd_vhmax(ia_simd_abs(a))); }
 
 #if defined(IA_ARCH_X86_SSE2)
-IA_FORCE_INLINE s128f ia_simd_read3f(f32x3 v)
+IA_FORCE_INLINE s128f ia_simd_read3f(f32x3 const v)
 {
     s128i xy;
     s128f z;
-    xy = _mm_loadl_epi64(ia_assume_aligned_cast(s128i const, v));
+    xy = _mm_loadl_epi64((s128i const *)v);
     z = _mm_load_ss(&v[2]);
     return _mm_movelh_ps(_mm_castsi128_ps(xy), z);
 }
 
 IA_FORCE_INLINE void ia_simd_write3f(f32x3 v, s128f vx)
 {
-    _mm_storel_pi(ia_assume_aligned_cast(__m64, v), vx);
+    _mm_storel_pi((__m64 *)v, vx);
     _mm_store_ss(&v[2], ia_simd_shuffle1(vx, 2, 2, 2, 2));
 }
 #endif /* IA_ARCH_X86_SSE2 */
@@ -313,4 +381,7 @@ IA_FORCE_INLINE s256f ia_simd256_fnmsub(s256f a, s256f b, s256f c)
     return _mm256_xor_ps(_mm256_add_ps(_mm256_mul_ps(a, b), c), ia_simd_float32x8_SIGNMASK_NEG);
 #endif /* IA_ARCH_X86_FMA */
 }
+
+IA_FORCE_INLINE s256f ia_simd256_select(s256f a, s256f b, s256f mask)
+{ return _mm256_blendv_ps(a, b, mask); }
 #endif /* IA_ARCH_X86_AVX */
@@ -0,0 +1,100 @@
+#pragma once
+/** @file ia/compute/sort.h
+ *  @brief Radix sort and sorting networks for integer keys with a payload.
+ *
+ *  Draw keys, sparse indices and event timestamps are sorted every frame. They're integers, so instead
+ *  of comparing them, an LSD (least significant digit first) radix sort distributes them by 8-bit
+ *  digits. Histograms of all digits are counted in a single read of the keys, then every digit takes
+ *  one stable scatter pass between the keys and a scratch buffer of the same size. A pass is skipped
+ *  when all keys share the digit, so small key ranges (e.g. indices below 65536) take fewer passes.
+ *  The payload is a u32, usually an index into the array of the sorted things, it's moved together
+ *  with the keys. Sorting is stable, equal keys keep their order.
+ *
+ *  [Radix Sort Revisited]
+ *  http://codercorner.com/RadixSortRevisited.htm
+ *
+ *  The parallel sort splits the keys into contiguous blocks, one per job. Every pass counts a histogram
+ *  per block, the offsets are then summed in digit-major, block-minor order, so each job scatters its
+ *  block into disjoint ranges of the target, and the sort stays stable.
+ *
+ *  Arrays of up to `IA_SORT_NETWORK_MAX` keys are sorted with a bitonic sorting network, it has no
+ *  data-dependent branches. Without a payload, u32 keys are sorted in SIMD registers (SSE4.1), four
+ *  keys at a time. Sorting networks are not stable.
+ *
+ *  [Efficient Implementation of Sorting on Multi-Core SIMD CPU Architecture]
+ *  http://www.vldb.org/pvldb/1/1454171.pdf
+ */
+#include <ia/base/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Largest count of keys sorted by a sorting network. */
+#define IA_SORT_NETWORK_MAX     16
+
+/** Upper limit of jobs of a parallel sort. */
+#define IA_SORT_MAX_JOBS        32
+
+/** Sorts up to `IA_SORT_NETWORK_MAX` keys in ascending order, `values` may be nullptr. Not stable.
+ *  Larger counts fall back to an insertion sort, use `ia_radix_sort_u32` for them. */
+IA_NONNULL(2) IA_HOT_FN IA_API void IA_CALL
+ia_sort_network_u32(
+    isize       count,
+    u32        *keys,
+    u32        *values);
+
+/** Sorts keys in ascending order, moving their values with them. The result is written to `keys`
+ *  and `values`, scratch buffers must hold `count` elements. Values and their scratch may be nullptr. */
+IA_NONNULL(2,4) IA_HOT_FN IA_API void IA_CALL
+ia_radix_sort_u32(
+    isize       count,
+    u32        *keys,
+    u32        *values,
+    u32        *keys_scratch,
+    u32        *values_scratch);
+
+/** Sorts 64-bit keys, see `ia_radix_sort_u32`. */
+IA_NONNULL(2,4) IA_HOT_FN IA_API void IA_CALL
+ia_radix_sort_u64(
+    isize       count,
+    u64        *keys,
+    u32        *values,
+    u64        *keys_scratch,
+    u32        *values_scratch);
+
+/** Sorts keys like `ia_radix_sort_u32`, using up to `job_count` jobs of the job system. It must be called
+ *  from a fiber, it yields until the sort is done. Small arrays are sorted by the calling fiber alone.
+ *  It doesn't allocate, job state of about 2 KB per job is kept on the calling fiber's stack. */
+IA_NONNULL(2,4) IA_API void IA_CALL
+ia_radix_sort_u32_parallel(
+    isize       count,
+    u32        *keys,
+    u32        *values,
+    u32        *keys_scratch,
+    u32        *values_scratch,
+    i32         job_count);
+
+/** Sorts 64-bit keys, see `ia_radix_sort_u32_parallel`. */
+IA_NONNULL(2,4) IA_API void IA_CALL
+ia_radix_sort_u64_parallel(
+    isize       count,
+    u64        *keys,
+    u32        *values,
+    u64        *keys_scratch,
+    u32        *values_scratch,
+    i32         job_count);
+
+/** Maps a float to a u32 key, that sorts in the same order as the float. */
+IA_FORCE_INLINE IA_CONST_FN u32
+ia_sort_key_f32(f32 x)
+{
+    u32 bits;
+    memcpy(&bits, &x, 4);
+    /* negative floats have all bits flipped, positive ones only the sign bit */
+    return bits ^ ((u32)((i32)bits >> 31) | 0x80000000u);
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,96 @@
+#pragma once
+/** @file ia/compute/stream.h
+ *  @brief Chunked streaming pipelines with bounded memory.
+ *
+ *  A stream is split into chunks that flow through two stages. The read stage runs sequentially
+ *  on the calling fiber and fills a staging slot with the next chunk (usually file I/O). The process
+ *  stage runs on worker threads, chunks are processed in parallel and write their results straight
+ *  into the final destination (e.g. decompress into mapped upload memory), so there are no full-size
+ *  intermediate buffers between stages.
+ *
+ *  Memory in flight is bounded by `in_flight * chunk_capacity` bytes of staging, provided by the
+ *  caller. When all slots are taken the read stage applies back-pressure: it yields on the oldest
+ *  chunk's work chain and only reuses the slot once that chunk is done. I/O of the next chunks
+ *  overlaps with processing of the previous ones.
+ *
+ *  LZ4 frames with independent blocks map naturally onto this, every block is a chunk. The read
+ *  stage walks the sequence headers of a block for its decompressed size, so its offset is known
+ *  before a worker decodes it, and blocks shorter than the maximum are allowed anywhere. For uploads into GPU memory, the destination
+ *  is the host address of a mapped buffer, as returned by `buffer_host_addresses` of the renderer.
+ */
+#include <ia/base/types.h>
+#include <ia/base/filesystem.h>
+#include <ia/compute/lz4.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Upper limit of chunks in flight, slot bookkeeping is kept on the stack. */
+#define IA_STREAM_MAX_IN_FLIGHT 64
+
+/** A single unit of work passing through the pipeline. */
+typedef struct ia_stream_chunk {
+    void               *src;        /**< Staging memory holding the chunk, written by the read stage. */
+    isize               src_size;   /**< Bytes of staging in use. */
+    i64                 index;      /**< Sequence number of the chunk, set by the pipeline. */
+    i64                 offset;     /**< Offset into the destination, set by the read stage. */
+    isize               size;       /**< Expected output size, set by the read stage. */
+    u32                 flags;      /**< Free for use by the stages. */
+} ia_stream_chunk;
+
+/** Reads the next chunk into `chunk->src`, up to `capacity` bytes. Runs sequentially on the calling fiber.
+ *  @return Number of bytes staged, 0 at the end of stream, or a negative value on failure. */
+typedef isize (IA_CALL *ia_stream_read_fn)(
+    void               *userdata,
+    ia_stream_chunk    *chunk,
+    isize               capacity);
+
+/** Processes a staged chunk on a worker thread. Chunks may be processed in any order and in parallel. */
+typedef ia_result (IA_CALL *ia_stream_process_fn)(
+    void                   *userdata,
+    ia_stream_chunk const  *chunk);
+
+/** Describes a streaming pipeline. */
+typedef struct ia_stream_info {
+    ia_stream_read_fn       read;
+    ia_stream_process_fn    process;
+    void                   *userdata;
+    void                   *staging;        /**< At least `in_flight * chunk_capacity` bytes. */
+    isize                   chunk_capacity; /**< Staging bytes available per chunk. */
+    i32                     in_flight;      /**< Chunks in flight, in range [1..IA_STREAM_MAX_IN_FLIGHT]. */
+    char const             *name;           /**< Name for the process work, for profiling. */
+} ia_stream_info;
+
+/** Runs the pipeline until the read stage ends the stream, or until any stage fails. Must be called from
+ *  a fiber of the job system, as it yields on work. After a failure no more chunks are read, and the
+ *  call returns once all chunks in flight are done.
+ *  @return The first failure of any stage, or `ia_result_success`. */
+IA_NONNULL_ALL IA_API ia_result IA_CALL
+ia_stream_run(ia_stream_info const *info);
+
+/** Returns the staging size required to stream a LZ4 frame with `in_flight` chunks, using blocks
+ *  of at most the given block size. Staging may be shared by streams that run one after another. */
+#define ia_stream_lz4_staging_size(block_size, in_flight) \
+    ((ia_lz4_block_size_bytes(block_size) + 8) * (in_flight))
+
+/** Streams a LZ4 frame from a file starting at `offset`, decompressing blocks on workers directly into
+ *  `dst`. The frame must use independent blocks, any of them may decode to less than the block size.
+ *  Block and content checksums are verified if present.
+ *  The `staging` must hold `ia_stream_lz4_staging_size(block_size, in_flight)` bytes for the block size
+ *  declared by the frame, otherwise streaming fails.
+ *  @return `ia_result_success` and the decompressed size in `out_size` if not nullptr. */
+IA_NONNULL(3,5) IA_API ia_result IA_CALL
+ia_stream_lz4_frame(
+    ia_file             file,
+    i64                 offset,
+    void               *dst,
+    isize               dst_capacity,
+    void               *staging,
+    isize               staging_size,
+    i32                 in_flight,
+    isize              *out_size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,560 @@
+#pragma once
+/** @file ia/compute/trigonometry.h
+ *  @brief Polynomial approximations of trigonometric, exponential and logarithm functions.
+ *
+ *  libm calls in per-vertex and per-sample loops (audio oscillators, camera math) are slow, and they
+ *  block auto-vectorization of the loop. These functions evaluate minimax polynomials after a range
+ *  reduction, with the coefficients of Cephes, and have no branches. There are scalar versions, that
+ *  compilers inline and vectorize, and versions over the lanes of `s128f` and `s256f` registers.
+ *  The `s256f` versions need AVX2 for the integer part of the range reduction.
+ *
+ *  [Cephes Mathematical Library]
+ *  https://www.netlib.org/cephes/
+ *
+ *  Max error against exact results, measured on 4M random arguments per function, with and without FMA:
+ *
+ *  | function      | domain                    | max error |
+ *  |---------------|---------------------------|-----------|
+ *  | sin, cos      | [-8192, 8192]             | 1.6 ULP   |
+ *  | tan           | [-64, 64]                 | 3.4 ULP   |
+ *  | atan2         | finite                    | 2.9 ULP   |
+ *  | acos          | [-1, 1]                   | 1.3 ULP   |
+ *  | exp           | [-87.3, 88.7]             | 1.3 ULP   |
+ *  | log           | positive normal floats    | 0.9 ULP   |
+ *
+ *  Near the zeros of sin, cos and tan (results below 2^-10) the error is absolute, below 2^-32,
+ *  there the error of the reduced argument dominates. Arguments of sin, cos and tan are reduced
+ *  to [-pi/4, pi/4] by subtracting a multiple of pi/2, split into three parts (Cody-Waite), the
+ *  reduction loses precision beyond the domain, tan the most as it's close to its poles. Exp underflows
+ *  gradually through denormals to zero and overflows to infinity. Log returns -infinity
+ *  for zero, infinity for infinity and NaN for negative arguments. atan2 handles signed zeros like libm.
+ *
+ *  acos takes a square root, loops with it vectorize only with `-fno-math-errno`.
+ *
+ *  The scalar versions do the same operations in the same order as the SIMD versions, the lanes match
+ *  the scalar results bit for bit as long as the compiler contracts the scalar multiply-adds, which GCC
+ *  and Clang do by default. With `-ffp-contract=off` on a target with FMA they may differ by 1 ULP.
+ */
+#include <ia/base/types.h>
+#include <ia/compute/simd.h>
+
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Cody-Waite split of pi/2, the leading parts have trailing zero bits so their products with the
+ * quadrant are exact. */
+#define _IA_TRIG_PIO2_1     1.5703125f
+#define _IA_TRIG_PIO2_2     4.837512969970703125e-4f
+#define _IA_TRIG_PIO2_3     7.54978995489188216e-8f
+/* sin and cos on [-pi/4, pi/4] */
+#define _IA_TRIG_S1         -1.9515295891e-4f
+#define _IA_TRIG_S2         8.3321608736e-3f
+#define _IA_TRIG_S3         -1.6666654611e-1f
+#define _IA_TRIG_C1         2.443315711809948e-5f
+#define _IA_TRIG_C2         -1.388731625493765e-3f
+#define _IA_TRIG_C3         4.166664568298827e-2f
+/* tan on [-pi/4, pi/4] */
+#define _IA_TRIG_T1         9.38540185543e-3f
+#define _IA_TRIG_T2         3.11992232697e-3f
+#define _IA_TRIG_T3         2.44301354525e-2f
+#define _IA_TRIG_T4         5.34112807005e-2f
+#define _IA_TRIG_T5         1.33387994085e-1f
+#define _IA_TRIG_T6         3.33331568548e-1f
+/* atan on [-tan(pi/8), tan(pi/8)] */
+#define _IA_TRIG_TAN_PI_8   0.41421356237f
+#define _IA_TRIG_A1         8.05374449538e-2f
+#define _IA_TRIG_A2         -1.38776856032e-1f
+#define _IA_TRIG_A3         1.99777106478e-1f
+#define _IA_TRIG_A4         -3.33329491539e-1f
+/* asin on [0, 0.5] */
+#define _IA_TRIG_AS1        4.2163199048e-2f
+#define _IA_TRIG_AS2        2.4181311049e-2f
+#define _IA_TRIG_AS3        4.5470025998e-2f
+#define _IA_TRIG_AS4        7.4953002686e-2f
+#define _IA_TRIG_AS5        1.6666752422e-1f
+/* exp on [-ln2/2, ln2/2], ln2 split in two parts */
+#define _IA_TRIG_EXP_LO     -104.0f
+#define _IA_TRIG_EXP_HI     88.8f
+#define _IA_TRIG_LN2_HI     0.693359375f
+#define _IA_TRIG_LN2_LO     -2.12194440e-4f
+#define _IA_TRIG_E1         1.9875691500e-4f
+#define _IA_TRIG_E2         1.3981999507e-3f
+#define _IA_TRIG_E3         8.3334519073e-3f
+#define _IA_TRIG_E4         4.1665795894e-2f
+#define _IA_TRIG_E5         1.6666665459e-1f
+#define _IA_TRIG_E6         5.0000001201e-1f
+/* log(1 + m) on [sqrt(1/2) - 1, sqrt(2) - 1] */
+#define _IA_TRIG_L1         7.0376836292e-2f
+#define _IA_TRIG_L2         -1.1514610310e-1f
+#define _IA_TRIG_L3         1.1676998740e-1f
+#define _IA_TRIG_L4         -1.2420140846e-1f
+#define _IA_TRIG_L5         1.4249322787e-1f
+#define _IA_TRIG_L6         -1.6668057665e-1f
+#define _IA_TRIG_L7         2.0000714765e-1f
+#define _IA_TRIG_L8         -2.4999993993e-1f
+#define _IA_TRIG_L9         3.3333331174e-1f
+
+IA_FORCE_INLINE IA_CONST_FN f32 ia_trig_from_bits_(u32 bits)
+{ f32 x; memcpy(&x, &bits, 4); return x; }
+
+IA_FORCE_INLINE IA_CONST_FN u32 ia_trig_to_bits_(f32 x)
+{ u32 bits; memcpy(&bits, &x, 4); return bits; }
+
+/* Rounds `x * scale` to the nearest integer for |x * scale| < 2^22. Adding 1.5 * 2^23 rounds away the
+ * fraction, the integer is in the low mantissa bits. Unlike a float to int conversion it's defined for any
+ * input, and it doesn't trap, so compilers if-convert and vectorize the loops it's in. The multiply and add
+ * are one expression, so they're fused where the SIMD versions fuse them. */
+IA_FORCE_INLINE IA_CONST_FN i32 ia_trig_round_(f32 x, f32 scale)
+{ return (i32)(ia_trig_to_bits_(x * scale + 0x1.8p23f) - 0x4b400000u); }
+
+/* Selects without a branch, the compiler can't sink the computation of `a` or `b` into one. */
+IA_FORCE_INLINE IA_CONST_FN f32 ia_trig_select_(bool c, f32 a, f32 b)
+{
+    u32 mask = -(u32)c;
+    return ia_trig_from_bits_((ia_trig_to_bits_(a) & mask) | (ia_trig_to_bits_(b) & ~mask));
+}
+
+/* Scalar versions */
+
+/** Sine and cosine of `x` radians. */
+IA_FORCE_INLINE void ia_sincosf(f32 x, f32 *s, f32 *c)
+{
+    i32 j = ia_trig_round_(x, IA_2_PIf);
+    f32 fj = (f32)j;
+    f32 r = x - fj * _IA_TRIG_PIO2_1;
+    r -= fj * _IA_TRIG_PIO2_2;
+    r -= fj * _IA_TRIG_PIO2_3;
+    f32 z = r * r;
+    f32 sp = _IA_TRIG_S1;
+    sp = sp * z + _IA_TRIG_S2;
+    sp = sp * z + _IA_TRIG_S3;
+    sp = sp * z * r + r;
+    f32 cp = _IA_TRIG_C1;
+    cp = cp * z + _IA_TRIG_C2;
+    cp = cp * z + _IA_TRIG_C3;
+    cp = cp * z * z + (1.0f - 0.5f * z);
+    /* sin(r + j * pi/2) cycles through sin r, cos r, -sin r, -cos r, cos is one quadrant ahead */
+    f32 sv = (j & 1) ? cp : sp;
+    f32 cv = (j & 1) ? sp : cp;
+    *s = (j & 2) ? -sv : sv;
+    *c = ((j + 1) & 2) ? -cv : cv;
+}
+
+IA_FORCE_INLINE f32 ia_sinf(f32 x)
+{ f32 s, c; ia_sincosf(x, &s, &c); return s; }
+
+IA_FORCE_INLINE f32 ia_cosf(f32 x)
+{ f32 s, c; ia_sincosf(x, &s, &c); return c; }
+
+IA_FORCE_INLINE f32 ia_tanf(f32 x)
+{
+    i32 j = ia_trig_round_(x, IA_2_PIf);
+    f32 fj = (f32)j;
+    f32 r = x - fj * _IA_TRIG_PIO2_1;
+    r -= fj * _IA_TRIG_PIO2_2;
+    r -= fj * _IA_TRIG_PIO2_3;
+    f32 z = r * r;
+    f32 t = _IA_TRIG_T1;
+    t = t * z + _IA_TRIG_T2;
+    t = t * z + _IA_TRIG_T3;
+    t = t * z + _IA_TRIG_T4;
+    t = t * z + _IA_TRIG_T5;
+    t = t * z + _IA_TRIG_T6;
+    t = t * z * r + r;
+    /* tan(r + pi/2) = -1 / tan(r) */
+    return (j & 1) ? -1.0f / t : t;
+}
+
+/** Angle of the vector (x, y) in radians, in [-pi, pi]. */
+IA_FORCE_INLINE f32 ia_atan2f(f32 y, f32 x)
+{
+    f32 ax = fabsf(x), ay = fabsf(y);
+    f32 lo = ax < ay ? ax : ay, hi = ax < ay ? ay : ax;
+    /* by a power of two, so lo + hi doesn't overflow and denormals keep their precision in the division */
+    f32 scale = hi > 0x1p125f ? 0.25f : hi < 0x1p-100f ? 0x1p24f : 1.0f;
+    lo *= scale;
+    hi *= scale;
+    /* atan(lo / hi) in [0, pi/4], above tan(pi/8) it's pi/4 + atan((lo - hi) / (lo + hi)) */
+    bool big = lo > _IA_TRIG_TAN_PI_8 * hi;
+    f32 den = big ? lo + hi : hi;
+    f32 t = (big ? lo - hi : lo) / (den > FLT_MIN ? den : FLT_MIN);
+    f32 z = t * t;
+    f32 p = _IA_TRIG_A1;
+    p = p * z + _IA_TRIG_A2;
+    p = p * z + _IA_TRIG_A3;
+    p = p * z + _IA_TRIG_A4;
+    f32 r = p * z * t + t;
+    r += big ? IA_PI_4f : 0.0f;
+    r = ay > ax ? IA_PI_2f - r : r;
+    r = signbit(x) ? IA_PIf - r : r;
+    return copysignf(r, y);
+}
+
+/** Arc cosine in radians, in [0, pi]. */
+IA_FORCE_INLINE f32 ia_acosf(f32 x)
+{
+    f32 ax = fabsf(x);
+    /* asin(s) for s in [0, 0.5], above 0.5 it's acos(|x|) = 2 * asin(sqrt((1 - |x|) / 2)) */
+    bool big = ax > 0.5f;
+    f32 z = big ? 0.5f * (1.0f - ax) : x * x;
+    f32 s = big ? sqrtf(z) : ax;
+    f32 p = _IA_TRIG_AS1;
+    p = p * z + _IA_TRIG_AS2;
+    p = p * z + _IA_TRIG_AS3;
+    p = p * z + _IA_TRIG_AS4;
+    p = p * z + _IA_TRIG_AS5;
+    p = p * z * s + s;
+    f32 rb = signbit(x) ? IA_PIf - 2.0f * p : 2.0f * p;
+    return big ? rb : IA_PI_2f - copysignf(p, x);
+}
+
+IA_FORCE_INLINE f32 ia_expf(f32 x)
+{
+    /* not fminf and fmaxf, those are libm calls that keep loops from vectorizing, a NaN passes through */
+    f32 xc = ia_trig_select_(x < _IA_TRIG_EXP_LO, _IA_TRIG_EXP_LO, x);
+    xc = ia_trig_select_(xc > _IA_TRIG_EXP_HI, _IA_TRIG_EXP_HI, xc);
+    i32 n = ia_trig_round_(xc, IA_LOG2Ef);
+    f32 fn = (f32)n;
+    f32 r = xc - fn * _IA_TRIG_LN2_HI;
+    r -= fn * _IA_TRIG_LN2_LO;
+    f32 p = _IA_TRIG_E1;
+    p = p * r + _IA_TRIG_E2;
+    p = p * r + _IA_TRIG_E3;
+    p = p * r + _IA_TRIG_E4;
+    p = p * r + _IA_TRIG_E5;
+    p = p * r + _IA_TRIG_E6;
+    p = p * r * r + (r + 1.0f);
+    /* 2^n in two normal factors, n is in [-150, 128], the product underflows gradually */
+    i32 n1 = n >> 1;
+    p *= ia_trig_from_bits_((u32)(n1 + 127) << 23);
+    return p * ia_trig_from_bits_((u32)(n - n1 + 127) << 23);
+}
+
+/** Natural logarithm. */
+IA_FORCE_INLINE f32 ia_logf(f32 x)
+{
+    /* x = m * 2^e with m in [sqrt(1/2), sqrt(2)) */
+    u32 bits = ia_trig_to_bits_(x);
+    i32 e = (i32)((bits >> 23) & 0xff) - 126;
+    f32 m = ia_trig_from_bits_((bits & 0x007fffffu) | 0x3f000000u);
+    bool lo = m < IA_SQRT1_2f;
+    e -= lo;
+    m = (lo ? m + m : m) - 1.0f;
+    f32 fe = (f32)e;
+    f32 z = m * m;
+    f32 p = _IA_TRIG_L1;
+    p = p * m + _IA_TRIG_L2;
+    p = p * m + _IA_TRIG_L3;
+    p = p * m + _IA_TRIG_L4;
+    p = p * m + _IA_TRIG_L5;
+    p = p * m + _IA_TRIG_L6;
+    p = p * m + _IA_TRIG_L7;
+    p = p * m + _IA_TRIG_L8;
+    p = p * m + _IA_TRIG_L9;
+    p = p * m * z + fe * _IA_TRIG_LN2_LO - 0.5f * z;
+    f32 r = m + p + fe * _IA_TRIG_LN2_HI;
+    /* the split above reads infinity as a finite 2^128 */
+    r = ia_trig_select_(x == INFINITY, INFINITY, r);
+    return ia_trig_select_(x > 0.0f, r, x == 0.0f ? -INFINITY : NAN);
+}
+
+#if defined(IA_SIMD_X86)
+/* s128f versions */
+
+/* ia_trig_round_() over the lanes */
+IA_FORCE_INLINE s128i ia_simd_trig_round_(s128f x, f32 scale)
+{
+    s128f t = ia_simd_fmadd(x, ia_simd_set1_rval(scale), ia_simd_set1_rval(0x1.8p23f));
+    return _mm_sub_epi32(_mm_castps_si128(t), _mm_set1_epi32(0x4b400000));
+}
+
+/** Sine and cosine of the lanes of `x` in radians. */
+IA_FORCE_INLINE void ia_simd_sincos(s128f x, s128f *s, s128f *c)
+{
+    s128i j = ia_simd_trig_round_(x, IA_2_PIf);
+    s128f fj = _mm_cvtepi32_ps(j);
+    s128f r = ia_simd_fnmadd(fj, ia_simd_set1_rval(_IA_TRIG_PIO2_1), x);
+    r = ia_simd_fnmadd(fj, ia_simd_set1_rval(_IA_TRIG_PIO2_2), r);
+    r = ia_simd_fnmadd(fj, ia_simd_set1_rval(_IA_TRIG_PIO2_3), r);
+    s128f z = ia_simd_mul(r, r);
+    s128f sp = ia_simd_fmadd(z, ia_simd_set1_rval(_IA_TRIG_S1), ia_simd_set1_rval(_IA_TRIG_S2));
+    sp = ia_simd_fmadd(sp, z, ia_simd_set1_rval(_IA_TRIG_S3));
+    sp = ia_simd_fmadd(ia_simd_mul(sp, z), r, r);
+    s128f cp = ia_simd_fmadd(z, ia_simd_set1_rval(_IA_TRIG_C1), ia_simd_set1_rval(_IA_TRIG_C2));
+    cp = ia_simd_fmadd(cp, z, ia_simd_set1_rval(_IA_TRIG_C3));
+    cp = ia_simd_fmadd(ia_simd_mul(cp, z), z, ia_simd_fnmadd(z, ia_simd_set1_rval(0.5f), ia_simd_set1_rval(1.0f)));
+    s128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+    s128f swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, one), one));
+    s128f sign_s = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, two), 30));
+    s128f sign_c = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, one), two), 30));
+    *s = _mm_xor_ps(ia_simd_select(sp, cp, swap), sign_s);
+    *c = _mm_xor_ps(ia_simd_select(cp, sp, swap), sign_c);
+}
+
+IA_FORCE_INLINE s128f ia_simd_sin(s128f x)
+{ s128f s, c; ia_simd_sincos(x, &s, &c); return s; }
+
+IA_FORCE_INLINE s128f ia_simd_cos(s128f x)
+{ s128f s, c; ia_simd_sincos(x, &s, &c); return c; }
+
+IA_FORCE_INLINE s128f ia_simd_tan(s128f x)
+{
+    s128i j = ia_simd_trig_round_(x, IA_2_PIf);
+    s128f fj = _mm_cvtepi32_ps(j);
+    s128f r = ia_simd_fnmadd(fj, ia_simd_set1_rval(_IA_TRIG_PIO2_1), x);
+    r = ia_simd_fnmadd(fj, ia_simd_set1_rval(_IA_TRIG_PIO2_2), r);
+    r = ia_simd_fnmadd(fj, ia_simd_set1_rval(_IA_TRIG_PIO2_3), r);
+    s128f z = ia_simd_mul(r, r);
+    s128f t = ia_simd_fmadd(z, ia_simd_set1_rval(_IA_TRIG_T1), ia_simd_set1_rval(_IA_TRIG_T2));
+    t = ia_simd_fmadd(t, z, ia_simd_set1_rval(_IA_TRIG_T3));
+    t = ia_simd_fmadd(t, z, ia_simd_set1_rval(_IA_TRIG_T4));
+    t = ia_simd_fmadd(t, z, ia_simd_set1_rval(_IA_TRIG_T5));
+    t = ia_simd_fmadd(t, z, ia_simd_set1_rval(_IA_TRIG_T6));
+    t = ia_simd_fmadd(ia_simd_mul(t, z), r, r);
+    s128i one = _mm_set1_epi32(1);
+    s128f odd = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, one), one));
+    return ia_simd_select(t, ia_simd_div(ia_simd_set1_rval(-1.0f), t), odd);
+}
+
+IA_FORCE_INLINE s128f ia_simd_atan2(s128f y, s128f x)
+{
+    s128f ax = ia_simd_abs(x), ay = ia_simd_abs(y);
+    s128f lo = ia_simd_min(ax, ay), hi = ia_simd_max(ax, ay);
+    s128f scale = ia_simd_select(ia_simd_set1_rval(1.0f), ia_simd_set1_rval(0.25f), _mm_cmpgt_ps(hi, ia_simd_set1_rval(0x1p125f)));
+    scale = ia_simd_select(scale, ia_simd_set1_rval(0x1p24f), _mm_cmplt_ps(hi, ia_simd_set1_rval(0x1p-100f)));
+    lo = ia_simd_mul(lo, scale);
+    hi = ia_simd_mul(hi, scale);
+    s128f big = _mm_cmpgt_ps(lo, ia_simd_mul(hi, ia_simd_set1_rval(_IA_TRIG_TAN_PI_8)));
+    s128f num = ia_simd_select(lo, ia_simd_sub(lo, hi), big);
+    s128f den = ia_simd_max(ia_simd_select(hi, ia_simd_add(lo, hi), big), ia_simd_set1_rval(FLT_MIN));
+    s128f t = ia_simd_div(num, den);
+    s128f z = ia_simd_mul(t, t);
+    s128f p = ia_simd_fmadd(z, ia_simd_set1_rval(_IA_TRIG_A1), ia_simd_set1_rval(_IA_TRIG_A2));
+    p = ia_simd_fmadd(p, z, ia_simd_set1_rval(_IA_TRIG_A3));
+    p = ia_simd_fmadd(p, z, ia_simd_set1_rval(_IA_TRIG_A4));
+    s128f r = ia_simd_fmadd(ia_simd_mul(p, z), t, t);
+    r = ia_simd_add(r, _mm_and_ps(big, ia_simd_set1_rval(IA_PI_4f)));
+    r = ia_simd_select(r, ia_simd_sub(ia_simd_set1_rval(IA_PI_2f), r), _mm_cmpgt_ps(ay, ax));
+    s128f x_neg = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(x), 31));
+    r = ia_simd_select(r, ia_simd_sub(ia_simd_set1_rval(IA_PIf), r), x_neg);
+    return _mm_or_ps(r, _mm_and_ps(y, ia_simd_float32x4_SIGNMASK_NEG));
+}
+
+IA_FORCE_INLINE s128f ia_simd_acos(s128f x)
+{
+    s128f ax = ia_simd_abs(x);
+    s128f big = _mm_cmpgt_ps(ax, ia_simd_set1_rval(0.5f));
+    s128f z = ia_simd_select(ia_simd_mul(x, x), ia_simd_mul(ia_simd_sub(ia_simd_set1_rval(1.0f), ax), ia_simd_set1_rval(0.5f)), big);
+    s128f s = ia_simd_select(ax, ia_simd_sqrt(z), big);
+    s128f p = ia_simd_fmadd(z, ia_simd_set1_rval(_IA_TRIG_AS1), ia_simd_set1_rval(_IA_TRIG_AS2));
+    p = ia_simd_fmadd(p, z, ia_simd_set1_rval(_IA_TRIG_AS3));
+    p = ia_simd_fmadd(p, z, ia_simd_set1_rval(_IA_TRIG_AS4));
+    p = ia_simd_fmadd(p, z, ia_simd_set1_rval(_IA_TRIG_AS5));
+    p = ia_simd_fmadd(ia_simd_mul(p, z), s, s);
+    s128f sign = _mm_and_ps(x, ia_simd_float32x4_SIGNMASK_NEG);
+    s128f x_neg = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(x), 31));
+    s128f p2 = ia_simd_add(p, p);
+    s128f rb = ia_simd_select(p2, ia_simd_sub(ia_simd_set1_rval(IA_PIf), p2), x_neg);
+    s128f rs = ia_simd_sub(ia_simd_set1_rval(IA_PI_2f), _mm_or_ps(p, sign));
+    return ia_simd_select(rs, rb, big);
+}
+
+IA_FORCE_INLINE s128f ia_simd_exp(s128f x)
+{
+    s128f xc = ia_simd_max(ia_simd_set1_rval(_IA_TRIG_EXP_LO), ia_simd_min(ia_simd_set1_rval(_IA_TRIG_EXP_HI), x));
+    s128i n = ia_simd_trig_round_(xc, IA_LOG2Ef);
+    s128f fn = _mm_cvtepi32_ps(n);
+    s128f r = ia_simd_fnmadd(fn, ia_simd_set1_rval(_IA_TRIG_LN2_HI), xc);
+    r = ia_simd_fnmadd(fn, ia_simd_set1_rval(_IA_TRIG_LN2_LO), r);
+    s128f p = ia_simd_fmadd(r, ia_simd_set1_rval(_IA_TRIG_E1), ia_simd_set1_rval(_IA_TRIG_E2));
+    p = ia_simd_fmadd(p, r, ia_simd_set1_rval(_IA_TRIG_E3));
+    p = ia_simd_fmadd(p, r, ia_simd_set1_rval(_IA_TRIG_E4));
+    p = ia_simd_fmadd(p, r, ia_simd_set1_rval(_IA_TRIG_E5));
+    p = ia_simd_fmadd(p, r, ia_simd_set1_rval(_IA_TRIG_E6));
+    p = ia_simd_fmadd(ia_simd_mul(p, r), r, ia_simd_add(r, ia_simd_set1_rval(1.0f)));
+    s128i bias = _mm_set1_epi32(127);
+    s128i n1 = _mm_srai_epi32(n, 1);
+    p = ia_simd_mul(p, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n1, bias), 23)));
+    return ia_simd_mul(p, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_sub_epi32(n, n1), bias), 23)));
+}
+
+IA_FORCE_INLINE s128f ia_simd_log(s128f x)
+{
+    s128i bits = _mm_castps_si128(x);
+    s128i e = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff)), _mm_set1_epi32(126));
+    s128f m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f000000)));
+    s128f lo = _mm_cmplt_ps(m, ia_simd_set1_rval(IA_SQRT1_2f));
+    /* the all ones mask is -1 */
+    e = _mm_add_epi32(e, _mm_castps_si128(lo));
+    m = ia_simd_sub(ia_simd_add(m, _mm_and_ps(lo, m)), ia_simd_set1_rval(1.0f));
+    s128f fe = _mm_cvtepi32_ps(e);
+    s128f z = ia_simd_mul(m, m);
+    s128f p = ia_simd_fmadd(m, ia_simd_set1_rval(_IA_TRIG_L1), ia_simd_set1_rval(_IA_TRIG_L2));
+    p = ia_simd_fmadd(p, m, ia_simd_set1_rval(_IA_TRIG_L3));
+    p = ia_simd_fmadd(p, m, ia_simd_set1_rval(_IA_TRIG_L4));
+    p = ia_simd_fmadd(p, m, ia_simd_set1_rval(_IA_TRIG_L5));
+    p = ia_simd_fmadd(p, m, ia_simd_set1_rval(_IA_TRIG_L6));
+    p = ia_simd_fmadd(p, m, ia_simd_set1_rval(_IA_TRIG_L7));
+    p = ia_simd_fmadd(p, m, ia_simd_set1_rval(_IA_TRIG_L8));
+    p = ia_simd_fmadd(p, m, ia_simd_set1_rval(_IA_TRIG_L9));
+    p = ia_simd_fmadd(ia_simd_mul(p, m), z, ia_simd_mul(fe, ia_simd_set1_rval(_IA_TRIG_LN2_LO)));
+    p = ia_simd_fnmadd(z, ia_simd_set1_rval(0.5f), p);
+    s128f r = ia_simd_fmadd(fe, ia_simd_set1_rval(_IA_TRIG_LN2_HI), ia_simd_add(m, p));
+    r = ia_simd_select(r, _mm_set1_ps(INFINITY), _mm_cmpeq_ps(x, _mm_set1_ps(INFINITY)));
+    r = ia_simd_select(_mm_set1_ps(NAN), r, _mm_cmpgt_ps(x, ia_simd_zero()));
+    return ia_simd_select(r, _mm_set1_ps(-INFINITY), _mm_cmpeq_ps(x, ia_simd_zero()));
+}
+
+#if defined(IA_ARCH_X86_AVX2)
+/* s256f versions */
+
+IA_FORCE_INLINE s256i ia_simd256_trig_round_(s256f x, f32 scale)
+{
+    s256f t = ia_simd256_fmadd(x, _mm256_set1_ps(scale), _mm256_set1_ps(0x1.8p23f));
+    return _mm256_sub_epi32(_mm256_castps_si256(t), _mm256_set1_epi32(0x4b400000));
+}
+
+IA_FORCE_INLINE void ia_simd256_sincos(s256f x, s256f *s, s256f *c)
+{
+    s256i j = ia_simd256_trig_round_(x, IA_2_PIf);
+    s256f fj = _mm256_cvtepi32_ps(j);
+    s256f r = ia_simd256_fnmadd(fj, _mm256_set1_ps(_IA_TRIG_PIO2_1), x);
+    r = ia_simd256_fnmadd(fj, _mm256_set1_ps(_IA_TRIG_PIO2_2), r);
+    r = ia_simd256_fnmadd(fj, _mm256_set1_ps(_IA_TRIG_PIO2_3), r);
+    s256f z = _mm256_mul_ps(r, r);
+    s256f sp = ia_simd256_fmadd(z, _mm256_set1_ps(_IA_TRIG_S1), _mm256_set1_ps(_IA_TRIG_S2));
+    sp = ia_simd256_fmadd(sp, z, _mm256_set1_ps(_IA_TRIG_S3));
+    sp = ia_simd256_fmadd(_mm256_mul_ps(sp, z), r, r);
+    s256f cp = ia_simd256_fmadd(z, _mm256_set1_ps(_IA_TRIG_C1), _mm256_set1_ps(_IA_TRIG_C2));
+    cp = ia_simd256_fmadd(cp, z, _mm256_set1_ps(_IA_TRIG_C3));
+    cp = ia_simd256_fmadd(_mm256_mul_ps(cp, z), z, ia_simd256_fnmadd(z, _mm256_set1_ps(0.5f), _mm256_set1_ps(1.0f)));
+    s256i one = _mm256_set1_epi32(1), two = _mm256_set1_epi32(2);
+    s256f swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, one), one));
+    s256f sign_s = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, two), 30));
+    s256f sign_c = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(j, one), two), 30));
+    *s = _mm256_xor_ps(ia_simd256_select(sp, cp, swap), sign_s);
+    *c = _mm256_xor_ps(ia_simd256_select(cp, sp, swap), sign_c);
+}
+
+IA_FORCE_INLINE s256f ia_simd256_sin(s256f x)
+{ s256f s, c; ia_simd256_sincos(x, &s, &c); return s; }
+
+IA_FORCE_INLINE s256f ia_simd256_cos(s256f x)
+{ s256f s, c; ia_simd256_sincos(x, &s, &c); return c; }
+
+IA_FORCE_INLINE s256f ia_simd256_tan(s256f x)
+{
+    s256i j = ia_simd256_trig_round_(x, IA_2_PIf);
+    s256f fj = _mm256_cvtepi32_ps(j);
+    s256f r = ia_simd256_fnmadd(fj, _mm256_set1_ps(_IA_TRIG_PIO2_1), x);
+    r = ia_simd256_fnmadd(fj, _mm256_set1_ps(_IA_TRIG_PIO2_2), r);
+    r = ia_simd256_fnmadd(fj, _mm256_set1_ps(_IA_TRIG_PIO2_3), r);
+    s256f z = _mm256_mul_ps(r, r);
+    s256f t = ia_simd256_fmadd(z, _mm256_set1_ps(_IA_TRIG_T1), _mm256_set1_ps(_IA_TRIG_T2));
+    t = ia_simd256_fmadd(t, z, _mm256_set1_ps(_IA_TRIG_T3));
+    t = ia_simd256_fmadd(t, z, _mm256_set1_ps(_IA_TRIG_T4));
+    t = ia_simd256_fmadd(t, z, _mm256_set1_ps(_IA_TRIG_T5));
+    t = ia_simd256_fmadd(t, z, _mm256_set1_ps(_IA_TRIG_T6));
+    t = ia_simd256_fmadd(_mm256_mul_ps(t, z), r, r);
+    s256i one = _mm256_set1_epi32(1);
+    s256f odd = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, one), one));
+    return ia_simd256_select(t, _mm256_div_ps(_mm256_set1_ps(-1.0f), t), odd);
+}
+
+IA_FORCE_INLINE s256f ia_simd256_atan2(s256f y, s256f x)
+{
+    s256f ax = _mm256_andnot_ps(ia_simd_float32x8_SIGNMASK_NEG, x);
+    s256f ay = _mm256_andnot_ps(ia_simd_float32x8_SIGNMASK_NEG, y);
+    s256f lo = _mm256_min_ps(ax, ay), hi = _mm256_max_ps(ax, ay);
+    s256f scale = ia_simd256_select(_mm256_set1_ps(1.0f), _mm256_set1_ps(0.25f), _mm256_cmp_ps(hi, _mm256_set1_ps(0x1p125f), _CMP_GT_OQ));
+    scale = ia_simd256_select(scale, _mm256_set1_ps(0x1p24f), _mm256_cmp_ps(hi, _mm256_set1_ps(0x1p-100f), _CMP_LT_OQ));
+    lo = _mm256_mul_ps(lo, scale);
+    hi = _mm256_mul_ps(hi, scale);
+    s256f big = _mm256_cmp_ps(lo, _mm256_mul_ps(hi, _mm256_set1_ps(_IA_TRIG_TAN_PI_8)), _CMP_GT_OQ);
+    s256f num = ia_simd256_select(lo, _mm256_sub_ps(lo, hi), big);
+    s256f den = _mm256_max_ps(ia_simd256_select(hi, _mm256_add_ps(lo, hi), big), _mm256_set1_ps(FLT_MIN));
+    s256f t = _mm256_div_ps(num, den);
+    s256f z = _mm256_mul_ps(t, t);
+    s256f p = ia_simd256_fmadd(z, _mm256_set1_ps(_IA_TRIG_A1), _mm256_set1_ps(_IA_TRIG_A2));
+    p = ia_simd256_fmadd(p, z, _mm256_set1_ps(_IA_TRIG_A3));
+    p = ia_simd256_fmadd(p, z, _mm256_set1_ps(_IA_TRIG_A4));
+    s256f r = ia_simd256_fmadd(_mm256_mul_ps(p, z), t, t);
+    r = _mm256_add_ps(r, _mm256_and_ps(big, _mm256_set1_ps(IA_PI_4f)));
+    r = ia_simd256_select(r, _mm256_sub_ps(_mm256_set1_ps(IA_PI_2f), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    s256f x_neg = _mm256_castsi256_ps(_mm256_srai_epi32(_mm256_castps_si256(x), 31));
+    r = ia_simd256_select(r, _mm256_sub_ps(_mm256_set1_ps(IA_PIf), r), x_neg);
+    return _mm256_or_ps(r, _mm256_and_ps(y, ia_simd_float32x8_SIGNMASK_NEG));
+}
+
+IA_FORCE_INLINE s256f ia_simd256_acos(s256f x)
+{
+    s256f ax = _mm256_andnot_ps(ia_simd_float32x8_SIGNMASK_NEG, x);
+    s256f big = _mm256_cmp_ps(ax, _mm256_set1_ps(0.5f), _CMP_GT_OQ);
+    s256f z = ia_simd256_select(_mm256_mul_ps(x, x), _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), ax), _mm256_set1_ps(0.5f)), big);
+    s256f s = ia_simd256_select(ax, _mm256_sqrt_ps(z), big);
+    s256f p = ia_simd256_fmadd(z, _mm256_set1_ps(_IA_TRIG_AS1), _mm256_set1_ps(_IA_TRIG_AS2));
+    p = ia_simd256_fmadd(p, z, _mm256_set1_ps(_IA_TRIG_AS3));
+    p = ia_simd256_fmadd(p, z, _mm256_set1_ps(_IA_TRIG_AS4));
+    p = ia_simd256_fmadd(p, z, _mm256_set1_ps(_IA_TRIG_AS5));
+    p = ia_simd256_fmadd(_mm256_mul_ps(p, z), s, s);
+    s256f sign = _mm256_and_ps(x, ia_simd_float32x8_SIGNMASK_NEG);
+    s256f x_neg = _mm256_castsi256_ps(_mm256_srai_epi32(_mm256_castps_si256(x), 31));
+    s256f p2 = _mm256_add_ps(p, p);
+    s256f rb = ia_simd256_select(p2, _mm256_sub_ps(_mm256_set1_ps(IA_PIf), p2), x_neg);
+    s256f rs = _mm256_sub_ps(_mm256_set1_ps(IA_PI_2f), _mm256_or_ps(p, sign));
+    return ia_simd256_select(rs, rb, big);
+}
+
+IA_FORCE_INLINE s256f ia_simd256_exp(s256f x)
+{
+    s256f xc = _mm256_max_ps(_mm256_set1_ps(_IA_TRIG_EXP_LO), _mm256_min_ps(_mm256_set1_ps(_IA_TRIG_EXP_HI), x));
+    s256i n = ia_simd256_trig_round_(xc, IA_LOG2Ef);
+    s256f fn = _mm256_cvtepi32_ps(n);
+    s256f r = ia_simd256_fnmadd(fn, _mm256_set1_ps(_IA_TRIG_LN2_HI), xc);
+    r = ia_simd256_fnmadd(fn, _mm256_set1_ps(_IA_TRIG_LN2_LO), r);
+    s256f p = ia_simd256_fmadd(r, _mm256_set1_ps(_IA_TRIG_E1), _mm256_set1_ps(_IA_TRIG_E2));
+    p = ia_simd256_fmadd(p, r, _mm256_set1_ps(_IA_TRIG_E3));
+    p = ia_simd256_fmadd(p, r, _mm256_set1_ps(_IA_TRIG_E4));
+    p = ia_simd256_fmadd(p, r, _mm256_set1_ps(_IA_TRIG_E5));
+    p = ia_simd256_fmadd(p, r, _mm256_set1_ps(_IA_TRIG_E6));
+    p = ia_simd256_fmadd(_mm256_mul_ps(p, r), r, _mm256_add_ps(r, _mm256_set1_ps(1.0f)));
+    s256i bias = _mm256_set1_epi32(127);
+    s256i n1 = _mm256_srai_epi32(n, 1);
+    p = _mm256_mul_ps(p, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n1, bias), 23)));
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_sub_epi32(n, n1), bias), 23)));
+}
+
+IA_FORCE_INLINE s256f ia_simd256_log(s256f x)
+{
+    s256i bits = _mm256_castps_si256(x);
+    s256i e = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0xff)), _mm256_set1_epi32(126));
+    s256f m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f000000)));
+    s256f lo = _mm256_cmp_ps(m, _mm256_set1_ps(IA_SQRT1_2f), _CMP_LT_OQ);
+    e = _mm256_add_epi32(e, _mm256_castps_si256(lo));
+    m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(lo, m)), _mm256_set1_ps(1.0f));
+    s256f fe = _mm256_cvtepi32_ps(e);
+    s256f z = _mm256_mul_ps(m, m);
+    s256f p = ia_simd256_fmadd(m, _mm256_set1_ps(_IA_TRIG_L1), _mm256_set1_ps(_IA_TRIG_L2));
+    p = ia_simd256_fmadd(p, m, _mm256_set1_ps(_IA_TRIG_L3));
+    p = ia_simd256_fmadd(p, m, _mm256_set1_ps(_IA_TRIG_L4));
+    p = ia_simd256_fmadd(p, m, _mm256_set1_ps(_IA_TRIG_L5));
+    p = ia_simd256_fmadd(p, m, _mm256_set1_ps(_IA_TRIG_L6));
+    p = ia_simd256_fmadd(p, m, _mm256_set1_ps(_IA_TRIG_L7));
+    p = ia_simd256_fmadd(p, m, _mm256_set1_ps(_IA_TRIG_L8));
+    p = ia_simd256_fmadd(p, m, _mm256_set1_ps(_IA_TRIG_L9));
+    p = ia_simd256_fmadd(_mm256_mul_ps(p, m), z, _mm256_mul_ps(fe, _mm256_set1_ps(_IA_TRIG_LN2_LO)));
+    p = ia_simd256_fnmadd(z, _mm256_set1_ps(0.5f), p);
+    s256f r = ia_simd256_fmadd(fe, _mm256_set1_ps(_IA_TRIG_LN2_HI), _mm256_add_ps(m, p));
+    r = ia_simd256_select(r, _mm256_set1_ps(INFINITY), _mm256_cmp_ps(x, _mm256_set1_ps(INFINITY), _CMP_EQ_OQ));
+    r = ia_simd256_select(_mm256_set1_ps(NAN), r, _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ));
+    return ia_simd256_select(r, _mm256_set1_ps(-INFINITY), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ));
+}
+#endif /* IA_ARCH_X86_AVX2 */
+#endif /* IA_SIMD_X86 */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -0,0 +1,398 @@
+#pragma once
+/** @file ia/compute/vector.h
+ *  @brief Vector math for 2, 3 and 4 component float vectors.
+ *
+ *  Operations work on the array types `f32x2`, `f32x3` and `f32x4` from `ia/base/types.h`, they have
+ *  the same layout as `float2`, `float3` and `float4` in shaders. Results are written into a `dest`
+ *  argument, which may alias any of the inputs. The API follows cglm, which the SIMD layer is based on.
+ *
+ *  [cglm: Highly Optimized 2D / 3D Graphics Math for C]
+ *  https://github.com/recp/cglm
+ *
+ *  4 component vectors are 16-byte aligned and are processed in a single SIMD register. 3 component
+ *  vectors are not aligned, they're loaded into a register with `ia_simd_read3f` for the operations
+ *  that combine components (dot, cross, normalize), and computed per component otherwise, compilers
+ *  vectorize these on their own. 2 component vectors are always scalar. Without SIMD, everything
+ *  falls back to scalar code with the same results up to rounding.
+ *
+ *  The `_fast` variants of normalization use a reciprocal square root estimate, refined by one
+ *  Newton-Raphson step. Its relative error is below 2^-21, about two ULP of a float, but
+ *  without the latency of a division and a square root.
+ */
+#include <ia/base/types.h>
+#include <ia/compute/simd.h>
+
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Reciprocal square root, with an estimate refined by one Newton-Raphson step where available. */
+IA_FORCE_INLINE f32 ia_rsqrtf(f32 x)
+{
+#if IA_SIMD
+    return ia_simd_first(ia_simd_rsqrt(ia_simd_set1_rval(x)));
+#else
+    return 1.0f / sqrtf(x);
+#endif
+}
+
+IA_FORCE_INLINE f32 ia_lerpf(f32 from, f32 to, f32 t)
+{ return from + t * (to - from); }
+
+IA_FORCE_INLINE f32 ia_clampf(f32 x, f32 lo, f32 hi)
+{ return fminf(fmaxf(x, lo), hi); }
+
+/* 2 component vectors */
+
+IA_FORCE_INLINE void ia_vec2_copy(f32x2 const a, f32x2 dest)
+{ dest[0] = a[0]; dest[1] = a[1]; }
+
+IA_FORCE_INLINE void ia_vec2_zero(f32x2 dest)
+{ dest[0] = dest[1] = 0.0f; }
+
+IA_FORCE_INLINE void ia_vec2_add(f32x2 const a, f32x2 const b, f32x2 dest)
+{ dest[0] = a[0] + b[0]; dest[1] = a[1] + b[1]; }
+
+IA_FORCE_INLINE void ia_vec2_sub(f32x2 const a, f32x2 const b, f32x2 dest)
+{ dest[0] = a[0] - b[0]; dest[1] = a[1] - b[1]; }
+
+/** Component-wise product. */
+IA_FORCE_INLINE void ia_vec2_mul(f32x2 const a, f32x2 const b, f32x2 dest)
+{ dest[0] = a[0] * b[0]; dest[1] = a[1] * b[1]; }
+
+IA_FORCE_INLINE void ia_vec2_scale(f32x2 const a, f32 s, f32x2 dest)
+{ dest[0] = a[0] * s; dest[1] = a[1] * s; }
+
+IA_FORCE_INLINE void ia_vec2_negate(f32x2 const a, f32x2 dest)
+{ dest[0] = -a[0]; dest[1] = -a[1]; }
+
+IA_FORCE_INLINE f32 ia_vec2_dot(f32x2 const a, f32x2 const b)
+{ return a[0] * b[0] + a[1] * b[1]; }
+
+/** Z component of the 3D cross product, the signed area of the parallelogram. */
+IA_FORCE_INLINE f32 ia_vec2_cross(f32x2 const a, f32x2 const b)
+{ return a[0] * b[1] - a[1] * b[0]; }
+
+IA_FORCE_INLINE f32 ia_vec2_norm2(f32x2 const a)
+{ return ia_vec2_dot(a, a); }
+
+IA_FORCE_INLINE f32 ia_vec2_norm(f32x2 const a)
+{ return sqrtf(ia_vec2_norm2(a)); }
+
+IA_FORCE_INLINE f32 ia_vec2_distance(f32x2 const a, f32x2 const b)
+{ return hypotf(a[0] - b[0], a[1] - b[1]); }
+
+/** Normalizes the vector, a zero vector stays zero. */
+IA_FORCE_INLINE void ia_vec2_normalize(f32x2 const a, f32x2 dest)
+{
+    f32 norm = ia_vec2_norm(a);
+    if (norm == 0.0f) {
+        ia_vec2_zero(dest);
+        return;
+    }
+    ia_vec2_scale(a, 1.0f / norm, dest);
+}
+
+IA_FORCE_INLINE void ia_vec2_min(f32x2 const a, f32x2 const b, f32x2 dest)
+{ dest[0] = fminf(a[0], b[0]); dest[1] = fminf(a[1], b[1]); }
+
+IA_FORCE_INLINE void ia_vec2_max(f32x2 const a, f32x2 const b, f32x2 dest)
+{ dest[0] = fmaxf(a[0], b[0]); dest[1] = fmaxf(a[1], b[1]); }
+
+IA_FORCE_INLINE void ia_vec2_lerp(f32x2 const from, f32x2 const to, f32 t, f32x2 dest)
+{ dest[0] = ia_lerpf(from[0], to[0], t); dest[1] = ia_lerpf(from[1], to[1], t); }
+
+/* 3 component vectors */
+
+IA_FORCE_INLINE void ia_vec3_copy(f32x3 const a, f32x3 dest)
+{ dest[0] = a[0]; dest[1] = a[1]; dest[2] = a[2]; }
+
+IA_FORCE_INLINE void ia_vec3_zero(f32x3 dest)
+{ dest[0] = dest[1] = dest[2] = 0.0f; }
+
+IA_FORCE_INLINE void ia_vec3_add(f32x3 const a, f32x3 const b, f32x3 dest)
+{ dest[0] = a[0] + b[0]; dest[1] = a[1] + b[1]; dest[2] = a[2] + b[2]; }
+
+IA_FORCE_INLINE void ia_vec3_sub(f32x3 const a, f32x3 const b, f32x3 dest)
+{ dest[0] = a[0] - b[0]; dest[1] = a[1] - b[1]; dest[2] = a[2] - b[2]; }
+
+/** Component-wise product. */
+IA_FORCE_INLINE void ia_vec3_mul(f32x3 const a, f32x3 const b, f32x3 dest)
+{ dest[0] = a[0] * b[0]; dest[1] = a[1] * b[1]; dest[2] = a[2] * b[2]; }
+
+IA_FORCE_INLINE void ia_vec3_scale(f32x3 const a, f32 s, f32x3 dest)
+{ dest[0] = a[0] * s; dest[1] = a[1] * s; dest[2] = a[2] * s; }
+
+/** dest += a * s */
+IA_FORCE_INLINE void ia_vec3_muladds(f32x3 const a, f32 s, f32x3 dest)
+{ dest[0] += a[0] * s; dest[1] += a[1] * s; dest[2] += a[2] * s; }
+
+IA_FORCE_INLINE void ia_vec3_negate(f32x3 const a, f32x3 dest)
+{ dest[0] = -a[0]; dest[1] = -a[1]; dest[2] = -a[2]; }
+
+IA_FORCE_INLINE f32 ia_vec3_dot(f32x3 const a, f32x3 const b)
+{
+#if IA_SIMD
+    /* the fourth lane of `ia_simd_read3f` is zero */
+    return ia_simd_dot(ia_simd_read3f(a), ia_simd_read3f(b));
+#else
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+#endif
+}
+
+IA_FORCE_INLINE void ia_vec3_cross(f32x3 const a, f32x3 const b, f32x3 dest)
+{
+#if IA_SIMD
+    s128f x0 = ia_simd_read3f(a), x1 = ia_simd_read3f(b);
+    /* a.yzx * b.zxy - a.zxy * b.yzx, computed as (a * b.yzx - a.yzx * b).yzx */
+    s128f a_yzx = ia_simd_shuffle1(x0, 3, 0, 2, 1);
+    s128f b_yzx = ia_simd_shuffle1(x1, 3, 0, 2, 1);
+    s128f c = ia_simd_sub(ia_simd_mul(x0, b_yzx), ia_simd_mul(a_yzx, x1));
+    ia_simd_write3f(dest, ia_simd_shuffle1(c, 3, 0, 2, 1));
+#else
+    f32 x = a[1] * b[2] - a[2] * b[1];
+    f32 y = a[2] * b[0] - a[0] * b[2];
+    f32 z = a[0] * b[1] - a[1] * b[0];
+    dest[0] = x; dest[1] = y; dest[2] = z;
+#endif
+}
+
+IA_FORCE_INLINE f32 ia_vec3_norm2(f32x3 const a)
+{ return ia_vec3_dot(a, a); }
+
+IA_FORCE_INLINE f32 ia_vec3_norm(f32x3 const a)
+{ return sqrtf(ia_vec3_norm2(a)); }
+
+IA_FORCE_INLINE f32 ia_vec3_distance2(f32x3 const a, f32x3 const b)
+{
+    f32x3 d;
+    ia_vec3_sub(a, b, d);
+    return ia_vec3_norm2(d);
+}
+
+IA_FORCE_INLINE f32 ia_vec3_distance(f32x3 const a, f32x3 const b)
+{ return sqrtf(ia_vec3_distance2(a, b)); }
+
+/** Normalizes the vector, a zero vector stays zero. */
+IA_FORCE_INLINE void ia_vec3_normalize(f32x3 const a, f32x3 dest)
+{
+    f32 norm = ia_vec3_norm(a);
+    if (norm == 0.0f) {
+        ia_vec3_zero(dest);
+        return;
+    }
+    ia_vec3_scale(a, 1.0f / norm, dest);
+}
+
+/** Normalizes the vector with a refined reciprocal square root, a zero vector stays zero. */
+IA_FORCE_INLINE void ia_vec3_normalize_fast(f32x3 const a, f32x3 dest)
+{
+#if IA_SIMD
+    s128f x0 = ia_simd_read3f(a);
+    s128f n2 = ia_simd_vdot(x0, x0);
+    s128f r = ia_simd_mul(x0, ia_simd_rsqrt(n2));
+    /* the estimate of 1/sqrt(0) is infinity, mask the NaNs out */
+    ia_simd_write3f(dest, ia_simd_and(r, ia_simd_cmpneq(n2, ia_simd_zero())));
+#else
+    f32 n2 = ia_vec3_norm2(a);
+    ia_vec3_scale(a, n2 > 0.0f ? ia_rsqrtf(n2) : 0.0f, dest);
+#endif
+}
+
+IA_FORCE_INLINE void ia_vec3_min(f32x3 const a, f32x3 const b, f32x3 dest)
+{ dest[0] = fminf(a[0], b[0]); dest[1] = fminf(a[1], b[1]); dest[2] = fminf(a[2], b[2]); }
+
+IA_FORCE_INLINE void ia_vec3_max(f32x3 const a, f32x3 const b, f32x3 dest)
+{ dest[0] = fmaxf(a[0], b[0]); dest[1] = fmaxf(a[1], b[1]); dest[2] = fmaxf(a[2], b[2]); }
+
+IA_FORCE_INLINE void ia_vec3_clamp(f32x3 const a, f32 lo, f32 hi, f32x3 dest)
+{ dest[0] = ia_clampf(a[0], lo, hi); dest[1] = ia_clampf(a[1], lo, hi); dest[2] = ia_clampf(a[2], lo, hi); }
+
+IA_FORCE_INLINE void ia_vec3_lerp(f32x3 const from, f32x3 const to, f32 t, f32x3 dest)
+{
+    dest[0] = ia_lerpf(from[0], to[0], t);
+    dest[1] = ia_lerpf(from[1], to[1], t);
+    dest[2] = ia_lerpf(from[2], to[2], t);
+}
+
+/* 4 component vectors */
+
+IA_FORCE_INLINE void ia_vec4_copy(f32x4 const a, f32x4 dest)
+{ memcpy(dest, a, sizeof(f32x4)); }
+
+IA_FORCE_INLINE void ia_vec4_zero(f32x4 dest)
+{ dest[0] = dest[1] = dest[2] = dest[3] = 0.0f; }
+
+/** Extends a 3 component vector with `w`. */
+IA_FORCE_INLINE void ia_vec4_from_vec3(f32x3 const a, f32 w, f32x4 dest)
+{ dest[0] = a[0]; dest[1] = a[1]; dest[2] = a[2]; dest[3] = w; }
+
+#if IA_SIMD
+/* Applies a binary SIMD operation to two vectors. */
+#define _IA_VEC4_SIMD_OP(op, a, b, dest) \
+    ia_simd_write(dest, op(ia_simd_read(a), ia_simd_read(b)))
+#endif
+
+IA_FORCE_INLINE void ia_vec4_add(f32x4 const a, f32x4 const b, f32x4 dest)
+{
+#if IA_SIMD
+    _IA_VEC4_SIMD_OP(ia_simd_add, a, b, dest);
+#else
+    for (i32 i = 0; i < 4; i++) dest[i] = a[i] + b[i];
+#endif
+}
+
+IA_FORCE_INLINE void ia_vec4_sub(f32x4 const a, f32x4 const b, f32x4 dest)
+{
+#if IA_SIMD
+    _IA_VEC4_SIMD_OP(ia_simd_sub, a, b, dest);
+#else
+    for (i32 i = 0; i < 4; i++) dest[i] = a[i] - b[i];
+#endif
+}
+
+/** Component-wise product. */
+IA_FORCE_INLINE void ia_vec4_mul(f32x4 const a, f32x4 const b, f32x4 dest)
+{
+#if IA_SIMD
+    _IA_VEC4_SIMD_OP(ia_simd_mul, a, b, dest);
+#else
+    for (i32 i = 0; i < 4; i++) dest[i] = a[i] * b[i];
+#endif
+}
+
+IA_FORCE_INLINE void ia_vec4_min(f32x4 const a, f32x4 const b, f32x4 dest)
+{
+#if IA_SIMD
+    _IA_VEC4_SIMD_OP(ia_simd_min, a, b, dest);
+#else
+    for (i32 i = 0; i < 4; i++) dest[i] = fminf(a[i], b[i]);
+#endif
+}
+
+IA_FORCE_INLINE void ia_vec4_max(f32x4 const a, f32x4 const b, f32x4 dest)
+{
+#if IA_SIMD
+    _IA_VEC4_SIMD_OP(ia_simd_max, a, b, dest);
+#else
+    for (i32 i = 0; i < 4; i++) dest[i] = fmaxf(a[i], b[i]);
+#endif
+}
+
+IA_FORCE_INLINE void ia_vec4_scale(f32x4 const a, f32 s, f32x4 dest)
+{
+#if IA_SIMD
+    ia_simd_write(dest, ia_simd_mul(ia_simd_read(a), ia_simd_set1_rval(s)));
+#else
+    for (i32 i = 0; i < 4; i++) dest[i] = a[i] * s;
+#endif
+}
+
+/** dest += a * s */
+IA_FORCE_INLINE void ia_vec4_muladds(f32x4 const a, f32 s, f32x4 dest)
+{
+#if IA_SIMD
+    ia_simd_write(dest, ia_simd_fmadd(ia_simd_read(a), ia_simd_set1_rval(s), ia_simd_read(dest)));
+#else
+    for (i32 i = 0; i < 4; i++) dest[i] += a[i] * s;
+#endif
+}
+
+IA_FORCE_INLINE void ia_vec4_negate(f32x4 const a, f32x4 dest)
+{
+#if IA_SIMD
+    ia_simd_write(dest, ia_simd_neg(ia_simd_read(a)));
+#else
+    for (i32 i = 0; i < 4; i++) dest[i] = -a[i];
+#endif
+}
+
+IA_FORCE_INLINE f32 ia_vec4_dot(f32x4 const a, f32x4 const b)
+{
+#if IA_SIMD
+    return ia_simd_dot(ia_simd_read(a), ia_simd_read(b));
+#else
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+#endif
+}
+
+IA_FORCE_INLINE f32 ia_vec4_norm2(f32x4 const a)
+{ return ia_vec4_dot(a, a); }
+
+IA_FORCE_INLINE f32 ia_vec4_norm(f32x4 const a)
+{
+#if IA_SIMD
+    return ia_simd_norm(ia_simd_read(a));
+#else
+    return sqrtf(ia_vec4_norm2(a));
+#endif
+}
+
+IA_FORCE_INLINE f32 ia_vec4_distance(f32x4 const a, f32x4 const b)
+{
+#if IA_SIMD
+    return ia_simd_norm(ia_simd_sub(ia_simd_read(a), ia_simd_read(b)));
+#else
+    f32x4 d;
+    ia_vec4_sub(a, b, d);
+    return ia_vec4_norm(d);
+#endif
+}
+
+/** Normalizes the vector, a zero vector stays zero. */
+IA_FORCE_INLINE void ia_vec4_normalize(f32x4 const a, f32x4 dest)
+{
+#if IA_SIMD
+    s128f x0 = ia_simd_read(a);
+    s128f norm = ia_simd_sqrt(ia_simd_vdot(x0, x0));
+    s128f r = ia_simd_div(x0, norm);
+    ia_simd_write(dest, ia_simd_and(r, ia_simd_cmpneq(norm, ia_simd_zero())));
+#else
+    f32 norm = ia_vec4_norm(a);
+    if (norm == 0.0f) {
+        ia_vec4_zero(dest);
+        return;
+    }
+    ia_vec4_scale(a, 1.0f / norm, dest);
+#endif
+}
+
+/** Normalizes the vector with a refined reciprocal square root, a zero vector stays zero. */
+IA_FORCE_INLINE void ia_vec4_normalize_fast(f32x4 const a, f32x4 dest)
+{
+#if IA_SIMD
+    s128f x0 = ia_simd_read(a);
+    s128f n2 = ia_simd_vdot(x0, x0);
+    s128f r = ia_simd_mul(x0, ia_simd_rsqrt(n2));
+    ia_simd_write(dest, ia_simd_and(r, ia_simd_cmpneq(n2, ia_simd_zero())));
+#else
+    f32 n2 = ia_vec4_norm2(a);
+    ia_vec4_scale(a, n2 > 0.0f ? ia_rsqrtf(n2) : 0.0f, dest);
+#endif
+}
+
+IA_FORCE_INLINE void ia_vec4_lerp(f32x4 const from, f32x4 const to, f32 t, f32x4 dest)
+{
+#if IA_SIMD
+    s128f x0 = ia_simd_read(from);
+    ia_simd_write(dest, ia_simd_fmadd(ia_simd_sub(ia_simd_read(to), x0), ia_simd_set1_rval(t), x0));
+#else
+    for (i32 i = 0; i < 4; i++) dest[i] = ia_lerpf(from[i], to[i], t);
+#endif
+}
+
+IA_FORCE_INLINE void ia_vec4_clamp(f32x4 const a, f32 lo, f32 hi, f32x4 dest)
+{
+#if IA_SIMD
+    s128f x0 = ia_simd_max(ia_simd_read(a), ia_simd_set1_rval(lo));
+    ia_simd_write(dest, ia_simd_min(x0, ia_simd_set1_rval(hi)));
+#else
+    for (i32 i = 0; i < 4; i++) dest[i] = ia_clampf(a[i], lo, hi);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
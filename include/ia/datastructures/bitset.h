@@ -1,10 +1,19 @@
 #pragma once
 /** @file ia/datastructures/bitset.h
- *  @brief Bitset data structure. 
- * 
- *  TODO docs 
+ *  @brief Bitset data structure.
+ *
+ *  A dynamically sized array of bits, stored in 64-bit words. The `size` is a count of bits,
+ *  words past the size are always kept zeroed, so bitsets of different sizes can be compared
+ *  by treating missing words as zeroes. Memory is allocated through the drift allocator.
+ *
+ *  Scans skip whole zero words, set bits are found with `ia_ctz64`. Logical operations over
+ *  whole sets run 256 bits at a time with AVX2, or 128 bits at a time with NEON. A rank index
+ *  stores the count of set bits before every block of `IA_BITSET_RANK_BLOCK_WORDS` words, it
+ *  makes rank a constant-time query and select a binary search over blocks.
  */
 #include <ia/base/types.h>
+#include <ia/base/log.h>
+#include <ia/compute/bits.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,10 +21,240 @@ extern "C" {
 
 typedef struct ia_bitset {
     u64    *v;
-    i32     size;
-    i32     alloc;
+    i32     size;   /**< Number of bits. */
+    i32     alloc;  /**< Number of allocated words. */
 } ia_bitset;
 
+static constexpr ia_bitset ia_bitset_init = { .v = nullptr, .size = 0, .alloc = 0 };
+
+/** Number of 64-bit words needed for a count of bits. */
+#define ia_bitset_words(bits) (((bits) + 63) >> 6)
+
+/** Resizes the bitset to hold `bits` bits, new bits are cleared. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_bitset_resize(
+    ia_bitset  *bitset,
+    i32         bits);
+
+/** @return `true` if the bit is set, bits outside of the size are never set. */
+IA_FORCE_INLINE bool
+ia_bitset_test(
+    ia_bitset const    *bitset,
+    i32                 bit)
+{
+    if ((u32)bit >= (u32)bitset->size)
+        return false;
+    return (bitset->v[bit >> 6] >> (bit & 63)) & 1;
+}
+
+/** Sets a bit, it must be within the size. */
+IA_FORCE_INLINE void
+ia_bitset_set(
+    ia_bitset  *bitset,
+    i32         bit)
+{
+    ia_dbg_assert((u32)bit < (u32)bitset->size, "Bit %d out of range of bitset<%d>.", bit, bitset->size);
+    bitset->v[bit >> 6] |= 1ull << (bit & 63);
+}
+
+/** Clears a bit, it must be within the size. */
+IA_FORCE_INLINE void
+ia_bitset_clear(
+    ia_bitset  *bitset,
+    i32         bit)
+{
+    ia_dbg_assert((u32)bit < (u32)bitset->size, "Bit %d out of range of bitset<%d>.", bit, bitset->size);
+    bitset->v[bit >> 6] &= ~(1ull << (bit & 63));
+}
+
+/** @return `true` if every bit set in `a` is also set in `b`. */
+IA_FORCE_INLINE bool
+ia_bitset_is_subset(
+    ia_bitset const    *a,
+    ia_bitset const    *b)
+{
+    i32 wa = ia_bitset_words(a->size), wb = ia_bitset_words(b->size);
+    for (i32 i = 0; i < wa; i++) {
+        u64 bits = i < wb ? b->v[i] : 0;
+        if (a->v[i] & ~bits)
+            return false;
+    }
+    return true;
+}
+
+/** @return `true` if any bit is set in both `a` and `b`. */
+IA_FORCE_INLINE bool
+ia_bitset_intersects(
+    ia_bitset const    *a,
+    ia_bitset const    *b)
+{
+    i32 w = ia_min(ia_bitset_words(a->size), ia_bitset_words(b->size));
+    for (i32 i = 0; i < w; i++)
+        if (a->v[i] & b->v[i])
+            return true;
+    return false;
+}
+
+/** @return `true` if both bitsets have the same bits set, regardless of their sizes. */
+IA_FORCE_INLINE bool
+ia_bitset_equal(
+    ia_bitset const    *a,
+    ia_bitset const    *b)
+{
+    i32 wa = ia_bitset_words(a->size), wb = ia_bitset_words(b->size);
+    for (i32 i = 0; i < ia_max(wa, wb); i++) {
+        u64 x = i < wa ? a->v[i] : 0;
+        u64 y = i < wb ? b->v[i] : 0;
+        if (x != y)
+            return false;
+    }
+    return true;
+}
+
+/** @return Index of the first set bit at or after `from`, or -1 if there is none. */
+IA_FORCE_INLINE i32
+ia_bitset_find_next(
+    ia_bitset const    *bitset,
+    i32                 from)
+{
+    if (from < 0)
+        from = 0;
+    if (from >= bitset->size)
+        return -1;
+
+    i32 words = ia_bitset_words(bitset->size);
+    i32 w = from >> 6;
+    u64 word = bitset->v[w] & (~0ull << (from & 63));
+    for (;;) {
+        if (word)
+            return (w << 6) + ia_ctz64(word);
+        if (++w >= words)
+            return -1;
+        word = bitset->v[w];
+    }
+}
+
+/** @return Index of the first set bit, or -1 if there is none. */
+IA_FORCE_INLINE i32
+ia_bitset_find_first(ia_bitset const *bitset)
+{ return ia_bitset_find_next(bitset, 0); }
+
+/** @return Index of the first cleared bit at or after `from`, or -1 if all bits up to the size are set. */
+IA_FORCE_INLINE i32
+ia_bitset_find_next_zero(
+    ia_bitset const    *bitset,
+    i32                 from)
+{
+    if (from < 0)
+        from = 0;
+    if (from >= bitset->size)
+        return -1;
+
+    i32 words = ia_bitset_words(bitset->size);
+    i32 w = from >> 6;
+    u64 word = ~bitset->v[w] & (~0ull << (from & 63));
+    for (;;) {
+        if (word) {
+            i32 bit = (w << 6) + ia_ctz64(word);
+            return bit < bitset->size ? bit : -1;
+        }
+        if (++w >= words)
+            return -1;
+        word = ~bitset->v[w];
+    }
+}
+
+/** Iterates set bits in ascending order. The bitset must not be resized by the loop body. */
+#define ia_bitset_foreach(bitset, BIT) \
+    for (i32 BIT = ia_bitset_find_first(bitset); BIT >= 0; BIT = ia_bitset_find_next(bitset, BIT + 1))
+
+/** dst = a & b, the result has the smaller size of both. `dst` may alias either operand. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_bitset_and(
+    ia_bitset          *dst,
+    ia_bitset const    *a,
+    ia_bitset const    *b);
+
+/** dst = a | b, the result has the larger size of both. `dst` may alias either operand. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_bitset_or(
+    ia_bitset          *dst,
+    ia_bitset const    *a,
+    ia_bitset const    *b);
+
+/** dst = a ^ b, the result has the larger size of both. `dst` may alias either operand. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_bitset_xor(
+    ia_bitset          *dst,
+    ia_bitset const    *a,
+    ia_bitset const    *b);
+
+/** dst = a & ~b, the result has the size of `a`. `dst` may alias either operand. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_bitset_andnot(
+    ia_bitset          *dst,
+    ia_bitset const    *a,
+    ia_bitset const    *b);
+
+/** @return Count of set bits. */
+IA_NONNULL_ALL IA_API i32 IA_CALL
+ia_bitset_popcount(ia_bitset const *bitset);
+
+/** @return Count of set bits in range [0..bit). */
+IA_NONNULL_ALL IA_API i32 IA_CALL
+ia_bitset_rank(
+    ia_bitset const    *bitset,
+    i32                 bit);
+
+/** @return Index of the k-th set bit (counting from zero), or -1 if there are not enough set bits. */
+IA_NONNULL_ALL IA_API i32 IA_CALL
+ia_bitset_select(
+    ia_bitset const    *bitset,
+    i32                 k);
+
+#define IA_BITSET_RANK_BLOCK_WORDS 8
+
+/** Cumulative counts of set bits, must be rebuilt after the bitset is modified. */
+typedef struct ia_bitset_ranks {
+    i32        *blocks;     /**< Set bits before every block, one more entry holds the total. */
+    i32         count;      /**< Number of blocks. */
+} ia_bitset_ranks;
+
+/** Builds the rank index of a bitset. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_bitset_ranks_build(
+    ia_bitset const    *bitset,
+    ia_bitset_ranks    *ranks);
+
+/** @return Count of set bits in range [0..bit), using a rank index. */
+IA_FORCE_INLINE i32
+ia_bitset_rank_indexed(
+    ia_bitset const        *bitset,
+    ia_bitset_ranks const  *ranks,
+    i32                     bit)
+{
+    if (bit >= bitset->size)
+        return ranks->blocks[ranks->count];
+    if (bit <= 0)
+        return 0;
+
+    i32 w = bit >> 6;
+    i32 block = w / IA_BITSET_RANK_BLOCK_WORDS;
+    i32 rank = ranks->blocks[block];
+    for (i32 i = block * IA_BITSET_RANK_BLOCK_WORDS; i < w; i++)
+        rank += ia_popcnt64(bitset->v[i]);
+    if (bit & 63)
+        rank += ia_popcnt64(bitset->v[w] & ((1ull << (bit & 63)) - 1));
+    return rank;
+}
+
+/** @return Index of the k-th set bit using a rank index, or -1 if there are not enough set bits. */
+IA_NONNULL_ALL IA_API i32 IA_CALL
+ia_bitset_select_indexed(
+    ia_bitset const        *bitset,
+    ia_bitset_ranks const  *ranks,
+    i32                     k);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,147 @@
+#pragma once
+/** @file ia/datastructures/btree.h
+ *  @brief Persistent B+-tree map of ordered 64-bit keys.
+ *
+ *  Keys and values are stored in leaves, inner nodes only hold separators and children. Every node
+ *  has room for `IA_BTREE_FANOUT` keys, kept in a cacheline aligned array. A node is searched by
+ *  comparing the key against all of its keys at once: four keys at a time with AVX2, two at a time
+ *  with NEON, and counting the matches. Lookups don't branch on key comparisons within a node.
+ *
+ *  Separator keys of an inner node: `keys[i]` for i > 0 is not greater than any key in `children[i]`,
+ *  and greater than every key in `children[i - 1]`. `keys[0]` is not used by searches.
+ *
+ *  The tree is persistent: a snapshot keeps a version of the tree alive, while the writer keeps
+ *  modifying it. Nodes are reference counted. The writer modifies a node in place when it's the only
+ *  owner, and copies it when it's shared with a snapshot, so only the path from the root to the
+ *  modified leaf is copied. Nodes of a snapshot are never modified, so any thread may read and iterate
+ *  a snapshot without locks, and release it when done. Released nodes go to a free list of the tree,
+ *  so every snapshot must be released before the tree is finalized.
+ *
+ *  The tree has a single writer, which is also the only thread that may take snapshots. Removal merges
+ *  a node with its sibling when both fit in one node, it doesn't borrow keys between siblings.
+ *  Memory is allocated through the drift allocator.
+ *
+ *  [The Ubiquitous B-Tree]
+ *  https://dl.acm.org/doi/10.1145/356770.356776
+ *
+ *  [Making B+-Trees Cache Conscious in Main Memory]
+ *  https://dl.acm.org/doi/10.1145/335191.335449
+ */
+#include <ia/base/types.h>
+#include <ia/base/atomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Count of keys in a node, two cachelines of keys. */
+#define IA_BTREE_FANOUT         16
+
+/** Upper limit of tree height, more than enough for any count of keys addressable in memory. */
+#define IA_BTREE_MAX_HEIGHT     16
+
+/** A node of the tree. */
+typedef struct IA_CACHELINE_ALIGNMENT ia_btree_node {
+    u64                         keys[IA_BTREE_FANOUT];
+    union {
+        u64                     values[IA_BTREE_FANOUT];    /**< In leaves. */
+        struct ia_btree_node   *children[IA_BTREE_FANOUT];  /**< In inner nodes. */
+    };
+    atomic_i32                  refs;   /**< Parents and snapshots referencing the node. */
+    i32                         count;
+    i32                         height; /**< Zero for leaves. */
+} ia_btree_node;
+
+/** The tree, owned by a single writer thread. */
+typedef struct ia_btree {
+    ia_btree_node              *root;   /**< nullptr if the tree is empty. */
+    isize                       count;
+    atomic_i32                  snapshots;  /**< Snapshots not released yet. */
+    ia_spinlock                 lock;
+    ia_btree_node              *free_nodes IA_THREAD_SAFETY_GUARDED_BY(lock);
+} ia_btree;
+
+/** An immutable version of the tree. */
+typedef struct ia_btree_snapshot {
+    ia_btree_node              *root;
+    isize                       count;
+    ia_btree                   *tree;   /**< Receives nodes when the snapshot is released, nullptr after. */
+} ia_btree_snapshot;
+
+/** Initializes an empty tree. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_btree_init(ia_btree *tree);
+
+/** Releases the tree's reference to its nodes. All snapshots must be released before, their nodes
+ *  are returned to the tree. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_btree_fini(ia_btree *tree);
+
+/** Inserts a key or replaces its value.
+ *  @return `true` if the key was not in the tree. */
+IA_NONNULL_ALL IA_HOT_FN IA_API bool IA_CALL
+ia_btree_insert(
+    ia_btree   *tree,
+    u64         key,
+    u64         value);
+
+/** Removes a key, writes its value to `out_value` if it's not nullptr.
+ *  @return `false` if the key was not in the tree. */
+IA_NONNULL(1) IA_HOT_FN IA_API bool IA_CALL
+ia_btree_remove(
+    ia_btree   *tree,
+    u64         key,
+    u64        *out_value);
+
+/** Builds the tree from strictly ascending keys, the tree must be empty. Nodes are filled
+ *  evenly, every node but the root is at least half full. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_btree_bulk_load(
+    ia_btree   *tree,
+    isize       count,
+    u64 const  *keys,
+    u64 const  *values);
+
+/** Looks up a key in the tree or a snapshot, starting at its root.
+ *  @return `false` if the key was not found. */
+IA_NONNULL(3) IA_HOT_FN IA_API bool IA_CALL
+ia_btree_get(
+    ia_btree_node const    *root,
+    u64                     key,
+    u64                    *out_value);
+
+/** Takes a snapshot of the current version, only the writer may call this. */
+IA_NONNULL_ALL IA_API ia_btree_snapshot IA_CALL
+ia_btree_snapshot_acquire(ia_btree *tree);
+
+/** Releases a snapshot, may be called from any thread. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_btree_snapshot_release(ia_btree_snapshot *snapshot);
+
+/** Iterates keys in an inclusive range in ascending order. */
+typedef struct ia_btree_iter {
+    ia_btree_node const        *path[IA_BTREE_MAX_HEIGHT];
+    i32                         index[IA_BTREE_MAX_HEIGHT];
+    i32                         depth;  /**< Zero when the iteration is over. */
+    u64                         hi;
+    u64                         key;    /**< Current key, valid after `ia_btree_iter_next` returns `true`. */
+    u64                         value;  /**< Current value. */
+} ia_btree_iter;
+
+/** Starts an iteration over keys in range [lo..hi] of the tree or a snapshot, starting at its root.
+ *  The writer must not modify the tree while iterating its root, snapshots are always safe. */
+IA_NONNULL(1) IA_API void IA_CALL
+ia_btree_iter_init(
+    ia_btree_iter          *iter,
+    ia_btree_node const    *root,
+    u64                     lo,
+    u64                     hi);
+
+/** Advances to the next key in range.
+ *  @return `false` after the last key. */
+IA_NONNULL_ALL IA_HOT_FN IA_API bool IA_CALL
+ia_btree_iter_next(ia_btree_iter *iter);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
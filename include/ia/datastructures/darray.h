@@ -31,18 +31,36 @@ static constexpr ia_darray ia_darray_init = { .v = nullptr, .len = 0, .alloc = 0
         i32 __len = n; \
         if (__len < ia_darray_len(da)) \
             __len = ia_darray_len(da); \
-        if (IA_UNLIKELY(ia_darray_is_empty(da))) { \
-            (da)->v = allocate((da)->allocator, (stride) * (n), (align)); \
-            (da)->len = 0; \
-            (da)->alloc = n; \
-        } else if (IA_LIKELY(ia_darray_alloc(da) != __len)) { \
-            (da)->alloc = (stride) * (n); \
-            void *__v = memcpy(allocate((da)->allocator, (da)->alloc, (align)), (da)->v, (da)->len); \
-            deallocate((da)->allocator, (da)->v, (da)->alloc * (stride)); \
+        if (IA_LIKELY(ia_darray_alloc(da) != __len)) { \
+            void *__v = allocate((da)->allocator, (stride) * __len, (align)); \
+            if ((da)->v) { \
+                memcpy(__v, (da)->v, (stride) * (da)->len); \
+                deallocate((da)->allocator, (da)->v, (stride) * (da)->alloc); \
+            } \
             (da)->v = __v; \
+            (da)->alloc = __len; \
         } \
     })
 
+/** Resizes the allocation to `n` elements of type T, never below the current length. */
+#define ia_darray_resize(T, da, n, ...) \
+    __ia_darray_resize_dbg_w_allocator(da, ia_ssizeof(T), ia_salignof(T), n, #T, __VA_ARGS__)
+
+/** Resizes the allocation to `n` elements of a runtime stride. */
+#define ia_darray_resize_w_stride(da, stride, align, n, ...) \
+    __ia_darray_resize_dbg_w_allocator(da, stride, align, n, "stride", __VA_ARGS__)
+
+/** Ensures room for at least `n` elements of a runtime stride, the allocation grows geometrically. */
+#define ia_darray_reserve_w_stride(da, stride, align, n, ...) \
+    ({ \
+        if ((n) > ia_darray_alloc(da)) \
+            ia_darray_resize_w_stride(da, stride, align, ia_max((n), ia_max(ia_darray_alloc(da) * 2, 16)), __VA_ARGS__); \
+    })
+
+/** Ensures room for at least `n` elements of type T, the allocation grows geometrically. */
+#define ia_darray_reserve(T, da, n, ...) \
+    ia_darray_reserve_w_stride(da, ia_ssizeof(T), ia_salignof(T), n, __VA_ARGS__)
+
 #define ia_darray_resize_as_bytes(da, size, align, ...) \
     __ia_darray_resize_dbg_w_allocator(da, ia_ssizeof(u8), align, size, "bytes", __VA_ARGS__)
 
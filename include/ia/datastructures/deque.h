@@ -8,9 +8,28 @@
  *  full deque buffer. Shrink behaviour choices are: never shrink, shrink to minimum
  *  when the deque is empty, or shrink by half when the queue is at 20% of capacity.
  *
- *  The interface has a Ruby style of naming ;3.
+ *  The interface has a Ruby style of naming ;3. `push` and `pop` work at the tail, `unshift`
+ *  and `shift` work at the head. Capacity is always a power of two, so positions wrap around
+ *  with a mask. Element stride is given to every call, typed macros pass `sizeof(T)`.
+ *  Memory is allocated through the drift allocator, unless an allocator pair is given at init.
+ *  Drift memory is never returned, so with the drift allocator the deque keeps its largest
+ *  buffer and the shrink behaviour has no effect on capacity.
+ *
+ *  The concurrent `ia_deque_ws` is a work-stealing deque as described by Chase and Lev, with
+ *  memory orderings from Le et al. The owner thread pushes and pops pointers at the bottom,
+ *  any other thread may steal from the top. Only a steal and a pop of the last item race on
+ *  a CAS. The owner grows the circular buffer when it's full, old buffers are left to the drift
+ *  allocator, so a thief that still reads one never touches freed memory.
+ *
+ *  [Dynamic Circular Work-Stealing Deque]
+ *  https://www.dre.vanderbilt.edu/~schmidt/PDF/work-stealing-dequeue.pdf
+ *
+ *  [Correct and Efficient Work-Stealing for Weak Memory Models]
+ *  https://fzn.fr/readings/ppopp13.pdf
  */
 #include <ia/base/types.h>
+#include <ia/base/atomic.h>
+#include <ia/base/log.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,18 +41,181 @@ enum : i32 {
     ia_deque_shrink_at_one_fifth,
 };
 
+/** Allocates a deque buffer, may return nullptr when out of memory. */
+typedef void *(IA_CALL *ia_deque_alloc_fn)(
+    void       *userdata,
+    isize       size,
+    isize       alignment);
+
+/** Returns a deque buffer of `size` bytes to its allocator. */
+typedef void (IA_CALL *ia_deque_free_fn)(
+    void       *userdata,
+    void       *ptr,
+    isize       size);
+
 /** Double-ended queue. `head` and `tail` are indices of the first and last items in deque.
  *  `len` is the distance between head and tail. `cap` is the total capacity of `v`. `min` 
  *  is the initial capacity of the deque. `shrink` is a flag to specify shrink behaviour.
  *  When shrinking, `min` is the smallest size. */
 typedef struct ia_deque {
-    void       *v;
-    i32         head, tail, len, cap, min, shrink;
+    void               *v;
+    i32                 head, tail, len, cap, min, shrink;
+    ia_deque_alloc_fn   alloc;      /**< nullptr for the drift allocator. */
+    ia_deque_free_fn    free;       /**< nullptr for the drift allocator. */
+    void               *userdata;
 #ifdef IA_DEBUG
-    char const *dbg_name;
+    char const         *dbg_name;
 #endif
 } ia_deque;
 
+/** Initializes an empty deque, `min_cap` is rounded up to a power of two. Buffers are taken from
+ *  `alloc` and returned to `free`, both nullptr selects the drift allocator. */
+IA_NONNULL(1,8) IA_API void IA_CALL
+ia_deque_init_(
+    ia_deque           *deque,
+    i32                 stride,
+    i32                 min_cap,
+    i32                 shrink,
+    ia_deque_alloc_fn   alloc,
+    ia_deque_free_fn    free,
+    void               *userdata,
+    char const         *type_name);
+/** Typed macro helper for `ia_deque_init_`, with the drift allocator. */
+#define ia_deque_init(deque, T, min_cap, shrink) \
+    ia_deque_init_(deque, ia_ssizeof(T), min_cap, shrink, nullptr, nullptr, nullptr, "deque<"#T">")
+/** Typed macro helper for `ia_deque_init_`, with an allocator pair. */
+#define ia_deque_init_w_allocator(deque, T, min_cap, shrink, alloc, free, userdata) \
+    ia_deque_init_(deque, ia_ssizeof(T), min_cap, shrink, alloc, free, userdata, "deque<"#T">")
+
+/** Returns the buffer to the allocator, the deque must be initialized again before use. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_deque_fini_(
+    ia_deque   *deque,
+    i32         stride);
+/** Macro helper for typed deque fini. */
+#define ia_deque_fini(deque, T) \
+    ia_deque_fini_(deque, ia_ssizeof(T))
+
+/** Appends an item at the tail, doubles the capacity if the deque is full. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_deque_push_(
+    ia_deque   *deque,
+    i32         stride,
+    void const *item);
+/** Macro helper for typed deque push. */
+#define ia_deque_push(deque, T, item) \
+    ia_deque_push_(deque, ia_ssizeof(T), ia_reinterpret_cast(void const *, item))
+
+/** Prepends an item at the head, doubles the capacity if the deque is full. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_deque_unshift_(
+    ia_deque   *deque,
+    i32         stride,
+    void const *item);
+/** Macro helper for typed deque unshift. */
+#define ia_deque_unshift(deque, T, item) \
+    ia_deque_unshift_(deque, ia_ssizeof(T), ia_reinterpret_cast(void const *, item))
+
+/** Removes the item at the tail and copies it into `out`, may shrink the deque.
+ *  @return `false` if the deque is empty. */
+IA_NONNULL_ALL IA_HOT_FN IA_API bool IA_CALL
+ia_deque_pop_(
+    ia_deque   *deque,
+    i32         stride,
+    void       *out);
+/** Macro helper for typed deque pop. */
+#define ia_deque_pop(deque, T, out) \
+    ia_deque_pop_(deque, ia_ssizeof(T), ia_reinterpret_cast(void *, out))
+
+/** Removes the item at the head and copies it into `out`, may shrink the deque.
+ *  @return `false` if the deque is empty. */
+IA_NONNULL_ALL IA_HOT_FN IA_API bool IA_CALL
+ia_deque_shift_(
+    ia_deque   *deque,
+    i32         stride,
+    void       *out);
+/** Macro helper for typed deque shift. */
+#define ia_deque_shift(deque, T, out) \
+    ia_deque_shift_(deque, ia_ssizeof(T), ia_reinterpret_cast(void *, out))
+
+/** Removes all items, shrinks to the minimum capacity unless shrinking is disabled or the
+ *  deque uses the drift allocator. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_deque_clear_(
+    ia_deque   *deque,
+    i32         stride);
+/** Macro helper for typed deque clear. */
+#define ia_deque_clear(deque, T) \
+    ia_deque_clear_(deque, ia_ssizeof(T))
+
+/** @return Pointer to the item at position `idx` counted from the head. */
+IA_FORCE_INLINE void *
+ia_deque_at_(
+    ia_deque const *deque,
+    i32             stride,
+    i32             idx)
+{
+    ia_dbg_assert((u32)idx < (u32)deque->len, "Index %d out of range of %s[%d].", idx, deque->dbg_name, deque->len);
+    return ia_elem_(deque->v, stride, (deque->head + idx) & (deque->cap - 1));
+}
+/** Typed deque element access. */
+#define ia_deque_at(deque, T, idx) \
+    ia_reinterpret_cast(T *, ia_deque_at_(deque, ia_ssizeof(T), idx))
+#define ia_deque_first(deque, T)    ia_deque_at(deque, T, 0)
+#define ia_deque_last(deque, T)     ia_deque_at(deque, T, (deque)->len - 1)
+#define ia_deque_is_empty(deque)    ((deque)->len == 0)
+
+/** A circular buffer of the work-stealing deque. */
+typedef struct ia_deque_ws_buffer {
+    isize                       mask;
+    atomic_uptr                 cells[];
+} ia_deque_ws_buffer;
+
+/** The work-stealing deque of pointers. The bottom is owned by a single thread. */
+typedef struct IA_CACHELINE_ALIGNMENT ia_deque_ws {
+    atomic_isize                top;
+    u8 _pad0[IA_CACHELINE_SIZE - sizeof(atomic_isize)];
+
+    atomic_isize                bottom;
+    IA_ATOMIC(ia_deque_ws_buffer *) buffer;
+    u8 _pad1[IA_CACHELINE_SIZE - sizeof(atomic_isize) - sizeof(void *)];
+} ia_deque_ws;
+
+/** Initializes an empty work-stealing deque, capacity must be a power of two. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_deque_ws_init(
+    ia_deque_ws    *ws,
+    isize           cap);
+
+/** Owner only. Pushes an item at the bottom, grows the buffer if it's full. */
+IA_NONNULL(1) IA_HOT_FN IA_API void IA_CALL
+ia_deque_ws_push(
+    ia_deque_ws    *ws,
+    void           *item);
+
+/** Owner only. Pops the most recently pushed item from the bottom.
+ *  @return `false` if the deque is empty, or a thief took the last item. */
+IA_NONNULL_ALL IA_HOT_FN IA_API bool IA_CALL
+ia_deque_ws_pop(
+    ia_deque_ws    *ws,
+    void          **out);
+
+/** Any thread. Steals the oldest item from the top.
+ *  @return `false` if the deque is empty, or the item was taken by someone else. */
+IA_NONNULL_ALL IA_HOT_FN IA_API bool IA_CALL
+ia_deque_ws_steal(
+    ia_deque_ws    *ws,
+    void          **out);
+
+/** @return Approximate count of items, may be stale by the time it's returned. */
+IA_FORCE_INLINE isize
+ia_deque_ws_len(ia_deque_ws *ws)
+{
+    isize b = ia_atomic_read_monotonic(&ws->bottom);
+    isize t = ia_atomic_read_monotonic(&ws->top);
+    return b > t ? b - t : 0;
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,230 @@
+#pragma once
+/** @file ia/datastructures/ecs.h
+ *  @brief Archetype-based entity component storage.
+ *
+ *  Entities with the same set of components share an archetype. An archetype stores its entities
+ *  in fixed-size chunks of `IA_ECS_CHUNK_SIZE` bytes, laid out as a structure of arrays: the entity
+ *  column first, followed by one column per component. Every column starts at a cacheline boundary,
+ *  so systems can iterate them with aligned `ia_simd_*` reads and writes. Rows are kept dense, so
+ *  destroying an entity or removing it from an archetype moves the last row into the hole.
+ *
+ *  Adding or removing a component moves an entity into another archetype, copying its components
+ *  between chunks. Transitions between archetypes are cached on both sides, so after the first move
+ *  the target archetype is found by a single lookup.
+ *
+ *  Component sets are `ia_bitset` masks indexed by the component id, entities are `ia_identifier`
+ *  handles from an `ia_sparse` set, which also stores the entity's archetype and row. A destroyed
+ *  entity's handle becomes stale, as the version is bumped.
+ *
+ *  Queries select archetypes by required and excluded components. Iteration walks matching chunks,
+ *  one chunk is the unit of work that can be handed to a job, see `ia_ecs_query_parallel`.
+ *  Structural changes (create, destroy, add, remove) are not allowed during iteration.
+ *
+ *  Memory is allocated through the drift allocator.
+ *
+ *  [Building an ECS #2: Archetypes and Vectorization]
+ *  https://ajmmertens.medium.com/building-an-ecs-2-archetypes-and-vectorization-fe21690805f9
+ *
+ *  [Unity ECS Concepts]
+ *  https://docs.unity3d.com/Packages/com.unity.entities@1.0/manual/concepts-archetypes.html
+ */
+#include <ia/base/types.h>
+#include <ia/datastructures/bitset.h>
+#include <ia/datastructures/darray.h>
+#include <ia/datastructures/sparse.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Size of a single chunk of archetype storage. */
+#define IA_ECS_CHUNK_SIZE               (16 * 1024)
+
+/** Upper limit of components accessed by a single query. */
+#define IA_ECS_QUERY_MAX_COMPONENTS     16
+
+/** Upper limit of jobs a parallel query is split into. */
+#define IA_ECS_QUERY_MAX_JOBS           64
+
+/** An entity handle, it's index and version come from the entity sparse set. */
+typedef struct { ia_identifier id; } ia_entity;
+
+/** An index of a registered component type. */
+typedef i32 ia_component;
+
+/** Describes a component type. A size of zero defines a tag, it takes no storage. */
+typedef struct ia_component_info {
+    i32                 size;
+    i32                 alignment;  /**< At most `IA_CACHELINE_SIZE`. */
+    char const         *name;
+} ia_component_info;
+
+/** A set of entities sharing the same components. */
+typedef struct ia_ecs_archetype {
+    ia_bitset           mask;           /**< Components of this archetype. */
+    ia_component       *components;     /**< Sorted component ids, `component_count` entries. */
+    i32                *column_offsets; /**< Byte offset of every component column within a chunk. */
+    i32                *column_sizes;   /**< Stride of every component column. */
+    i32                 component_count;
+    i32                 chunk_capacity; /**< Rows per chunk. */
+    i32                 count;          /**< Rows in use, all chunks but the last are full. */
+    ia_darray           chunks;         /**< darray<u8 *> - chunk storage, the entity column is at offset 0. */
+    ia_darray           add_edges;      /**< darray<i32> - archetype plus one after adding a component. */
+    ia_darray           remove_edges;   /**< darray<i32> - archetype plus one after removing a component. */
+} ia_ecs_archetype;
+
+/** The entity component storage. */
+typedef struct ia_ecs {
+    ia_sparse           entities;       /**< sparse<ia_ecs_record> */
+    ia_darray           components;     /**< darray<ia_component_info> */
+    ia_darray           archetypes;     /**< darray<ia_ecs_archetype>, the first one has no components. */
+} ia_ecs;
+
+/** Location of an entity's components. */
+typedef struct ia_ecs_record {
+    i32                 archetype;
+    i32                 row;
+} ia_ecs_record;
+
+/** Initializes an empty storage. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_ecs_init(ia_ecs *ecs);
+
+/** Releases the storage, all entity handles become invalid. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_ecs_fini(ia_ecs *ecs);
+
+/** Registers a component type.
+ *  @return Component id used by other calls. */
+IA_NONNULL_ALL IA_API ia_component IA_CALL
+ia_ecs_register_component(
+    ia_ecs                     *ecs,
+    ia_component_info const    *info);
+
+/** Creates an entity without components. */
+IA_NONNULL_ALL IA_API ia_entity IA_CALL
+ia_ecs_create(ia_ecs *ecs);
+
+/** Destroys an entity and its components.
+ *  @return `false` if the entity was not alive. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_ecs_destroy(
+    ia_ecs         *ecs,
+    ia_entity       entity);
+
+/** @return `true` if the entity handle is alive. */
+IA_FORCE_INLINE bool
+ia_ecs_is_alive(
+    ia_ecs const   *ecs,
+    ia_entity       entity)
+{ return ia_sparse_contains(&ecs->entities, entity.id); }
+
+/** Adds a component to the entity, moving it into another archetype. If the entity already
+ *  has the component nothing is moved. New component data is zeroed.
+ *  @return Pointer to the component data, valid until the next structural change, or nullptr if dead. */
+IA_NONNULL_ALL IA_API void *IA_CALL
+ia_ecs_add(
+    ia_ecs         *ecs,
+    ia_entity       entity,
+    ia_component    component);
+
+/** Removes a component from the entity, moving it into another archetype.
+ *  @return `false` if the entity is dead or doesn't have the component. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_ecs_remove(
+    ia_ecs         *ecs,
+    ia_entity       entity,
+    ia_component    component);
+
+/** @return Pointer to the component data, or nullptr if the entity is dead, doesn't have
+ *          the component, or the component is a tag. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void *IA_CALL
+ia_ecs_get(
+    ia_ecs const   *ecs,
+    ia_entity       entity,
+    ia_component    component);
+
+/** @return `true` if the entity is alive and has the component. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_ecs_has(
+    ia_ecs const   *ecs,
+    ia_entity       entity,
+    ia_component    component);
+
+/** Selects archetypes that have all of `with` components and none of `without` components.
+ *  The columns of a chunk view follow the order of the `components` array. */
+typedef struct ia_ecs_query {
+    ia_bitset           with;
+    ia_bitset           without;
+    i32                 component_count;
+    ia_component        components[IA_ECS_QUERY_MAX_COMPONENTS];
+} ia_ecs_query;
+
+/** Initializes a query, components to access are required by the query.
+ *  @return `false` if there are more than `IA_ECS_QUERY_MAX_COMPONENTS` components, the query
+ *          is then left without components and must not be used. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_ecs_query_init(
+    ia_ecs_query       *query,
+    i32                 component_count,
+    ia_component const *components);
+
+/** Requires a component without accessing it, for tags. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_ecs_query_with(
+    ia_ecs_query       *query,
+    ia_component        component);
+
+/** Excludes archetypes with the component. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_ecs_query_without(
+    ia_ecs_query       *query,
+    ia_component        component);
+
+/** A chunk of entities matched by a query. Column pointers are cacheline aligned. */
+typedef struct ia_ecs_chunk_view {
+    ia_entity const    *entities;
+    void               *columns[IA_ECS_QUERY_MAX_COMPONENTS];  /**< nullptr for tags. */
+    i32                 count;
+} ia_ecs_chunk_view;
+
+/** Iterates chunks of a query. */
+typedef struct ia_ecs_iter {
+    ia_ecs const       *ecs;
+    ia_ecs_query const *query;
+    i32                 archetype;
+    i32                 chunk;
+    ia_ecs_chunk_view   view;
+} ia_ecs_iter;
+
+/** Starts an iteration over chunks matching the query. */
+IA_FORCE_INLINE ia_ecs_iter
+ia_ecs_query_iter(
+    ia_ecs const       *ecs,
+    ia_ecs_query const *query)
+{ return (ia_ecs_iter){ .ecs = ecs, .query = query, .archetype = 0, .chunk = -1 }; }
+
+/** Advances to the next non-empty chunk, writes it to `iter->view`.
+ *  @return `false` after the last chunk. */
+IA_NONNULL_ALL IA_HOT_FN IA_API bool IA_CALL
+ia_ecs_iter_next(ia_ecs_iter *iter);
+
+/** A system invoked for a chunk of entities. */
+typedef void (IA_CALL *ia_ecs_system_fn)(
+    void                       *userdata,
+    ia_ecs_chunk_view const    *view);
+
+/** Runs a system over all chunks matching the query, split into at most `job_count` jobs of
+ *  contiguous chunk ranges. Must be called from a fiber of the job system, returns when all jobs
+ *  are done. The system may write to components but may not make structural changes. */
+IA_NONNULL(1,2,3) IA_API void IA_CALL
+ia_ecs_query_parallel(
+    ia_ecs                 *ecs,
+    ia_ecs_query const     *query,
+    ia_ecs_system_fn        system,
+    void                   *userdata,
+    i32                     job_count);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
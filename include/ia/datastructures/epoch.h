@@ -0,0 +1,113 @@
+#pragma once
+/** @file ia/datastructures/epoch.h
+ *  @brief Epoch-based memory reclamation for lock-free data structures.
+ *
+ *  A lock-free structure can't free a node right after unlinking it, other threads may still hold
+ *  a pointer they loaded before. With epochs, readers pin the domain around every access, and the
+ *  writer retires unlinked nodes instead of freeing them. The domain has a global epoch counter that
+ *  advances only when every pinned worker has observed the current epoch. A node retired when the
+ *  global epoch was `e` is freed once the epoch reaches `e + 2`, by then every worker that could
+ *  have loaded the node has unpinned.
+ *
+ *  [Practical lock-freedom]
+ *  https://www.cl.cam.ac.uk/techreports/UCAM-CL-TR-579.pdf
+ *
+ *  [Crossbeam epoch-based garbage collection]
+ *  https://aturon.github.io/blog/2015/08/27/epoch/
+ *
+ *  State is kept per worker thread, indexed by `ia_worker_thread_index()`, not per OS thread, and
+ *  a fiber may migrate between workers at a yield (see `ia/base/work.h`). So a pinned section must
+ *  not yield, it pins and unpins within a single execution slice of the fiber. Debug builds assert
+ *  that the fiber unpins on the worker it pinned on. Every fiber switch point is outside of pinned
+ *  sections, so a worker that is switching fibers never holds back the epoch. Nested pins of the
+ *  same worker are counted, only the outermost one publishes the epoch.
+ *
+ *  Retired nodes go to a list of the current worker, no other thread touches it. Every
+ *  `IA_EPOCH_COLLECT_INTERVAL` retires the worker tries to advance the epoch and frees the expired
+ *  prefix of its list. Pinned sections are short, so the epoch lags behind by at most the longest
+ *  pinned section. Memory overhead is bounded: when the list of an unpinned worker holds more than
+ *  `IA_EPOCH_RETIRE_LIMIT` nodes, it waits for the epoch to advance until it's back under the limit.
+ *  At most `(thread_count + 1) * IA_EPOCH_RETIRE_LIMIT` nodes are pending, plus the nodes retired
+ *  within pinned sections that are still running.
+ *
+ *  Memory of the domain is allocated through the drift allocator.
+ */
+#include <ia/base/types.h>
+#include <ia/base/atomic.h>
+#include <ia/datastructures/darray.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Count of retires after which a worker tries to advance the epoch and collect. */
+#define IA_EPOCH_COLLECT_INTERVAL   64
+
+/** Count of pending retired nodes of a worker, above which it waits for reclamation. */
+#define IA_EPOCH_RETIRE_LIMIT       1024
+
+/** Frees a retired node. */
+typedef void (IA_CALL *ia_epoch_free_fn)(void *userdata, void *node);
+
+/** Per-worker state of the domain, on its own cacheline. */
+typedef struct IA_CACHELINE_ALIGNMENT ia_epoch_worker {
+    atomic_u64              state;      /**< Observed epoch shifted left by one, the lowest bit is set while pinned. */
+    i32                     depth;      /**< Nesting of pins. */
+    i32                     since_collect;
+    ia_darray               retired;    /**< darray<epoch_retired> - in order of retirement, so in order of epochs. */
+} ia_epoch_worker;
+
+/** The reclamation domain, shared by all workers. */
+typedef struct IA_CACHELINE_ALIGNMENT ia_epoch {
+    atomic_u64              global;
+    u8 _pad0[IA_CACHELINE_SIZE - sizeof(atomic_u64)];
+
+    ia_epoch_worker        *workers;
+    i32                     worker_count;
+} ia_epoch;
+
+/** Proof of a pinned section, it's passed to `ia_epoch_unpin`. */
+typedef struct ia_epoch_guard {
+    ia_epoch_worker        *worker;
+} ia_epoch_guard;
+
+/** Initializes the domain for worker indices [0..thread_count]. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_epoch_init(
+    ia_epoch   *epoch,
+    i32         thread_count);
+
+/** Frees all retired nodes, no worker may be pinned and no node may be retired anymore. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_epoch_fini(ia_epoch *epoch);
+
+/** Pins the current worker, nodes it loads from a lock-free structure stay alive until it unpins.
+ *  The fiber must not yield before it unpins. */
+IA_NONNULL_ALL IA_HOT_FN IA_API ia_epoch_guard IA_CALL
+ia_epoch_pin(ia_epoch *epoch);
+
+/** Unpins the current worker. The outermost unpin waits for reclamation if the worker's retire
+ *  list is over `IA_EPOCH_RETIRE_LIMIT`. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_epoch_unpin(
+    ia_epoch       *epoch,
+    ia_epoch_guard *guard);
+
+/** Retires a node that is already unlinked from the structure, `free_fn` is called on it when no worker
+ *  can reach it anymore. It may be called from a pinned section or outside of one. */
+IA_NONNULL(1,2,3) IA_HOT_FN IA_API void IA_CALL
+ia_epoch_retire(
+    ia_epoch           *epoch,
+    void               *node,
+    ia_epoch_free_fn    free_fn,
+    void               *userdata);
+
+/** Tries to advance the epoch and frees the expired nodes retired by the current worker.
+ *  Meant for quiescent points, e.g. the end of a frame.
+ *  @return Count of nodes still pending on the current worker. */
+IA_NONNULL_ALL IA_API isize IA_CALL
+ia_epoch_collect(ia_epoch *epoch);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
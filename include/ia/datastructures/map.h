@@ -2,7 +2,15 @@
 /** @file ia/datastructures/map.h
  *  @brief Map data structure.
  * 
- *  TODO docs 
+ *  An unordered map of 64-bit keys to 64-bit values. Keys are spread across a power of two
+ *  count of buckets with Fibonacci hashing, so integer keys that are close to each other land
+ *  in different buckets. Every bucket is a linked list of entries. When the count of entries
+ *  exceeds the count of buckets, the bucket array is doubled and entries are relinked.
+ *  Removed entries are kept in a free list for reuse. Memory is allocated through the drift
+ *  allocator.
+ *
+ *  [Fibonacci Hashing: The Optimization that the World Forgot]
+ *  https://probablydance.com/2018/06/16/fibonacci-hashing-the-optimization-that-the-world-forgot-or-a-better-alternative-to-integer-modulo/
  */
 #include <ia/base/types.h>
 
@@ -29,6 +37,7 @@ typedef struct ia_map {
     u32                     bucket_count;
     u32                     count : 26;
     u32                     bucket_shift : 6;
+    ia_bucket_entry        *free_entries;
 } ia_map;
 
 typedef struct ia_map_iter {
@@ -38,6 +47,51 @@ typedef struct ia_map_iter {
     ia_map_data            *res;
 } ia_map_iter;
 
+/** Initializes an empty map. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_map_init(ia_map *map);
+
+/** Releases memory of the map. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_map_fini(ia_map *map);
+
+/** @return Pointer to the value of a key, or nullptr if the key is not in the map. */
+IA_NONNULL_ALL IA_HOT_FN IA_API ia_map_value *IA_CALL
+ia_map_get(
+    ia_map const   *map,
+    ia_map_key      key);
+
+/** Inserts the key with a zero value if it's not in the map.
+ *  @return Pointer to the value, valid until the key is removed. */
+IA_NONNULL_ALL IA_HOT_FN IA_API ia_map_value *IA_CALL
+ia_map_ensure(
+    ia_map         *map,
+    ia_map_key      key);
+
+/** Removes the key from the map.
+ *  @return `false` if the key was not in the map. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_map_remove(
+    ia_map         *map,
+    ia_map_key      key);
+
+/** Count of entries in the map. */
+#define ia_map_count(map)   ((i32)(map)->count)
+
+/** Starts an iteration over the map, entries must not be inserted or removed while iterating. */
+IA_FORCE_INLINE ia_map_iter
+ia_map_iter_init(ia_map const *map)
+{ return (ia_map_iter){ .map = map, .bucket = nullptr, .entry = nullptr, .res = nullptr }; }
+
+/** Advances the iterator to the next entry.
+ *  @return `false` after the last entry. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_map_next(ia_map_iter *iter);
+
+/** Key and value of the current entry of an iterator. */
+#define ia_map_key(iter)    ((iter)->res[0])
+#define ia_map_value(iter)  ((iter)->res[1])
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
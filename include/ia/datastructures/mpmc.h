@@ -58,10 +58,10 @@ ia_mpmc_init_(
 #ifdef IA_DEBUG
     mpmc->dbg_name = type_name;
 #endif
-    for (isize i; i < cell_count; i++) 
+    for (isize i = 0; i < cell_count; i++) 
         ia_atomic_write_monotonic(&mpmc->sequence[i], i);
-    ia_atomic_write_monotonic(&mpmc->enqueue_pos, 0); \
-    ia_atomic_write_monotonic(&mpmc->dequeue_pos, 0); \
+    ia_atomic_write_monotonic(&mpmc->enqueue_pos, 0);
+    ia_atomic_write_monotonic(&mpmc->dequeue_pos, 0);
 }
 /** Typed macro helper for `ia_mpmc_init_`. */
 #define ia_mpmc_init(mpmc, T, cell_count, data_buffer, sequence_buffer) \
@@ -75,6 +75,17 @@ ia_mpmc_rotate(
     isize const     pos_delta,
     isize          *out_pos);
 
+/** Either enqueue into or dequeue from the MPMC ring buffer, claiming a contiguous range of up to
+ *  `max_count` cells with a single CAS on the cursor. Only cells that are ready are claimed.
+ *  @return Count of claimed cells, starting at `out_pos`. */
+IA_NONNULL_ALL IA_HOT_FN IA_API isize IA_CALL
+ia_mpmc_rotate_n(
+    ia_mpmc        *mpmc,
+    atomic_isize   *in_or_out,
+    isize const     pos_delta,
+    isize           max_count,
+    isize          *out_pos);
+
 /** The producer. Data within cells is persistent, so submissions can be made from the stack. */
 IA_NONNULL_ALL IA_FORCE_INLINE bool
 ia_mpmc_enqueue_(
@@ -103,7 +114,7 @@ ia_mpmc_dequeue_(
     void           *target)
 {
     isize pos;
-    bool success = ia_mpmc_rotate(mpmc, &mpmc->dequeue_pos, mpmc->mask, &pos);
+    bool success = ia_mpmc_rotate(mpmc, &mpmc->dequeue_pos, 1, &pos);
     if (success) {
         isize at = pos & mpmc->mask;
         memcpy(target, ia_elem_(mpmc->data, stride, at), stride);
@@ -115,6 +126,50 @@ ia_mpmc_dequeue_(
 #define ia_mpmc_dequeue(mpmc, T, target) \
     ia_mpmc_dequeue_(mpmc, ia_ssizeof(T), ia_reinterpret_cast(void *, target))
 
+/** The batched producer. Enqueues up to `count` elements from a contiguous array, all in one claim.
+ *  @return Count of enqueued elements, less than `count` if the ring buffer is near full. */
+IA_NONNULL_ALL IA_FORCE_INLINE isize
+ia_mpmc_enqueue_n_(
+    ia_mpmc        *mpmc,
+    isize           stride,
+    void const     *submit,
+    isize           count)
+{
+    isize pos;
+    isize n = ia_mpmc_rotate_n(mpmc, &mpmc->enqueue_pos, 0, count, &pos);
+    for (isize i = 0; i < n; i++) {
+        isize at = (pos + i) & mpmc->mask;
+        memcpy(ia_elem_(mpmc->data, stride, at), ia_elem_(submit, stride, i), stride);
+        ia_atomic_write(&mpmc->sequence[at], pos + i + 1, ia_atomic_model_release);
+    }
+    return n;
+}
+/** Macro helper for typed batched MPMC enqueue. */
+#define ia_mpmc_enqueue_n(mpmc, T, submit, count) \
+    ia_mpmc_enqueue_n_(mpmc, ia_ssizeof(T), ia_reinterpret_cast(void const *, submit), count)
+
+/** The batched consumer. Dequeues up to `count` elements into a contiguous array, all in one claim.
+ *  @return Count of dequeued elements, less than `count` if the ring buffer is near empty. */
+IA_NONNULL_ALL IA_FORCE_INLINE isize
+ia_mpmc_dequeue_n_(
+    ia_mpmc        *mpmc,
+    isize           stride,
+    void           *target,
+    isize           count)
+{
+    isize pos;
+    isize n = ia_mpmc_rotate_n(mpmc, &mpmc->dequeue_pos, 1, count, &pos);
+    for (isize i = 0; i < n; i++) {
+        isize at = (pos + i) & mpmc->mask;
+        memcpy(ia_elem_(target, stride, i), ia_elem_(mpmc->data, stride, at), stride);
+        ia_atomic_write(&mpmc->sequence[at], pos + i + mpmc->mask + 1, ia_atomic_model_release);
+    }
+    return n;
+}
+/** Macro helper for typed batched MPMC dequeue. */
+#define ia_mpmc_dequeue_n(mpmc, T, target, count) \
+    ia_mpmc_dequeue_n_(mpmc, ia_ssizeof(T), ia_reinterpret_cast(void *, target), count)
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
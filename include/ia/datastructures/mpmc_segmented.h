@@ -0,0 +1,112 @@
+#pragma once
+/** @file ia/datastructures/mpmc_segmented.h
+ *  @brief Unbounded multiple-producer multiple-consumer queue.
+ *
+ *  The queue is a linked list of fixed power-of-two ring segments, every segment is an `ia_mpmc`
+ *  ring that is filled once and never wraps around. Producers claim a cell with a single fetch-add
+ *  on the tail segment's enqueue position. When the claimed position falls past the end of the
+ *  segment, the segment is closed, and the producer links a new one behind it, placing its element
+ *  in the first cell before publishing the link. Producers never fail, they only allocate when the
+ *  pool of recycled segments is empty.
+ *
+ *  Consumers walk the head segment like the bounded ring. When all cells of the head segment are
+ *  consumed and a next segment is linked, the head advances and the drained segment is retired.
+ *
+ *  A retired segment may still be accessed by threads that loaded it as the head or tail. Every
+ *  worker thread publishes the segment it's working on in a hazard slot indexed by
+ *  `ia_worker_thread_index()`, padded to a cacheline. Retired segments are recycled into the pool
+ *  only after no hazard slot refers to them. An operation never yields, so a fiber can't migrate
+ *  while it holds a hazard. The retire list and the pool are guarded by a spinlock, they're touched
+ *  once per segment, not once per element.
+ *
+ *  [Hazard Pointers: Safe Memory Reclamation for Lock-Free Objects]
+ *  https://www.cs.otago.ac.nz/cosc440/readings/hazard-pointers.pdf
+ *
+ *  [Fast Concurrent Queues for x86 Processors]
+ *  https://www.cs.tau.ac.il/~mad/publications/ppopp2013-x86queues.pdf
+ */
+#include <ia/base/types.h>
+#include <ia/base/atomic.h>
+#include <ia/datastructures/mpmc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** A ring segment of the unbounded queue, its data and sequence buffers follow the structure. */
+typedef struct IA_CACHELINE_ALIGNMENT ia_mpmc_segment {
+    ia_mpmc                                 ring;
+    IA_ATOMIC(struct ia_mpmc_segment *)     next;       /**< Next segment in the queue. */
+    struct ia_mpmc_segment                 *free_next;  /**< Next segment in the retire list or pool. */
+} ia_mpmc_segment;
+
+/** A hazard slot of a single worker thread. */
+typedef struct IA_CACHELINE_ALIGNMENT ia_mpmc_hazard {
+    IA_ATOMIC(ia_mpmc_segment *)            segment;
+    u8 _pad0[IA_CACHELINE_SIZE - sizeof(void *)];
+} ia_mpmc_hazard;
+
+/** The unbounded MPMC queue. */
+typedef struct IA_CACHELINE_ALIGNMENT ia_mpmc_segmented {
+    IA_ATOMIC(ia_mpmc_segment *)            head;
+    u8 _pad0[IA_CACHELINE_SIZE - sizeof(void *)];
+
+    IA_ATOMIC(ia_mpmc_segment *)            tail;
+    u8 _pad1[IA_CACHELINE_SIZE - sizeof(void *)];
+
+    ia_spinlock                             lock;
+    ia_mpmc_segment                        *retired    IA_THREAD_SAFETY_GUARDED_BY(lock);
+    ia_mpmc_segment                        *pool       IA_THREAD_SAFETY_GUARDED_BY(lock);
+    ia_mpmc_hazard                         *hazards;
+    i32                                     hazard_count;
+    isize                                   stride;
+    isize                                   cell_count;
+#ifdef IA_DEBUG
+    char const                             *dbg_name;
+#endif
+} ia_mpmc_segmented;
+
+/** Initializes the queue with one empty segment. Cell count of every segment must be a power of 2,
+ *  stride must be sizeof(T). Hazard slots are allocated for worker indices [0..thread_count].
+ *  Memory is allocated through the drift allocator. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_mpmc_segmented_init_(
+    ia_mpmc_segmented  *mpmc,
+    isize               stride,
+    isize               cell_count,
+    i32                 thread_count,
+    char const         *type_name);
+/** Typed macro helper for `ia_mpmc_segmented_init_`. */
+#define ia_mpmc_segmented_init(mpmc, T, cell_count, thread_count) \
+    ia_mpmc_segmented_init_(mpmc, ia_ssizeof(T), cell_count, thread_count, "mpmc_segmented<"#T">")
+
+/** Preallocates segments into the pool, so bursts of producers don't have to allocate. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_mpmc_segmented_reserve(
+    ia_mpmc_segmented  *mpmc,
+    i32                 segment_count);
+
+/** The producer, it never fails. Data is copied into the queue, so submissions can be made from the stack. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_mpmc_segmented_enqueue_(
+    ia_mpmc_segmented  *mpmc,
+    isize               stride,
+    void const         *submit);
+/** Macro helper for typed segmented MPMC enqueue. */
+#define ia_mpmc_segmented_enqueue(mpmc, T, submit) \
+    ia_mpmc_segmented_enqueue_(mpmc, ia_ssizeof(T), ia_reinterpret_cast(void const *, submit))
+
+/** The consumer. Copies the data within the queue into a target data of the same type.
+ *  @return `false` if the queue is empty. */
+IA_NONNULL_ALL IA_HOT_FN IA_API bool IA_CALL
+ia_mpmc_segmented_dequeue_(
+    ia_mpmc_segmented  *mpmc,
+    isize               stride,
+    void               *target);
+/** Macro helper for typed segmented MPMC dequeue. */
+#define ia_mpmc_segmented_dequeue(mpmc, T, target) \
+    ia_mpmc_segmented_dequeue_(mpmc, ia_ssizeof(T), ia_reinterpret_cast(void *, target))
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
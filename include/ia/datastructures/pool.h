@@ -0,0 +1,132 @@
+#pragma once
+/** @file ia/datastructures/pool.h
+ *  @brief Generational handle pool of fixed-size slots.
+ *
+ *  Resource handles (render, audio, video and XR objects) are `ia_identifier` values, an index of
+ *  a slot in the lower 32 bits and its version in the upper 32 bits. The pool hands out slots and
+ *  stores their payloads in a single array, indexed directly by the handle index. Every slot keeps
+ *  its current version in a parallel array. A handle is valid while its version matches the slot's,
+ *  so validating a handle on a hot path is one load and one compare, there is no map lookup.
+ *
+ *  Versions of alive slots are odd, versions of free slots are even. Both acquiring and releasing
+ *  a slot bumps its version, so a released handle is stale forever (until the 32-bit version wraps
+ *  around). Handles with an even version are rejected before the load, so a free slot never validates,
+ *  even for a made-up handle, and the empty identifier (version 0) is never valid.
+ *
+ *  Free slots are kept in a lock-free LIFO list, linked by slot indices. The list head is tagged with
+ *  a counter bumped on every change, so a slot that is popped and pushed back between a load and a
+ *  CAS can't corrupt the list (the ABA problem). Slots that were never used are handed out from a
+ *  watermark, so initialization doesn't touch the whole pool. Any thread may acquire and release.
+ *
+ *  Validation detects handles released before, it doesn't keep a slot alive. A thread that reads
+ *  a payload while another thread releases its slot must synchronize on its own, e.g. by deferring
+ *  the release to the end of a frame.
+ *
+ *  Memory is allocated through the drift allocator.
+ *
+ *  [Handles are the better pointers]
+ *  https://floooh.github.io/2018/06/17/handles-vs-pointers.html
+ *
+ *  [Treiber stack]
+ *  https://en.wikipedia.org/wiki/Treiber_stack
+ */
+#include <ia/base/types.h>
+#include <ia/base/atomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** The handle pool, its capacity is fixed on initialization. */
+typedef struct IA_CACHELINE_ALIGNMENT ia_pool {
+    atomic_u64      free_head;  /**< Tag in the upper 32 bits, free slot index plus one in the lower ones. */
+    u8         _pad0[IA_CACHELINE_SIZE - sizeof(atomic_u64)];
+
+    atomic_i32      watermark;  /**< Slots at and above it were never used. */
+    atomic_i32      count;      /**< Alive slots. */
+    u8         _pad1[IA_CACHELINE_SIZE - 2 * sizeof(atomic_i32)];
+
+    void           *data;       /**< Payloads, `stride` bytes per slot. */
+    atomic_u32     *versions;
+    atomic_u32     *next;       /**< Free list links, index plus one. */
+    isize           stride;
+    i32             capacity;
+#ifdef IA_DEBUG
+    char const     *dbg_name;
+#endif
+} ia_pool;
+
+/** Initializes the pool with `capacity` slots, stride must be sizeof(T) and may be zero. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_pool_init_(
+    ia_pool        *pool,
+    isize           stride,
+    i32             capacity,
+    char const     *type_name);
+/** Typed macro helper for `ia_pool_init_`. */
+#define ia_pool_init(pool, T, capacity) \
+    ia_pool_init_(pool, ia_ssizeof(T), capacity, "pool<"#T">")
+
+/** Acquires a free slot, its payload is zeroed.
+ *  @return A new handle, or an empty identifier if the pool is full. */
+IA_NONNULL_ALL IA_HOT_FN IA_API ia_identifier IA_CALL
+ia_pool_acquire(ia_pool *pool);
+
+/** Releases the slot of a valid handle, the handle and its copies become stale.
+ *  @return `false` if the handle was already stale. */
+IA_NONNULL_ALL IA_HOT_FN IA_API bool IA_CALL
+ia_pool_release(
+    ia_pool        *pool,
+    ia_identifier   handle);
+
+/** @return `true` if the handle refers to an alive slot of its version. */
+IA_NONNULL_ALL IA_FORCE_INLINE bool
+ia_pool_is_valid(
+    ia_pool const  *pool,
+    ia_identifier   handle)
+{
+    u32 index = ia_identifier_get_index(handle);
+    u32 version = ia_identifier_get_version(handle);
+    /* an even version never belongs to an alive slot, it would match a free one */
+    return (version & 1) && index < (u32)pool->capacity
+        && ia_atomic_read(&pool->versions[index], ia_atomic_model_acquire) == version;
+}
+
+/** @return Pointer to the payload of a valid handle, nullptr if the handle is stale. */
+IA_NONNULL_ALL IA_FORCE_INLINE void *
+ia_pool_get(
+    ia_pool const  *pool,
+    ia_identifier   handle)
+{ return ia_pool_is_valid(pool, handle) ? ia_elem_(pool->data, pool->stride, ia_identifier_get_index(handle)) : nullptr; }
+
+/** Typed macro helper for `ia_pool_get`. */
+#define ia_pool_get_as(T, pool, handle) \
+    ia_reinterpret_cast(T *, ia_pool_get(pool, handle))
+
+/** Payload of a slot by its index, for iteration over [0..ia_pool_watermark). */
+#define ia_pool_at_as(T, pool, index) \
+    ia_elem((pool)->data, T, index)
+
+/** @return Count of slots that were ever used, alive ones are below it. */
+IA_NONNULL_ALL IA_FORCE_INLINE i32
+ia_pool_watermark(ia_pool const *pool)
+{ return ia_min(ia_atomic_read(&pool->watermark, ia_atomic_model_acquire), pool->capacity); }
+
+/** @return Handle of an alive slot at the given index, or an empty identifier if the slot is free. */
+IA_NONNULL_ALL IA_FORCE_INLINE ia_identifier
+ia_pool_handle_at(
+    ia_pool const  *pool,
+    i32             index)
+{
+    u32 version = ia_atomic_read(&pool->versions[index], ia_atomic_model_acquire);
+    return (version & 1) ? ia_identifier_raw(index, version) : 0;
+}
+
+/** @return Count of alive slots. */
+IA_NONNULL_ALL IA_FORCE_INLINE i32
+ia_pool_count(ia_pool const *pool)
+{ return ia_atomic_read_monotonic(&pool->count); }
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -1,8 +1,22 @@
 #pragma once
 /** @file ia/datastructures/sparse.h
  *  @brief Sparse set data structure.
- * 
- *  TODO docs 
+ *
+ *  A sparse set maps 32-bit indices to densely packed elements. The sparse array is split into
+ *  pages of `IA_SPARSE_PAGE_SIZE` entries that are allocated on first use, so large and scattered
+ *  index ranges don't waste memory. Every sparse entry stores a position into the dense array.
+ *  Element data is kept parallel to the dense array, so iteration is a linear walk over memory.
+ *  Removal swaps the last alive element into the hole, element pointers are not stable.
+ *
+ *  Indices are handed out as `ia_identifier` values, the upper 32 bits hold a version. Removing
+ *  an index bumps the version, so any identifier that still refers to the old element becomes
+ *  stale, and is rejected by `contains` and `get`. Removed identifiers stay in the dense array
+ *  past `count`, and are recycled by `ia_sparse_new_index` with their bumped version.
+ *
+ *  Memory is allocated through the drift allocator.
+ *
+ *  [Building an ECS #2: Archetypes and Vectorization]
+ *  https://ajmmertens.medium.com/building-an-ecs-2-archetypes-and-vectorization-fe21690805f9
  */
 #include <ia/base/types.h>
 #include <ia/datastructures/darray.h>
@@ -11,16 +25,105 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#define IA_SPARSE_PAGE_BITS     12
+#define IA_SPARSE_PAGE_SIZE     (1 << IA_SPARSE_PAGE_BITS)
+#define IA_SPARSE_PAGE_MASK     (IA_SPARSE_PAGE_SIZE - 1)
+
 /** Dense array with indices to sparse array. The dense array stores both alive and dead
  *  sparse indices. The `count` member keeps track of which sparse indices are alive. */
 typedef struct ia_sparse {
-    ia_darray   dense;      /**< darray<u64> */
-    ia_darray   pages;      /**< darray<internal> - chunks with sparse arrays and data. */
+    ia_darray   dense;      /**< darray<u64> - identifiers, alive ones in range [0..count). */
+    ia_darray   values;     /**< darray<stride> - element data, parallel to the dense array. */
+    ia_darray   pages;      /**< darray<i32 *> - chunks of sparse arrays, dense positions plus one. */
     i32         stride;     /**< Size of an element in the sparse array. */
     i32         count;      /**< Number of alive entries in the dense array. */
     u64         max_idx;    /**< Local max index, if no global was set. */
 } ia_sparse;
 
+/** Initializes an empty sparse set for elements of `stride` bytes, stride may be zero. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_sparse_init(
+    ia_sparse  *sparse,
+    i32         stride);
+
+/** Releases memory of the sparse set. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_sparse_fini(ia_sparse *sparse);
+
+/** Removes all elements, recycled indices and versions are kept. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_sparse_clear(ia_sparse *sparse);
+
+/** Creates an alive index, recycles a removed one if possible. The element data is zeroed.
+ *  @return A new identifier, its version is never zero. */
+IA_NONNULL_ALL IA_API ia_identifier IA_CALL
+ia_sparse_new_index(ia_sparse *sparse);
+
+/** Makes the given identifier alive, keeping its version. If the index is already alive it's
+ *  version must match. New element data is zeroed.
+ *  @return Pointer to the element data, valid until the next insert or remove. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void *IA_CALL
+ia_sparse_insert(
+    ia_sparse      *sparse,
+    ia_identifier   id);
+
+/** Removes an alive element, the last alive element is moved into its place.
+ *  @return `false` if the identifier is stale or not alive. */
+IA_NONNULL_ALL IA_HOT_FN IA_API bool IA_CALL
+ia_sparse_remove(
+    ia_sparse      *sparse,
+    ia_identifier   id);
+
+/** @return Position in the dense array plus one, or 0 if the index has no dense entry. */
+IA_FORCE_INLINE i32
+ia_sparse_dense_slot(
+    ia_sparse const    *sparse,
+    u32                 index)
+{
+    u32 page = index >> IA_SPARSE_PAGE_BITS;
+    if (page >= (u32)sparse->pages.len)
+        return 0;
+    i32 const *entries = ia_darray_as(i32 *, &sparse->pages)[page];
+    return entries ? entries[index & IA_SPARSE_PAGE_MASK] : 0;
+}
+
+/** @return Position of an alive identifier in the dense array, or -1 if stale or not alive. */
+IA_FORCE_INLINE i32
+ia_sparse_dense_index(
+    ia_sparse const    *sparse,
+    ia_identifier       id)
+{
+    i32 slot = ia_sparse_dense_slot(sparse, ia_identifier_get_index(id)) - 1;
+    if (slot < 0 || slot >= sparse->count || ia_darray_as(ia_identifier, &sparse->dense)[slot] != id)
+        return -1;
+    return slot;
+}
+
+/** @return `true` if the identifier is alive and it's version matches. */
+IA_FORCE_INLINE bool
+ia_sparse_contains(
+    ia_sparse const    *sparse,
+    ia_identifier       id)
+{ return ia_sparse_dense_index(sparse, id) >= 0; }
+
+/** @return Pointer to the element data of an alive identifier, nullptr if stale or not alive. */
+IA_FORCE_INLINE void *
+ia_sparse_get(
+    ia_sparse const    *sparse,
+    ia_identifier       id)
+{
+    i32 slot = ia_sparse_dense_index(sparse, id);
+    return slot >= 0 ? ia_elem_(sparse->values.v, sparse->stride, slot) : nullptr;
+}
+
+/** Dense identifiers of alive elements, `sparse->count` entries. */
+#define ia_sparse_ids(sparse) \
+    ((ia_identifier const *)(sparse)->dense.v)
+
+/** Dense element data of alive elements, `sparse->count` entries. */
+#define ia_sparse_values_as(T, sparse) \
+    ia_reinterpret_cast(T *, (sparse)->values.v)
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
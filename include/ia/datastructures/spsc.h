@@ -0,0 +1,206 @@
+#pragma once
+/** @file ia/datastructures/spsc.h
+ *  @brief Single-producer single-consumer ring buffer.
+ *
+ *  With exactly one producer and one consumer, the positions don't need to be claimed with a CAS.
+ *  Each side owns one position, it is the only writer of it and only ever reads the other side's
+ *  position. Every operation is a bounded number of loads and stores, so both sides are wait-free,
+ *  which makes the ring safe to use from a realtime audio callback.
+ *
+ *  Each side keeps a cached copy of the other side's position on its own cacheline. The shared
+ *  position is only read when the cached one says the ring is full (for the producer) or empty
+ *  (for the consumer), so in the steady state the cachelines don't bounce between the cores.
+ *
+ *  [A lock-free, cache-efficient shared ring buffer implementation]
+ *  https://rigtorp.se/ringbuffer/
+ *
+ *  Besides copying enqueue and dequeue, the ring has a zero-copy API. The producer reserves
+ *  a contiguous range of cells, writes into the ring memory and commits it. The consumer peeks
+ *  a contiguous range, reads it in place and releases it. A range never wraps around the end
+ *  of the ring, so a reservation may return fewer cells than are free.
+ */
+#include <ia/base/types.h>
+#include <ia/base/atomic.h>
+#include <ia/base/log.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** The SPSC ring buffer is limited to a size that is a power of two. */
+typedef struct IA_CACHELINE_ALIGNMENT ia_spsc {
+    void           *data;
+    isize           mask;
+    isize           stride;
+    u8         _pad0[IA_CACHELINE_SIZE - sizeof(void *) - 2 * sizeof(isize)];
+
+    atomic_isize    tail;           /**< Written by the producer. */
+    isize           head_cached;    /**< Producer's copy of the head. */
+    u8         _pad1[IA_CACHELINE_SIZE - sizeof(atomic_isize) - sizeof(isize)];
+
+    atomic_isize    head;           /**< Written by the consumer. */
+    isize           tail_cached;    /**< Consumer's copy of the tail. */
+    u8         _pad2[IA_CACHELINE_SIZE - sizeof(atomic_isize) - sizeof(isize) - sizeof(char const *)];
+#ifdef IA_DEBUG
+    char const     *dbg_name;
+#endif
+} ia_spsc;
+
+/** Initializes the SPSC data structure. Buffer memory must be externally managed.
+ *  Cell count must be a power of 2, stride must be sizeof(T). */
+IA_FORCE_INLINE void
+ia_spsc_init_(
+    ia_spsc        *spsc,
+    isize           stride,
+    isize           cell_count,
+    void           *data_buffer,
+    char const     *type_name)
+{
+    ia_dbg_assert(ia_is_pow2(cell_count), "%s", type_name);
+    spsc->data = data_buffer;
+    spsc->mask = cell_count - 1;
+    spsc->stride = stride;
+    spsc->head_cached = 0;
+    spsc->tail_cached = 0;
+#ifdef IA_DEBUG
+    spsc->dbg_name = type_name;
+#endif
+    ia_atomic_write_monotonic(&spsc->tail, 0);
+    ia_atomic_write_monotonic(&spsc->head, 0);
+}
+/** Typed macro helper for `ia_spsc_init_`. */
+#define ia_spsc_init(spsc, T, cell_count, data_buffer) \
+    ia_spsc_init_(spsc, ia_ssizeof(T), cell_count, data_buffer, "spsc<"#T">")
+
+/** Producer side. Reserves up to `count` contiguous cells for writing, they're not visible to
+ *  the consumer until `ia_spsc_commit` is called.
+ *  @return Count of reserved cells, starting at `*out_cells`. Zero if the ring is full. */
+IA_NONNULL_ALL IA_FORCE_INLINE isize
+ia_spsc_reserve(
+    ia_spsc        *spsc,
+    isize           count,
+    void          **out_cells)
+{
+    isize tail = ia_atomic_read_monotonic(&spsc->tail);
+    isize capacity = spsc->mask + 1;
+    isize free = capacity - (tail - spsc->head_cached);
+    if (free < count) {
+        spsc->head_cached = ia_atomic_read(&spsc->head, ia_atomic_model_acquire);
+        free = capacity - (tail - spsc->head_cached);
+    }
+    isize at = tail & spsc->mask;
+    count = ia_min(count, ia_min(free, capacity - at));
+    *out_cells = ia_elem_(spsc->data, spsc->stride, at);
+    return count;
+}
+
+/** Producer side. Publishes `count` cells written after `ia_spsc_reserve`. */
+IA_NONNULL_ALL IA_FORCE_INLINE void
+ia_spsc_commit(
+    ia_spsc        *spsc,
+    isize           count)
+{
+    isize tail = ia_atomic_read_monotonic(&spsc->tail);
+    ia_dbg_assert(count >= 0 && tail + count - spsc->head_cached <= spsc->mask + 1, "Commit of %lld cells overflows the ring.", (long long)count);
+    ia_atomic_write(&spsc->tail, tail + count, ia_atomic_model_release);
+}
+
+/** Consumer side. Peeks up to `count` contiguous cells for reading in place.
+ *  @return Count of readable cells, starting at `*out_cells`. Zero if the ring is empty. */
+IA_NONNULL_ALL IA_FORCE_INLINE isize
+ia_spsc_peek(
+    ia_spsc        *spsc,
+    isize           count,
+    void          **out_cells)
+{
+    isize head = ia_atomic_read_monotonic(&spsc->head);
+    isize avail = spsc->tail_cached - head;
+    if (avail < count) {
+        spsc->tail_cached = ia_atomic_read(&spsc->tail, ia_atomic_model_acquire);
+        avail = spsc->tail_cached - head;
+    }
+    isize at = head & spsc->mask;
+    count = ia_min(count, ia_min(avail, spsc->mask + 1 - at));
+    *out_cells = ia_elem_(spsc->data, spsc->stride, at);
+    return count;
+}
+
+/** Consumer side. Returns `count` cells read after `ia_spsc_peek` back to the producer. */
+IA_NONNULL_ALL IA_FORCE_INLINE void
+ia_spsc_release(
+    ia_spsc        *spsc,
+    isize           count)
+{
+    isize head = ia_atomic_read_monotonic(&spsc->head);
+    ia_dbg_assert(count >= 0 && head + count <= spsc->tail_cached, "Release of %lld cells underflows the ring.", (long long)count);
+    ia_atomic_write(&spsc->head, head + count, ia_atomic_model_release);
+}
+
+/** The producer. Copies up to `count` elements from a contiguous array, the copy may be split
+ *  in two at the end of the ring.
+ *  @return Count of enqueued elements, less than `count` if the ring buffer is near full. */
+IA_NONNULL_ALL IA_FORCE_INLINE isize
+ia_spsc_enqueue_n_(
+    ia_spsc        *spsc,
+    isize           stride,
+    void const     *submit,
+    isize           count)
+{
+    ia_dbg_assert(stride == spsc->stride, "Enqueue of %lld byte elements into a ring of %lld byte cells.", (long long)stride, (long long)spsc->stride);
+    isize tail = ia_atomic_read_monotonic(&spsc->tail);
+    isize capacity = spsc->mask + 1;
+    if (capacity - (tail - spsc->head_cached) < count)
+        spsc->head_cached = ia_atomic_read(&spsc->head, ia_atomic_model_acquire);
+    count = ia_min(count, capacity - (tail - spsc->head_cached));
+    if (count <= 0)
+        return 0;
+
+    isize at = tail & spsc->mask;
+    isize first = ia_min(count, capacity - at);
+    memcpy(ia_elem_(spsc->data, spsc->stride, at), submit, first * spsc->stride);
+    memcpy(spsc->data, ia_elem_(submit, spsc->stride, first), (count - first) * spsc->stride);
+    ia_atomic_write(&spsc->tail, tail + count, ia_atomic_model_release);
+    return count;
+}
+/** Macro helper for typed batched SPSC enqueue. */
+#define ia_spsc_enqueue_n(spsc, T, submit, count) \
+    ia_spsc_enqueue_n_(spsc, ia_ssizeof(T), ia_reinterpret_cast(void const *, submit), count)
+/** Macro helper for typed SPSC enqueue. */
+#define ia_spsc_enqueue(spsc, T, submit) \
+    (ia_spsc_enqueue_n_(spsc, ia_ssizeof(T), ia_reinterpret_cast(void const *, submit), 1) == 1)
+
+/** The consumer. Copies up to `count` elements into a contiguous array, the copy may be split
+ *  in two at the end of the ring.
+ *  @return Count of dequeued elements, less than `count` if the ring buffer is near empty. */
+IA_NONNULL_ALL IA_FORCE_INLINE isize
+ia_spsc_dequeue_n_(
+    ia_spsc        *spsc,
+    isize           stride,
+    void           *target,
+    isize           count)
+{
+    ia_dbg_assert(stride == spsc->stride, "Dequeue of %lld byte elements from a ring of %lld byte cells.", (long long)stride, (long long)spsc->stride);
+    isize head = ia_atomic_read_monotonic(&spsc->head);
+    if (spsc->tail_cached - head < count)
+        spsc->tail_cached = ia_atomic_read(&spsc->tail, ia_atomic_model_acquire);
+    count = ia_min(count, spsc->tail_cached - head);
+    if (count <= 0)
+        return 0;
+
+    isize at = head & spsc->mask;
+    isize first = ia_min(count, spsc->mask + 1 - at);
+    memcpy(target, ia_elem_(spsc->data, spsc->stride, at), first * spsc->stride);
+    memcpy(ia_elem_(target, spsc->stride, first), spsc->data, (count - first) * spsc->stride);
+    ia_atomic_write(&spsc->head, head + count, ia_atomic_model_release);
+    return count;
+}
+/** Macro helper for typed batched SPSC dequeue. */
+#define ia_spsc_dequeue_n(spsc, T, target, count) \
+    ia_spsc_dequeue_n_(spsc, ia_ssizeof(T), ia_reinterpret_cast(void *, target), count)
+/** Macro helper for typed SPSC dequeue. */
+#define ia_spsc_dequeue(spsc, T, target) \
+    (ia_spsc_dequeue_n_(spsc, ia_ssizeof(T), ia_reinterpret_cast(void *, target), 1) == 1)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
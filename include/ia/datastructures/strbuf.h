@@ -5,6 +5,21 @@
  *  These are meant to be used with the usual C string and memory APIs.
  *  Given that the length of the buffer is known, it's often better to 
  *  use the standard mem* functions than the str* ones (e.g. memchr vs strchr).
+ *
+ *  A string buffer is kept null-terminated after every append, and grows geometrically through
+ *  the drift allocator. The initial memory may be provided by the caller (e.g. a stack array),
+ *  it is never freed, growing only copies the string into a new allocation.
+ *
+ *  A rope is a linked list of chunks, appending never moves text that was already written,
+ *  so long logs and debug dumps don't pay for copying on growth. Chunks are allocated with
+ *  a user callback, that may be backed by an arena, or by the drift allocator if none is given.
+ *
+ *  Formatting (`appendf`) doesn't go through libc printf. It understands the printf syntax of
+ *  flags, width, precision and length modifiers, for conversions `d i u x X o c s p f F e E g G %`.
+ *  Integers are written two digits at a time from a lookup table. Floating point numbers are
+ *  formatted by scaling with powers of ten, the result may differ from a correctly rounded printf
+ *  in the last digit, which is fine for logs and debug output. Precision is limited to 17 digits,
+ *  in `%g` that is also the limit of digits after the point for values below 1.
  */
 #include <ia/base/types.h>
 
@@ -20,6 +35,19 @@ typedef struct ia_strbuf {
 
 static constexpr ia_strbuf ia_strbuf_init = { .v = nullptr, .len = 0, .alloc = 0 };
 
+/** Ensures room for `n` more bytes and a null terminator. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_strbuf_reserve(
+    ia_strbuf  *buf,
+    i32         n);
+
+/** Append exactly N bytes, the bytes may contain zeroes. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_strbuf_append(
+    ia_strbuf  *buf,
+    void const *data,
+    i32         n);
+
 /** Append the buffer using maximum of N bytes from a (preferrably null-terminated) cstr. */
 IA_API void IA_CALL 
 ia_strbuf_appendstrn(
@@ -27,6 +55,143 @@ ia_strbuf_appendstrn(
     char const *str, 
     i32         n);
 
+/** Append a null-terminated cstr. */
+IA_FORCE_INLINE void
+ia_strbuf_appendstr(
+    ia_strbuf  *buf,
+    char const *str)
+{ ia_strbuf_append(buf, str, (i32)strlen(str)); }
+
+/** Append a single character. */
+IA_FORCE_INLINE void
+ia_strbuf_appendc(
+    ia_strbuf  *buf,
+    char        c)
+{
+    if (IA_UNLIKELY(buf->len + 2 > buf->alloc))
+        ia_strbuf_reserve(buf, 1);
+    buf->v[buf->len++] = c;
+    buf->v[buf->len] = '\0';
+}
+
+/** Append a formatted string.
+ *  @return Number of bytes appended. */
+IA_API i32 IA_CALL
+ia_strbuf_appendf(
+    ia_strbuf  *buf,
+    char const *fmt,
+    ...) IA_PRINTF(2,3);
+
+/** As `ia_strbuf_appendf`, but directly accepts a variable argument list. */
+IA_API i32 IA_CALL
+ia_strbuf_appendv(
+    ia_strbuf  *buf,
+    char const *fmt,
+    va_list     args);
+
+/** Truncates the string, memory is kept. */
+IA_FORCE_INLINE void
+ia_strbuf_clear(ia_strbuf *buf)
+{
+    buf->len = 0;
+    if (buf->alloc > 0)
+        buf->v[0] = '\0';
+}
+
+/** Allocates memory for rope chunks, may return nullptr when out of memory. */
+typedef void *(IA_CALL *ia_strbuf_alloc_fn)(
+    void       *userdata,
+    isize       size,
+    isize       alignment);
+
+/** A chunk of a rope, `v` holds `len` bytes, not null-terminated. */
+typedef struct ia_strbuf_chunk {
+    struct ia_strbuf_chunk *next;
+    i32                     len, alloc;
+    char                    v[];
+} ia_strbuf_chunk;
+
+/** A string built from a list of chunks. */
+typedef struct ia_strbuf_rope {
+    ia_strbuf_chunk        *head;
+    ia_strbuf_chunk        *tail;
+    isize                   len;        /**< Total length of all chunks. */
+    i32                     chunk_size; /**< Minimal size of a new chunk. */
+    ia_strbuf_alloc_fn      alloc;      /**< nullptr for the drift allocator. */
+    void                   *userdata;
+} ia_strbuf_rope;
+
+/** Initializes an empty rope. */
+IA_NONNULL(1) IA_API void IA_CALL
+ia_strbuf_rope_init(
+    ia_strbuf_rope     *rope,
+    i32                 chunk_size,
+    ia_strbuf_alloc_fn  alloc,
+    void               *userdata);
+
+/** Append exactly N bytes to the rope.
+ *  @return `false` if the allocator failed, the text may be partially appended. */
+IA_NONNULL_ALL IA_API bool IA_CALL
+ia_strbuf_rope_append(
+    ia_strbuf_rope *rope,
+    void const     *data,
+    isize           n);
+
+/** Append a formatted string to the rope.
+ *  @return Number of bytes appended. */
+IA_API i32 IA_CALL
+ia_strbuf_rope_appendf(
+    ia_strbuf_rope *rope,
+    char const     *fmt,
+    ...) IA_PRINTF(2,3);
+
+/** As `ia_strbuf_rope_appendf`, but directly accepts a variable argument list. */
+IA_API i32 IA_CALL
+ia_strbuf_rope_appendv(
+    ia_strbuf_rope *rope,
+    char const     *fmt,
+    va_list         args);
+
+/** Appends the text of the whole rope to a string buffer. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_strbuf_rope_flatten(
+    ia_strbuf_rope const   *rope,
+    ia_strbuf              *out);
+
+/** Largest count of bytes written by a single `ia_fmt_*` call. */
+#define IA_FMT_MAX 48
+
+/** Writes decimal digits of an unsigned integer, without a null terminator.
+ *  @return Count of bytes written, at most 20. */
+IA_NONNULL_ALL IA_API i32 IA_CALL
+ia_fmt_u64(
+    char       *dst,
+    u64         v);
+
+/** Writes decimal digits of a signed integer, without a null terminator.
+ *  @return Count of bytes written, at most 20. */
+IA_NONNULL_ALL IA_API i32 IA_CALL
+ia_fmt_i64(
+    char       *dst,
+    i64         v);
+
+/** Writes hexadecimal digits of an unsigned integer, without a null terminator.
+ *  @return Count of bytes written, at most 16. */
+IA_NONNULL_ALL IA_API i32 IA_CALL
+ia_fmt_hex64(
+    char       *dst,
+    u64         v,
+    bool        uppercase);
+
+/** Writes a floating point number in fixed notation with `precision` digits after the point,
+ *  like `%.*f`. Values of magnitude 1e16 or more are written in exponent notation.
+ *  @return Count of bytes written, at most `IA_FMT_MAX`. */
+IA_NONNULL_ALL IA_API i32 IA_CALL
+ia_fmt_f64(
+    char       *dst,
+    f64         v,
+    i32         precision);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
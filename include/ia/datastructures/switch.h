@@ -2,7 +2,22 @@
 /** @file ia/datastructures/switch.h
  *  @brief Interleaved linked list for storing mutually exclusive values.
  * 
- *  TODO docs 
+ *  Every element is in at most one list at a time, the list is identified by a 64-bit value,
+ *  for example a resource state or a visibility bucket. All lists are interleaved in the same
+ *  node storage: a node holds the next and previous element of its list, and the value of the
+ *  element. Moving an element from one list to another only unlinks and relinks its node, so
+ *  it's O(1) regardless of list sizes, and no list has to be searched or compacted.
+ *
+ *  Nodes are stored in pages of `IA_SWITCH_PAGE_SIZE` elements, allocated on first use, so a
+ *  sparse range of element indices doesn't waste memory, and a list of elements with nearby
+ *  indices walks nearby memory. The `hdrs` map stores a header for every non-empty list:
+ *  the first element in the low 32 bits, and the count of elements in the high 32 bits.
+ *
+ *  Element index 0 is reserved as the end of a list, value 0 means an element is in no list.
+ *  Memory is allocated through the drift allocator.
+ *
+ *  [Flecs switch list]
+ *  https://github.com/SanderMertens/flecs/blob/v3.2.0/src/datastructures/switch_list.c
  */
 #include <ia/base/types.h>
 #include <ia/datastructures/darray.h>
@@ -12,6 +27,10 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#define IA_SWITCH_PAGE_BITS     12
+#define IA_SWITCH_PAGE_SIZE     (1 << IA_SWITCH_PAGE_BITS)
+#define IA_SWITCH_PAGE_MASK     (IA_SWITCH_PAGE_SIZE - 1)
+
 typedef struct ia_switch_node {
     u32 next, prev;
 } ia_switch_node;
@@ -26,6 +45,92 @@ typedef struct ia_switch {
     ia_darray   pages;  /**< darray<ia_switch_page> */
 } ia_switch;
 
+/** Initializes an empty switch list. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_switch_init(ia_switch *sw);
+
+/** Releases memory of the switch list. */
+IA_NONNULL_ALL IA_API void IA_CALL
+ia_switch_fini(ia_switch *sw);
+
+/** Moves the element into the list of `value`, removing it from its previous list.
+ *  A value of zero only removes the element. */
+IA_NONNULL_ALL IA_HOT_FN IA_API void IA_CALL
+ia_switch_set(
+    ia_switch  *sw,
+    u32         element,
+    u64         value);
+
+/** Removes the element from its list. */
+IA_FORCE_INLINE void
+ia_switch_reset(
+    ia_switch  *sw,
+    u32         element)
+{ ia_switch_set(sw, element, 0); }
+
+/** @return Node of an element, or nullptr if the element's page was never allocated. */
+IA_FORCE_INLINE ia_switch_node *
+ia_switch_node_of(
+    ia_switch const    *sw,
+    u32                 element)
+{
+    u32 page = element >> IA_SWITCH_PAGE_BITS;
+    if (page >= (u32)sw->pages.len)
+        return nullptr;
+    ia_switch_page *p = &ia_darray_as(ia_switch_page, &sw->pages)[page];
+    return p->nodes.v ? &ia_darray_as(ia_switch_node, &p->nodes)[element & IA_SWITCH_PAGE_MASK] : nullptr;
+}
+
+/** @return Value of the list the element is in, or 0 if it's in no list. */
+IA_FORCE_INLINE u64
+ia_switch_get(
+    ia_switch const    *sw,
+    u32                 element)
+{
+    u32 page = element >> IA_SWITCH_PAGE_BITS;
+    if (page >= (u32)sw->pages.len)
+        return 0;
+    ia_switch_page *p = &ia_darray_as(ia_switch_page, &sw->pages)[page];
+    return p->values.v ? ia_darray_as(u64, &p->values)[element & IA_SWITCH_PAGE_MASK] : 0;
+}
+
+/** @return First element of the list of `value`, or 0 if the list is empty. */
+IA_FORCE_INLINE u32
+ia_switch_first(
+    ia_switch const    *sw,
+    u64                 value)
+{
+    ia_map_value const *hdr = ia_map_get(&sw->hdrs, value);
+    return hdr ? (u32)*hdr : 0;
+}
+
+/** @return Count of elements in the list of `value`. */
+IA_FORCE_INLINE i32
+ia_switch_count(
+    ia_switch const    *sw,
+    u64                 value)
+{
+    ia_map_value const *hdr = ia_map_get(&sw->hdrs, value);
+    return hdr ? (i32)(*hdr >> 32) : 0;
+}
+
+/** @return Element after the given one in its list, or 0 at the end of the list. */
+IA_FORCE_INLINE u32
+ia_switch_next(
+    ia_switch const    *sw,
+    u32                 element)
+{
+    ia_switch_node const *node = ia_switch_node_of(sw, element);
+    return node ? node->next : 0;
+}
+
+/** Iterates elements of the list of `value`. The body may move the current element to
+ *  another list, the next element is read before the body runs. */
+#define ia_switch_foreach(sw, value, ELEMENT) \
+    for (u32 ELEMENT = ia_switch_first(sw, value), ELEMENT##_next_ = ia_switch_next(sw, ELEMENT); \
+         ELEMENT != 0; \
+         ELEMENT = ELEMENT##_next_, ELEMENT##_next_ = ia_switch_next(sw, ELEMENT))
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -22,9 +22,13 @@
 #include <ia/compute/simd.h>
 #include <ia/compute/aabb.h>
 #include <ia/compute/bits.h>
+#include <ia/compute/bvh.h>
 #include <ia/compute/camera.h>
 #include <ia/compute/crypto.h>
 #include <ia/compute/lz4.h>
+#include <ia/compute/pack.h>
+#include <ia/compute/stream.h>
+#include <ia/compute/sort.h>
 #include <ia/compute/matrix.h>
 #include <ia/compute/quaternion.h>
 #include <ia/compute/trigonometry.h>
@@ -33,13 +37,19 @@
 #include <ia/datastructures/arena.h>
 #include <ia/datastructures/balloc.h>
 #include <ia/datastructures/bitset.h>
+#include <ia/datastructures/btree.h>
 #include <ia/datastructures/dagraph.h>
 #include <ia/datastructures/darray.h>
 #include <ia/datastructures/deque.h>
+#include <ia/datastructures/ecs.h>
+#include <ia/datastructures/epoch.h>
 #include <ia/datastructures/hashmap.h>
 #include <ia/datastructures/map.h>
 #include <ia/datastructures/mpmc.h>
+#include <ia/datastructures/mpmc_segmented.h>
+#include <ia/datastructures/pool.h>
 #include <ia/datastructures/sparse.h>
+#include <ia/datastructures/spsc.h>
 #include <ia/datastructures/stack.h>
 #include <ia/datastructures/strbuf.h>
 #include <ia/datastructures/switch.h>
@@ -63,6 +73,7 @@ typedef struct ia_foundation_host {
     usize                   page_size_in_use;
     ia_hugepage_sizes       hugepage_sizes;
     i32                     cpu_thread_count, cpu_cores_count, cpu_package_count;
+    ia_cpu_features         cpu_features;
 } ia_foundation_host;
 
 /** TODO docs */
@@ -0,0 +1,2335 @@
+#include <ia/compute/lz4.h>
+#include <ia/compute/stream.h>
+#include <ia/compute/sort.h>
+#include <ia/compute/matrix.h>
+#include <ia/compute/quaternion.h>
+#include <ia/compute/camera.h>
+#include <ia/compute/bvh.h>
+#include <ia/compute/pack.h>
+#include <ia/compute/simd.h>
+#include <ia/compute/bits.h>
+#include <ia/base/endian.h>
+#include <ia/base/log.h>
+#include <ia/base/work.h>
+#include <ia/base/memory.h>
+#include <ia/base/atomic.h>
+#include <ia/base/system.h>
+
+#include "compute_kernels.h"
+
+/** Picks the widest kernel variant the host supports, once per runtime. The tables are constant data,
+ *  racing first calls store the same pointer. */
+static compute_kernels const *compute_kernels_select(void)
+{
+    static IA_ATOMIC(compute_kernels const *) selected = nullptr;
+    compute_kernels const *kernels = ia_atomic_read(&selected, ia_atomic_model_monotonic);
+    if (kernels)
+        return kernels;
+
+    kernels = &compute_kernels_baseline;
+#ifdef IA_COMPUTE_KERNELS_X86
+    ia_cpu_features features = ia_cpufeatures();
+    if (ia_cpu_features_has(features, COMPUTE_KERNELS_AVX512_FEATURES))
+        kernels = &compute_kernels_avx512;
+    else if (ia_cpu_features_has(features, COMPUTE_KERNELS_AVX2_FEATURES))
+        kernels = &compute_kernels_avx2;
+#endif /* IA_COMPUTE_KERNELS_X86 */
+    ia_atomic_write(&selected, kernels, ia_atomic_model_monotonic);
+    return kernels;
+}
+
+/* LZ4 block format constants */
+#define LZ4_MINMATCH        4
+#define LZ4_LASTLITERALS    5   /* the last 5 bytes of a block are always literals */
+#define LZ4_MFLIMIT         12  /* the last match must start at least 12 bytes before the end */
+#define LZ4_MAX_DISTANCE    65535
+#define LZ4_ML_BITS         4
+#define LZ4_ML_MASK         ((1u << LZ4_ML_BITS) - 1)
+#define LZ4_RUN_MASK        ((1u << (8 - LZ4_ML_BITS)) - 1)
+#define LZ4_HASH_LOG        12
+#define LZ4_SKIP_TRIGGER    6
+/* the decoder uses wide copies only when this many bytes remain in the output */
+#define LZ4_WILD_MARGIN     32
+
+static inline u16 lz4_read16(void const *p) { u16 v; memcpy(&v, p, 2); return ia_le16_to_cpu(v); }
+static inline u32 lz4_read32(void const *p) { u32 v; memcpy(&v, p, 4); return v; }
+static inline u64 lz4_read64(void const *p) { u64 v; memcpy(&v, p, 8); return ia_le64_to_cpu(v); }
+static inline void lz4_write16(void *p, u16 v) { le16 x = ia_cpu_to_le16(v); memcpy(p, &x, 2); }
+static inline void lz4_write32(void *p, u32 v) { le32 x = ia_cpu_to_le32(v); memcpy(p, &x, 4); }
+
+/** Copies 16 bytes at a time, may write up to 15 bytes past `end`. */
+static inline void lz4_wild_copy16(u8 *dst, u8 const *src, u8 *end)
+{
+    do {
+        memcpy(dst, src, 16);
+        dst += 16; src += 16;
+    } while (dst < end);
+}
+
+/** Copies 8 bytes at a time, may write up to 7 bytes past `end`. */
+static inline void lz4_wild_copy8(u8 *dst, u8 const *src, u8 *end)
+{
+    do {
+        memcpy(dst, src, 8);
+        dst += 8; src += 8;
+    } while (dst < end);
+}
+
+/** Returns the count of equal bytes in `p` and `m`, never reading past `limit`. */
+static inline isize lz4_count(u8 const *p, u8 const *m, u8 const *limit)
+{
+    u8 const *start = p;
+    while (p + 8 <= limit) {
+        u64 diff = lz4_read64(p) ^ lz4_read64(m);
+        if (diff)
+            return (p - start) + (ia_ctz64(diff) >> 3);
+        p += 8; m += 8;
+    }
+    while (p < limit && *p == *m) { p++; m++; }
+    return p - start;
+}
+
+static inline u32 lz4_hash(u32 sequence, i32 hash_log)
+{ return (sequence * 2654435761u) >> (32 - hash_log); }
+
+/** Writes a length continuation, every 255 is one byte, the remainder ends the run. */
+static inline u8 *lz4_write_length(u8 *op, usize len)
+{
+    for (; len >= 255; len -= 255)
+        *op++ = 255;
+    *op++ = (u8)len;
+    return op;
+}
+
+/** Emits a single sequence: token, literals, offset and match length.
+ *  @return The new output cursor, or nullptr if the output would overflow. */
+static u8 *lz4_emit_sequence(
+    u8         *op,
+    u8 const   *oend,
+    u8 const   *anchor,
+    usize       lit_len,
+    u32         offset,
+    usize       match_len)
+{
+    /* token + literal run + literals + offset + match run */
+    if ((usize)(oend - op) < 1 + (lit_len / 255 + 1) + lit_len + 2 + (match_len / 255 + 1))
+        return nullptr;
+
+    u8 *token = op++;
+    usize ml = match_len - LZ4_MINMATCH;
+
+    if (lit_len >= LZ4_RUN_MASK) {
+        *token = LZ4_RUN_MASK << LZ4_ML_BITS;
+        op = lz4_write_length(op, lit_len - LZ4_RUN_MASK);
+    } else {
+        *token = (u8)(lit_len << LZ4_ML_BITS);
+    }
+    memcpy(op, anchor, lit_len);
+    op += lit_len;
+
+    lz4_write16(op, (u16)offset);
+    op += 2;
+
+    if (ml >= LZ4_ML_MASK) {
+        *token |= LZ4_ML_MASK;
+        op = lz4_write_length(op, ml - LZ4_ML_MASK);
+    } else {
+        *token |= (u8)ml;
+    }
+    return op;
+}
+
+/** Emits the trailing literal run of a block. */
+static u8 *lz4_emit_last_literals(
+    u8         *op,
+    u8 const   *oend,
+    u8 const   *anchor,
+    usize       lit_len)
+{
+    if ((usize)(oend - op) < 1 + (lit_len / 255 + 1) + lit_len)
+        return nullptr;
+
+    if (lit_len >= LZ4_RUN_MASK) {
+        *op++ = LZ4_RUN_MASK << LZ4_ML_BITS;
+        op = lz4_write_length(op, lit_len - LZ4_RUN_MASK);
+    } else {
+        *op++ = (u8)(lit_len << LZ4_ML_BITS);
+    }
+    memcpy(op, anchor, lit_len);
+    return op + lit_len;
+}
+
+isize ia_lz4_compress(
+    void const *src,
+    isize       src_size,
+    void       *dst,
+    isize       dst_capacity,
+    i32         acceleration)
+{
+    if (src_size < 0 || src_size > IA_LZ4_MAX_INPUT_SIZE || dst_capacity <= 0)
+        return 0;
+    if (acceleration < 1)
+        acceleration = 1;
+
+    u32 table[1 << LZ4_HASH_LOG];
+    u8 const *base = (u8 const *)src;
+    u8 const *ip = base;
+    u8 const *anchor = base;
+    u8 const *iend = base + src_size;
+    u8 const *mflimit = iend - LZ4_MFLIMIT;
+    u8 const *matchlimit = iend - LZ4_LASTLITERALS;
+    u8 *op = (u8 *)dst;
+    u8 const *oend = op + dst_capacity;
+
+    if (src_size < LZ4_MFLIMIT + 1)
+        goto last_literals;
+
+    memset(table, 0, sizeof(table));
+    table[lz4_hash(lz4_read32(ip), LZ4_HASH_LOG)] = 0;
+    ip++;
+
+    for (;;) {
+        u8 const *match;
+        u32 search = (u32)acceleration << LZ4_SKIP_TRIGGER;
+        u32 step = 1;
+
+        /* find a match, skip faster over incompressible data */
+        for (;;) {
+            if (ip > mflimit)
+                goto last_literals;
+            u32 seq = lz4_read32(ip);
+            u32 h = lz4_hash(seq, LZ4_HASH_LOG);
+            match = base + table[h];
+            table[h] = (u32)(ip - base);
+            if (match < ip && (ip - match) <= LZ4_MAX_DISTANCE && lz4_read32(match) == seq)
+                break;
+            ip += step;
+            step = search++ >> LZ4_SKIP_TRIGGER;
+        }
+
+        /* catch up backwards */
+        while (ip > anchor && match > base && ip[-1] == match[-1]) {
+            ip--; match--;
+        }
+        isize match_len = LZ4_MINMATCH + lz4_count(ip + LZ4_MINMATCH, match + LZ4_MINMATCH, matchlimit);
+
+        op = lz4_emit_sequence(op, oend, anchor, (usize)(ip - anchor), (u32)(ip - match), (usize)match_len);
+        if (IA_UNLIKELY(!op))
+            return 0;
+
+        ip += match_len;
+        anchor = ip;
+        if (ip > mflimit)
+            break;
+        /* fill the table with a position inside the match, it improves the ratio for free */
+        table[lz4_hash(lz4_read32(ip - 2), LZ4_HASH_LOG)] = (u32)(ip - 2 - base);
+    }
+last_literals:
+    op = lz4_emit_last_literals(op, oend, anchor, (usize)(iend - anchor));
+    if (IA_UNLIKELY(!op))
+        return 0;
+    return op - (u8 *)dst;
+}
+
+/** Inserts all positions up to `ip` into the hash chains. */
+static inline void lz4_hc_insert(
+    ia_lz4_hc_state    *state,
+    u8 const           *base,
+    u32                *next_to_update,
+    u8 const           *ip)
+{
+    u32 target = (u32)(ip - base);
+    for (u32 idx = *next_to_update; idx < target; idx++) {
+        u32 h = lz4_hash(lz4_read32(base + idx), IA_LZ4_HC_HASH_LOG);
+        u32 prev = state->hash_table[h];
+        u32 delta = (prev == UINT32_MAX) ? LZ4_MAX_DISTANCE : idx - prev;
+        state->chain_table[idx & (IA_LZ4_HC_DICT_SIZE - 1)] = (u16)ia_min(delta, (u32)LZ4_MAX_DISTANCE);
+        state->hash_table[h] = idx;
+    }
+    *next_to_update = target;
+}
+
+/** Walks the hash chain at `ip` and returns the length of the longest match. */
+static inline isize lz4_hc_find_longest(
+    ia_lz4_hc_state    *state,
+    u8 const           *base,
+    u32                *next_to_update,
+    u8 const           *ip,
+    u8 const           *matchlimit,
+    i32                 attempts,
+    u8 const          **out_match)
+{
+    lz4_hc_insert(state, base, next_to_update, ip);
+
+    u32 pos = (u32)(ip - base);
+    u32 seq = lz4_read32(ip);
+    u32 cand = state->hash_table[lz4_hash(seq, IA_LZ4_HC_HASH_LOG)];
+    isize best = 0;
+
+    while (cand != UINT32_MAX && cand < pos && pos - cand <= LZ4_MAX_DISTANCE && attempts-- > 0) {
+        u8 const *m = base + cand;
+        /* quick reject: the byte that would extend the best match must match */
+        if (m[best] == ip[best] && lz4_read32(m) == seq) {
+            isize len = LZ4_MINMATCH + lz4_count(ip + LZ4_MINMATCH, m + LZ4_MINMATCH, matchlimit);
+            if (len > best) {
+                best = len;
+                *out_match = m;
+                if (ip + len >= matchlimit)
+                    break;
+            }
+        }
+        u32 delta = state->chain_table[cand & (IA_LZ4_HC_DICT_SIZE - 1)];
+        if (delta == 0 || delta > cand)
+            break;
+        cand -= delta;
+    }
+    return best;
+}
+
+isize ia_lz4_compress_hc(
+    void const         *src,
+    isize               src_size,
+    void               *dst,
+    isize               dst_capacity,
+    i32                 level,
+    ia_lz4_hc_state    *state)
+{
+    if (src_size < 0 || src_size > IA_LZ4_MAX_INPUT_SIZE || dst_capacity <= 0)
+        return 0;
+    level = ia_clamp(level, ia_lz4_level_hc_min, ia_lz4_level_hc_max);
+
+    i32 attempts = 1 << (level - 1);
+    bool lazy = level >= 4;
+    u8 const *base = (u8 const *)src;
+    u8 const *ip = base;
+    u8 const *anchor = base;
+    u8 const *iend = base + src_size;
+    u8 const *mflimit = iend - LZ4_MFLIMIT;
+    u8 const *matchlimit = iend - LZ4_LASTLITERALS;
+    u8 *op = (u8 *)dst;
+    u8 const *oend = op + dst_capacity;
+    u32 next_to_update = 0;
+
+    if (src_size < LZ4_MFLIMIT + 1)
+        goto last_literals;
+
+    memset(state->hash_table, 0xff, sizeof(state->hash_table));
+
+    while (ip <= mflimit) {
+        u8 const *match = nullptr;
+        isize len = lz4_hc_find_longest(state, base, &next_to_update, ip, matchlimit, attempts, &match);
+        if (len < LZ4_MINMATCH) {
+            ip++;
+            continue;
+        }
+        /* lazy evaluation, defer the match if the next position gives a longer one */
+        while (lazy && ip + 1 <= mflimit) {
+            u8 const *match2 = nullptr;
+            isize len2 = lz4_hc_find_longest(state, base, &next_to_update, ip + 1, matchlimit, attempts, &match2);
+            if (len2 <= len + 1)
+                break;
+            ip++;
+            len = len2;
+            match = match2;
+        }
+        op = lz4_emit_sequence(op, oend, anchor, (usize)(ip - anchor), (u32)(ip - match), (usize)len);
+        if (IA_UNLIKELY(!op))
+            return 0;
+        ip += len;
+        anchor = ip;
+    }
+last_literals:
+    op = lz4_emit_last_literals(op, oend, anchor, (usize)(iend - anchor));
+    if (IA_UNLIKELY(!op))
+        return 0;
+    return op - (u8 *)dst;
+}
+
+/** Reads a length continuation. Returns false if the input ends before the run does,
+ *  or if the length would wrap (possible with 32-bit sizes on crafted input). */
+static inline bool lz4_read_length(u8 const **ip, u8 const *iend, usize *len)
+{
+    u32 s;
+    do {
+        if (IA_UNLIKELY(*ip >= iend || *len > SIZE_MAX - 255))
+            return false;
+        s = *(*ip)++;
+        *len += s;
+    } while (s == 255);
+    return true;
+}
+
+/* offset tables for short overlapping matches, they spread a pattern of 1..7 bytes into 8 */
+static i32 const g_lz4_inc32[8] = { 0, 1, 2, 1, 0, 4, 4, 4 };
+static i32 const g_lz4_dec64[8] = { 0, 0, 0, -1, -4, 1, 2, 3 };
+
+/** The block decoder. `low` is the lowest address a match may reference, it's below `dst`
+ *  when decoding linked blocks, where previous blocks act as a dictionary. */
+static isize lz4_decompress_generic(
+    u8 const   *src,
+    isize       src_size,
+    u8         *dst,
+    isize       dst_capacity,
+    u8 const   *low)
+{
+    u8 const *ip = src;
+    u8 const *iend = src + src_size;
+    u8 *op = dst;
+    u8 *oend = dst + dst_capacity;
+
+    if (IA_UNLIKELY(src_size <= 0 || dst_capacity < 0))
+        return -1;
+
+    for (;;) {
+        u32 token = *ip++;
+        usize lit_len = token >> LZ4_ML_BITS;
+
+        /* literals */
+        if (lit_len == LZ4_RUN_MASK && !lz4_read_length(&ip, iend, &lit_len))
+            return -1;
+        if (IA_UNLIKELY(lit_len > (usize)(iend - ip) || lit_len > (usize)(oend - op)))
+            return -1;
+        if (IA_LIKELY((usize)(oend - op) >= lit_len + LZ4_WILD_MARGIN && (usize)(iend - ip) >= lit_len + LZ4_WILD_MARGIN)) {
+            lz4_wild_copy16(op, ip, op + lit_len);
+        } else {
+            memmove(op, ip, lit_len);
+        }
+        ip += lit_len;
+        op += lit_len;
+
+        /* the block always ends with literals */
+        if (ip == iend)
+            break;
+
+        /* match */
+        if (IA_UNLIKELY(iend - ip < 2))
+            return -1;
+        usize offset = lz4_read16(ip);
+        ip += 2;
+        u8 const *match = op - offset;
+        if (IA_UNLIKELY(offset == 0 || offset > (usize)(op - low)))
+            return -1;
+
+        usize match_len = token & LZ4_ML_MASK;
+        if (match_len == LZ4_ML_MASK && !lz4_read_length(&ip, iend, &match_len))
+            return -1;
+        match_len += LZ4_MINMATCH;
+        if (IA_UNLIKELY(match_len > (usize)(oend - op)))
+            return -1;
+
+        u8 *cpy = op + match_len;
+        if (IA_LIKELY((usize)(oend - cpy) >= LZ4_WILD_MARGIN)) {
+            if (offset >= 16) {
+                lz4_wild_copy16(op, match, cpy);
+            } else {
+                if (offset < 8) {
+                    op[0] = match[0]; op[1] = match[1];
+                    op[2] = match[2]; op[3] = match[3];
+                    match += g_lz4_inc32[offset];
+                    memcpy(op + 4, match, 4);
+                    match -= g_lz4_dec64[offset];
+                } else {
+                    memcpy(op, match, 8);
+                    match += 8;
+                }
+                op += 8;
+                if (op < cpy)
+                    lz4_wild_copy8(op, match, cpy);
+            }
+        } else {
+            /* close to the end of output, copy byte by byte, overlap is intended */
+            while (op < cpy)
+                *op++ = *match++;
+        }
+        op = cpy;
+
+        if (IA_UNLIKELY(ip >= iend))
+            return -1; /* a block can't end with a match */
+    }
+    return op - dst;
+}
+
+isize ia_lz4_decompress(
+    void const *src,
+    isize       src_size,
+    void       *dst,
+    isize       dst_capacity)
+{
+    return lz4_decompress_generic((u8 const *)src, src_size, (u8 *)dst, dst_capacity, (u8 const *)dst);
+}
+
+#define XXH_PRIME32_1   0x9e3779b1u
+#define XXH_PRIME32_2   0x85ebca77u
+#define XXH_PRIME32_3   0xc2b2ae3du
+#define XXH_PRIME32_4   0x27d4eb2fu
+#define XXH_PRIME32_5   0x165667b1u
+
+static inline u32 xxh_rotl32(u32 x, i32 r) { return (x << r) | (x >> (32 - r)); }
+
+static inline u32 xxh32_round(u32 acc, u32 input)
+{
+    acc += input * XXH_PRIME32_2;
+    acc = xxh_rotl32(acc, 13);
+    return acc * XXH_PRIME32_1;
+}
+
+u32 ia_xxh32(
+    void const *src,
+    isize       src_size,
+    u32         seed)
+{
+    u8 const *p = (u8 const *)src;
+    u8 const *end = p + src_size;
+    u32 h;
+
+    if (src_size >= 16) {
+        u8 const *limit = end - 16;
+        u32 v1 = seed + XXH_PRIME32_1 + XXH_PRIME32_2;
+        u32 v2 = seed + XXH_PRIME32_2;
+        u32 v3 = seed;
+        u32 v4 = seed - XXH_PRIME32_1;
+        do {
+            v1 = xxh32_round(v1, ia_le32_to_cpu(lz4_read32(p + 0)));
+            v2 = xxh32_round(v2, ia_le32_to_cpu(lz4_read32(p + 4)));
+            v3 = xxh32_round(v3, ia_le32_to_cpu(lz4_read32(p + 8)));
+            v4 = xxh32_round(v4, ia_le32_to_cpu(lz4_read32(p + 12)));
+            p += 16;
+        } while (p <= limit);
+        h = xxh_rotl32(v1, 1) + xxh_rotl32(v2, 7) + xxh_rotl32(v3, 12) + xxh_rotl32(v4, 18);
+    } else {
+        h = seed + XXH_PRIME32_5;
+    }
+    h += (u32)src_size;
+
+    for (; p + 4 <= end; p += 4) {
+        h += ia_le32_to_cpu(lz4_read32(p)) * XXH_PRIME32_3;
+        h = xxh_rotl32(h, 17) * XXH_PRIME32_4;
+    }
+    for (; p < end; p++) {
+        h += (*p) * XXH_PRIME32_5;
+        h = xxh_rotl32(h, 11) * XXH_PRIME32_1;
+    }
+    h ^= h >> 15;
+    h *= XXH_PRIME32_2;
+    h ^= h >> 13;
+    h *= XXH_PRIME32_3;
+    h ^= h >> 16;
+    return h;
+}
+
+/* LZ4 frame format constants */
+#define LZ4F_MAGIC              0x184d2204u
+#define LZ4F_SKIPPABLE_MAGIC    0x184d2a50u
+#define LZ4F_SKIPPABLE_MASK     0xfffffff0u
+#define LZ4F_VERSION            (1u << 6)
+#define LZ4F_FLG_BLOCK_INDEP    (1u << 5)
+#define LZ4F_FLG_BLOCK_CHECKSUM (1u << 4)
+#define LZ4F_FLG_CONTENT_SIZE   (1u << 3)
+#define LZ4F_FLG_CONTENT_CHECKSUM (1u << 2)
+#define LZ4F_FLG_DICT_ID        (1u << 0)
+#define LZ4F_BLOCK_UNCOMPRESSED (1u << 31)
+#define LZ4F_HEADER_MAX         19  /* magic + flg + bd + content size + dict id + hc */
+
+isize ia_lz4_frame_bound(
+    isize                       src_size,
+    ia_lz4_frame_info const    *info)
+{
+    isize block_max = ia_lz4_block_size_bytes(info->block_size);
+    isize block_count = (src_size + block_max - 1) / block_max;
+    /* blocks that don't compress are stored raw, so they never exceed their source size */
+    return LZ4F_HEADER_MAX + src_size + block_count * (4 + (info->block_checksum ? 4 : 0)) + 4 + 4;
+}
+
+isize ia_lz4_frame_compress(
+    void const                 *src,
+    isize                       src_size,
+    void                       *dst,
+    isize                       dst_capacity,
+    ia_lz4_frame_info const    *info,
+    ia_lz4_hc_state            *hc_state)
+{
+    u8 const *ip = (u8 const *)src;
+    u8 const *iend = ip + src_size;
+    u8 *op = (u8 *)dst;
+    u8 *oend = op + dst_capacity;
+    isize block_max = ia_lz4_block_size_bytes(info->block_size);
+    bool use_hc = info->level > 0;
+
+    ia_assert(!use_hc || hc_state, "The HC compressor requires work memory.");
+    if (src_size < 0 || dst_capacity < LZ4F_HEADER_MAX)
+        return 0;
+
+    /* frame descriptor */
+    lz4_write32(op, LZ4F_MAGIC);
+    op += 4;
+    u8 *desc = op;
+    *op++ = LZ4F_VERSION | LZ4F_FLG_BLOCK_INDEP
+          | (info->block_checksum ? LZ4F_FLG_BLOCK_CHECKSUM : 0)
+          | (info->content_size ? LZ4F_FLG_CONTENT_SIZE : 0)
+          | (info->content_checksum ? LZ4F_FLG_CONTENT_CHECKSUM : 0);
+    *op++ = (u8)(info->block_size << 4);
+    if (info->content_size) {
+        le64 size = ia_cpu_to_le64((u64)src_size);
+        memcpy(op, &size, 8);
+        op += 8;
+    }
+    *op = (u8)(ia_xxh32(desc, op - desc, 0) >> 8);
+    op++;
+
+    /* blocks */
+    while (ip < iend) {
+        isize n = ia_min(block_max, iend - ip);
+        isize extra = info->block_checksum ? 4 : 0;
+        if (oend - op < 4 + extra + 1)
+            return 0;
+
+        u8 *block = op + 4;
+        isize avail = ia_min(oend - block - extra, n - 1); /* compressed must be smaller, else store raw */
+        isize written = 0;
+        if (avail > 0) {
+            written = use_hc
+                ? ia_lz4_compress_hc(ip, n, block, avail, info->level, hc_state)
+                : ia_lz4_compress(ip, n, block, avail, 1 - info->level);
+        }
+        if (written > 0) {
+            lz4_write32(op, (u32)written);
+        } else {
+            if (oend - block - extra < n)
+                return 0;
+            memcpy(block, ip, n);
+            written = n;
+            lz4_write32(op, (u32)n | LZ4F_BLOCK_UNCOMPRESSED);
+        }
+        op = block + written;
+        if (info->block_checksum) {
+            lz4_write32(op, ia_xxh32(block, written, 0));
+            op += 4;
+        }
+        ip += n;
+    }
+
+    /* end mark and checksum */
+    if (oend - op < 4 + (info->content_checksum ? 4 : 0))
+        return 0;
+    lz4_write32(op, 0);
+    op += 4;
+    if (info->content_checksum) {
+        lz4_write32(op, ia_xxh32(src, src_size, 0));
+        op += 4;
+    }
+    return op - (u8 *)dst;
+}
+
+/** Parses a frame header. Returns the header size, 0 for skippable frames, or -1 on error. */
+static isize lz4f_read_header(
+    u8 const   *src,
+    isize       src_size,
+    u8         *out_flg,
+    isize      *out_block_max,
+    i64        *out_content_size,
+    isize      *out_frame_skip)
+{
+    if (src_size < 4)
+        return -1;
+    u32 magic = ia_le32_to_cpu(lz4_read32(src));
+    if ((magic & LZ4F_SKIPPABLE_MASK) == LZ4F_SKIPPABLE_MAGIC) {
+        if (src_size < 8)
+            return -1;
+        *out_frame_skip = 8 + (isize)ia_le32_to_cpu(lz4_read32(src + 4));
+        return 0;
+    }
+    if (magic != LZ4F_MAGIC || src_size < 7)
+        return -1;
+
+    u8 flg = src[4], bd = src[5];
+    if ((flg & 0xc0) != LZ4F_VERSION || (flg & 0x02) || (bd & 0x8f))
+        return -1;
+    u32 bs = (bd >> 4) & 7;
+    if (bs < ia_lz4_block_size_64kb)
+        return -1;
+
+    isize size = 4 + 2 + ((flg & LZ4F_FLG_CONTENT_SIZE) ? 8 : 0) + ((flg & LZ4F_FLG_DICT_ID) ? 4 : 0) + 1;
+    if (src_size < size)
+        return -1;
+    if ((u8)(ia_xxh32(src + 4, size - 5, 0) >> 8) != src[size - 1])
+        return -1;
+
+    *out_flg = flg;
+    *out_block_max = ia_lz4_block_size_bytes(bs);
+    *out_content_size = (flg & LZ4F_FLG_CONTENT_SIZE) ? (i64)lz4_read64(src + 6) : -1;
+    return size;
+}
+
+isize ia_lz4_frame_content_size(
+    void const *src,
+    isize       src_size)
+{
+    u8 flg;
+    isize block_max, skip;
+    i64 content_size;
+    isize header = lz4f_read_header((u8 const *)src, src_size, &flg, &block_max, &content_size, &skip);
+    if (header <= 0 || content_size < 0 || content_size > PTRDIFF_MAX)
+        return -1;
+    return (isize)content_size;
+}
+
+isize ia_lz4_frame_decompress(
+    void const *src,
+    isize       src_size,
+    void       *dst,
+    isize       dst_capacity)
+{
+    u8 const *ip = (u8 const *)src;
+    u8 const *iend = ip + src_size;
+    u8 *op = (u8 *)dst;
+    u8 *oend = op + dst_capacity;
+
+    while (ip < iend) {
+        u8 flg;
+        isize block_max, skip = 0;
+        i64 content_size;
+        isize header = lz4f_read_header(ip, iend - ip, &flg, &block_max, &content_size, &skip);
+        if (header < 0)
+            return -1;
+        if (header == 0) {
+            if (skip > iend - ip)
+                return -1;
+            ip += skip;
+            continue;
+        }
+        if (flg & LZ4F_FLG_DICT_ID)
+            return -1; /* external dictionaries are not supported */
+        ip += header;
+
+        u8 *frame_begin = op;
+        bool linked = !(flg & LZ4F_FLG_BLOCK_INDEP);
+        isize extra = (flg & LZ4F_FLG_BLOCK_CHECKSUM) ? 4 : 0;
+
+        for (;;) {
+            if (iend - ip < 4)
+                return -1;
+            u32 word = ia_le32_to_cpu(lz4_read32(ip));
+            ip += 4;
+            if (word == 0)
+                break;
+
+            isize n = (isize)(word & ~LZ4F_BLOCK_UNCOMPRESSED);
+            if (n > block_max || n > iend - ip - extra)
+                return -1;
+            if (extra && ia_xxh32(ip, n, 0) != ia_le32_to_cpu(lz4_read32(ip + n)))
+                return -1;
+
+            if (word & LZ4F_BLOCK_UNCOMPRESSED) {
+                if (n > oend - op)
+                    return -1;
+                memcpy(op, ip, n);
+                op += n;
+            } else {
+                isize cap = ia_min(block_max, oend - op);
+                isize res = lz4_decompress_generic(ip, n, op, cap, linked ? frame_begin : op);
+                if (res < 0)
+                    return -1;
+                op += res;
+            }
+            ip += n + extra;
+        }
+
+        if (content_size >= 0 && content_size != op - frame_begin)
+            return -1;
+        if (flg & LZ4F_FLG_CONTENT_CHECKSUM) {
+            if (iend - ip < 4 || ia_xxh32(frame_begin, op - frame_begin, 0) != ia_le32_to_cpu(lz4_read32(ip)))
+                return -1;
+            ip += 4;
+        }
+    }
+    return op - (u8 *)dst;
+}
+
+typedef struct stream_slot {
+    ia_stream_chunk         chunk;
+    ia_stream_info const   *info;
+    ia_work_details         details;
+    ia_work_chain           chain;
+    ia_result               result;
+} stream_slot;
+
+static IA_WORK_FN(stream_process_slot, stream_slot *slot)
+{
+    slot->result = slot->info->process(slot->info->userdata, &slot->chunk);
+}
+
+/** Waits for the work of a slot to finish, the chain is invalidated after a yield. */
+static ia_result stream_slot_wait(stream_slot *slot)
+{
+    if (slot->chain) {
+        ia_yield(slot->chain);
+        slot->chain = nullptr;
+    }
+    return slot->result;
+}
+
+ia_result ia_stream_run(ia_stream_info const *info)
+{
+    stream_slot slots[IA_STREAM_MAX_IN_FLIGHT];
+    i32 in_flight = ia_clamp(info->in_flight, 1, IA_STREAM_MAX_IN_FLIGHT);
+    ia_result result = ia_result_success;
+
+    ia_assert(info->chunk_capacity > 0, "Stream `%s` has no staging memory.", info->name);
+
+    for (i32 i = 0; i < in_flight; i++) {
+        slots[i].info = info;
+        slots[i].chain = nullptr;
+        slots[i].result = ia_result_success;
+    }
+
+    for (i64 index = 0;; index++) {
+        stream_slot *slot = &slots[index % in_flight];
+
+        /* back-pressure, the slot is reused only after its previous chunk is done */
+        result = stream_slot_wait(slot);
+        if (result != ia_result_success)
+            break;
+
+        slot->chunk = (ia_stream_chunk){
+            .src = (u8 *)info->staging + (index % in_flight) * info->chunk_capacity,
+            .index = index,
+        };
+        isize staged = info->read(info->userdata, &slot->chunk, info->chunk_capacity);
+        if (staged <= 0) {
+            if (staged < 0) result = ia_result_unknown_error;
+            break;
+        }
+        slot->chunk.src_size = staged;
+        slot->details = (ia_work_details){
+            .fn = (ia_work_fn)stream_process_slot,
+            .data = slot,
+            .name = info->name,
+        };
+        slot->chain = ia_submit_work(1, &slot->details);
+    }
+
+    /* drain, keep the first failure */
+    for (i32 i = 0; i < in_flight; i++) {
+        ia_result res = stream_slot_wait(&slots[i]);
+        if (result == ia_result_success)
+            result = res;
+    }
+    return result;
+}
+
+typedef struct lz4_stream {
+    ia_file     file;
+    i64         pos;            /* file position of the next block after `next_word` */
+    u32         next_word;      /* block size word of the next block */
+    u8          flg;
+    isize       block_max;
+    u8         *dst;
+    isize       dst_capacity;
+    isize       total;          /* decompressed size of the blocks read so far */
+} lz4_stream;
+
+#define LZ4_CHUNK_UNCOMPRESSED  (1u << 0)
+
+/** Sums literal and match lengths of a compressed block, without decoding it. It walks only the
+ *  sequence headers, so the read stage knows where a block lands before a worker decodes it.
+ *  @return Decompressed size, or -1 if the block is malformed. */
+static isize lz4_block_decompressed_size(
+    u8 const   *src,
+    isize       src_size)
+{
+    u8 const *ip = src;
+    u8 const *iend = src + src_size;
+    usize total = 0;
+
+    if (IA_UNLIKELY(src_size <= 0))
+        return -1;
+    for (;;) {
+        u32 token = *ip++;
+        usize lit_len = token >> LZ4_ML_BITS;
+        if (lit_len == LZ4_RUN_MASK && !lz4_read_length(&ip, iend, &lit_len))
+            return -1;
+        if (IA_UNLIKELY(lit_len > (usize)(iend - ip)))
+            return -1;
+        ip += lit_len;
+        total += lit_len;
+        if (ip == iend)
+            break;
+
+        if (IA_UNLIKELY(iend - ip < 3))
+            return -1;
+        ip += 2;
+        usize match_len = token & LZ4_ML_MASK;
+        if (match_len == LZ4_ML_MASK && !lz4_read_length(&ip, iend, &match_len))
+            return -1;
+        total += match_len + LZ4_MINMATCH;
+        if (IA_UNLIKELY(total > PTRDIFF_MAX))
+            return -1;
+    }
+    return (isize)total;
+}
+
+static isize IA_CALL lz4_stream_read(
+    lz4_stream         *s,
+    ia_stream_chunk    *chunk,
+    isize               capacity)
+{
+    if (s->next_word == 0)
+        return 0;
+
+    isize n = (isize)(s->next_word & ~LZ4F_BLOCK_UNCOMPRESSED);
+    isize extra = (s->flg & LZ4F_FLG_BLOCK_CHECKSUM) ? 4 : 0;
+    /* read the next block's size word together with this block */
+    isize want = n + extra + 4;
+    if (n > s->block_max || want > capacity)
+        return -1;
+    if (ia_file_read(s->file, chunk->src, want, s->pos) != want)
+        return -1;
+    s->pos += want;
+
+    /* any block may be shorter than the maximum, the offset is the running total */
+    bool uncompressed = s->next_word & LZ4F_BLOCK_UNCOMPRESSED;
+    isize size = uncompressed ? n : lz4_block_decompressed_size((u8 const *)chunk->src, n);
+    if (size < 0 || size > s->block_max || size > s->dst_capacity - s->total)
+        return -1;
+    chunk->flags = uncompressed ? LZ4_CHUNK_UNCOMPRESSED : 0;
+    chunk->offset = s->total;
+    chunk->size = size;
+    s->total += size;
+    s->next_word = ia_le32_to_cpu(lz4_read32((u8 *)chunk->src + n + extra));
+    return n + extra;
+}
+
+static ia_result IA_CALL lz4_stream_process(
+    lz4_stream             *s,
+    ia_stream_chunk const  *chunk)
+{
+    u8 const *src = (u8 const *)chunk->src;
+    isize n = chunk->src_size;
+    u8 *out = s->dst + chunk->offset;
+    isize res;
+
+    if (s->flg & LZ4F_FLG_BLOCK_CHECKSUM) {
+        n -= 4;
+        if (ia_xxh32(src, n, 0) != ia_le32_to_cpu(lz4_read32(src + n)))
+            return ia_result_unknown_error;
+    }
+    if (chunk->flags & LZ4_CHUNK_UNCOMPRESSED) {
+        if (n > chunk->size)
+            return ia_result_unknown_error;
+        memcpy(out, src, n);
+        res = n;
+    } else {
+        res = lz4_decompress_generic(src, n, out, chunk->size, out);
+        if (res < 0)
+            return ia_result_unknown_error;
+    }
+    if (res != chunk->size)
+        return ia_result_unknown_error;
+    return ia_result_success;
+}
+
+ia_result ia_stream_lz4_frame(
+    ia_file             file,
+    i64                 offset,
+    void               *dst,
+    isize               dst_capacity,
+    void               *staging,
+    isize               staging_size,
+    i32                 in_flight,
+    isize              *out_size)
+{
+    u8 header[LZ4F_HEADER_MAX + 4];
+    lz4_stream s = { .file = file, .dst = (u8 *)dst, .dst_capacity = dst_capacity };
+    i64 content_size;
+    isize skip;
+
+    isize got = ia_file_read(file, header, ia_ssizeof(header), offset);
+    isize header_size = lz4f_read_header(header, ia_max(got, 0), &s.flg, &s.block_max, &content_size, &skip);
+    if (header_size <= 0 || got < header_size + 4)
+        return ia_result_unknown_error;
+    if (!(s.flg & LZ4F_FLG_BLOCK_INDEP) || (s.flg & LZ4F_FLG_DICT_ID))
+        return ia_result_unknown_error; /* linked blocks must be decoded in order */
+    if (content_size > dst_capacity)
+        return ia_result_unknown_error;
+
+    s.next_word = ia_le32_to_cpu(lz4_read32(header + header_size));
+    s.pos = offset + header_size + 4;
+
+    in_flight = ia_clamp(in_flight, 1, IA_STREAM_MAX_IN_FLIGHT);
+    ia_stream_info info = {
+        .read = (ia_stream_read_fn)lz4_stream_read,
+        .process = (ia_stream_process_fn)lz4_stream_process,
+        .userdata = &s,
+        .staging = staging,
+        .chunk_capacity = staging_size / in_flight,
+        .in_flight = in_flight,
+        .name = "ia_stream_lz4_frame",
+    };
+    if (info.chunk_capacity < s.block_max + 8)
+        return ia_result_unknown_error;
+
+    ia_result result = ia_stream_run(&info);
+    if (result != ia_result_success)
+        return result;
+
+    if (content_size >= 0 && content_size != s.total)
+        return ia_result_unknown_error;
+    if (s.flg & LZ4F_FLG_CONTENT_CHECKSUM) {
+        /* the content checksum follows the end mark, which was read with the last block */
+        u32 checksum;
+        if (ia_file_read(file, &checksum, 4, s.pos) != 4)
+            return ia_result_unknown_error;
+        if (ia_xxh32(dst, s.total, 0) != ia_le32_to_cpu(checksum))
+            return ia_result_unknown_error;
+    }
+    if (out_size)
+        *out_size = s.total;
+    return ia_result_success;
+}
+
+/* Bitonic sorting network of 16 packed keys, branchless compare-exchanges. */
+static void sort_network16_u64(u64 *v)
+{
+    for (i32 k = 2; k <= IA_SORT_NETWORK_MAX; k <<= 1) {
+        for (i32 j = k >> 1; j > 0; j >>= 1) {
+            for (i32 i = 0; i < IA_SORT_NETWORK_MAX; i++) {
+                i32 l = i ^ j;
+                if (l <= i)
+                    continue;
+                u64 a = v[i], b = v[l];
+                u64 lo = a < b ? a : b, hi = a < b ? b : a;
+                bool up = (i & k) == 0;
+                v[i] = up ? lo : hi;
+                v[l] = up ? hi : lo;
+            }
+        }
+    }
+}
+
+/* The key size is a constant at every call site, so the generic sort is specialized when inlined. */
+IA_FORCE_INLINE u64 radix_key(void const *keys, i32 key_size, isize i)
+{ return key_size == 4 ? ((u32 const *)keys)[i] : ((u64 const *)keys)[i]; }
+
+IA_FORCE_INLINE void radix_set_key(void *keys, i32 key_size, isize i, u64 key)
+{
+    if (key_size == 4)
+        ((u32 *)keys)[i] = (u32)key;
+    else
+        ((u64 *)keys)[i] = key;
+}
+
+IA_FORCE_INLINE void radix_insertion_sort(
+    isize       count,
+    void       *keys,
+    u32        *values,
+    i32         key_size)
+{
+    for (isize i = 1; i < count; i++) {
+        u64 key = radix_key(keys, key_size, i);
+        u32 value = values ? values[i] : 0;
+        isize j = i;
+        for (; j > 0 && radix_key(keys, key_size, j - 1) > key; j--) {
+            radix_set_key(keys, key_size, j, radix_key(keys, key_size, j - 1));
+            if (values)
+                values[j] = values[j - 1];
+        }
+        radix_set_key(keys, key_size, j, key);
+        if (values)
+            values[j] = value;
+    }
+}
+
+void ia_sort_network_u32(
+    isize       count,
+    u32        *keys,
+    u32        *values)
+{
+    ia_dbg_assert(count <= IA_SORT_NETWORK_MAX, "Sorting network of %lld keys is too large.", (long long)count);
+    if (IA_UNLIKELY(count > IA_SORT_NETWORK_MAX)) {
+        /* there is no scratch for a radix sort, a correct slow result beats a stack overrun */
+        radix_insertion_sort(count, keys, values, 4);
+        return;
+    }
+    if (count <= 1)
+        return;
+    compute_kernels const *kernels = compute_kernels_select();
+    if (!values && kernels->sort_network16_u32) {
+        alignas(16) u32 v[IA_SORT_NETWORK_MAX];
+        memcpy(v, keys, sizeof(u32) * count);
+        memset(&v[count], 0xff, sizeof(u32) * (IA_SORT_NETWORK_MAX - count));
+        kernels->sort_network16_u32(v);
+        memcpy(keys, v, sizeof(u32) * count);
+        return;
+    }
+    /* the value is packed below the key, padding sorts last */
+    u64 v[IA_SORT_NETWORK_MAX];
+    for (isize i = 0; i < IA_SORT_NETWORK_MAX; i++)
+        v[i] = i < count ? (u64)keys[i] << 32 | (values ? values[i] : 0) : UINT64_MAX;
+    sort_network16_u64(v);
+    for (isize i = 0; i < count; i++) {
+        keys[i] = (u32)(v[i] >> 32);
+        if (values)
+            values[i] = (u32)v[i];
+    }
+}
+
+/* Digits of the radix sort are 8 bits wide. */
+#define RADIX_BITS          8
+#define RADIX_BUCKETS       (1 << RADIX_BITS)
+/* below this count insertion sort is faster than the counting passes */
+#define RADIX_SMALL         64
+/* below this count a parallel sort runs on the calling fiber */
+#define RADIX_PARALLEL_MIN  (1 << 16)
+
+/* Moves keys of the range [begin..end) to their offsets, the offsets are advanced. */
+IA_FORCE_INLINE void radix_scatter(
+    void const *src_keys,
+    u32 const  *src_values,
+    void       *dst_keys,
+    u32        *dst_values,
+    isize       begin,
+    isize       end,
+    i32         shift,
+    i32         key_size,
+    isize      *offsets)
+{
+    if (src_values) {
+        for (isize i = begin; i < end; i++) {
+            u64 key = radix_key(src_keys, key_size, i);
+            isize at = offsets[(key >> shift) & (RADIX_BUCKETS - 1)]++;
+            radix_set_key(dst_keys, key_size, at, key);
+            dst_values[at] = src_values[i];
+        }
+    } else {
+        for (isize i = begin; i < end; i++) {
+            u64 key = radix_key(src_keys, key_size, i);
+            radix_set_key(dst_keys, key_size, offsets[(key >> shift) & (RADIX_BUCKETS - 1)]++, key);
+        }
+    }
+}
+
+IA_FORCE_INLINE void radix_sort(
+    isize       count,
+    void       *keys,
+    u32        *values,
+    void       *keys_scratch,
+    u32        *values_scratch,
+    i32         key_size)
+{
+    ia_dbg_assert(!values || values_scratch, "Radix sort of values needs a values scratch buffer.");
+    if (count < RADIX_SMALL) {
+        if (key_size == 4 && !values && count <= IA_SORT_NETWORK_MAX)
+            ia_sort_network_u32(count, (u32 *)keys, nullptr);
+        else
+            radix_insertion_sort(count, keys, values, key_size);
+        return;
+    }
+
+    /* histograms of all digits in a single read */
+    isize histograms[sizeof(u64)][RADIX_BUCKETS] = {0};
+    for (isize i = 0; i < count; i++) {
+        u64 key = radix_key(keys, key_size, i);
+        for (i32 d = 0; d < key_size; d++)
+            histograms[d][(key >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+    }
+
+    void *src_keys = keys, *dst_keys = keys_scratch;
+    u32 *src_values = values, *dst_values = values_scratch;
+    u64 first = radix_key(keys, key_size, 0);
+    for (i32 d = 0; d < key_size; d++) {
+        isize *offsets = histograms[d];
+        i32 shift = d * RADIX_BITS;
+        if (offsets[(first >> shift) & (RADIX_BUCKETS - 1)] == count)
+            continue; /* every key has the same digit */
+
+        for (isize b = 0, sum = 0; b < RADIX_BUCKETS; b++) {
+            isize c = offsets[b];
+            offsets[b] = sum;
+            sum += c;
+        }
+        radix_scatter(src_keys, src_values, dst_keys, dst_values, 0, count, shift, key_size, offsets);
+        ia_swap(src_keys, dst_keys);
+        ia_swap(src_values, dst_values);
+    }
+    if (src_keys != keys) {
+        memcpy(keys, src_keys, count * key_size);
+        if (values)
+            memcpy(values, src_values, count * sizeof(u32));
+    }
+}
+
+void ia_radix_sort_u32(
+    isize       count,
+    u32        *keys,
+    u32        *values,
+    u32        *keys_scratch,
+    u32        *values_scratch)
+{
+    radix_sort(count, keys, values, keys_scratch, values_scratch, sizeof(u32));
+}
+
+void ia_radix_sort_u64(
+    isize       count,
+    u64        *keys,
+    u32        *values,
+    u64        *keys_scratch,
+    u32        *values_scratch)
+{
+    radix_sort(count, keys, values, keys_scratch, values_scratch, sizeof(u64));
+}
+
+typedef struct radix_job {
+    void const     *src_keys;
+    u32 const      *src_values;
+    void           *dst_keys;
+    u32            *dst_values;
+    isize           begin;
+    isize           end;
+    i32             shift;
+    i32             key_size;
+    isize           offsets[RADIX_BUCKETS]; /* histogram of the block, then its scatter offsets */
+} radix_job;
+
+static IA_WORK_FN(radix_job_count, radix_job *job)
+{
+    memset(job->offsets, 0, sizeof(job->offsets));
+    for (isize i = job->begin; i < job->end; i++)
+        job->offsets[(radix_key(job->src_keys, job->key_size, i) >> job->shift) & (RADIX_BUCKETS - 1)]++;
+}
+
+static IA_WORK_FN(radix_job_scatter, radix_job *job)
+{
+    if (job->key_size == 4)
+        radix_scatter(job->src_keys, job->src_values, job->dst_keys, job->dst_values, job->begin, job->end, job->shift, 4, job->offsets);
+    else
+        radix_scatter(job->src_keys, job->src_values, job->dst_keys, job->dst_values, job->begin, job->end, job->shift, 8, job->offsets);
+}
+
+static void radix_sort_parallel(
+    isize       count,
+    void       *keys,
+    u32        *values,
+    void       *keys_scratch,
+    u32        *values_scratch,
+    i32         key_size,
+    i32         job_count)
+{
+    if (count < RADIX_PARALLEL_MIN || job_count <= 1) {
+        if (key_size == 4)
+            radix_sort(count, keys, values, keys_scratch, values_scratch, 4);
+        else
+            radix_sort(count, keys, values, keys_scratch, values_scratch, 8);
+        return;
+    }
+    ia_dbg_assert(!values || values_scratch, "Radix sort of values needs a values scratch buffer.");
+
+    /* contiguous blocks of keys, the first jobs take the remainder */
+    job_count = ia_min(job_count, IA_SORT_MAX_JOBS);
+    radix_job jobs[IA_SORT_MAX_JOBS];
+    ia_work_details details[IA_SORT_MAX_JOBS];
+    isize per_job = count / job_count, extra = count % job_count;
+    isize first = 0;
+    for (i32 j = 0; j < job_count; j++) {
+        jobs[j].begin = first;
+        jobs[j].end = first + per_job + (j < extra);
+        jobs[j].key_size = key_size;
+        first = jobs[j].end;
+    }
+
+    void *src_keys = keys, *dst_keys = keys_scratch;
+    u32 *src_values = values, *dst_values = values_scratch;
+    for (i32 shift = 0; shift < key_size * 8; shift += RADIX_BITS) {
+        for (i32 j = 0; j < job_count; j++) {
+            jobs[j].src_keys = src_keys;
+            jobs[j].src_values = src_values;
+            jobs[j].dst_keys = dst_keys;
+            jobs[j].dst_values = dst_values;
+            jobs[j].shift = shift;
+            details[j] = (ia_work_details){ .fn = (ia_work_fn)radix_job_count, .data = &jobs[j], .name = "ia_radix_sort_count" };
+        }
+        ia_yield(ia_submit_work(job_count, details));
+
+        /* offsets in digit-major, block-minor order keep the sort stable */
+        isize sum = 0;
+        u64 first_digit = (radix_key(src_keys, key_size, 0) >> shift) & (RADIX_BUCKETS - 1);
+        isize first_total = 0;
+        for (i32 j = 0; j < job_count; j++)
+            first_total += jobs[j].offsets[first_digit];
+        if (first_total == count)
+            continue; /* every key has the same digit */
+        for (isize b = 0; b < RADIX_BUCKETS; b++) {
+            for (i32 j = 0; j < job_count; j++) {
+                isize c = jobs[j].offsets[b];
+                jobs[j].offsets[b] = sum;
+                sum += c;
+            }
+        }
+
+        for (i32 j = 0; j < job_count; j++)
+            details[j] = (ia_work_details){ .fn = (ia_work_fn)radix_job_scatter, .data = &jobs[j], .name = "ia_radix_sort_scatter" };
+        ia_yield(ia_submit_work(job_count, details));
+        ia_swap(src_keys, dst_keys);
+        ia_swap(src_values, dst_values);
+    }
+    if (src_keys != keys) {
+        memcpy(keys, src_keys, count * key_size);
+        if (values)
+            memcpy(values, src_values, count * sizeof(u32));
+    }
+}
+
+void ia_radix_sort_u32_parallel(
+    isize       count,
+    u32        *keys,
+    u32        *values,
+    u32        *keys_scratch,
+    u32        *values_scratch,
+    i32         job_count)
+{
+    radix_sort_parallel(count, keys, values, keys_scratch, values_scratch, sizeof(u32), job_count);
+}
+
+void ia_radix_sort_u64_parallel(
+    isize       count,
+    u64        *keys,
+    u32        *values,
+    u64        *keys_scratch,
+    u32        *values_scratch,
+    i32         job_count)
+{
+    radix_sort_parallel(count, keys, values, keys_scratch, values_scratch, sizeof(u64), job_count);
+}
+
+/* Inverse of the 3x3 part and the translation of an affine transform, rows of the inverse
+ * 3x3 part are cross products of the columns, divided by the determinant. */
+static bool affine_inverse(
+    f32x3 const    *m,
+    f32x3          *dest)
+{
+    f32x3 r[3];
+    ia_vec3_cross(m[1], m[2], r[0]);
+    ia_vec3_cross(m[2], m[0], r[1]);
+    ia_vec3_cross(m[0], m[1], r[2]);
+    f32 det = ia_vec3_dot(m[0], r[0]);
+    if (IA_UNLIKELY(det == 0.0f || !isfinite(det)))
+        return false;
+
+    f32 inv_det = 1.0f / det;
+    for (i32 i = 0; i < 3; i++)
+        ia_vec3_scale(r[i], inv_det, r[i]);
+    for (i32 c = 0; c < 3; c++) {
+        dest[c][0] = r[0][c];
+        dest[c][1] = r[1][c];
+        dest[c][2] = r[2][c];
+    }
+    f32x3 t;
+    ia_vec3_copy(m[3], t);
+    dest[3][0] = -ia_vec3_dot(r[0], t);
+    dest[3][1] = -ia_vec3_dot(r[1], t);
+    dest[3][2] = -ia_vec3_dot(r[2], t);
+    return true;
+}
+
+bool ia_mat4_inverse_affine(
+    f32m4x4 const   m,
+    f32m4x4         dest)
+{
+    f32m4x3 a, r;
+    ia_affine_from_mat4(m, a);
+    if (!affine_inverse(a, r))
+        return false;
+    ia_affine_to_mat4(r, dest);
+    return true;
+}
+
+bool ia_affine_inverse(
+    f32m4x3 const   m,
+    f32m4x3         dest)
+{
+    f32m4x3 r;
+    if (!affine_inverse(m, r))
+        return false;
+    memcpy(dest, r, sizeof(f32m4x3));
+    return true;
+}
+
+/* 2x2 minors of the first two and the last two columns, by Laplace expansion. The expansion is
+ * the same for the transpose, so the formulas index the columns as rows. */
+#define MAT4_MINORS(m) \
+    f32 s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1]; \
+    f32 s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2]; \
+    f32 s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3]; \
+    f32 s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2]; \
+    f32 s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3]; \
+    f32 s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3]; \
+    f32 c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3]; \
+    f32 c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3]; \
+    f32 c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2]; \
+    f32 c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3]; \
+    f32 c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2]; \
+    f32 c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1]; \
+    f32 det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0
+
+f32 ia_mat4_determinant(f32m4x4 const m)
+{
+    MAT4_MINORS(m);
+    return det;
+}
+
+bool ia_mat4_inverse(
+    f32m4x4 const   m,
+    f32m4x4         dest)
+{
+    MAT4_MINORS(m);
+    if (IA_UNLIKELY(det == 0.0f || !isfinite(det)))
+        return false;
+
+    f32m4x4 r = {
+        { + m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3,
+          - m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3,
+          + m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3,
+          - m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3 },
+        { - m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1,
+          + m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1,
+          - m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1,
+          + m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1 },
+        { + m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0,
+          - m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0,
+          + m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0,
+          - m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0 },
+        { - m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0,
+          + m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0,
+          - m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0,
+          + m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0 },
+    };
+    f32 inv_det = 1.0f / det;
+    for (i32 c = 0; c < 4; c++)
+        ia_vec4_scale(r[c], inv_det, dest[c]);
+    return true;
+}
+#undef MAT4_MINORS
+
+void ia_mat4_transform_points(
+    f32m4x4 const   m,
+    isize           count,
+    f32x3 const    *points,
+    f32x4          *dest)
+{
+    compute_kernels_select()->mat4_transform_points(m, count, points, dest);
+}
+
+void ia_affine_transform_points(
+    f32m4x3 const   m,
+    isize           count,
+    f32x3 const    *points,
+    f32x3          *dest)
+{
+    compute_kernels_select()->affine_transform_points(m, count, points, dest);
+}
+
+void ia_quat_nlerp_soa(
+    isize               count,
+    ia_quat_soa const  *from,
+    ia_quat_soa const  *to,
+    f32                 t,
+    ia_quat_soa const  *dest)
+{
+    compute_kernels_select()->quat_nlerp_soa(count, from, to, &t, 0, dest);
+}
+
+void ia_quat_nlerp_soa_weights(
+    isize               count,
+    ia_quat_soa const  *from,
+    ia_quat_soa const  *to,
+    f32 const          *weights,
+    ia_quat_soa const  *dest)
+{
+    compute_kernels_select()->quat_nlerp_soa(count, from, to, weights, 1, dest);
+}
+
+/* below this count a parallel cull runs on the calling fiber */
+#define CULL_PARALLEL_MIN   (1 << 14)
+
+isize ia_frustum_cull_aabbs(
+    ia_frustum const   *frustum,
+    isize               count,
+    ia_aabb_soa const  *boxes,
+    u32                *indices)
+{
+    return compute_kernels_select()->frustum_cull(frustum, 0, count, boxes, indices);
+}
+
+typedef struct cull_job {
+    ia_frustum const   *frustum;
+    ia_aabb_soa const  *boxes;
+    u32                *indices;
+    isize               begin;
+    isize               end;
+    isize               visible;
+} cull_job;
+
+static IA_WORK_FN(cull_job_run, cull_job *job)
+{
+    job->visible = compute_kernels_select()->frustum_cull(job->frustum, job->begin, job->end, job->boxes, &job->indices[job->begin]);
+}
+
+isize ia_frustum_cull_aabbs_parallel(
+    ia_frustum const   *frustum,
+    isize               count,
+    ia_aabb_soa const  *boxes,
+    u32                *indices,
+    i32                 job_count)
+{
+    if (count < CULL_PARALLEL_MIN || job_count <= 1)
+        return compute_kernels_select()->frustum_cull(frustum, 0, count, boxes, indices);
+
+    /* blocks are multiples of 16 boxes, the AVX-512 width, so only the last block has a scalar tail */
+    job_count = ia_min(job_count, IA_FRUSTUM_CULL_MAX_JOBS);
+    cull_job jobs[IA_FRUSTUM_CULL_MAX_JOBS];
+    ia_work_details details[IA_FRUSTUM_CULL_MAX_JOBS];
+    isize per_job = ((count + job_count - 1) / job_count + 15) & ~(isize)15;
+    i32 j = 0;
+    for (isize first = 0; first < count; first += per_job, j++) {
+        jobs[j] = (cull_job){
+            .frustum = frustum,
+            .boxes = boxes,
+            .indices = indices,
+            .begin = first,
+            .end = ia_min(first + per_job, count),
+        };
+        details[j] = (ia_work_details){ .fn = (ia_work_fn)cull_job_run, .data = &jobs[j], .name = "ia_frustum_cull" };
+    }
+    ia_yield(ia_submit_work(j, details));
+
+    /* every block wrote its list at its first box, the lists only move towards the front */
+    isize visible = jobs[0].visible;
+    for (i32 k = 1; k < j; k++) {
+        memmove(&indices[visible], &indices[jobs[k].begin], jobs[k].visible * sizeof(u32));
+        visible += jobs[k].visible;
+    }
+    return visible;
+}
+
+void ia_camera_views_update(
+    i32                 view_count,
+    ia_camera_view     *views,
+    u32                 frame_index,
+    u32                 jitter_phases)
+{
+    f32x2 jitter = {0};
+    if (jitter_phases)
+        ia_camera_jitter_halton(frame_index, jitter_phases, jitter);
+
+    for (i32 i = 0; i < view_count; i++) {
+        ia_camera_view *v = &views[i];
+        f32m4x4 projection;
+        /* a zeroed view has no w row yet, that's the first update */
+        bool first = true;
+        for (i32 c = 0; c < 4; c++)
+            first &= v->view_projection_unjittered[c][3] == 0.0f;
+
+        ia_mat4_copy(v->view_projection_unjittered, v->prev_view_projection);
+        ia_mat4_mul(v->projection, v->view, v->view_projection_unjittered);
+        if (first)
+            ia_mat4_copy(v->view_projection_unjittered, v->prev_view_projection);
+        ia_frustum_from_mat4(v->view_projection_unjittered, &v->frustum);
+
+        ia_vec2_copy(jitter, v->jitter);
+        ia_camera_jitter_projection(v->projection, jitter, v->resolution, projection);
+        ia_mat4_mul(projection, v->view, v->view_projection);
+    }
+}
+
+/* binary nodes deeper than this split at the median, so the depth of the tree stays bounded */
+#define BVH_SAH_DEPTH       40
+/* a level of the tree pushes at most the children of a node but one, the depth is below 80 */
+#define BVH_STACK_SIZE      (80 * IA_BVH_WIDTH)
+/* nodes with fewer primitives are built by the job that split their parent */
+#define BVH_PARALLEL_MIN    4096
+/* child of an unused slot of a node */
+#define BVH_EMPTY           UINT32_MAX
+
+typedef struct bvh_binary_node {
+    ia_aabb     bounds;
+    u32         left;       /* the right child is `left + 1` */
+    u32         first;
+    u32         count;      /* 0 for an inner node */
+} bvh_binary_node;
+
+typedef struct bvh_builder {
+    ia_aabb const      *boxes;
+    f32x3              *centroids;
+    u32                *ids;
+    bvh_binary_node    *nodes;
+    atomic_i32          next;
+    i32                 parallel_depth;
+} bvh_builder;
+
+typedef struct bvh_build_job {
+    bvh_builder    *builder;
+    u32             node;
+    u32             begin;
+    u32             end;
+    i32             depth;
+} bvh_build_job;
+
+IA_FORCE_INLINE i32 bvh_bin(f32 c, f32 lo, f32 scale)
+{
+    i32 k = (i32)((c - lo) * scale);
+    return ia_clamp(k, 0, IA_BVH_BINS - 1);
+}
+
+/* Evaluates the splits at the bin borders along every axis, the bins stay out of the recursion's frames.
+ * @return Axis of the cheapest split, or -1 if no split separates the centroids. */
+static IA_FORCE_NOINLINE i32 bvh_find_split(
+    bvh_builder const  *b,
+    u32                 begin,
+    u32                 end,
+    ia_aabb const      *centroid_bounds,
+    i32                *out_bin,
+    f32                *out_cost)
+{
+    i32 axis = -1;
+    f32 best = INFINITY;
+    for (i32 a = 0; a < 3; a++) {
+        f32 lo = centroid_bounds->min[a], extent = centroid_bounds->max[a] - lo;
+        if (!(extent > 0.0f))
+            continue;
+        f32 scale = IA_BVH_BINS / extent;
+        ia_aabb bins[IA_BVH_BINS];
+        u32 counts[IA_BVH_BINS] = {0};
+        for (i32 k = 0; k < IA_BVH_BINS; k++)
+            ia_aabb_empty(&bins[k]);
+        for (u32 i = begin; i < end; i++) {
+            u32 id = b->ids[i];
+            i32 k = bvh_bin(b->centroids[id][a], lo, scale);
+            counts[k]++;
+            ia_aabb_merge(&bins[k], &b->boxes[id], &bins[k]);
+        }
+        /* costs of the right sides, then a sweep from the left */
+        f32 right[IA_BVH_BINS];
+        ia_aabb acc;
+        u32 c = 0;
+        ia_aabb_empty(&acc);
+        for (i32 k = IA_BVH_BINS - 1; k > 0; k--) {
+            ia_aabb_merge(&acc, &bins[k], &acc);
+            c += counts[k];
+            right[k] = c ? ia_aabb_surface_area(&acc) * (f32)c : 0.0f;
+        }
+        ia_aabb_empty(&acc);
+        c = 0;
+        for (i32 k = 0; k < IA_BVH_BINS - 1; k++) {
+            ia_aabb_merge(&acc, &bins[k], &acc);
+            c += counts[k];
+            if (c == 0 || c == end - begin)
+                continue;
+            f32 cost = ia_aabb_surface_area(&acc) * (f32)c + right[k + 1];
+            if (cost < best) {
+                best = cost;
+                axis = a;
+                *out_bin = k + 1;
+            }
+        }
+    }
+    *out_cost = best;
+    return axis;
+}
+
+static void bvh_build_node(bvh_builder *b, u32 node, u32 begin, u32 end, i32 depth);
+
+static IA_WORK_FN(bvh_build_job_run, bvh_build_job *job)
+{
+    bvh_build_node(job->builder, job->node, job->begin, job->end, job->depth);
+}
+
+static void bvh_build_node(bvh_builder *b, u32 node, u32 begin, u32 end, i32 depth)
+{
+    bvh_binary_node *n = &b->nodes[node];
+    u32 count = end - begin;
+    ia_aabb centroid_bounds;
+    ia_aabb_empty(&n->bounds);
+    ia_aabb_empty(&centroid_bounds);
+    for (u32 i = begin; i < end; i++) {
+        ia_aabb_merge(&n->bounds, &b->boxes[b->ids[i]], &n->bounds);
+        ia_aabb_merge_point(&centroid_bounds, b->centroids[b->ids[i]], &centroid_bounds);
+    }
+    n->first = begin;
+    n->count = count;
+    if (count <= 1)
+        return;
+
+    i32 bin = 0, axis = -1;
+    f32 cost = INFINITY;
+    if (depth < BVH_SAH_DEPTH)
+        axis = bvh_find_split(b, begin, end, &centroid_bounds, &bin, &cost);
+
+    u32 mid;
+    if (axis >= 0) {
+        /* a split costs a traversal step and the intersections of both sides, weighted by their areas */
+        f32 area = ia_aabb_surface_area(&n->bounds);
+        if (count <= IA_BVH_LEAF_MAX && cost + area >= area * (f32)count)
+            return;
+        f32 lo = centroid_bounds.min[axis];
+        f32 scale = IA_BVH_BINS / (centroid_bounds.max[axis] - lo);
+        u32 i = begin, j = end;
+        while (i < j) {
+            if (bvh_bin(b->centroids[b->ids[i]][axis], lo, scale) < bin) {
+                i++;
+            } else {
+                j--;
+                ia_swap(b->ids[i], b->ids[j]);
+            }
+        }
+        mid = i;
+    } else {
+        if (count <= IA_BVH_LEAF_MAX)
+            return;
+        /* the centroids don't separate, or the tree is too deep, any halves will do */
+        mid = begin + count / 2;
+    }
+
+    u32 left = (u32)ia_atomic_add_monotonic(&b->next, 2);
+    n->left = left;
+    n->count = 0;
+    if (depth < b->parallel_depth && count >= BVH_PARALLEL_MIN) {
+        bvh_build_job jobs[2] = {
+            { .builder = b, .node = left, .begin = begin, .end = mid, .depth = depth + 1 },
+            { .builder = b, .node = left + 1, .begin = mid, .end = end, .depth = depth + 1 },
+        };
+        ia_work_details details[2];
+        for (i32 j = 0; j < 2; j++)
+            details[j] = (ia_work_details){ .fn = (ia_work_fn)bvh_build_job_run, .data = &jobs[j], .name = "ia_bvh_build" };
+        ia_yield(ia_submit_work(2, details));
+    } else {
+        bvh_build_node(b, left, begin, mid, depth + 1);
+        bvh_build_node(b, left + 1, mid, end, depth + 1);
+    }
+}
+
+IA_FORCE_INLINE void bvh_write_slot(ia_bvh_node *node, i32 i, ia_aabb const *a)
+{
+    node->min_x[i] = a->min[0];
+    node->min_y[i] = a->min[1];
+    node->min_z[i] = a->min[2];
+    node->max_x[i] = a->max[0];
+    node->max_y[i] = a->max[1];
+    node->max_z[i] = a->max[2];
+}
+
+IA_FORCE_INLINE void bvh_node_bounds(ia_bvh_node const *node, ia_aabb *dest)
+{
+    ia_aabb_empty(dest);
+    for (i32 i = 0; i < IA_BVH_WIDTH; i++) {
+        ia_aabb a = {
+            .min = { node->min_x[i], node->min_y[i], node->min_z[i] },
+            .max = { node->max_x[i], node->max_y[i], node->max_z[i] },
+        };
+        ia_aabb_merge(dest, &a, dest);
+    }
+}
+
+/* Fills a wide node from the subtree of a binary node, opening the inner child of the largest area
+ * until the node is full. Nodes are numbered in preorder, parents before children. */
+static void bvh_collapse(ia_bvh *bvh, bvh_binary_node const *binary, u32 binary_node, u32 node)
+{
+    u32 slots[IA_BVH_WIDTH];
+    i32 n = 0;
+    if (binary[binary_node].count) {
+        slots[n++] = binary_node;
+    } else {
+        slots[n++] = binary[binary_node].left;
+        slots[n++] = binary[binary_node].left + 1;
+    }
+    while (n < IA_BVH_WIDTH) {
+        i32 open = -1;
+        f32 open_area = -1.0f;
+        for (i32 i = 0; i < n; i++) {
+            bvh_binary_node const *c = &binary[slots[i]];
+            f32 area = ia_aabb_surface_area(&c->bounds);
+            if (!c->count && area > open_area) {
+                open = i;
+                open_area = area;
+            }
+        }
+        if (open < 0)
+            break;
+        u32 left = binary[slots[open]].left;
+        slots[open] = left;
+        slots[n++] = left + 1;
+    }
+
+    ia_bvh_node *w = &bvh->nodes[node];
+    for (i32 i = 0; i < IA_BVH_WIDTH; i++) {
+        if (i >= n) {
+            ia_aabb empty;
+            ia_aabb_empty(&empty);
+            bvh_write_slot(w, i, &empty);
+            w->child[i] = BVH_EMPTY;
+            w->count[i] = 0;
+            continue;
+        }
+        bvh_binary_node const *c = &binary[slots[i]];
+        bvh_write_slot(w, i, &c->bounds);
+        if (c->count) {
+            w->child[i] = c->first;
+            w->count[i] = c->count;
+        } else {
+            u32 child = (u32)bvh->node_count++;
+            w->child[i] = child;
+            w->count[i] = 0;
+            bvh_collapse(bvh, binary, slots[i], child);
+        }
+    }
+}
+
+void ia_bvh_build(
+    ia_bvh         *bvh,
+    isize           count,
+    ia_aabb const  *boxes,
+    i32             job_count)
+{
+    ia_dbg_assert(count < (isize)UINT32_MAX / 2, "Too many primitives for a BVH.");
+    if (count > bvh->capacity) {
+        /* drift memory isn't freed, growing at least twofold keeps growing scenes from piling it up */
+        isize capacity = ia_max(count, 2 * bvh->capacity);
+        /* every wide node but a leaf root takes at least one binary inner node */
+        bvh->nodes = ia_drift_alloc_as(ia_bvh_node, capacity);
+        bvh->indices = ia_drift_alloc_as(u32, capacity);
+        bvh->boxes = ia_drift_alloc_as(ia_aabb, capacity);
+        isize scratch_size = ia_ssizeof(bvh_binary_node) * (2 * capacity - 1) + ia_ssizeof(f32x3) * capacity;
+        bvh->scratch = ia_drift_alloc(scratch_size, ia_salignof(bvh_binary_node));
+        bvh->capacity = capacity;
+    }
+    bvh->count = count;
+    bvh->node_count = 0;
+    ia_aabb_empty(&bvh->bounds);
+    if (count == 0)
+        return;
+
+    bvh_builder b = { .boxes = boxes, .ids = bvh->indices };
+    b.nodes = (bvh_binary_node *)bvh->scratch;
+    b.centroids = (f32x3 *)(b.nodes + 2 * bvh->capacity - 1);
+    ia_atomic_init(&b.next, 1);
+    /* subtrees are handed to jobs until there are a few per job */
+    while (job_count > 1 && (1 << b.parallel_depth) < job_count * 4)
+        b.parallel_depth++;
+    for (isize i = 0; i < count; i++) {
+        b.ids[i] = (u32)i;
+        for (i32 a = 0; a < 3; a++)
+            b.centroids[i][a] = (boxes[i].min[a] + boxes[i].max[a]) * 0.5f;
+    }
+    bvh_build_node(&b, 0, 0, (u32)count, 0);
+
+    bvh->node_count = 1;
+    bvh_collapse(bvh, b.nodes, 0, 0);
+    for (isize i = 0; i < count; i++)
+        bvh->boxes[i] = boxes[b.ids[i]];
+    bvh->bounds = b.nodes[0].bounds;
+}
+
+void ia_bvh_refit(
+    ia_bvh         *bvh,
+    ia_aabb const  *boxes)
+{
+    for (isize i = 0; i < bvh->count; i++)
+        bvh->boxes[i] = boxes[bvh->indices[i]];
+    /* children have higher indices than their parents, they're refit first */
+    for (i32 n = bvh->node_count - 1; n >= 0; n--) {
+        ia_bvh_node *w = &bvh->nodes[n];
+        for (i32 i = 0; i < IA_BVH_WIDTH; i++) {
+            ia_aabb a;
+            if (w->child[i] == BVH_EMPTY)
+                continue;
+            if (w->count[i]) {
+                ia_aabb_empty(&a);
+                for (u32 k = w->child[i]; k < w->child[i] + w->count[i]; k++)
+                    ia_aabb_merge(&a, &bvh->boxes[k], &a);
+            } else {
+                bvh_node_bounds(&bvh->nodes[w->child[i]], &a);
+            }
+            bvh_write_slot(w, i, &a);
+        }
+    }
+    if (bvh->node_count)
+        bvh_node_bounds(&bvh->nodes[0], &bvh->bounds);
+}
+
+typedef struct bvh_ray {
+    f32x3   inv;        /* reciprocal of the direction, without infinities */
+    f32x3   origin_inv; /* origin multiplied by `inv` */
+    bool    negative[3];
+} bvh_ray;
+
+typedef struct bvh_entry {
+    u32     node;
+    f32     t;
+} bvh_entry;
+
+IA_FORCE_INLINE void bvh_ray_init(bvh_ray *ray, f32x3 const origin, f32x3 const direction)
+{
+    for (i32 a = 0; a < 3; a++) {
+        /* a tiny component instead of zero keeps the slabs of origins on a box face from NaNs */
+        f32 d = fabsf(direction[a]) < 1e-20f ? copysignf(1e-20f, direction[a]) : direction[a];
+        ray->inv[a] = 1.0f / d;
+        ray->origin_inv[a] = origin[a] * ray->inv[a];
+        ray->negative[a] = ray->inv[a] < 0.0f;
+    }
+}
+
+/* Slab test of a box, the near side of every slab is picked by the sign of the direction.
+ * @return Distance where the ray enters the box, or infinity. */
+IA_FORCE_INLINE f32 bvh_ray_box(bvh_ray const *ray, ia_aabb const *a, f32 t_max)
+{
+    f32 t_near = 0.0f, t_far = t_max;
+    for (i32 i = 0; i < 3; i++) {
+        f32 lo = ray->negative[i] ? a->max[i] : a->min[i];
+        f32 hi = ray->negative[i] ? a->min[i] : a->max[i];
+        f32 t0 = lo * ray->inv[i] - ray->origin_inv[i];
+        f32 t1 = hi * ray->inv[i] - ray->origin_inv[i];
+        t_near = t0 > t_near ? t0 : t_near;
+        t_far = t1 < t_far ? t1 : t_far;
+    }
+    return t_near <= t_far ? t_near : INFINITY;
+}
+
+/* Slab test of the children of a node, distances where the ray enters them are written into `t_near`.
+ * @return Mask of the children hit within [0, t_max]. */
+IA_FORCE_INLINE u32 bvh_ray_node(bvh_ray const *ray, ia_bvh_node const *node, f32 t_max, f32 *t_near)
+{
+    f32 const *nx = ray->negative[0] ? node->max_x : node->min_x;
+    f32 const *ny = ray->negative[1] ? node->max_y : node->min_y;
+    f32 const *nz = ray->negative[2] ? node->max_z : node->min_z;
+    f32 const *fx = ray->negative[0] ? node->min_x : node->max_x;
+    f32 const *fy = ray->negative[1] ? node->min_y : node->max_y;
+    f32 const *fz = ray->negative[2] ? node->min_z : node->max_z;
+#if defined(IA_SIMD_X86) && IA_BVH_WIDTH == 8
+    s256f ix = _mm256_set1_ps(ray->inv[0]), ox = _mm256_set1_ps(ray->origin_inv[0]);
+    s256f iy = _mm256_set1_ps(ray->inv[1]), oy = _mm256_set1_ps(ray->origin_inv[1]);
+    s256f iz = _mm256_set1_ps(ray->inv[2]), oz = _mm256_set1_ps(ray->origin_inv[2]);
+    s256f t0 = _mm256_max_ps(ia_simd256_fmsub(_mm256_load_ps(nx), ix, ox), ia_simd256_fmsub(_mm256_load_ps(ny), iy, oy));
+    s256f t1 = _mm256_min_ps(ia_simd256_fmsub(_mm256_load_ps(fx), ix, ox), ia_simd256_fmsub(_mm256_load_ps(fy), iy, oy));
+    t0 = _mm256_max_ps(t0, _mm256_max_ps(ia_simd256_fmsub(_mm256_load_ps(nz), iz, oz), _mm256_setzero_ps()));
+    t1 = _mm256_min_ps(t1, _mm256_min_ps(ia_simd256_fmsub(_mm256_load_ps(fz), iz, oz), _mm256_set1_ps(t_max)));
+    _mm256_storeu_ps(t_near, t0);
+    return (u32)_mm256_movemask_ps(_mm256_cmp_ps(t0, t1, _CMP_LE_OQ));
+#elif defined(IA_SIMD_X86)
+    s128f ix = ia_simd_set1_rval(ray->inv[0]), ox = ia_simd_set1_rval(ray->origin_inv[0]);
+    s128f iy = ia_simd_set1_rval(ray->inv[1]), oy = ia_simd_set1_rval(ray->origin_inv[1]);
+    s128f iz = ia_simd_set1_rval(ray->inv[2]), oz = ia_simd_set1_rval(ray->origin_inv[2]);
+    s128f t0 = ia_simd_max(ia_simd_fmsub(ia_simd_read(nx), ix, ox), ia_simd_fmsub(ia_simd_read(ny), iy, oy));
+    s128f t1 = ia_simd_min(ia_simd_fmsub(ia_simd_read(fx), ix, ox), ia_simd_fmsub(ia_simd_read(fy), iy, oy));
+    t0 = ia_simd_max(t0, ia_simd_max(ia_simd_fmsub(ia_simd_read(nz), iz, oz), _mm_setzero_ps()));
+    t1 = ia_simd_min(t1, ia_simd_min(ia_simd_fmsub(ia_simd_read(fz), iz, oz), ia_simd_set1_rval(t_max)));
+    _mm_storeu_ps(t_near, t0);
+    return (u32)_mm_movemask_ps(_mm_cmple_ps(t0, t1));
+#else
+    u32 mask = 0;
+    for (i32 i = 0; i < IA_BVH_WIDTH; i++) {
+        f32 t0 = 0.0f, t1 = t_max;
+        f32 n[3] = { nx[i] * ray->inv[0] - ray->origin_inv[0], ny[i] * ray->inv[1] - ray->origin_inv[1], nz[i] * ray->inv[2] - ray->origin_inv[2] };
+        f32 f[3] = { fx[i] * ray->inv[0] - ray->origin_inv[0], fy[i] * ray->inv[1] - ray->origin_inv[1], fz[i] * ray->inv[2] - ray->origin_inv[2] };
+        for (i32 a = 0; a < 3; a++) {
+            t0 = n[a] > t0 ? n[a] : t0;
+            t1 = f[a] < t1 ? f[a] : t1;
+        }
+        t_near[i] = t0;
+        mask |= (u32)(t0 <= t1) << i;
+    }
+    return mask;
+#endif
+}
+
+static bool bvh_traverse_ray(
+    ia_bvh const   *bvh,
+    f32x3 const     origin,
+    f32x3 const     direction,
+    f32             t_max,
+    ia_bvh_ray_fn   fn,
+    void           *userdata,
+    bool            any,
+    ia_bvh_hit     *hit)
+{
+    if (bvh->node_count == 0)
+        return false;
+    bvh_ray ray;
+    bvh_ray_init(&ray, origin, direction);
+
+    bvh_entry stack[BVH_STACK_SIZE];
+    f32 t_near[IA_BVH_WIDTH];
+    i32 top = 0;
+    stack[top++] = (bvh_entry){ .node = 0, .t = 0.0f };
+    f32 best = t_max;
+    u32 primitive = 0;
+    bool found = false;
+    while (top) {
+        bvh_entry e = stack[--top];
+        if (e.t > best)
+            continue; /* a closer hit was found since it was pushed */
+        ia_bvh_node const *node = &bvh->nodes[e.node];
+        u32 mask = bvh_ray_node(&ray, node, best, t_near);
+        i32 first = top;
+        while (mask) {
+            i32 i = ia_ctz(mask);
+            mask &= mask - 1;
+            if (node->count[i] == 0) {
+                /* inserted by distance, the nearest child is popped first */
+                bvh_entry c = { .node = node->child[i], .t = t_near[i] };
+                i32 j = top++;
+                for (; j > first && stack[j - 1].t < c.t; j--)
+                    stack[j] = stack[j - 1];
+                stack[j] = c;
+                continue;
+            }
+            for (u32 k = node->child[i]; k < node->child[i] + node->count[i]; k++) {
+                f32 t = bvh_ray_box(&ray, &bvh->boxes[k], best);
+                if (fn && t < best)
+                    t = fn(userdata, bvh->indices[k], origin, direction, best);
+                if (t < best) {
+                    best = t;
+                    primitive = bvh->indices[k];
+                    found = true;
+                    if (any)
+                        return true;
+                }
+            }
+        }
+    }
+    if (found)
+        *hit = (ia_bvh_hit){ .primitive = primitive, .t = best };
+    return found;
+}
+
+bool ia_bvh_raycast(
+    ia_bvh const   *bvh,
+    f32x3 const     origin,
+    f32x3 const     direction,
+    f32             t_max,
+    ia_bvh_ray_fn   fn,
+    void           *userdata,
+    ia_bvh_hit     *hit)
+{
+    return bvh_traverse_ray(bvh, origin, direction, t_max, fn, userdata, false, hit);
+}
+
+bool ia_bvh_occluded(
+    ia_bvh const   *bvh,
+    f32x3 const     origin,
+    f32x3 const     direction,
+    f32             t_max,
+    ia_bvh_ray_fn   fn,
+    void           *userdata)
+{
+    ia_bvh_hit hit;
+    return bvh_traverse_ray(bvh, origin, direction, t_max, fn, userdata, true, &hit);
+}
+
+/* Plane tests of the children of a node, with the corner farthest along the plane normal.
+ * Unused children have infinite corners, their distances are -inf or NaN and fail the test.
+ * @return Mask of the children not fully behind a plane. */
+IA_FORCE_INLINE u32 bvh_frustum_node(ia_frustum const *frustum, ia_bvh_node const *node)
+{
+#if defined(IA_SIMD_X86) && IA_BVH_WIDTH == 8
+    s256f visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+#elif defined(IA_SIMD_X86)
+    s128f visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+#else
+    u32 mask = (1u << IA_BVH_WIDTH) - 1;
+#endif
+    for (i32 p = 0; p < ia_frustum_plane_count; p++) {
+        f32 const *n = frustum->planes[p];
+        f32 const *px = n[0] >= 0.0f ? node->max_x : node->min_x;
+        f32 const *py = n[1] >= 0.0f ? node->max_y : node->min_y;
+        f32 const *pz = n[2] >= 0.0f ? node->max_z : node->min_z;
+#if defined(IA_SIMD_X86) && IA_BVH_WIDTH == 8
+        s256f d = ia_simd256_fmadd(_mm256_load_ps(px), _mm256_set1_ps(n[0]), _mm256_set1_ps(n[3]));
+        d = ia_simd256_fmadd(_mm256_load_ps(py), _mm256_set1_ps(n[1]), d);
+        d = ia_simd256_fmadd(_mm256_load_ps(pz), _mm256_set1_ps(n[2]), d);
+        visible = _mm256_and_ps(visible, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+#elif defined(IA_SIMD_X86)
+        s128f d = ia_simd_fmadd(ia_simd_read(px), ia_simd_set1_rval(n[0]), ia_simd_set1_rval(n[3]));
+        d = ia_simd_fmadd(ia_simd_read(py), ia_simd_set1_rval(n[1]), d);
+        d = ia_simd_fmadd(ia_simd_read(pz), ia_simd_set1_rval(n[2]), d);
+        visible = _mm_and_ps(visible, _mm_cmpge_ps(d, _mm_setzero_ps()));
+#else
+        for (i32 i = 0; i < IA_BVH_WIDTH; i++)
+            if (!(px[i] * n[0] + py[i] * n[1] + pz[i] * n[2] + n[3] >= 0.0f))
+                mask &= ~(1u << i);
+#endif
+    }
+#if defined(IA_SIMD_X86) && IA_BVH_WIDTH == 8
+    return (u32)_mm256_movemask_ps(visible);
+#elif defined(IA_SIMD_X86)
+    return (u32)_mm_movemask_ps(visible);
+#else
+    return mask;
+#endif
+}
+
+/* Overlap tests of the children of a node, unused children have min above every max. */
+IA_FORCE_INLINE u32 bvh_aabb_node(ia_aabb const *a, ia_bvh_node const *node)
+{
+#if defined(IA_SIMD_X86) && IA_BVH_WIDTH == 8
+    s256f m = _mm256_and_ps(
+        _mm256_cmp_ps(_mm256_load_ps(node->min_x), _mm256_set1_ps(a->max[0]), _CMP_LE_OQ),
+        _mm256_cmp_ps(_mm256_load_ps(node->max_x), _mm256_set1_ps(a->min[0]), _CMP_GE_OQ));
+    m = _mm256_and_ps(m, _mm256_and_ps(
+        _mm256_cmp_ps(_mm256_load_ps(node->min_y), _mm256_set1_ps(a->max[1]), _CMP_LE_OQ),
+        _mm256_cmp_ps(_mm256_load_ps(node->max_y), _mm256_set1_ps(a->min[1]), _CMP_GE_OQ)));
+    m = _mm256_and_ps(m, _mm256_and_ps(
+        _mm256_cmp_ps(_mm256_load_ps(node->min_z), _mm256_set1_ps(a->max[2]), _CMP_LE_OQ),
+        _mm256_cmp_ps(_mm256_load_ps(node->max_z), _mm256_set1_ps(a->min[2]), _CMP_GE_OQ)));
+    return (u32)_mm256_movemask_ps(m);
+#elif defined(IA_SIMD_X86)
+    s128f m = _mm_and_ps(
+        _mm_cmple_ps(ia_simd_read(node->min_x), ia_simd_set1_rval(a->max[0])),
+        _mm_cmpge_ps(ia_simd_read(node->max_x), ia_simd_set1_rval(a->min[0])));
+    m = _mm_and_ps(m, _mm_and_ps(
+        _mm_cmple_ps(ia_simd_read(node->min_y), ia_simd_set1_rval(a->max[1])),
+        _mm_cmpge_ps(ia_simd_read(node->max_y), ia_simd_set1_rval(a->min[1]))));
+    m = _mm_and_ps(m, _mm_and_ps(
+        _mm_cmple_ps(ia_simd_read(node->min_z), ia_simd_set1_rval(a->max[2])),
+        _mm_cmpge_ps(ia_simd_read(node->max_z), ia_simd_set1_rval(a->min[2]))));
+    return (u32)_mm_movemask_ps(m);
+#else
+    u32 mask = 0;
+    for (i32 i = 0; i < IA_BVH_WIDTH; i++) {
+        ia_aabb b = {
+            .min = { node->min_x[i], node->min_y[i], node->min_z[i] },
+            .max = { node->max_x[i], node->max_y[i], node->max_z[i] },
+        };
+        mask |= (u32)ia_aabb_overlaps(a, &b) << i;
+    }
+    return mask;
+#endif
+}
+
+isize ia_bvh_query_frustum(
+    ia_bvh const       *bvh,
+    ia_frustum const   *frustum,
+    u32                *out,
+    isize               capacity)
+{
+    if (bvh->node_count == 0)
+        return 0;
+    u32 stack[BVH_STACK_SIZE];
+    i32 top = 0;
+    isize found = 0;
+    stack[top++] = 0;
+    while (top) {
+        ia_bvh_node const *node = &bvh->nodes[stack[--top]];
+        u32 mask = bvh_frustum_node(frustum, node);
+        while (mask) {
+            i32 i = ia_ctz(mask);
+            mask &= mask - 1;
+            if (node->count[i] == 0) {
+                stack[top++] = node->child[i];
+                continue;
+            }
+            for (u32 k = node->child[i]; k < node->child[i] + node->count[i]; k++) {
+                if (!ia_frustum_test_aabb(frustum, &bvh->boxes[k]))
+                    continue;
+                if (found < capacity)
+                    out[found] = bvh->indices[k];
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+isize ia_bvh_query_aabb(
+    ia_bvh const   *bvh,
+    ia_aabb const  *box,
+    u32            *out,
+    isize           capacity)
+{
+    if (bvh->node_count == 0)
+        return 0;
+    u32 stack[BVH_STACK_SIZE];
+    i32 top = 0;
+    isize found = 0;
+    stack[top++] = 0;
+    while (top) {
+        ia_bvh_node const *node = &bvh->nodes[stack[--top]];
+        u32 mask = bvh_aabb_node(box, node);
+        while (mask) {
+            i32 i = ia_ctz(mask);
+            mask &= mask - 1;
+            if (node->count[i] == 0) {
+                stack[top++] = node->child[i];
+                continue;
+            }
+            for (u32 k = node->child[i]; k < node->child[i] + node->count[i]; k++) {
+                if (!ia_aabb_overlaps(box, &bvh->boxes[k]))
+                    continue;
+                if (found < capacity)
+                    out[found] = bvh->indices[k];
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+void ia_f16_encode(
+    isize           count,
+    f32 const      *src,
+    u16            *dest)
+{
+    compute_kernels_select()->f16_encode(count, src, dest);
+}
+
+void ia_f16_decode(
+    isize           count,
+    u16 const      *src,
+    f32            *dest)
+{
+    compute_kernels_select()->f16_decode(count, src, dest);
+}
+
+#if defined(IA_SIMD_X86)
+/* Clamps 4 floats to [lo, 1] and scales them to integers rounded to nearest even, NaN becomes 0.
+ * Scaled in doubles like `ia_pack_round_scaled_`, so the codes are the same as of the scalar version. */
+IA_FORCE_INLINE s128i norm_encode4(f32 const *src, f32 lo, f32 scale)
+{
+    s128f x = _mm_loadu_ps(src);
+    x = _mm_and_ps(x, _mm_cmpord_ps(x, x));
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(lo)), _mm_set1_ps(1.0f));
+    s128d s = _mm_set1_pd((f64)scale);
+    s128i a = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtps_pd(x), s));
+    s128i b = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), s));
+    return _mm_unpacklo_epi64(a, b);
+}
+#endif /* IA_SIMD_X86 */
+
+void ia_norm_encode(
+    ia_norm_format  format,
+    isize           count,
+    f32 const      *src,
+    void           *dest)
+{
+    isize i = 0;
+    switch (format) {
+    case ia_norm_format_unorm8: {
+        u8 *d = dest;
+#if defined(IA_SIMD_X86)
+        for (; i + 16 <= count; i += 16) {
+            s128i lo = _mm_packs_epi32(norm_encode4(&src[i], 0.0f, 255.0f), norm_encode4(&src[i + 4], 0.0f, 255.0f));
+            s128i hi = _mm_packs_epi32(norm_encode4(&src[i + 8], 0.0f, 255.0f), norm_encode4(&src[i + 12], 0.0f, 255.0f));
+            _mm_storeu_si128((s128i *)&d[i], _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; i < count; i++)
+            d[i] = ia_unorm8_from_f32(src[i]);
+        break;
+    }
+    case ia_norm_format_snorm8: {
+        i8 *d = dest;
+#if defined(IA_SIMD_X86)
+        for (; i + 16 <= count; i += 16) {
+            s128i lo = _mm_packs_epi32(norm_encode4(&src[i], -1.0f, 127.0f), norm_encode4(&src[i + 4], -1.0f, 127.0f));
+            s128i hi = _mm_packs_epi32(norm_encode4(&src[i + 8], -1.0f, 127.0f), norm_encode4(&src[i + 12], -1.0f, 127.0f));
+            _mm_storeu_si128((s128i *)&d[i], _mm_packs_epi16(lo, hi));
+        }
+#endif
+        for (; i < count; i++)
+            d[i] = ia_snorm8_from_f32(src[i]);
+        break;
+    }
+    case ia_norm_format_unorm16: {
+        u16 *d = dest;
+#if defined(IA_SIMD_X86)
+        /* SSE2 only packs with signed saturation, the codes are biased into its range and back */
+        s128i bias = _mm_set1_epi32(32768);
+        for (; i + 8 <= count; i += 8) {
+            s128i lo = _mm_sub_epi32(norm_encode4(&src[i], 0.0f, 65535.0f), bias);
+            s128i hi = _mm_sub_epi32(norm_encode4(&src[i + 4], 0.0f, 65535.0f), bias);
+            _mm_storeu_si128((s128i *)&d[i], _mm_xor_si128(_mm_packs_epi32(lo, hi), _mm_set1_epi16((i16)0x8000)));
+        }
+#endif
+        for (; i < count; i++)
+            d[i] = ia_unorm16_from_f32(src[i]);
+        break;
+    }
+    case ia_norm_format_snorm16: {
+        i16 *d = dest;
+#if defined(IA_SIMD_X86)
+        for (; i + 8 <= count; i += 8) {
+            s128i v = _mm_packs_epi32(norm_encode4(&src[i], -1.0f, 32767.0f), norm_encode4(&src[i + 4], -1.0f, 32767.0f));
+            _mm_storeu_si128((s128i *)&d[i], v);
+        }
+#endif
+        for (; i < count; i++)
+            d[i] = ia_snorm16_from_f32(src[i]);
+        break;
+    }
+    }
+}
+
+/* The decode loops are conversions and multiplies without branches, compilers vectorize them. */
+void ia_norm_decode(
+    ia_norm_format  format,
+    isize           count,
+    void const     *src,
+    f32            *dest)
+{
+    switch (format) {
+    case ia_norm_format_unorm8:
+        for (isize i = 0; i < count; i++)
+            dest[i] = ia_unorm8_to_f32(((u8 const *)src)[i]);
+        break;
+    case ia_norm_format_snorm8:
+        for (isize i = 0; i < count; i++)
+            dest[i] = ia_snorm8_to_f32(((i8 const *)src)[i]);
+        break;
+    case ia_norm_format_unorm16:
+        for (isize i = 0; i < count; i++)
+            dest[i] = ia_unorm16_to_f32(((u16 const *)src)[i]);
+        break;
+    case ia_norm_format_snorm16:
+        for (isize i = 0; i < count; i++)
+            dest[i] = ia_snorm16_to_f32(((i16 const *)src)[i]);
+        break;
+    }
+}
+
+void ia_oct_encode_snorm16(
+    isize           count,
+    f32x3 const    *normals,
+    u32            *dest)
+{
+    for (isize i = 0; i < count; i++) {
+        f32x2 e;
+        ia_oct_from_vec3(normals[i], e);
+        /* of the four codes around the point, keep the one that decodes closest to the normal */
+        f32 bx = floorf(e[0] * 32767.0f), by = floorf(e[1] * 32767.0f);
+        f32 best = INFINITY;
+        u32 code = 0;
+        for (i32 k = 0; k < 4; k++) {
+            f32 qx = ia_min(bx + (f32)(k & 1), 32767.0f);
+            f32 qy = ia_min(by + (f32)(k >> 1), 32767.0f);
+            f32x2 q = { qx * (1.0f / 32767.0f), qy * (1.0f / 32767.0f) };
+            f32x3 v;
+            ia_oct_to_vec3(q, v);
+            /* a dot product close to 1 has no precision left to tell the candidates apart, a distance does */
+            f32 dx = v[0] - normals[i][0], dy = v[1] - normals[i][1], dz = v[2] - normals[i][2];
+            f32 d = dx * dx + dy * dy + dz * dz;
+            if (d < best) {
+                best = d;
+                code = (u32)(u16)(i16)qx | (u32)(u16)(i16)qy << 16;
+            }
+        }
+        dest[i] = code;
+    }
+}
+
+void ia_oct_decode_snorm16(
+    isize           count,
+    u32 const      *src,
+    f32x3          *dest)
+{
+    for (isize i = 0; i < count; i++) {
+        f32x2 e = { ia_snorm16_to_f32((i16)(src[i] & 0xffffu)), ia_snorm16_to_f32((i16)(src[i] >> 16)) };
+        ia_oct_to_vec3(e, dest[i]);
+    }
+}
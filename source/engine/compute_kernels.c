@@ -0,0 +1,406 @@
+/* Compiled once per instruction set, `COMPUTE_KERNELS_VARIANT` names the table of this build.
+ * Everything else is static, so the variants never clash. See compute_kernels.h. */
+#include "compute_kernels.h"
+#include <ia/compute/simd.h>
+#include <ia/compute/vector.h>
+#include <ia/compute/bits.h>
+
+#ifndef COMPUTE_KERNELS_VARIANT
+#define COMPUTE_KERNELS_VARIANT baseline
+#endif
+#define COMPUTE_KERNELS_TABLE_(variant) compute_kernels_##variant
+#define COMPUTE_KERNELS_TABLE(variant)  COMPUTE_KERNELS_TABLE_(variant)
+
+#if defined(IA_SIMD_X86) && defined(IA_ARCH_X86_SSE4_1)
+/* Sorts a bitonic sequence of 4 lanes. */
+static inline s128i sort_bitonic4(s128i v)
+{
+    s128i t = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    v = _mm_blend_epi16(_mm_min_epu32(v, t), _mm_max_epu32(v, t), 0xf0);
+    t = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_blend_epi16(_mm_min_epu32(v, t), _mm_max_epu32(v, t), 0xcc);
+}
+
+/* Merges two sorted runs of 4 lanes into a sorted run of 8. */
+static inline void sort_merge4(s128i *a, s128i *b)
+{
+    s128i r = _mm_shuffle_epi32(*b, _MM_SHUFFLE(0, 1, 2, 3));
+    s128i lo = _mm_min_epu32(*a, r), hi = _mm_max_epu32(*a, r);
+    *a = sort_bitonic4(lo);
+    *b = sort_bitonic4(hi);
+}
+
+/* Merges two sorted runs of 8 lanes into a sorted run of 16. */
+static inline void sort_merge8(s128i *a0, s128i *a1, s128i *b0, s128i *b1)
+{
+    s128i r0 = _mm_shuffle_epi32(*b1, _MM_SHUFFLE(0, 1, 2, 3));
+    s128i r1 = _mm_shuffle_epi32(*b0, _MM_SHUFFLE(0, 1, 2, 3));
+    s128i l0 = _mm_min_epu32(*a0, r0), l1 = _mm_min_epu32(*a1, r1);
+    s128i h0 = _mm_max_epu32(*a0, r0), h1 = _mm_max_epu32(*a1, r1);
+    *a0 = sort_bitonic4(_mm_min_epu32(l0, l1));
+    *a1 = sort_bitonic4(_mm_max_epu32(l0, l1));
+    *b0 = sort_bitonic4(_mm_min_epu32(h0, h1));
+    *b1 = sort_bitonic4(_mm_max_epu32(h0, h1));
+}
+
+static inline void sort_exchange4(s128i *a, s128i *b)
+{
+    s128i lo = _mm_min_epu32(*a, *b);
+    *b = _mm_max_epu32(*a, *b);
+    *a = lo;
+}
+
+/* Sorts 16 keys: columns of 4 registers with a sorting network, then bitonic merges of the rows. */
+static void sort_network16_u32(u32 *v)
+{
+    s128i v0 = _mm_load_si128((s128i const *)&v[0]);
+    s128i v1 = _mm_load_si128((s128i const *)&v[4]);
+    s128i v2 = _mm_load_si128((s128i const *)&v[8]);
+    s128i v3 = _mm_load_si128((s128i const *)&v[12]);
+    sort_exchange4(&v0, &v1);
+    sort_exchange4(&v2, &v3);
+    sort_exchange4(&v0, &v2);
+    sort_exchange4(&v1, &v3);
+    sort_exchange4(&v1, &v2);
+
+    /* transpose, every sorted column becomes a sorted register */
+    s128i t0 = _mm_unpacklo_epi32(v0, v1), t1 = _mm_unpacklo_epi32(v2, v3);
+    s128i t2 = _mm_unpackhi_epi32(v0, v1), t3 = _mm_unpackhi_epi32(v2, v3);
+    v0 = _mm_unpacklo_epi64(t0, t1);
+    v1 = _mm_unpackhi_epi64(t0, t1);
+    v2 = _mm_unpacklo_epi64(t2, t3);
+    v3 = _mm_unpackhi_epi64(t2, t3);
+
+    sort_merge4(&v0, &v1);
+    sort_merge4(&v2, &v3);
+    sort_merge8(&v0, &v1, &v2, &v3);
+    _mm_store_si128((s128i *)&v[0], v0);
+    _mm_store_si128((s128i *)&v[4], v1);
+    _mm_store_si128((s128i *)&v[8], v2);
+    _mm_store_si128((s128i *)&v[12], v3);
+}
+#endif /* IA_SIMD_X86 && IA_ARCH_X86_SSE4_1 */
+
+static void mat4_transform_points(
+    f32m4x4 const   m,
+    isize           count,
+    f32x3 const    *points,
+    f32x4          *dest)
+{
+#if defined(IA_SIMD_X86)
+    s128f c0 = ia_simd_read(m[0]), c1 = ia_simd_read(m[1]);
+    s128f c2 = ia_simd_read(m[2]), c3 = ia_simd_read(m[3]);
+    for (isize i = 0; i < count; i++) {
+        s128f r = ia_simd_fmadd(c0, ia_simd_set1_rval(points[i][0]), c3);
+        r = ia_simd_fmadd(c1, ia_simd_set1_rval(points[i][1]), r);
+        r = ia_simd_fmadd(c2, ia_simd_set1_rval(points[i][2]), r);
+        ia_simd_write(dest[i], r);
+    }
+#else
+    for (isize i = 0; i < count; i++) {
+        f32 x = points[i][0], y = points[i][1], z = points[i][2];
+        for (i32 j = 0; j < 4; j++)
+            dest[i][j] = m[0][j] * x + m[1][j] * y + m[2][j] * z + m[3][j];
+    }
+#endif
+}
+
+static void affine_transform_points(
+    f32m4x3 const   m,
+    isize           count,
+    f32x3 const    *points,
+    f32x3          *dest)
+{
+#if defined(IA_SIMD_X86)
+    s128f c0 = ia_simd_read3f(m[0]), c1 = ia_simd_read3f(m[1]);
+    s128f c2 = ia_simd_read3f(m[2]), c3 = ia_simd_read3f(m[3]);
+    for (isize i = 0; i < count; i++) {
+        s128f r = ia_simd_fmadd(c0, ia_simd_set1_rval(points[i][0]), c3);
+        r = ia_simd_fmadd(c1, ia_simd_set1_rval(points[i][1]), r);
+        r = ia_simd_fmadd(c2, ia_simd_set1_rval(points[i][2]), r);
+        ia_simd_write3f(dest[i], r);
+    }
+#else
+    for (isize i = 0; i < count; i++) {
+        f32 x = points[i][0], y = points[i][1], z = points[i][2];
+        for (i32 j = 0; j < 3; j++)
+            dest[i][j] = m[0][j] * x + m[1][j] * y + m[2][j] * z + m[3][j];
+    }
+#endif
+}
+
+/* Normalized lerp of rotations in SoA, `weights` advance by `weight_stride`, zero for a shared weight. */
+static void quat_nlerp_soa(
+    isize               count,
+    ia_quat_soa const  *from,
+    ia_quat_soa const  *to,
+    f32 const          *weights,
+    isize               weight_stride,
+    ia_quat_soa const  *dest)
+{
+    isize i = 0;
+#if defined(IA_SIMD_X86) && defined(IA_ARCH_X86_AVX512F) && defined(IA_ARCH_X86_AVX512DQ)
+    for (; i + 16 <= count; i += 16) {
+        s512f ax = _mm512_loadu_ps(&from->x[i]), bx = _mm512_loadu_ps(&to->x[i]);
+        s512f ay = _mm512_loadu_ps(&from->y[i]), by = _mm512_loadu_ps(&to->y[i]);
+        s512f az = _mm512_loadu_ps(&from->z[i]), bz = _mm512_loadu_ps(&to->z[i]);
+        s512f aw = _mm512_loadu_ps(&from->w[i]), bw = _mm512_loadu_ps(&to->w[i]);
+        s512f t = weight_stride ? _mm512_loadu_ps(&weights[i]) : _mm512_set1_ps(weights[0]);
+        s512f d = _mm512_mul_ps(ax, bx);
+        d = _mm512_fmadd_ps(ay, by, d);
+        d = _mm512_fmadd_ps(az, bz, d);
+        d = _mm512_fmadd_ps(aw, bw, d);
+        s512f tb = _mm512_xor_ps(t, _mm512_and_ps(d, _mm512_set1_ps(-0.0f)));
+        s512f ta = _mm512_sub_ps(_mm512_set1_ps(1.0f), t);
+        s512f rx = _mm512_fmadd_ps(bx, tb, _mm512_mul_ps(ax, ta));
+        s512f ry = _mm512_fmadd_ps(by, tb, _mm512_mul_ps(ay, ta));
+        s512f rz = _mm512_fmadd_ps(bz, tb, _mm512_mul_ps(az, ta));
+        s512f rw = _mm512_fmadd_ps(bw, tb, _mm512_mul_ps(aw, ta));
+        s512f n2 = _mm512_mul_ps(rx, rx);
+        n2 = _mm512_fmadd_ps(ry, ry, n2);
+        n2 = _mm512_fmadd_ps(rz, rz, n2);
+        n2 = _mm512_fmadd_ps(rw, rw, n2);
+        /* the estimate has 14 bits, one Newton-Raphson step is still needed for full precision */
+        s512f y = _mm512_rsqrt14_ps(n2);
+        s512f h = _mm512_mul_ps(_mm512_mul_ps(n2, _mm512_set1_ps(0.5f)), _mm512_mul_ps(y, y));
+        y = _mm512_mul_ps(y, _mm512_sub_ps(_mm512_set1_ps(1.5f), h));
+        _mm512_storeu_ps(&dest->x[i], _mm512_mul_ps(rx, y));
+        _mm512_storeu_ps(&dest->y[i], _mm512_mul_ps(ry, y));
+        _mm512_storeu_ps(&dest->z[i], _mm512_mul_ps(rz, y));
+        _mm512_storeu_ps(&dest->w[i], _mm512_mul_ps(rw, y));
+    }
+#endif
+#if defined(IA_SIMD_X86) && defined(IA_ARCH_X86_AVX)
+    for (; i + 8 <= count; i += 8) {
+        s256f ax = _mm256_loadu_ps(&from->x[i]), bx = _mm256_loadu_ps(&to->x[i]);
+        s256f ay = _mm256_loadu_ps(&from->y[i]), by = _mm256_loadu_ps(&to->y[i]);
+        s256f az = _mm256_loadu_ps(&from->z[i]), bz = _mm256_loadu_ps(&to->z[i]);
+        s256f aw = _mm256_loadu_ps(&from->w[i]), bw = _mm256_loadu_ps(&to->w[i]);
+        s256f t = weight_stride ? _mm256_loadu_ps(&weights[i]) : _mm256_set1_ps(weights[0]);
+        /* the sign of the dot product flips the weight of `to` into the shorter arc */
+        s256f d = _mm256_mul_ps(ax, bx);
+        d = ia_simd256_fmadd(ay, by, d);
+        d = ia_simd256_fmadd(az, bz, d);
+        d = ia_simd256_fmadd(aw, bw, d);
+        s256f tb = _mm256_xor_ps(t, _mm256_and_ps(d, ia_simd_float32x8_SIGNMASK_NEG));
+        s256f ta = _mm256_sub_ps(_mm256_set1_ps(1.0f), t);
+        s256f rx = ia_simd256_fmadd(bx, tb, _mm256_mul_ps(ax, ta));
+        s256f ry = ia_simd256_fmadd(by, tb, _mm256_mul_ps(ay, ta));
+        s256f rz = ia_simd256_fmadd(bz, tb, _mm256_mul_ps(az, ta));
+        s256f rw = ia_simd256_fmadd(bw, tb, _mm256_mul_ps(aw, ta));
+        s256f n2 = _mm256_mul_ps(rx, rx);
+        n2 = ia_simd256_fmadd(ry, ry, n2);
+        n2 = ia_simd256_fmadd(rz, rz, n2);
+        n2 = ia_simd256_fmadd(rw, rw, n2);
+        /* one Newton-Raphson step: y * (1.5 - 0.5 * x * y * y) */
+        s256f y = _mm256_rsqrt_ps(n2);
+        s256f h = _mm256_mul_ps(_mm256_mul_ps(n2, _mm256_set1_ps(0.5f)), _mm256_mul_ps(y, y));
+        y = _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), h));
+        _mm256_storeu_ps(&dest->x[i], _mm256_mul_ps(rx, y));
+        _mm256_storeu_ps(&dest->y[i], _mm256_mul_ps(ry, y));
+        _mm256_storeu_ps(&dest->z[i], _mm256_mul_ps(rz, y));
+        _mm256_storeu_ps(&dest->w[i], _mm256_mul_ps(rw, y));
+    }
+#endif
+#if defined(IA_SIMD_X86)
+    for (; i + 4 <= count; i += 4) {
+        s128f ax = _mm_loadu_ps(&from->x[i]), bx = _mm_loadu_ps(&to->x[i]);
+        s128f ay = _mm_loadu_ps(&from->y[i]), by = _mm_loadu_ps(&to->y[i]);
+        s128f az = _mm_loadu_ps(&from->z[i]), bz = _mm_loadu_ps(&to->z[i]);
+        s128f aw = _mm_loadu_ps(&from->w[i]), bw = _mm_loadu_ps(&to->w[i]);
+        s128f t = weight_stride ? _mm_loadu_ps(&weights[i]) : ia_simd_set1_rval(weights[0]);
+        s128f d = ia_simd_mul(ax, bx);
+        d = ia_simd_fmadd(ay, by, d);
+        d = ia_simd_fmadd(az, bz, d);
+        d = ia_simd_fmadd(aw, bw, d);
+        s128f tb = _mm_xor_ps(t, _mm_and_ps(d, ia_simd_float32x4_SIGNMASK_NEG));
+        s128f ta = ia_simd_sub(ia_simd_set1_rval(1.0f), t);
+        s128f rx = ia_simd_fmadd(bx, tb, ia_simd_mul(ax, ta));
+        s128f ry = ia_simd_fmadd(by, tb, ia_simd_mul(ay, ta));
+        s128f rz = ia_simd_fmadd(bz, tb, ia_simd_mul(az, ta));
+        s128f rw = ia_simd_fmadd(bw, tb, ia_simd_mul(aw, ta));
+        s128f n2 = ia_simd_mul(rx, rx);
+        n2 = ia_simd_fmadd(ry, ry, n2);
+        n2 = ia_simd_fmadd(rz, rz, n2);
+        n2 = ia_simd_fmadd(rw, rw, n2);
+        s128f y = ia_simd_rsqrt(n2);
+        _mm_storeu_ps(&dest->x[i], ia_simd_mul(rx, y));
+        _mm_storeu_ps(&dest->y[i], ia_simd_mul(ry, y));
+        _mm_storeu_ps(&dest->z[i], ia_simd_mul(rz, y));
+        _mm_storeu_ps(&dest->w[i], ia_simd_mul(rw, y));
+    }
+#endif
+    for (; i < count; i++) {
+        f32 t = weights[i * weight_stride];
+        f32 d = from->x[i] * to->x[i] + from->y[i] * to->y[i] + from->z[i] * to->z[i] + from->w[i] * to->w[i];
+        f32 tb = d < 0.0f ? -t : t, ta = 1.0f - t;
+        f32 rx = from->x[i] * ta + to->x[i] * tb;
+        f32 ry = from->y[i] * ta + to->y[i] * tb;
+        f32 rz = from->z[i] * ta + to->z[i] * tb;
+        f32 rw = from->w[i] * ta + to->w[i] * tb;
+        f32 y = ia_rsqrtf(rx * rx + ry * ry + rz * rz + rw * rw);
+        dest->x[i] = rx * y;
+        dest->y[i] = ry * y;
+        dest->z[i] = rz * y;
+        dest->w[i] = rw * y;
+    }
+}
+
+/* Culls boxes [begin..end), the indices of visible ones are written from `indices[0]`. A box is visible
+ * when the smallest of its plane distances, extended by the projected extent, is not negative. */
+static isize frustum_cull(
+    ia_frustum const   *frustum,
+    isize               begin,
+    isize               end,
+    ia_aabb_soa const  *boxes,
+    u32                *indices)
+{
+    f32 n[ia_frustum_plane_count][7];
+    for (i32 p = 0; p < ia_frustum_plane_count; p++) {
+        f32 const *plane = frustum->planes[p];
+        for (i32 j = 0; j < 4; j++)
+            n[p][j] = plane[j];
+        for (i32 j = 0; j < 3; j++)
+            n[p][4 + j] = fabsf(plane[j]);
+    }
+    isize visible = 0, i = begin;
+#if defined(IA_SIMD_X86) && defined(IA_ARCH_X86_AVX512F)
+    s512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    for (; i + 16 <= end; i += 16) {
+        s512f cx = _mm512_loadu_ps(&boxes->center_x[i]);
+        s512f cy = _mm512_loadu_ps(&boxes->center_y[i]);
+        s512f cz = _mm512_loadu_ps(&boxes->center_z[i]);
+        s512f ex = _mm512_loadu_ps(&boxes->extent_x[i]);
+        s512f ey = _mm512_loadu_ps(&boxes->extent_y[i]);
+        s512f ez = _mm512_loadu_ps(&boxes->extent_z[i]);
+        s512f m = _mm512_set1_ps(INFINITY);
+        for (i32 p = 0; p < ia_frustum_plane_count; p++) {
+            s512f d = _mm512_fmadd_ps(cx, _mm512_set1_ps(n[p][0]), _mm512_set1_ps(n[p][3]));
+            d = _mm512_fmadd_ps(cy, _mm512_set1_ps(n[p][1]), d);
+            d = _mm512_fmadd_ps(cz, _mm512_set1_ps(n[p][2]), d);
+            d = _mm512_fmadd_ps(ex, _mm512_set1_ps(n[p][4]), d);
+            d = _mm512_fmadd_ps(ey, _mm512_set1_ps(n[p][5]), d);
+            d = _mm512_fmadd_ps(ez, _mm512_set1_ps(n[p][6]), d);
+            m = _mm512_min_ps(m, d);
+        }
+        u32 mask = (u32)_mm512_cmp_ps_mask(m, _mm512_setzero_ps(), _CMP_GE_OQ);
+        /* compressed in a register and stored whole, a compress store to memory is microcoded on some
+         * cores. The lanes past the visible ones land below `indices[i + 16 - begin]`, inside this block. */
+        s512i idx = _mm512_add_epi32(_mm512_set1_epi32((i32)i), lanes);
+        _mm512_storeu_si512(&indices[visible], _mm512_maskz_compress_epi32((__mmask16)mask, idx));
+        visible += ia_popcnt(mask);
+    }
+#endif
+#if defined(IA_SIMD_X86) && defined(IA_ARCH_X86_AVX)
+    for (; i + 8 <= end; i += 8) {
+        s256f cx = _mm256_loadu_ps(&boxes->center_x[i]);
+        s256f cy = _mm256_loadu_ps(&boxes->center_y[i]);
+        s256f cz = _mm256_loadu_ps(&boxes->center_z[i]);
+        s256f ex = _mm256_loadu_ps(&boxes->extent_x[i]);
+        s256f ey = _mm256_loadu_ps(&boxes->extent_y[i]);
+        s256f ez = _mm256_loadu_ps(&boxes->extent_z[i]);
+        s256f m = _mm256_set1_ps(INFINITY);
+        for (i32 p = 0; p < ia_frustum_plane_count; p++) {
+            s256f d = ia_simd256_fmadd(cx, _mm256_set1_ps(n[p][0]), _mm256_set1_ps(n[p][3]));
+            d = ia_simd256_fmadd(cy, _mm256_set1_ps(n[p][1]), d);
+            d = ia_simd256_fmadd(cz, _mm256_set1_ps(n[p][2]), d);
+            d = ia_simd256_fmadd(ex, _mm256_set1_ps(n[p][4]), d);
+            d = ia_simd256_fmadd(ey, _mm256_set1_ps(n[p][5]), d);
+            d = ia_simd256_fmadd(ez, _mm256_set1_ps(n[p][6]), d);
+            m = _mm256_min_ps(m, d);
+        }
+        u32 mask = (u32)_mm256_movemask_ps(_mm256_cmp_ps(m, _mm256_setzero_ps(), _CMP_GE_OQ));
+        /* every index is stored, only the visible ones advance the count, no branches to mispredict */
+        for (i32 k = 0; k < 8; k++) {
+            indices[visible] = (u32)(i + k);
+            visible += (mask >> k) & 1;
+        }
+    }
+#endif
+#if defined(IA_SIMD_X86)
+    for (; i + 4 <= end; i += 4) {
+        s128f cx = _mm_loadu_ps(&boxes->center_x[i]);
+        s128f cy = _mm_loadu_ps(&boxes->center_y[i]);
+        s128f cz = _mm_loadu_ps(&boxes->center_z[i]);
+        s128f ex = _mm_loadu_ps(&boxes->extent_x[i]);
+        s128f ey = _mm_loadu_ps(&boxes->extent_y[i]);
+        s128f ez = _mm_loadu_ps(&boxes->extent_z[i]);
+        s128f m = ia_simd_set1_rval(INFINITY);
+        for (i32 p = 0; p < ia_frustum_plane_count; p++) {
+            s128f d = ia_simd_fmadd(cx, ia_simd_set1_rval(n[p][0]), ia_simd_set1_rval(n[p][3]));
+            d = ia_simd_fmadd(cy, ia_simd_set1_rval(n[p][1]), d);
+            d = ia_simd_fmadd(cz, ia_simd_set1_rval(n[p][2]), d);
+            d = ia_simd_fmadd(ex, ia_simd_set1_rval(n[p][4]), d);
+            d = ia_simd_fmadd(ey, ia_simd_set1_rval(n[p][5]), d);
+            d = ia_simd_fmadd(ez, ia_simd_set1_rval(n[p][6]), d);
+            m = ia_simd_min(m, d);
+        }
+        u32 mask = (u32)_mm_movemask_ps(_mm_cmpge_ps(m, _mm_setzero_ps()));
+        for (i32 k = 0; k < 4; k++) {
+            indices[visible] = (u32)(i + k);
+            visible += (mask >> k) & 1;
+        }
+    }
+#endif
+    for (; i < end; i++) {
+        f32 m = INFINITY;
+        for (i32 p = 0; p < ia_frustum_plane_count; p++) {
+            f32 d = boxes->center_x[i] * n[p][0] + boxes->center_y[i] * n[p][1] + boxes->center_z[i] * n[p][2] + n[p][3]
+                  + boxes->extent_x[i] * n[p][4] + boxes->extent_y[i] * n[p][5] + boxes->extent_z[i] * n[p][6];
+            m = m < d ? m : d;
+        }
+        indices[visible] = (u32)i;
+        visible += m >= 0.0f;
+    }
+    return visible;
+}
+
+static void f16_encode(
+    isize               count,
+    f32 const          *src,
+    u16                *dest)
+{
+    isize i = 0;
+#if defined(IA_SIMD_X86) && defined(IA_ARCH_X86_F16C)
+    for (; i + 8 <= count; i += 8) {
+        s128i h = _mm256_cvtps_ph(_mm256_loadu_ps(&src[i]), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128((s128i *)&dest[i], h);
+    }
+#elif defined(IA_SIMD_NEON) && defined(IA_ARCH_AARCH64)
+    for (; i + 4 <= count; i += 4)
+        vst1_u16(&dest[i], vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(&src[i]))));
+#endif
+    for (; i < count; i++)
+        dest[i] = ia_f16_from_f32(src[i]);
+}
+
+static void f16_decode(
+    isize               count,
+    u16 const          *src,
+    f32                *dest)
+{
+    isize i = 0;
+#if defined(IA_SIMD_X86) && defined(IA_ARCH_X86_F16C)
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(&dest[i], _mm256_cvtph_ps(_mm_loadu_si128((s128i const *)&src[i])));
+#elif defined(IA_SIMD_NEON) && defined(IA_ARCH_AARCH64)
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(&dest[i], vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(&src[i]))));
+#endif
+    for (; i < count; i++)
+        dest[i] = ia_f16_to_f32(src[i]);
+}
+
+compute_kernels const COMPUTE_KERNELS_TABLE(COMPUTE_KERNELS_VARIANT) = {
+    .frustum_cull = frustum_cull,
+    .quat_nlerp_soa = quat_nlerp_soa,
+    .mat4_transform_points = mat4_transform_points,
+    .affine_transform_points = affine_transform_points,
+#if defined(IA_SIMD_X86) && defined(IA_ARCH_X86_SSE4_1)
+    .sort_network16_u32 = sort_network16_u32,
+#else
+    .sort_network16_u32 = nullptr,
+#endif
+    .f16_encode = f16_encode,
+    .f16_decode = f16_decode,
+};
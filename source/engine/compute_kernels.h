@@ -0,0 +1,58 @@
+#pragma once
+/* Hot compute kernels, built once per instruction set and picked at runtime from `ia_cpufeatures`.
+ * `compute_kernels.c` is the only source, the `compute_kernels_*.c` variants include it under
+ * different compile flags. Portable builds run at the x86-64 baseline, without this the AVX paths
+ * of the kernels would only ever run in builds targeting the host. */
+#include <ia/compute/camera.h>
+#include <ia/compute/matrix.h>
+#include <ia/compute/quaternion.h>
+#include <ia/compute/pack.h>
+#include <ia/base/system.h>
+
+typedef struct compute_kernels {
+    /** Culls boxes [begin..end), indices of visible ones are written from `indices[0]`. */
+    isize (*frustum_cull)(
+        ia_frustum const   *frustum,
+        isize               begin,
+        isize               end,
+        ia_aabb_soa const  *boxes,
+        u32                *indices);
+    /** Normalized lerp of rotations in SoA, `weights` advance by `weight_stride`, zero for a shared weight. */
+    void (*quat_nlerp_soa)(
+        isize               count,
+        ia_quat_soa const  *from,
+        ia_quat_soa const  *to,
+        f32 const          *weights,
+        isize               weight_stride,
+        ia_quat_soa const  *dest);
+    void (*mat4_transform_points)(
+        f32m4x4 const       m,
+        isize               count,
+        f32x3 const        *points,
+        f32x4              *dest);
+    void (*affine_transform_points)(
+        f32m4x3 const       m,
+        isize               count,
+        f32x3 const        *points,
+        f32x3              *dest);
+    /** Sorts 16 aligned keys, null if this instruction set has no sorting network. */
+    void (*sort_network16_u32)(u32 *v);
+    void (*f16_encode)(isize count, f32 const *src, u16 *dest);
+    void (*f16_decode)(isize count, u16 const *src, f32 *dest);
+} compute_kernels;
+
+/* built with the flags of the engine */
+extern compute_kernels const compute_kernels_baseline;
+
+/* the build defines IA_COMPUTE_KERNELS_X86 when the variants below are compiled in */
+#ifdef IA_COMPUTE_KERNELS_X86
+#define COMPUTE_KERNELS_AVX2_FEATURES \
+    (ia_cpu_feature_x86_avx2 | ia_cpu_feature_x86_fma | ia_cpu_feature_x86_f16c | \
+     ia_cpu_feature_x86_bmi | ia_cpu_feature_x86_bmi2 | ia_cpu_feature_x86_lzcnt | ia_cpu_feature_x86_popcnt)
+#define COMPUTE_KERNELS_AVX512_FEATURES \
+    (COMPUTE_KERNELS_AVX2_FEATURES | ia_cpu_feature_x86_avx512f | ia_cpu_feature_x86_avx512cd | \
+     ia_cpu_feature_x86_avx512dq | ia_cpu_feature_x86_avx512bw | ia_cpu_feature_x86_avx512vl)
+
+extern compute_kernels const compute_kernels_avx2;
+extern compute_kernels const compute_kernels_avx512;
+#endif /* IA_COMPUTE_KERNELS_X86 */
@@ -0,0 +1,3 @@
+/* Built with -mavx2 -mfma -mf16c -mbmi -mbmi2 -mlzcnt -mpopcnt, see compute_kernels.h. */
+#define COMPUTE_KERNELS_VARIANT avx2
+#include "compute_kernels.c"
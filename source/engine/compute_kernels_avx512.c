@@ -0,0 +1,3 @@
+/* Built with the AVX2 flags and -mavx512f -mavx512cd -mavx512dq -mavx512bw -mavx512vl, see compute_kernels.h. */
+#define COMPUTE_KERNELS_VARIANT avx512
+#include "compute_kernels.c"
@@ -1,4 +1,19 @@
 #include <ia/datastructures/mpmc.h>
+#include <ia/datastructures/mpmc_segmented.h>
+#include <ia/datastructures/deque.h>
+#include <ia/datastructures/map.h>
+#include <ia/datastructures/switch.h>
+#include <ia/datastructures/strbuf.h>
+#include <ia/datastructures/btree.h>
+#include <ia/datastructures/pool.h>
+#include <ia/datastructures/epoch.h>
+#include <ia/datastructures/sparse.h>
+#include <ia/datastructures/bitset.h>
+#include <ia/datastructures/ecs.h>
+#include <ia/base/memory.h>
+#include <ia/base/work.h>
+
+#include <math.h>
 
 /* sequence values:
  * slot empty => seq == pos
@@ -34,3 +49,2825 @@ bool ia_mpmc_rotate(
     }
     IA_UNREACHABLE;
 }
+
+/* Cells are claimed from the cursor position in order. Cells of a range can't be taken by anyone
+ * else while the cursor is below them, so once the prefix is seen ready it stays ready until the
+ * CAS publishes the claim. A fetch-add can't be used here, it can't be undone when the ring has
+ * fewer ready cells than requested. */
+isize ia_mpmc_rotate_n(
+    ia_mpmc        *mpmc,
+    atomic_isize   *in_or_out,
+    isize const     pos_delta,
+    isize           max_count,
+    isize          *out_pos)
+{
+    isize seq, diff, count, pos = ia_atomic_read_monotonic(in_or_out);
+
+    max_count = ia_min(max_count, mpmc->mask + 1);
+    if (max_count <= 0)
+        return 0;
+
+    for (;;) {
+        diff = 0;
+        for (count = 0; count < max_count; count++) {
+            seq = ia_atomic_read(&mpmc->sequence[(pos + count) & mpmc->mask], ia_atomic_model_acquire);
+            diff = (isize)((iptr)seq - (iptr)(pos + count + pos_delta));
+            if (diff != 0)
+                break;
+        }
+        if (count > 0) {
+            if (IA_LIKELY(ia_atomic_cmpxchg_weak_monotonic(in_or_out, &pos, pos + count))) {
+                *out_pos = pos;
+                return count;
+            }
+        } else if (diff < 0) {
+            /* it's empty (or full, for producers) */
+            return 0;
+        } else {
+            ia_cpu_relax();
+            pos = ia_atomic_read_monotonic(in_or_out);
+        }
+    }
+    IA_UNREACHABLE;
+}
+
+/* Segment memory: the header, sequence buffer, then the data buffer. */
+static ia_mpmc_segment *mpmc_segment_alloc(ia_mpmc_segmented *mpmc)
+{
+    isize header = ia_align(ia_ssizeof(ia_mpmc_segment), IA_CACHELINE_SIZE);
+    isize sequence = ia_align(mpmc->cell_count * ia_ssizeof(atomic_isize), 16);
+    ia_mpmc_segment *seg = (ia_mpmc_segment *)ia_drift_alloc(header + sequence + mpmc->cell_count * mpmc->stride, IA_CACHELINE_SIZE);
+    ia_assert(seg != nullptr, "Out of memory for a segment of %lld cells.", (long long)mpmc->cell_count);
+    seg->ring.sequence = (atomic_isize *)ia_offset_(seg, header);
+    seg->ring.data = ia_offset_(seg, header + sequence);
+    return seg;
+}
+
+/* The segment must not be reachable from the queue or any hazard. */
+static void mpmc_segment_reset(
+    ia_mpmc_segmented  *mpmc,
+    ia_mpmc_segment    *seg)
+{
+#ifdef IA_DEBUG
+    char const *name = mpmc->dbg_name;
+#else
+    char const *name = nullptr;
+#endif
+    ia_mpmc_init_(&seg->ring, mpmc->stride, mpmc->cell_count, seg->ring.data, seg->ring.sequence, name);
+    ia_atomic_write_monotonic(&seg->next, nullptr);
+    seg->free_next = nullptr;
+}
+
+static ia_mpmc_segment *mpmc_segment_acquire(ia_mpmc_segmented *mpmc)
+{
+    ia_spinlock_scoped guard = ia_spinlock_scoped_acquire(&mpmc->lock);
+    ia_mpmc_segment *seg = mpmc->pool;
+    if (seg)
+        mpmc->pool = seg->free_next;
+    ia_spinlock_scoped_release(&guard);
+
+    if (!seg)
+        seg = mpmc_segment_alloc(mpmc);
+    mpmc_segment_reset(mpmc, seg);
+    return seg;
+}
+
+static bool mpmc_segment_is_hazard(
+    ia_mpmc_segmented  *mpmc,
+    ia_mpmc_segment    *seg)
+{
+    for (i32 i = 0; i < mpmc->hazard_count; i++)
+        if (ia_atomic_read(&mpmc->hazards[i].segment, ia_atomic_model_seq_cst) == seg)
+            return true;
+    return false;
+}
+
+/* Retired segments are recycled once no hazard refers to them, the ones still in use are kept
+ * in the retire list and checked again when the next segment is retired. */
+static void mpmc_segment_retire(
+    ia_mpmc_segmented  *mpmc,
+    ia_mpmc_segment    *seg)
+{
+    ia_spinlock_scoped guard = ia_spinlock_scoped_acquire(&mpmc->lock);
+    seg->free_next = mpmc->retired;
+    mpmc->retired = seg;
+
+    ia_mpmc_segment **link = &mpmc->retired;
+    while ((seg = *link) != nullptr) {
+        if (mpmc_segment_is_hazard(mpmc, seg)) {
+            link = &seg->free_next;
+            continue;
+        }
+        *link = seg->free_next;
+        seg->free_next = mpmc->pool;
+        mpmc->pool = seg;
+    }
+    ia_spinlock_scoped_release(&guard);
+}
+
+/* Publishes the segment in the hazard slot, then checks it's still the head or tail. A segment is
+ * retired only after both head and tail moved past it, so a validated hazard keeps it alive. */
+static ia_mpmc_segment *mpmc_segment_protect(
+    ia_mpmc_hazard                 *hazard,
+    IA_ATOMIC(ia_mpmc_segment *)   *src)
+{
+    ia_mpmc_segment *seg = ia_atomic_read(src, ia_atomic_model_acquire);
+    for (;;) {
+        ia_atomic_write(&hazard->segment, seg, ia_atomic_model_seq_cst);
+        ia_mpmc_segment *again = ia_atomic_read(src, ia_atomic_model_seq_cst);
+        if (again == seg)
+            return seg;
+        seg = again;
+    }
+}
+
+static ia_mpmc_hazard *mpmc_hazard(ia_mpmc_segmented *mpmc)
+{
+    i32 index = ia_worker_thread_index();
+    ia_dbg_assert(index >= 0 && index < mpmc->hazard_count, "Worker index %d out of range of hazard slots.", index);
+    return &mpmc->hazards[index];
+}
+
+void ia_mpmc_segmented_init_(
+    ia_mpmc_segmented  *mpmc,
+    isize               stride,
+    isize               cell_count,
+    i32                 thread_count,
+    char const         *type_name)
+{
+    ia_assert(ia_is_pow2(cell_count), "%s: cell count %lld is not a power of 2.", type_name, (long long)cell_count);
+    mpmc->stride = stride;
+    mpmc->cell_count = cell_count;
+    mpmc->lock = (ia_spinlock)ia_spinlock_init;
+    mpmc->retired = nullptr;
+    mpmc->pool = nullptr;
+#ifdef IA_DEBUG
+    mpmc->dbg_name = type_name;
+#endif
+    mpmc->hazard_count = thread_count + 1;
+    mpmc->hazards = ia_drift_alloc_as(ia_mpmc_hazard, mpmc->hazard_count);
+    for (i32 i = 0; i < mpmc->hazard_count; i++)
+        ia_atomic_write_monotonic(&mpmc->hazards[i].segment, nullptr);
+
+    ia_mpmc_segment *seg = mpmc_segment_alloc(mpmc);
+    mpmc_segment_reset(mpmc, seg);
+    ia_atomic_write_monotonic(&mpmc->head, seg);
+    ia_atomic_write(&mpmc->tail, seg, ia_atomic_model_release);
+}
+
+void ia_mpmc_segmented_reserve(
+    ia_mpmc_segmented  *mpmc,
+    i32                 segment_count)
+{
+    for (i32 i = 0; i < segment_count; i++) {
+        ia_mpmc_segment *seg = mpmc_segment_alloc(mpmc);
+        mpmc_segment_reset(mpmc, seg);
+
+        ia_spinlock_scoped guard = ia_spinlock_scoped_acquire(&mpmc->lock);
+        seg->free_next = mpmc->pool;
+        mpmc->pool = seg;
+        ia_spinlock_scoped_release(&guard);
+    }
+}
+
+/* Segments never wrap around. A position past the last cell means the segment is closed,
+ * every producer that sees it tries to link the next segment, only one of them succeeds. */
+void ia_mpmc_segmented_enqueue_(
+    ia_mpmc_segmented  *mpmc,
+    isize               stride,
+    void const         *submit)
+{
+    ia_dbg_assert(stride == mpmc->stride, "Enqueue of %lld byte elements into a queue of %lld byte cells.", (long long)stride, (long long)mpmc->stride);
+    ia_mpmc_hazard *hazard = mpmc_hazard(mpmc);
+
+    for (;;) {
+        ia_mpmc_segment *seg = mpmc_segment_protect(hazard, &mpmc->tail);
+        isize pos = ia_atomic_add_monotonic(&seg->ring.enqueue_pos, 1);
+        if (IA_LIKELY(pos <= seg->ring.mask)) {
+            memcpy(ia_elem_(seg->ring.data, stride, pos), submit, stride);
+            ia_atomic_write(&seg->ring.sequence[pos], pos + 1, ia_atomic_model_release);
+            break;
+        }
+
+        ia_mpmc_segment *next = ia_atomic_read(&seg->next, ia_atomic_model_acquire);
+        if (!next) {
+            /* the first cell is filled before the segment is published */
+            ia_mpmc_segment *fresh = mpmc_segment_acquire(mpmc);
+            memcpy(fresh->ring.data, submit, stride);
+            ia_atomic_write_monotonic(&fresh->ring.sequence[0], 1);
+            ia_atomic_write_monotonic(&fresh->ring.enqueue_pos, 1);
+
+            if (ia_atomic_cmpxchg_strong(&seg->next, &next, fresh, ia_atomic_model_release, ia_atomic_model_acquire)) {
+                ia_atomic_cmpxchg_strong(&mpmc->tail, &seg, fresh, ia_atomic_model_seq_cst, ia_atomic_model_monotonic);
+                break;
+            }
+            /* lost the race, the segment was never visible */
+            mpmc_segment_reset(mpmc, fresh);
+            ia_spinlock_scoped guard = ia_spinlock_scoped_acquire(&mpmc->lock);
+            fresh->free_next = mpmc->pool;
+            mpmc->pool = fresh;
+            ia_spinlock_scoped_release(&guard);
+        }
+        ia_atomic_cmpxchg_strong(&mpmc->tail, &seg, next, ia_atomic_model_seq_cst, ia_atomic_model_monotonic);
+    }
+    ia_atomic_write(&hazard->segment, nullptr, ia_atomic_model_release);
+}
+
+bool ia_mpmc_segmented_dequeue_(
+    ia_mpmc_segmented  *mpmc,
+    isize               stride,
+    void               *target)
+{
+    ia_dbg_assert(stride == mpmc->stride, "Dequeue of %lld byte elements from a queue of %lld byte cells.", (long long)stride, (long long)mpmc->stride);
+    ia_mpmc_hazard *hazard = mpmc_hazard(mpmc);
+    bool success = false;
+
+    for (;;) {
+        ia_mpmc_segment *seg = mpmc_segment_protect(hazard, &mpmc->head);
+        isize pos = ia_atomic_read_monotonic(&seg->ring.dequeue_pos);
+        if (IA_LIKELY(pos <= seg->ring.mask)) {
+            isize seq = ia_atomic_read(&seg->ring.sequence[pos], ia_atomic_model_acquire);
+            if (seq != pos + 1)
+                break; /* it's empty */
+            if (ia_atomic_cmpxchg_weak_monotonic(&seg->ring.dequeue_pos, &pos, pos + 1)) {
+                memcpy(target, ia_elem_(seg->ring.data, stride, pos), stride);
+                success = true;
+                break;
+            }
+            continue;
+        }
+
+        /* the segment is drained */
+        ia_mpmc_segment *next = ia_atomic_read(&seg->next, ia_atomic_model_acquire);
+        if (!next)
+            break;
+        ia_mpmc_segment *expected = seg;
+        ia_atomic_cmpxchg_strong(&mpmc->tail, &expected, next, ia_atomic_model_seq_cst, ia_atomic_model_monotonic);
+        expected = seg;
+        if (ia_atomic_cmpxchg_strong(&mpmc->head, &expected, next, ia_atomic_model_seq_cst, ia_atomic_model_monotonic)) {
+            ia_atomic_write(&hazard->segment, nullptr, ia_atomic_model_release);
+            mpmc_segment_retire(mpmc, seg);
+        }
+    }
+    ia_atomic_write(&hazard->segment, nullptr, ia_atomic_model_release);
+    return success;
+}
+
+/* Moves the items into a new buffer of `cap` items, starting at index 0. */
+static void deque_realloc(
+    ia_deque   *deque,
+    i32         stride,
+    i32         cap)
+{
+    isize size = (isize)stride * cap;
+    void *v = deque->alloc ? deque->alloc(deque->userdata, size, 16) : ia_drift_alloc(size, 16);
+    ia_assert(v != nullptr, "Out of memory for %d items of deque.", cap);
+    if (deque->len > 0) {
+        i32 first = ia_min(deque->len, deque->cap - deque->head);
+        memcpy(v, ia_elem_(deque->v, stride, deque->head), (isize)stride * first);
+        memcpy(ia_elem_(v, stride, first), deque->v, (isize)stride * (deque->len - first));
+    }
+    if (deque->v && deque->free)
+        deque->free(deque->userdata, deque->v, (isize)stride * deque->cap);
+    deque->v = v;
+    deque->cap = cap;
+    deque->head = 0;
+    deque->tail = (deque->len - 1) & (cap - 1);
+}
+
+static void deque_maybe_shrink(
+    ia_deque   *deque,
+    i32         stride)
+{
+    /* drift memory can't be returned, a smaller buffer would only add to it */
+    if (deque->cap <= deque->min || !deque->free)
+        return;
+    switch (deque->shrink) {
+        case ia_deque_shrink_if_empty:
+            if (deque->len == 0)
+                deque_realloc(deque, stride, deque->min);
+            break;
+        case ia_deque_shrink_at_one_fifth:
+            if (deque->len <= deque->cap / 5)
+                deque_realloc(deque, stride, deque->cap >> 1);
+            break;
+        default:
+            break;
+    }
+}
+
+void ia_deque_init_(
+    ia_deque           *deque,
+    i32                 stride,
+    i32                 min_cap,
+    i32                 shrink,
+    ia_deque_alloc_fn   alloc,
+    ia_deque_free_fn    free,
+    void               *userdata,
+    char const         *type_name)
+{
+    ia_san_assert(stride > 0 && min_cap > 0, "%s", type_name);
+    ia_san_assert(!alloc == !free, "%s needs both or none of alloc and free.", type_name);
+    *deque = (ia_deque){
+        .min = (i32)(1u << (32 - ia_clz((u32)min_cap - 1))),
+        .shrink = shrink,
+        .alloc = alloc,
+        .free = free,
+        .userdata = userdata,
+#ifdef IA_DEBUG
+        .dbg_name = type_name,
+#endif
+    };
+    deque_realloc(deque, stride, deque->min);
+}
+
+void ia_deque_fini_(
+    ia_deque   *deque,
+    i32         stride)
+{
+    if (deque->v && deque->free)
+        deque->free(deque->userdata, deque->v, (isize)stride * deque->cap);
+    deque->v = nullptr;
+    deque->cap = deque->len = 0;
+}
+
+void ia_deque_push_(
+    ia_deque   *deque,
+    i32         stride,
+    void const *item)
+{
+    if (IA_UNLIKELY(deque->len == deque->cap))
+        deque_realloc(deque, stride, deque->cap << 1);
+    deque->tail = (deque->tail + 1) & (deque->cap - 1);
+    deque->len++;
+    memcpy(ia_elem_(deque->v, stride, deque->tail), item, stride);
+}
+
+void ia_deque_unshift_(
+    ia_deque   *deque,
+    i32         stride,
+    void const *item)
+{
+    if (IA_UNLIKELY(deque->len == deque->cap))
+        deque_realloc(deque, stride, deque->cap << 1);
+    deque->head = (deque->head - 1) & (deque->cap - 1);
+    deque->len++;
+    memcpy(ia_elem_(deque->v, stride, deque->head), item, stride);
+}
+
+bool ia_deque_pop_(
+    ia_deque   *deque,
+    i32         stride,
+    void       *out)
+{
+    if (deque->len == 0)
+        return false;
+    memcpy(out, ia_elem_(deque->v, stride, deque->tail), stride);
+    deque->tail = (deque->tail - 1) & (deque->cap - 1);
+    deque->len--;
+    deque_maybe_shrink(deque, stride);
+    return true;
+}
+
+bool ia_deque_shift_(
+    ia_deque   *deque,
+    i32         stride,
+    void       *out)
+{
+    if (deque->len == 0)
+        return false;
+    memcpy(out, ia_elem_(deque->v, stride, deque->head), stride);
+    deque->head = (deque->head + 1) & (deque->cap - 1);
+    deque->len--;
+    deque_maybe_shrink(deque, stride);
+    return true;
+}
+
+void ia_deque_clear_(
+    ia_deque   *deque,
+    i32         stride)
+{
+    deque->len = 0;
+    deque->head = 0;
+    deque->tail = deque->cap - 1;
+    if (deque->shrink != ia_deque_no_shrink && deque->cap > deque->min && deque->free)
+        deque_realloc(deque, stride, deque->min);
+}
+
+static ia_deque_ws_buffer *deque_ws_buffer_alloc(isize cap)
+{
+    ia_deque_ws_buffer *buffer = (ia_deque_ws_buffer *)ia_drift_alloc(
+        ia_ssizeof(ia_deque_ws_buffer) + cap * ia_ssizeof(atomic_uptr), ia_salignof(ia_deque_ws_buffer));
+    ia_assert(buffer != nullptr, "Out of memory for %lld items of work-stealing deque.", (long long)cap);
+    buffer->mask = cap - 1;
+    return buffer;
+}
+
+void ia_deque_ws_init(
+    ia_deque_ws    *ws,
+    isize           cap)
+{
+    ia_dbg_assert(ia_is_pow2(cap), "Work-stealing deque capacity %lld is not a power of 2.", (long long)cap);
+    ia_atomic_write_monotonic(&ws->top, 0);
+    ia_atomic_write_monotonic(&ws->bottom, 0);
+    ia_atomic_write(&ws->buffer, deque_ws_buffer_alloc(cap), ia_atomic_model_release);
+}
+
+void ia_deque_ws_push(
+    ia_deque_ws    *ws,
+    void           *item)
+{
+    isize b = ia_atomic_read_monotonic(&ws->bottom);
+    isize t = ia_atomic_read(&ws->top, ia_atomic_model_acquire);
+    ia_deque_ws_buffer *buffer = ia_atomic_read_monotonic(&ws->buffer);
+
+    if (IA_UNLIKELY(b - t > buffer->mask)) {
+        /* the old buffer is not freed, thieves may still read from it */
+        ia_deque_ws_buffer *grown = deque_ws_buffer_alloc((buffer->mask + 1) << 1);
+        for (isize i = t; i < b; i++)
+            ia_atomic_write_monotonic(&grown->cells[i & grown->mask], ia_atomic_read_monotonic(&buffer->cells[i & buffer->mask]));
+        ia_atomic_write(&ws->buffer, grown, ia_atomic_model_release);
+        buffer = grown;
+    }
+    ia_atomic_write_monotonic(&buffer->cells[b & buffer->mask], (uptr)item);
+    ia_atomic_thread_fence(ia_atomic_model_release);
+    ia_atomic_write_monotonic(&ws->bottom, b + 1);
+}
+
+bool ia_deque_ws_pop(
+    ia_deque_ws    *ws,
+    void          **out)
+{
+    isize b = ia_atomic_read_monotonic(&ws->bottom) - 1;
+    ia_deque_ws_buffer *buffer = ia_atomic_read_monotonic(&ws->buffer);
+    ia_atomic_write_monotonic(&ws->bottom, b);
+    ia_atomic_thread_fence(ia_atomic_model_seq_cst);
+    isize t = ia_atomic_read_monotonic(&ws->top);
+
+    if (t > b) {
+        /* it's empty */
+        ia_atomic_write_monotonic(&ws->bottom, b + 1);
+        return false;
+    }
+    void *item = (void *)ia_atomic_read_monotonic(&buffer->cells[b & buffer->mask]);
+    if (t == b) {
+        /* the last item, race against thieves, `out` is untouched if one of them wins */
+        bool won = ia_atomic_cmpxchg_strong(&ws->top, &t, t + 1, ia_atomic_model_seq_cst, ia_atomic_model_monotonic);
+        ia_atomic_write_monotonic(&ws->bottom, b + 1);
+        if (!won)
+            return false;
+    }
+    *out = item;
+    return true;
+}
+
+bool ia_deque_ws_steal(
+    ia_deque_ws    *ws,
+    void          **out)
+{
+    isize t = ia_atomic_read(&ws->top, ia_atomic_model_acquire);
+    ia_atomic_thread_fence(ia_atomic_model_seq_cst);
+    isize b = ia_atomic_read(&ws->bottom, ia_atomic_model_acquire);
+
+    if (t >= b)
+        return false;
+    ia_deque_ws_buffer *buffer = ia_atomic_read(&ws->buffer, ia_atomic_model_acquire);
+    void *item = (void *)ia_atomic_read_monotonic(&buffer->cells[t & buffer->mask]);
+    if (!ia_atomic_cmpxchg_strong(&ws->top, &t, t + 1, ia_atomic_model_seq_cst, ia_atomic_model_monotonic))
+        return false;
+    *out = item;
+    return true;
+}
+
+/* Fibonacci hashing, the upper bits of the product select the bucket. */
+#define IA_MAP_FIBONACCI 11400714819323198485ull
+#define IA_MAP_MIN_BUCKETS 8
+
+static inline ia_bucket *map_bucket(ia_map const *map, ia_map_key key)
+{ return &map->buckets[(key * IA_MAP_FIBONACCI) >> map->bucket_shift]; }
+
+static void map_rehash(
+    ia_map *map,
+    u32     bucket_count)
+{
+    ia_bucket *old = map->buckets;
+    u32 old_count = map->bucket_count;
+
+    map->buckets = ia_drift_alloc_as(ia_bucket, bucket_count);
+    ia_assert(map->buckets != nullptr, "Out of memory for %u map buckets.", bucket_count);
+    memset(map->buckets, 0, sizeof(ia_bucket) * bucket_count);
+    map->bucket_count = bucket_count;
+    map->bucket_shift = 64 - ia_ctz(bucket_count);
+
+    for (u32 i = 0; i < old_count; i++) {
+        ia_bucket_entry *entry = old[i].first;
+        while (entry) {
+            ia_bucket_entry *next = entry->next;
+            ia_bucket *bucket = map_bucket(map, entry->key);
+            entry->next = bucket->first;
+            bucket->first = entry;
+            entry = next;
+        }
+    }
+}
+
+void ia_map_init(ia_map *map)
+{
+    *map = (ia_map){ .buckets = nullptr, .free_entries = nullptr };
+    map_rehash(map, IA_MAP_MIN_BUCKETS);
+}
+
+void ia_map_fini(ia_map *map)
+{
+    /* memory is owned by the drift allocator */
+    *map = (ia_map){ .buckets = nullptr, .free_entries = nullptr };
+}
+
+ia_map_value *ia_map_get(
+    ia_map const   *map,
+    ia_map_key      key)
+{
+    if (IA_UNLIKELY(!map->buckets))
+        return nullptr;
+    for (ia_bucket_entry *entry = map_bucket(map, key)->first; entry; entry = entry->next)
+        if (entry->key == key)
+            return &entry->value;
+    return nullptr;
+}
+
+ia_map_value *ia_map_ensure(
+    ia_map         *map,
+    ia_map_key      key)
+{
+    ia_map_value *value = ia_map_get(map, key);
+    if (value)
+        return value;
+
+    if (IA_UNLIKELY(!map->buckets))
+        map_rehash(map, IA_MAP_MIN_BUCKETS);
+    else if (map->count >= map->bucket_count)
+        map_rehash(map, map->bucket_count << 1);
+
+    ia_bucket_entry *entry = map->free_entries;
+    if (entry) {
+        map->free_entries = entry->next;
+    } else {
+        entry = ia_drift_alloc_as(ia_bucket_entry, 1);
+        ia_assert(entry != nullptr, "Out of memory for a map entry.");
+    }
+    ia_bucket *bucket = map_bucket(map, key);
+    entry->key = key;
+    entry->value = 0;
+    entry->next = bucket->first;
+    bucket->first = entry;
+    map->count++;
+    return &entry->value;
+}
+
+bool ia_map_remove(
+    ia_map         *map,
+    ia_map_key      key)
+{
+    if (IA_UNLIKELY(!map->buckets))
+        return false;
+    for (ia_bucket_entry **link = &map_bucket(map, key)->first; *link; link = &(*link)->next) {
+        ia_bucket_entry *entry = *link;
+        if (entry->key != key)
+            continue;
+        *link = entry->next;
+        entry->next = map->free_entries;
+        map->free_entries = entry;
+        map->count--;
+        return true;
+    }
+    return false;
+}
+
+bool ia_map_next(ia_map_iter *iter)
+{
+    ia_map const *map = iter->map;
+    ia_bucket_entry *entry = iter->entry ? iter->entry->next : nullptr;
+    ia_bucket *bucket = iter->bucket;
+
+    while (!entry) {
+        bucket = bucket ? bucket + 1 : map->buckets;
+        if (!bucket || bucket >= map->buckets + map->bucket_count)
+            return false;
+        entry = bucket->first;
+    }
+    iter->bucket = bucket;
+    iter->entry = entry;
+    iter->res = &entry->key;
+    return true;
+}
+
+static ia_switch_page *switch_page_ensure(
+    ia_switch  *sw,
+    u32         element)
+{
+    i32 page = (i32)(element >> IA_SWITCH_PAGE_BITS);
+    if (page >= sw->pages.len) {
+        ia_darray_reserve(ia_switch_page, &sw->pages, page + 1, ia_drift_allocator);
+        memset(&ia_darray_as(ia_switch_page, &sw->pages)[sw->pages.len], 0, sizeof(ia_switch_page) * (page + 1 - sw->pages.len));
+        sw->pages.len = page + 1;
+    }
+    ia_switch_page *p = &ia_darray_as(ia_switch_page, &sw->pages)[page];
+    if (!p->nodes.v) {
+        ia_darray_resize(ia_switch_node, &p->nodes, IA_SWITCH_PAGE_SIZE, ia_drift_allocator);
+        ia_darray_resize(u64, &p->values, IA_SWITCH_PAGE_SIZE, ia_drift_allocator);
+        memset(p->nodes.v, 0, sizeof(ia_switch_node) * IA_SWITCH_PAGE_SIZE);
+        memset(p->values.v, 0, sizeof(u64) * IA_SWITCH_PAGE_SIZE);
+        p->nodes.len = p->values.len = IA_SWITCH_PAGE_SIZE;
+    }
+    return p;
+}
+
+void ia_switch_init(ia_switch *sw)
+{
+    ia_map_init(&sw->hdrs);
+    sw->pages = ia_darray_init;
+}
+
+void ia_switch_fini(ia_switch *sw)
+{
+    /* memory is owned by the drift allocator */
+    ia_map_fini(&sw->hdrs);
+    sw->pages = ia_darray_init;
+}
+
+/* List headers are packed into the map value: first element in the low bits, count in the high bits. */
+void ia_switch_set(
+    ia_switch  *sw,
+    u32         element,
+    u64         value)
+{
+    ia_dbg_assert(element != 0, "Element 0 is reserved as the end of a switch list.");
+    ia_switch_page *page = switch_page_ensure(sw, element);
+    u32 slot = element & IA_SWITCH_PAGE_MASK;
+    u64 *values = ia_darray_as(u64, &page->values);
+    ia_switch_node *node = &ia_darray_as(ia_switch_node, &page->nodes)[slot];
+
+    u64 old = values[slot];
+    if (old == value)
+        return;
+
+    if (old != 0) {
+        /* unlink from the old list */
+        ia_map_value *hdr = ia_map_get(&sw->hdrs, old);
+        ia_dbg_assert(hdr != nullptr, "Switch list of element %u has no header.", element);
+        if (node->prev)
+            ia_switch_node_of(sw, node->prev)->next = node->next;
+        else
+            *hdr = (*hdr & ~0xffffffffull) | node->next;
+        if (node->next)
+            ia_switch_node_of(sw, node->next)->prev = node->prev;
+        *hdr -= 1ull << 32;
+        if ((*hdr >> 32) == 0)
+            ia_map_remove(&sw->hdrs, old);
+    }
+
+    values[slot] = value;
+    node->prev = 0;
+    node->next = 0;
+    if (value == 0)
+        return;
+
+    /* link as the first element of the new list */
+    ia_map_value *hdr = ia_map_ensure(&sw->hdrs, value);
+    u32 first = (u32)*hdr;
+    if (first) {
+        ia_switch_node_of(sw, first)->prev = element;
+        node->next = first;
+    }
+    *hdr = ((*hdr >> 32) + 1) << 32 | element;
+}
+
+void ia_strbuf_reserve(
+    ia_strbuf  *buf,
+    i32         n)
+{
+    i32 need = buf->len + n + 1;
+    if (need <= buf->alloc)
+        return;
+    /* the old memory may be owned by the caller, it's never freed */
+    i32 alloc = ia_max(need, ia_max(buf->alloc * 2, 64));
+    char *v = (char *)ia_drift_alloc(alloc, 1);
+    ia_assert(v != nullptr, "Out of memory for a string of %d bytes.", alloc);
+    if (buf->len > 0)
+        memcpy(v, buf->v, buf->len);
+    v[buf->len] = '\0';
+    buf->v = v;
+    buf->alloc = alloc;
+}
+
+void ia_strbuf_append(
+    ia_strbuf  *buf,
+    void const *data,
+    i32         n)
+{
+    if (n <= 0)
+        return;
+    ia_strbuf_reserve(buf, n);
+    memcpy(buf->v + buf->len, data, n);
+    buf->len += n;
+    buf->v[buf->len] = '\0';
+}
+
+void ia_strbuf_appendstrn(
+    ia_strbuf  *buf, 
+    char const *str, 
+    i32         n)
+{
+    if (!buf || !str || n <= 0)
+        return;
+    ia_strbuf_append(buf, str, (i32)strnlen(str, n));
+}
+
+static char const g_fmt_digits2[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+static u64 const g_fmt_pow10_u64[18] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+    1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+    100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+};
+
+/* 10^(2^k) */
+static f64 const g_fmt_pow10_bin[9] = { 1e1, 1e2, 1e4, 1e8, 1e16, 1e32, 1e64, 1e128, 1e256 };
+
+#define IA_FMT_MAX_PRECISION 17
+
+i32 ia_fmt_u64(
+    char       *dst,
+    u64         v)
+{
+    char tmp[20];
+    i32 i = 20;
+    while (v >= 100) {
+        u32 r = (u32)(v % 100);
+        v /= 100;
+        i -= 2;
+        memcpy(&tmp[i], &g_fmt_digits2[r * 2], 2);
+    }
+    if (v >= 10) {
+        i -= 2;
+        memcpy(&tmp[i], &g_fmt_digits2[v * 2], 2);
+    } else {
+        tmp[--i] = (char)('0' + v);
+    }
+    memcpy(dst, &tmp[i], 20 - i);
+    return 20 - i;
+}
+
+i32 ia_fmt_i64(
+    char       *dst,
+    i64         v)
+{
+    if (v >= 0)
+        return ia_fmt_u64(dst, (u64)v);
+    dst[0] = '-';
+    return 1 + ia_fmt_u64(dst + 1, 0 - (u64)v);
+}
+
+i32 ia_fmt_hex64(
+    char       *dst,
+    u64         v,
+    bool        uppercase)
+{
+    char const *alphabet = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+    i32 n = v ? (64 - ia_clz64(v) + 3) >> 2 : 1;
+    for (i32 i = n - 1; i >= 0; i--, v >>= 4)
+        dst[i] = alphabet[v & 15];
+    return n;
+}
+
+/* Fixed notation of 0 <= v < 1.8e19, ties of the fraction are rounded to even. */
+static i32 fmt_fixed(
+    char       *dst,
+    f64         v,
+    i32         precision)
+{
+    ia_dbg_assert(precision >= 0 && precision <= IA_FMT_MAX_PRECISION, "Fixed precision %d out of range.", precision);
+    u64 ip = (u64)v;
+    u64 scale = g_fmt_pow10_u64[precision];
+    f64 scaled = (v - (f64)ip) * (f64)scale;
+    u64 fp = (u64)scaled;
+    f64 rem = scaled - (f64)fp;
+    if (rem > 0.5 || (rem == 0.5 && (precision ? fp : ip) & 1))
+        fp++;
+    if (fp >= scale) {
+        ip++;
+        fp -= scale;
+    }
+    i32 n = ia_fmt_u64(dst, ip);
+    if (precision > 0) {
+        char tmp[20];
+        i32 d = ia_fmt_u64(tmp, fp);
+        dst[n++] = '.';
+        memset(dst + n, '0', precision - d);
+        n += precision - d;
+        memcpy(dst + n, tmp, d);
+        n += d;
+    }
+    return n;
+}
+
+/* Exponent notation of v >= 0, writes the decimal exponent of the rounded mantissa. */
+static i32 fmt_exponent(
+    char       *dst,
+    f64         v,
+    i32         precision,
+    bool        uppercase,
+    i32        *out_exp)
+{
+    i32 e = 0;
+    if (v >= 10.0) {
+        for (i32 k = 8; k >= 0; k--) {
+            if (v >= g_fmt_pow10_bin[k]) {
+                v /= g_fmt_pow10_bin[k];
+                e += 1 << k;
+            }
+        }
+    } else if (v > 0.0 && v < 1.0) {
+        for (i32 k = 8; k >= 0; k--) {
+            if (v * g_fmt_pow10_bin[k] < 10.0) {
+                v *= g_fmt_pow10_bin[k];
+                e -= 1 << k;
+            }
+        }
+        if (v < 1.0) {
+            v *= 10.0;
+            e--;
+        }
+    }
+
+    i32 n = fmt_fixed(dst, v, precision);
+    if (n - (precision ? precision + 1 : 0) > 1) {
+        /* the mantissa was rounded up to 10 */
+        e++;
+        n = 0;
+        dst[n++] = '1';
+        if (precision > 0) {
+            dst[n++] = '.';
+            memset(dst + n, '0', precision);
+            n += precision;
+        }
+    }
+    dst[n++] = uppercase ? 'E' : 'e';
+    dst[n++] = e < 0 ? '-' : '+';
+    u32 mag = e < 0 ? (u32)-e : (u32)e;
+    if (mag < 10)
+        dst[n++] = '0';
+    n += ia_fmt_u64(dst + n, mag);
+    *out_exp = e;
+    return n;
+}
+
+/* Removes trailing zeroes of the fraction, and the point if nothing is left after it. */
+static i32 fmt_strip_zeroes(
+    char       *dst,
+    i32         n)
+{
+    if (!memchr(dst, '.', n))
+        return n;
+    char *e = (char *)memchr(dst, 'e', n);
+    if (!e)
+        e = (char *)memchr(dst, 'E', n);
+    i32 end = e ? (i32)(e - dst) : n;
+    i32 cut = end;
+    while (dst[cut - 1] == '0')
+        cut--;
+    if (dst[cut - 1] == '.')
+        cut--;
+    memmove(dst + cut, dst + end, n - end);
+    return n - (end - cut);
+}
+
+/* Formats the magnitude of a floating point number for a printf conversion. */
+static i32 fmt_float(
+    char       *dst,
+    f64         v,
+    i32         precision,
+    char        conv,
+    bool        alt,
+    bool       *out_finite)
+{
+    bool uppercase = conv == 'F' || conv == 'E' || conv == 'G';
+    *out_finite = true;
+    if (v != v || v - v != 0.0) {
+        *out_finite = false;
+        memcpy(dst, v != v ? (uppercase ? "NAN" : "nan") : (uppercase ? "INF" : "inf"), 3);
+        return 3;
+    }
+    if (precision < 0)
+        precision = 6;
+    precision = ia_min(precision, IA_FMT_MAX_PRECISION);
+
+    i32 e, n;
+    switch (conv) {
+        case 'f': case 'F':
+            if (v < 1e16)
+                return fmt_fixed(dst, v, precision);
+            return fmt_exponent(dst, v, precision, uppercase, &e);
+        case 'e': case 'E':
+            return fmt_exponent(dst, v, precision, uppercase, &e);
+        default:
+            if (precision == 0)
+                precision = 1;
+            n = fmt_exponent(dst, v, precision - 1, uppercase, &e);
+            /* below 1 this asks for up to 4 digits after the point more than the table holds */
+            if (e < precision && e >= -4)
+                n = fmt_fixed(dst, v, ia_min(precision - 1 - e, IA_FMT_MAX_PRECISION));
+            return alt ? n : fmt_strip_zeroes(dst, n);
+    }
+}
+
+i32 ia_fmt_f64(
+    char       *dst,
+    f64         v,
+    i32         precision)
+{
+    i32 n = 0;
+    bool finite;
+    if (signbit(v))
+        dst[n++] = '-';
+    return n + fmt_float(dst + n, fabs(v), ia_clamp(precision, 0, IA_FMT_MAX_PRECISION), 'f', false, &finite);
+}
+
+typedef void (*fmt_emit_fn)(void *sink, char const *str, isize n);
+
+static void fmt_pad(
+    fmt_emit_fn emit,
+    void       *sink,
+    char        c,
+    isize       n)
+{
+    static char const spaces[16] = "                ";
+    static char const zeroes[16] = "0000000000000000";
+    while (n > 0) {
+        isize k = ia_min(n, 16);
+        emit(sink, c == '0' ? zeroes : spaces, k);
+        n -= k;
+    }
+}
+
+/* Parses the printf syntax: %[flags][width][.precision][length]conversion. */
+static isize fmt_format(
+    fmt_emit_fn emit,
+    void       *sink,
+    char const *fmt,
+    va_list     args)
+{
+    isize total = 0;
+    for (;;) {
+        char const *start = fmt;
+        while (*fmt && *fmt != '%')
+            fmt++;
+        if (fmt > start) {
+            emit(sink, start, fmt - start);
+            total += fmt - start;
+        }
+        if (!*fmt)
+            break;
+        fmt++;
+
+        bool left = false, plus = false, space = false, zero = false, alt = false;
+        for (;; fmt++) {
+            if (*fmt == '-') left = true;
+            else if (*fmt == '+') plus = true;
+            else if (*fmt == ' ') space = true;
+            else if (*fmt == '0') zero = true;
+            else if (*fmt == '#') alt = true;
+            else break;
+        }
+
+        i32 width = 0, precision = -1;
+        if (*fmt == '*') {
+            width = va_arg(args, int);
+            if (width < 0) {
+                left = true;
+                width = -width;
+            }
+            fmt++;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9')
+                width = width * 10 + (*fmt++ - '0');
+        }
+        if (*fmt == '.') {
+            fmt++;
+            precision = 0;
+            if (*fmt == '*') {
+                precision = va_arg(args, int);
+                if (precision < 0)
+                    precision = -1;
+                fmt++;
+            } else {
+                while (*fmt >= '0' && *fmt <= '9')
+                    precision = precision * 10 + (*fmt++ - '0');
+            }
+        }
+
+        /* 0 for int, 1 for long, 2 for long long, -1 for short, -2 for char, 3 for long double,
+         * 4 for size_t, 5 for intmax_t, 6 for ptrdiff_t, these differ from long long on 32-bit targets */
+        i32 length = 0;
+        switch (*fmt) {
+            case 'h': fmt++; length = -1; if (*fmt == 'h') { fmt++; length = -2; } break;
+            case 'l': fmt++; length = 1; if (*fmt == 'l') { fmt++; length = 2; } break;
+            case 'L': fmt++; length = 3; break;
+            case 'z': fmt++; length = 4; break;
+            case 'j': fmt++; length = 5; break;
+            case 't': fmt++; length = 6; break;
+            default: break;
+        }
+
+        char buf[IA_FMT_MAX + 32];
+        char const *body = buf;
+        isize body_len = 0;
+        char prefix[2];
+        i32 prefix_len = 0;
+        bool numeric = true, integer = false, is_zero = false, octal_alt = false;
+
+        char conv = *fmt;
+        if (conv)
+            fmt++;
+        switch (conv) {
+            case 'd': case 'i': {
+                i64 v;
+                switch (length) {
+                    case 1: v = va_arg(args, long); break;
+                    case 2: case 3: v = va_arg(args, long long); break;
+                    case 4: case 6: v = va_arg(args, ptrdiff_t); break;
+                    case 5: v = va_arg(args, intmax_t); break;
+                    default: v = va_arg(args, int); break;
+                }
+                if (length == -1) v = (short)v;
+                else if (length == -2) v = (signed char)v;
+                if (v < 0) prefix[prefix_len++] = '-';
+                else if (plus) prefix[prefix_len++] = '+';
+                else if (space) prefix[prefix_len++] = ' ';
+                body_len = ia_fmt_u64(buf, v < 0 ? 0 - (u64)v : (u64)v);
+                integer = true;
+                is_zero = v == 0;
+                break;
+            }
+            case 'u': case 'x': case 'X': case 'o': {
+                u64 v;
+                switch (length) {
+                    case 1: v = va_arg(args, unsigned long); break;
+                    case 2: case 3: v = va_arg(args, unsigned long long); break;
+                    case 4: case 6: v = va_arg(args, size_t); break;
+                    case 5: v = va_arg(args, uintmax_t); break;
+                    default: v = va_arg(args, unsigned); break;
+                }
+                if (length == -1) v = (unsigned short)v;
+                else if (length == -2) v = (unsigned char)v;
+                if (conv == 'u') {
+                    body_len = ia_fmt_u64(buf, v);
+                } else if (conv == 'o') {
+                    i32 n = v ? (64 - ia_clz64(v) + 2) / 3 : 1;
+                    for (i32 i = n - 1; i >= 0; i--, v >>= 3)
+                        buf[i] = (char)('0' + (v & 7));
+                    body_len = n;
+                    octal_alt = alt;
+                } else {
+                    if (alt && v) {
+                        prefix[prefix_len++] = '0';
+                        prefix[prefix_len++] = conv;
+                    }
+                    body_len = ia_fmt_hex64(buf, v, conv == 'X');
+                }
+                integer = true;
+                is_zero = v == 0;
+                break;
+            }
+            case 'p':
+                prefix[prefix_len++] = '0';
+                prefix[prefix_len++] = 'x';
+                body_len = ia_fmt_hex64(buf, (uptr)va_arg(args, void *), false);
+                break;
+            case 'c':
+                buf[0] = (char)va_arg(args, int);
+                body_len = 1;
+                numeric = false;
+                break;
+            case 's':
+                body = va_arg(args, char const *);
+                if (!body)
+                    body = "(null)";
+                body_len = precision >= 0 ? (isize)strnlen(body, precision) : (isize)strlen(body);
+                numeric = false;
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+                f64 v = length == 3 ? (f64)va_arg(args, long double) : va_arg(args, double);
+                if (signbit(v)) prefix[prefix_len++] = '-';
+                else if (plus) prefix[prefix_len++] = '+';
+                else if (space) prefix[prefix_len++] = ' ';
+                body_len = fmt_float(buf, fabs(v), precision, conv, alt, &numeric);
+                break;
+            }
+            case '%':
+                buf[0] = '%';
+                body_len = 1;
+                numeric = false;
+                break;
+            default:
+                /* unknown conversions are written as they are */
+                buf[0] = '%';
+                buf[1] = conv;
+                body_len = conv ? 2 : 1;
+                numeric = false;
+                break;
+        }
+
+        isize lead = 0;
+        if (integer && precision >= 0) {
+            zero = false;
+            if (precision == 0 && is_zero)
+                body_len = 0;
+            lead = ia_max(0, precision - body_len);
+        }
+        /* the alternate octal form only makes sure the digits start with 0, precision may do it */
+        if (octal_alt && lead == 0 && (body_len == 0 || body[0] != '0'))
+            prefix[prefix_len++] = '0';
+        isize pad = ia_max(0, width - (prefix_len + lead + body_len));
+        bool zero_pad = zero && numeric && !left;
+
+        if (!left && !zero_pad)
+            fmt_pad(emit, sink, ' ', pad);
+        if (prefix_len)
+            emit(sink, prefix, prefix_len);
+        if (zero_pad)
+            fmt_pad(emit, sink, '0', pad);
+        fmt_pad(emit, sink, '0', lead);
+        if (body_len)
+            emit(sink, body, body_len);
+        if (left)
+            fmt_pad(emit, sink, ' ', pad);
+        total += pad + prefix_len + lead + body_len;
+    }
+    return total;
+}
+
+static void fmt_emit_strbuf(void *sink, char const *str, isize n)
+{ ia_strbuf_append((ia_strbuf *)sink, str, (i32)n); }
+
+static void fmt_emit_rope(void *sink, char const *str, isize n)
+{ ia_strbuf_rope_append((ia_strbuf_rope *)sink, str, n); }
+
+i32 ia_strbuf_appendv(
+    ia_strbuf  *buf,
+    char const *fmt,
+    va_list     args)
+{
+    if (buf->alloc == 0)
+        ia_strbuf_reserve(buf, 0);
+    return (i32)fmt_format(fmt_emit_strbuf, buf, fmt, args);
+}
+
+i32 ia_strbuf_appendf(
+    ia_strbuf  *buf,
+    char const *fmt,
+    ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    i32 n = ia_strbuf_appendv(buf, fmt, args);
+    va_end(args);
+    return n;
+}
+
+void ia_strbuf_rope_init(
+    ia_strbuf_rope     *rope,
+    i32                 chunk_size,
+    ia_strbuf_alloc_fn  alloc,
+    void               *userdata)
+{
+    *rope = (ia_strbuf_rope){
+        .head = nullptr,
+        .tail = nullptr,
+        .len = 0,
+        .chunk_size = ia_max(chunk_size, 64),
+        .alloc = alloc,
+        .userdata = userdata,
+    };
+}
+
+bool ia_strbuf_rope_append(
+    ia_strbuf_rope *rope,
+    void const     *data,
+    isize           n)
+{
+    u8 const *src = (u8 const *)data;
+    while (n > 0) {
+        ia_strbuf_chunk *tail = rope->tail;
+        if (!tail || tail->len == tail->alloc) {
+            i32 size = (i32)ia_max((isize)rope->chunk_size, ia_min(n, (isize)1 << 30));
+            isize bytes = ia_ssizeof(ia_strbuf_chunk) + size;
+            ia_strbuf_chunk *chunk = (ia_strbuf_chunk *)(rope->alloc
+                ? rope->alloc(rope->userdata, bytes, ia_salignof(ia_strbuf_chunk))
+                : ia_drift_alloc(bytes, ia_salignof(ia_strbuf_chunk)));
+            if (!chunk)
+                return false;
+            chunk->next = nullptr;
+            chunk->len = 0;
+            chunk->alloc = size;
+            if (tail)
+                tail->next = chunk;
+            else
+                rope->head = chunk;
+            rope->tail = tail = chunk;
+        }
+        isize k = ia_min(n, (isize)(tail->alloc - tail->len));
+        memcpy(tail->v + tail->len, src, k);
+        tail->len += (i32)k;
+        rope->len += k;
+        src += k;
+        n -= k;
+    }
+    return true;
+}
+
+i32 ia_strbuf_rope_appendv(
+    ia_strbuf_rope *rope,
+    char const     *fmt,
+    va_list         args)
+{ return (i32)fmt_format(fmt_emit_rope, rope, fmt, args); }
+
+i32 ia_strbuf_rope_appendf(
+    ia_strbuf_rope *rope,
+    char const     *fmt,
+    ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    i32 n = ia_strbuf_rope_appendv(rope, fmt, args);
+    va_end(args);
+    return n;
+}
+
+void ia_strbuf_rope_flatten(
+    ia_strbuf_rope const   *rope,
+    ia_strbuf              *out)
+{
+    ia_strbuf_reserve(out, (i32)rope->len);
+    for (ia_strbuf_chunk const *chunk = rope->head; chunk; chunk = chunk->next)
+        ia_strbuf_append(out, chunk->v, chunk->len);
+}
+
+/* Bitmasks with one bit per key of a node, for keys below or not above the given key. */
+#if defined(IA_ARCH_X86_AVX2)
+static inline u32 btree_mask_less(u64 const *keys, u64 key)
+{
+    /* there is no unsigned 64-bit compare, flipping the sign bits makes the signed one work */
+    __m256i bias = _mm256_set1_epi64x((i64)0x8000000000000000ull);
+    __m256i k = _mm256_xor_si256(_mm256_set1_epi64x((i64)key), bias);
+    u32 mask = 0;
+    for (i32 i = 0; i < IA_BTREE_FANOUT; i += 4) {
+        __m256i v = _mm256_xor_si256(_mm256_load_si256((__m256i const *)&keys[i]), bias);
+        mask |= (u32)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v))) << i;
+    }
+    return mask;
+}
+
+static inline u32 btree_mask_less_equal(u64 const *keys, u64 key)
+{
+    __m256i bias = _mm256_set1_epi64x((i64)0x8000000000000000ull);
+    __m256i k = _mm256_xor_si256(_mm256_set1_epi64x((i64)key), bias);
+    u32 mask = 0;
+    for (i32 i = 0; i < IA_BTREE_FANOUT; i += 4) {
+        __m256i v = _mm256_xor_si256(_mm256_load_si256((__m256i const *)&keys[i]), bias);
+        mask |= (u32)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, k))) << i;
+    }
+    return ~mask & ((1u << IA_BTREE_FANOUT) - 1);
+}
+#elif defined(IA_ARCH_ARM_NEON) && defined(IA_ARCH_AARCH64)
+static inline u32 btree_mask_less(u64 const *keys, u64 key)
+{
+    uint64x2_t k = vdupq_n_u64(key);
+    u32 mask = 0;
+    for (i32 i = 0; i < IA_BTREE_FANOUT; i += 2) {
+        uint64x2_t c = vcltq_u64(vld1q_u64(&keys[i]), k);
+        mask |= (u32)((vgetq_lane_u64(c, 0) & 1) | ((vgetq_lane_u64(c, 1) & 1) << 1)) << i;
+    }
+    return mask;
+}
+
+static inline u32 btree_mask_less_equal(u64 const *keys, u64 key)
+{
+    uint64x2_t k = vdupq_n_u64(key);
+    u32 mask = 0;
+    for (i32 i = 0; i < IA_BTREE_FANOUT; i += 2) {
+        uint64x2_t c = vcleq_u64(vld1q_u64(&keys[i]), k);
+        mask |= (u32)((vgetq_lane_u64(c, 0) & 1) | ((vgetq_lane_u64(c, 1) & 1) << 1)) << i;
+    }
+    return mask;
+}
+#else
+static inline u32 btree_mask_less(u64 const *keys, u64 key)
+{
+    u32 mask = 0;
+    for (i32 i = 0; i < IA_BTREE_FANOUT; i++)
+        mask |= (u32)(keys[i] < key) << i;
+    return mask;
+}
+
+static inline u32 btree_mask_less_equal(u64 const *keys, u64 key)
+{
+    u32 mask = 0;
+    for (i32 i = 0; i < IA_BTREE_FANOUT; i++)
+        mask |= (u32)(keys[i] <= key) << i;
+    return mask;
+}
+#endif
+
+/* Position of the first key not below the given key, within a leaf. */
+static inline i32 btree_leaf_lower_bound(ia_btree_node const *node, u64 key)
+{ return ia_popcnt(btree_mask_less(node->keys, key) & ((1u << node->count) - 1)); }
+
+/* Index of the child that may contain the key, `keys[0]` takes no part in it. */
+static inline i32 btree_inner_child(ia_btree_node const *node, u64 key)
+{ return ia_popcnt(btree_mask_less_equal(node->keys, key) & ((1u << node->count) - 2)); }
+
+static ia_btree_node *btree_node_alloc(
+    ia_btree   *tree,
+    i32         height)
+{
+    ia_spinlock_scoped guard = ia_spinlock_scoped_acquire(&tree->lock);
+    ia_btree_node *node = tree->free_nodes;
+    if (node)
+        tree->free_nodes = node->children[0];
+    ia_spinlock_scoped_release(&guard);
+
+    if (!node) {
+        node = (ia_btree_node *)ia_drift_alloc(ia_ssizeof(ia_btree_node), IA_CACHELINE_SIZE);
+        ia_assert(node != nullptr, "Out of memory for a B-tree node.");
+    }
+    ia_atomic_write_monotonic(&node->refs, 1);
+    node->count = 0;
+    node->height = height;
+    return node;
+}
+
+static void btree_node_retain(ia_btree_node *node)
+{ ia_atomic_add_monotonic(&node->refs, 1); }
+
+/* Drops a reference, the last one releases the children and moves the node to the free list. */
+static void btree_node_release(
+    ia_btree       *tree,
+    ia_btree_node  *node)
+{
+    if (ia_atomic_sub(&node->refs, 1, ia_atomic_model_acq_rel) != 1)
+        return;
+    if (node->height > 0)
+        for (i32 i = 0; i < node->count; i++)
+            btree_node_release(tree, node->children[i]);
+
+    ia_spinlock_scoped guard = ia_spinlock_scoped_acquire(&tree->lock);
+    node->children[0] = tree->free_nodes;
+    tree->free_nodes = node;
+    ia_spinlock_scoped_release(&guard);
+}
+
+/* Moves `n` entries (keys with values or children) within or between nodes of the same height. */
+static void btree_move(
+    ia_btree_node          *dst,
+    i32                     dst_at,
+    ia_btree_node const    *src,
+    i32                     src_at,
+    i32                     n)
+{
+    memmove(&dst->keys[dst_at], &src->keys[src_at], sizeof(u64) * n);
+    if (src->height > 0)
+        memmove(&dst->children[dst_at], &src->children[src_at], sizeof(ia_btree_node *) * n);
+    else
+        memmove(&dst->values[dst_at], &src->values[src_at], sizeof(u64) * n);
+}
+
+/* Returns a node exclusively owned by the caller's reference, a shared node is copied. */
+static ia_btree_node *btree_node_unshare(
+    ia_btree       *tree,
+    ia_btree_node  *node)
+{
+    if (ia_atomic_read(&node->refs, ia_atomic_model_acquire) == 1)
+        return node;
+    ia_btree_node *copy = btree_node_alloc(tree, node->height);
+    btree_move(copy, 0, node, 0, node->count);
+    copy->count = node->count;
+    if (node->height > 0)
+        for (i32 i = 0; i < node->count; i++)
+            btree_node_retain(node->children[i]);
+    btree_node_release(tree, node);
+    return copy;
+}
+
+/* Inserts an entry into an owned node at position `pos`. A full node is split in half,
+ * the new right node is returned, its first key is the separator for the parent. */
+static ia_btree_node *btree_node_insert_at(
+    ia_btree       *tree,
+    ia_btree_node  *node,
+    i32             pos,
+    u64             key,
+    u64             value,
+    ia_btree_node  *child)
+{
+    ia_btree_node *right = nullptr;
+    if (node->count == IA_BTREE_FANOUT) {
+        i32 half = IA_BTREE_FANOUT / 2;
+        right = btree_node_alloc(tree, node->height);
+        btree_move(right, 0, node, half, IA_BTREE_FANOUT - half);
+        right->count = IA_BTREE_FANOUT - half;
+        node->count = half;
+        if (pos > half) {
+            node = right;
+            pos -= half;
+        }
+    }
+    btree_move(node, pos + 1, node, pos, node->count - pos);
+    node->keys[pos] = key;
+    if (node->height > 0)
+        node->children[pos] = child;
+    else
+        node->values[pos] = value;
+    node->count++;
+    return right;
+}
+
+static void btree_node_remove_at(
+    ia_btree_node  *node,
+    i32             pos)
+{
+    btree_move(node, pos, node, pos + 1, node->count - pos - 1);
+    node->count--;
+}
+
+static ia_btree_node *btree_insert_rec(
+    ia_btree       *tree,
+    ia_btree_node  *node,
+    u64             key,
+    u64             value,
+    bool           *inserted)
+{
+    if (node->height == 0) {
+        i32 pos = btree_leaf_lower_bound(node, key);
+        if (pos < node->count && node->keys[pos] == key) {
+            node->values[pos] = value;
+            *inserted = false;
+            return nullptr;
+        }
+        *inserted = true;
+        return btree_node_insert_at(tree, node, pos, key, value, nullptr);
+    }
+
+    i32 idx = btree_inner_child(node, key);
+    ia_btree_node *child = btree_node_unshare(tree, node->children[idx]);
+    node->children[idx] = child;
+    ia_btree_node *split = btree_insert_rec(tree, child, key, value, inserted);
+    if (!split)
+        return nullptr;
+    return btree_node_insert_at(tree, node, idx + 1, split->keys[0], 0, split);
+}
+
+static bool btree_remove_rec(
+    ia_btree       *tree,
+    ia_btree_node  *node,
+    u64             key,
+    u64            *out_value)
+{
+    if (node->height == 0) {
+        i32 pos = btree_leaf_lower_bound(node, key);
+        if (pos >= node->count || node->keys[pos] != key)
+            return false;
+        if (out_value)
+            *out_value = node->values[pos];
+        btree_node_remove_at(node, pos);
+        return true;
+    }
+
+    i32 idx = btree_inner_child(node, key);
+    ia_btree_node *child = btree_node_unshare(tree, node->children[idx]);
+    node->children[idx] = child;
+    if (!btree_remove_rec(tree, child, key, out_value))
+        return false;
+
+    if (child->count == 0) {
+        btree_node_release(tree, child);
+        btree_node_remove_at(node, idx);
+    } else if (child->count < IA_BTREE_FANOUT / 2 && node->count > 1) {
+        /* merge with a sibling if both fit into one node */
+        i32 l = idx > 0 ? idx - 1 : idx, r = l + 1;
+        ia_btree_node *right = node->children[r];
+        if (node->children[l]->count + right->count <= IA_BTREE_FANOUT) {
+            ia_btree_node *left = btree_node_unshare(tree, node->children[l]);
+            node->children[l] = left;
+            i32 base = left->count;
+            btree_move(left, base, right, 0, right->count);
+            left->count += right->count;
+            if (left->height > 0) {
+                /* the separator in the parent is the lower bound of the right node's first child */
+                left->keys[base] = node->keys[r];
+                for (i32 i = 0; i < right->count; i++)
+                    btree_node_retain(right->children[i]);
+            }
+            btree_node_release(tree, right);
+            btree_node_remove_at(node, r);
+        }
+    }
+    return true;
+}
+
+void ia_btree_init(ia_btree *tree)
+{
+    tree->root = nullptr;
+    tree->count = 0;
+    ia_atomic_write_monotonic(&tree->snapshots, 0);
+    tree->lock = (ia_spinlock)ia_spinlock_init;
+    tree->free_nodes = nullptr;
+}
+
+void ia_btree_fini(ia_btree *tree)
+{
+    ia_assert(ia_atomic_read(&tree->snapshots, ia_atomic_model_acquire) == 0,
+            "B-tree finalized with %d snapshots not released.", ia_atomic_read_monotonic(&tree->snapshots));
+    if (tree->root)
+        btree_node_release(tree, tree->root);
+    tree->root = nullptr;
+    tree->count = 0;
+}
+
+bool ia_btree_insert(
+    ia_btree   *tree,
+    u64         key,
+    u64         value)
+{
+    if (IA_UNLIKELY(!tree->root)) {
+        ia_btree_node *leaf = btree_node_alloc(tree, 0);
+        leaf->keys[0] = key;
+        leaf->values[0] = value;
+        leaf->count = 1;
+        tree->root = leaf;
+        tree->count = 1;
+        return true;
+    }
+
+    bool inserted;
+    tree->root = btree_node_unshare(tree, tree->root);
+    ia_btree_node *split = btree_insert_rec(tree, tree->root, key, value, &inserted);
+    if (split) {
+        ia_assert(tree->root->height + 1 < IA_BTREE_MAX_HEIGHT, "B-tree is too high.");
+        ia_btree_node *root = btree_node_alloc(tree, tree->root->height + 1);
+        root->keys[0] = tree->root->keys[0];
+        root->children[0] = tree->root;
+        root->keys[1] = split->keys[0];
+        root->children[1] = split;
+        root->count = 2;
+        tree->root = root;
+    }
+    tree->count += inserted;
+    return inserted;
+}
+
+bool ia_btree_remove(
+    ia_btree   *tree,
+    u64         key,
+    u64        *out_value)
+{
+    /* a missing key would copy the shared path for nothing */
+    u64 value;
+    if (!tree->root || !ia_btree_get(tree->root, key, &value))
+        return false;
+    if (out_value)
+        *out_value = value;
+
+    tree->root = btree_node_unshare(tree, tree->root);
+    btree_remove_rec(tree, tree->root, key, nullptr);
+    tree->count--;
+
+    ia_btree_node *root = tree->root;
+    if (root->count == 0) {
+        btree_node_release(tree, root);
+        tree->root = nullptr;
+    } else if (root->height > 0 && root->count == 1) {
+        tree->root = root->children[0];
+        btree_node_retain(tree->root);
+        btree_node_release(tree, root);
+    }
+    return true;
+}
+
+void ia_btree_bulk_load(
+    ia_btree   *tree,
+    isize       count,
+    u64 const  *keys,
+    u64 const  *values)
+{
+    ia_assert(tree->root == nullptr, "Bulk load into a B-tree that is not empty.");
+    if (count <= 0)
+        return;
+
+    /* entries are spread evenly, so every node of a level is at least half full. Nodes are built in
+     * key order, every level above the leaves keeps the one parent that is still being filled. */
+    isize level_count[IA_BTREE_MAX_HEIGHT];
+    i32 top = 0;
+    level_count[0] = (count + IA_BTREE_FANOUT - 1) / IA_BTREE_FANOUT;
+    while (level_count[top] > 1) {
+        ia_assert(top + 1 < IA_BTREE_MAX_HEIGHT, "B-tree is too high.");
+        level_count[top + 1] = (level_count[top] + IA_BTREE_FANOUT - 1) / IA_BTREE_FANOUT;
+        top++;
+    }
+    ia_btree_node *open[IA_BTREE_MAX_HEIGHT] = {0};
+    isize open_index[IA_BTREE_MAX_HEIGHT] = {0};
+    for (isize j = 0; j < level_count[0]; j++) {
+        isize begin = count * j / level_count[0], end = count * (j + 1) / level_count[0];
+        ia_btree_node *node = btree_node_alloc(tree, 0);
+        for (isize i = begin; i < end; i++) {
+            ia_dbg_assert(i == 0 || keys[i - 1] < keys[i], "B-tree bulk load keys are not strictly ascending at %lld.", (long long)i);
+            node->keys[i - begin] = keys[i];
+            node->values[i - begin] = values[i];
+        }
+        node->count = (i32)(end - begin);
+
+        /* a completed node goes to its parent, which may complete in turn */
+        for (i32 height = 1; node && height <= top; height++) {
+            if (!open[height])
+                open[height] = btree_node_alloc(tree, height);
+            ia_btree_node *parent = open[height];
+            parent->keys[parent->count] = node->keys[0];
+            parent->children[parent->count++] = node;
+
+            isize p = open_index[height], children = level_count[height - 1], parents = level_count[height];
+            if (parent->count < children * (p + 1) / parents - children * p / parents) {
+                node = nullptr;
+            } else {
+                open[height] = nullptr;
+                open_index[height]++;
+                node = parent;
+            }
+        }
+        if (node)
+            tree->root = node;
+    }
+    tree->count = count;
+}
+
+bool ia_btree_get(
+    ia_btree_node const    *root,
+    u64                     key,
+    u64                    *out_value)
+{
+    ia_btree_node const *node = root;
+    if (!node)
+        return false;
+    while (node->height > 0)
+        node = node->children[btree_inner_child(node, key)];
+    i32 pos = btree_leaf_lower_bound(node, key);
+    if (pos >= node->count || node->keys[pos] != key)
+        return false;
+    *out_value = node->values[pos];
+    return true;
+}
+
+ia_btree_snapshot ia_btree_snapshot_acquire(ia_btree *tree)
+{
+    if (tree->root)
+        btree_node_retain(tree->root);
+    ia_atomic_add_monotonic(&tree->snapshots, 1);
+    return (ia_btree_snapshot){ .root = tree->root, .count = tree->count, .tree = tree };
+}
+
+void ia_btree_snapshot_release(ia_btree_snapshot *snapshot)
+{
+    if (!snapshot->tree)
+        return;
+    if (snapshot->root)
+        btree_node_release(snapshot->tree, snapshot->root);
+    ia_atomic_sub(&snapshot->tree->snapshots, 1, ia_atomic_model_release);
+    snapshot->root = nullptr;
+    snapshot->count = 0;
+    snapshot->tree = nullptr;
+}
+
+void ia_btree_iter_init(
+    ia_btree_iter          *iter,
+    ia_btree_node const    *root,
+    u64                     lo,
+    u64                     hi)
+{
+    iter->depth = 0;
+    iter->hi = hi;
+    if (!root || lo > hi)
+        return;
+
+    ia_btree_node const *node = root;
+    for (i32 d = 0;; d++) {
+        iter->path[d] = node;
+        if (node->height == 0) {
+            iter->index[d] = btree_leaf_lower_bound(node, lo);
+            iter->depth = d + 1;
+            return;
+        }
+        iter->index[d] = btree_inner_child(node, lo);
+        node = node->children[iter->index[d]];
+    }
+}
+
+bool ia_btree_iter_next(ia_btree_iter *iter)
+{
+    i32 d = iter->depth - 1;
+    if (d < 0)
+        return false;
+
+    ia_btree_node const *leaf = iter->path[d];
+    while (iter->index[d] >= leaf->count) {
+        /* climb to the first ancestor with a next child, then descend to its leftmost leaf */
+        i32 level = d - 1;
+        while (level >= 0 && iter->index[level] + 1 >= iter->path[level]->count)
+            level--;
+        if (level < 0) {
+            iter->depth = 0;
+            return false;
+        }
+        iter->index[level]++;
+        for (i32 l = level + 1; l <= d; l++) {
+            iter->path[l] = iter->path[l - 1]->children[iter->index[l - 1]];
+            iter->index[l] = 0;
+        }
+        leaf = iter->path[d];
+    }
+
+    i32 pos = iter->index[d];
+    if (leaf->keys[pos] > iter->hi) {
+        iter->depth = 0;
+        return false;
+    }
+    iter->key = leaf->keys[pos];
+    iter->value = leaf->values[pos];
+    iter->index[d] = pos + 1;
+    return true;
+}
+
+void ia_pool_init_(
+    ia_pool        *pool,
+    isize           stride,
+    i32             capacity,
+    char const     *type_name)
+{
+    ia_assert(capacity > 0, "%s: capacity %d is not positive.", type_name, capacity);
+    pool->stride = stride;
+    pool->capacity = capacity;
+#ifdef IA_DEBUG
+    pool->dbg_name = type_name;
+#endif
+    pool->data = stride ? ia_drift_alloc(stride * capacity, IA_CACHELINE_SIZE) : nullptr;
+    pool->versions = ia_drift_alloc_as(atomic_u32, capacity);
+    pool->next = ia_drift_alloc_as(atomic_u32, capacity);
+    ia_assert(pool->versions && pool->next && (pool->data || !stride), "%s: out of memory.", type_name);
+    for (i32 i = 0; i < capacity; i++)
+        ia_atomic_write_monotonic(&pool->versions[i], 0);
+    ia_atomic_write_monotonic(&pool->watermark, 0);
+    ia_atomic_write_monotonic(&pool->count, 0);
+    ia_atomic_write(&pool->free_head, 0, ia_atomic_model_release);
+}
+
+ia_identifier ia_pool_acquire(ia_pool *pool)
+{
+    u32 index;
+    u64 head = ia_atomic_read(&pool->free_head, ia_atomic_model_acquire);
+    for (;;) {
+        u32 top = (u32)head;
+        if (!top) {
+            /* the free list is empty, take a slot that was never used */
+            i32 mark = ia_atomic_read_monotonic(&pool->watermark);
+            do {
+                if (mark >= pool->capacity)
+                    return 0;
+            } while (!ia_atomic_cmpxchg_weak(&pool->watermark, &mark, mark + 1, ia_atomic_model_monotonic, ia_atomic_model_monotonic));
+            index = (u32)mark;
+            break;
+        }
+        /* the link may be stale if the slot was popped meanwhile, then the tag makes the CAS fail */
+        u32 next = ia_atomic_read_monotonic(&pool->next[top - 1]);
+        u64 desired = ((head >> 32) + 1) << 32 | next;
+        if (ia_atomic_cmpxchg_weak(&pool->free_head, &head, desired, ia_atomic_model_acquire, ia_atomic_model_acquire)) {
+            index = top - 1;
+            break;
+        }
+    }
+
+    if (pool->stride)
+        memset(ia_elem_(pool->data, pool->stride, index), 0, pool->stride);
+    /* the slot is owned now, the release store publishes the zeroed payload with an odd version */
+    u32 version = ia_atomic_read_monotonic(&pool->versions[index]) + 1;
+    ia_atomic_write(&pool->versions[index], version, ia_atomic_model_release);
+    ia_atomic_add(&pool->count, 1, ia_atomic_model_monotonic);
+    return ia_identifier_raw(index, version);
+}
+
+bool ia_pool_release(
+    ia_pool        *pool,
+    ia_identifier   handle)
+{
+    u32 index = ia_identifier_get_index(handle);
+    u32 version = ia_identifier_get_version(handle);
+    if (index >= (u32)pool->capacity || !(version & 1))
+        return false;
+    /* only one of racing releases of the same handle wins */
+    if (!ia_atomic_cmpxchg_strong(&pool->versions[index], &version, version + 1, ia_atomic_model_acq_rel, ia_atomic_model_monotonic))
+        return false;
+
+    u64 head = ia_atomic_read_monotonic(&pool->free_head);
+    u64 desired;
+    do {
+        ia_atomic_write_monotonic(&pool->next[index], (u32)head);
+        desired = ((head >> 32) + 1) << 32 | (index + 1);
+    } while (!ia_atomic_cmpxchg_weak(&pool->free_head, &head, desired, ia_atomic_model_release, ia_atomic_model_monotonic));
+    ia_atomic_sub(&pool->count, 1, ia_atomic_model_monotonic);
+    return true;
+}
+
+typedef struct epoch_retired {
+    void               *node;
+    ia_epoch_free_fn    free_fn;
+    void               *userdata;
+    u64                 epoch;      /* global epoch after the node was unlinked */
+} epoch_retired;
+
+static inline ia_epoch_worker *epoch_worker(ia_epoch *epoch)
+{
+    i32 index = ia_worker_thread_index();
+    ia_dbg_assert(index >= 0 && index < epoch->worker_count, "Worker index %d is out of the epoch domain.", index);
+    return &epoch->workers[index];
+}
+
+/* The epoch advances when every pinned worker has observed it.
+ * Returns the global epoch after the attempt. */
+static u64 epoch_try_advance(ia_epoch *epoch)
+{
+    u64 global = ia_atomic_read_monotonic(&epoch->global);
+    ia_atomic_thread_fence(ia_atomic_model_seq_cst);
+    for (i32 i = 0; i < epoch->worker_count; i++) {
+        u64 state = ia_atomic_read_monotonic(&epoch->workers[i].state);
+        if ((state & 1) && (state >> 1) != global)
+            return global;
+    }
+    /* pairs with the release of unpins, accesses of pinned sections happen before any free */
+    ia_atomic_thread_fence(ia_atomic_model_acquire);
+    if (ia_atomic_cmpxchg_strong(&epoch->global, &global, global + 1, ia_atomic_model_release, ia_atomic_model_acquire))
+        return global + 1;
+    return global;
+}
+
+/* Frees the expired prefix of the worker's retire list. Free functions must not retire nodes. */
+static void epoch_collect_worker(
+    ia_epoch_worker    *worker,
+    u64                 global)
+{
+    epoch_retired *retired = ia_darray_as(epoch_retired, &worker->retired);
+    i32 expired = 0;
+    while (expired < worker->retired.len && retired[expired].epoch + 2 <= global)
+        expired++;
+    if (expired == 0)
+        return;
+    for (i32 i = 0; i < expired; i++)
+        retired[i].free_fn(retired[i].userdata, retired[i].node);
+    memmove(retired, &retired[expired], sizeof(epoch_retired) * (worker->retired.len - expired));
+    worker->retired.len -= expired;
+}
+
+/* Waits for the epoch to advance until the worker is back under the retire limit. It's called only
+ * while the worker is unpinned, so it only waits for pinned sections of other workers to end. */
+static void epoch_reclaim_to_limit(
+    ia_epoch           *epoch,
+    ia_epoch_worker    *worker)
+{
+    for (;;) {
+        u64 global = ia_atomic_read(&epoch->global, ia_atomic_model_acquire);
+        epoch_collect_worker(worker, global);
+        if (worker->retired.len <= IA_EPOCH_RETIRE_LIMIT)
+            break;
+        if (epoch_try_advance(epoch) == global)
+            ia_cpu_relax();
+    }
+}
+
+void ia_epoch_init(
+    ia_epoch   *epoch,
+    i32         thread_count)
+{
+    epoch->worker_count = thread_count + 1;
+    epoch->workers = ia_drift_alloc_as(ia_epoch_worker, epoch->worker_count);
+    ia_assert(epoch->workers != nullptr, "Out of memory for %d epoch workers.", epoch->worker_count);
+    for (i32 i = 0; i < epoch->worker_count; i++) {
+        ia_epoch_worker *worker = &epoch->workers[i];
+        ia_atomic_write_monotonic(&worker->state, 0);
+        worker->depth = 0;
+        worker->since_collect = 0;
+        worker->retired = ia_darray_init;
+    }
+    ia_atomic_write(&epoch->global, 0, ia_atomic_model_release);
+}
+
+void ia_epoch_fini(ia_epoch *epoch)
+{
+    for (i32 i = 0; i < epoch->worker_count; i++) {
+        ia_epoch_worker *worker = &epoch->workers[i];
+        ia_dbg_assert(worker->depth == 0, "Worker %d is still pinned.", i);
+        epoch_collect_worker(worker, UINT64_MAX);
+    }
+}
+
+ia_epoch_guard ia_epoch_pin(ia_epoch *epoch)
+{
+    ia_epoch_worker *worker = epoch_worker(epoch);
+    if (worker->depth++ == 0) {
+        u64 global = ia_atomic_read_monotonic(&epoch->global);
+        ia_atomic_write_monotonic(&worker->state, global << 1 | 1);
+        /* the pin must be visible to advancing workers before any load from the structure */
+        ia_atomic_thread_fence(ia_atomic_model_seq_cst);
+    }
+    return (ia_epoch_guard){ .worker = worker };
+}
+
+void ia_epoch_unpin(
+    ia_epoch       *epoch,
+    ia_epoch_guard *guard)
+{
+    ia_epoch_worker *worker = guard->worker;
+    ia_dbg_assert(worker == epoch_worker(epoch), "A fiber yielded in a pinned section and migrated to another worker.");
+    ia_dbg_assert(worker->depth > 0, "Unpin without a pin.");
+    if (--worker->depth > 0)
+        return;
+    ia_atomic_write(&worker->state, ia_atomic_read_monotonic(&worker->state) & ~1ull, ia_atomic_model_release);
+    if (worker->retired.len > IA_EPOCH_RETIRE_LIMIT)
+        epoch_reclaim_to_limit(epoch, worker);
+}
+
+void ia_epoch_retire(
+    ia_epoch           *epoch,
+    void               *node,
+    ia_epoch_free_fn    free_fn,
+    void               *userdata)
+{
+    ia_epoch_worker *worker = epoch_worker(epoch);
+    /* the epoch is read after the node was unlinked, a worker that could still reach it is pinned at
+     * this epoch or an older one */
+    ia_atomic_thread_fence(ia_atomic_model_seq_cst);
+    u64 global = ia_atomic_read_monotonic(&epoch->global);
+
+    ia_darray_reserve(epoch_retired, &worker->retired, worker->retired.len + 1, ia_drift_allocator);
+    ia_darray_as(epoch_retired, &worker->retired)[worker->retired.len++] = (epoch_retired){
+        .node = node,
+        .free_fn = free_fn,
+        .userdata = userdata,
+        .epoch = global,
+    };
+
+    if (++worker->since_collect >= IA_EPOCH_COLLECT_INTERVAL) {
+        worker->since_collect = 0;
+        epoch_collect_worker(worker, epoch_try_advance(epoch));
+    }
+    if (worker->depth == 0 && worker->retired.len > IA_EPOCH_RETIRE_LIMIT)
+        epoch_reclaim_to_limit(epoch, worker);
+}
+
+isize ia_epoch_collect(ia_epoch *epoch)
+{
+    ia_epoch_worker *worker = epoch_worker(epoch);
+    epoch_collect_worker(worker, epoch_try_advance(epoch));
+    return worker->retired.len;
+}
+
+void ia_sparse_init(
+    ia_sparse  *sparse,
+    i32         stride)
+{
+    ia_san_assert(stride >= 0, "Sparse stride must not be negative.");
+    *sparse = (ia_sparse){
+        .dense = ia_darray_init,
+        .values = ia_darray_init,
+        .pages = ia_darray_init,
+        .stride = stride,
+    };
+}
+
+void ia_sparse_fini(ia_sparse *sparse)
+{
+    /* memory is owned by the drift allocator */
+    ia_sparse_init(sparse, sparse->stride);
+}
+
+static inline ia_identifier sparse_bump_version(ia_identifier id)
+{
+    u32 version = ia_identifier_get_version(id) + 1;
+    /* version 0 marks an empty identifier, skip it on wrap around */
+    return ia_identifier_raw(ia_identifier_get_index(id), version ? version : 1);
+}
+
+void ia_sparse_clear(ia_sparse *sparse)
+{
+    ia_identifier *dense = ia_darray_as(ia_identifier, &sparse->dense);
+    for (i32 i = 0; i < sparse->count; i++)
+        dense[i] = sparse_bump_version(dense[i]);
+    sparse->count = 0;
+}
+
+/** Returns the sparse entry of an index, allocates the page if necessary. */
+static i32 *sparse_entry_ensure(
+    ia_sparse  *sparse,
+    u32         index)
+{
+    i32 page = (i32)(index >> IA_SPARSE_PAGE_BITS);
+
+    if (page >= sparse->pages.len) {
+        ia_darray_reserve(i32 *, &sparse->pages, page + 1, ia_drift_allocator);
+        for (i32 i = sparse->pages.len; i <= page; i++)
+            ia_darray_as(i32 *, &sparse->pages)[i] = nullptr;
+        sparse->pages.len = page + 1;
+    }
+    i32 **entries = &ia_darray_as(i32 *, &sparse->pages)[page];
+    if (IA_UNLIKELY(*entries == nullptr)) {
+        *entries = ia_drift_alloc_as(i32, IA_SPARSE_PAGE_SIZE);
+        memset(*entries, 0, ia_ssizeof(i32) * IA_SPARSE_PAGE_SIZE);
+    }
+    return &(*entries)[index & IA_SPARSE_PAGE_MASK];
+}
+
+/** Swaps two entries of the dense array and fixes their sparse entries, values are not touched. */
+static void sparse_swap_ids(
+    ia_sparse  *sparse,
+    i32         a,
+    i32         b)
+{
+    ia_identifier *dense = ia_darray_as(ia_identifier, &sparse->dense);
+    ia_identifier id_a = dense[a], id_b = dense[b];
+
+    dense[a] = id_b;
+    dense[b] = id_a;
+    *sparse_entry_ensure(sparse, ia_identifier_get_index(id_b)) = a + 1;
+    *sparse_entry_ensure(sparse, ia_identifier_get_index(id_a)) = b + 1;
+}
+
+/** Appends an identifier to the end of the dense array, returns its position. */
+static i32 sparse_dense_push(
+    ia_sparse      *sparse,
+    ia_identifier   id)
+{
+    i32 pos = sparse->dense.len;
+
+    ia_darray_reserve(ia_identifier, &sparse->dense, pos + 1, ia_drift_allocator);
+    if (sparse->stride > 0)
+        ia_darray_reserve_w_stride(&sparse->values, sparse->stride, 16, pos + 1, ia_drift_allocator);
+    ia_darray_as(ia_identifier, &sparse->dense)[pos] = id;
+    sparse->dense.len = sparse->values.len = pos + 1;
+    *sparse_entry_ensure(sparse, ia_identifier_get_index(id)) = pos + 1;
+    return pos;
+}
+
+static inline void *sparse_value_zeroed(
+    ia_sparse  *sparse,
+    i32         pos)
+{
+    void *value = ia_elem_(sparse->values.v, sparse->stride, pos);
+    if (sparse->stride > 0)
+        memset(value, 0, sparse->stride);
+    return value;
+}
+
+ia_identifier ia_sparse_new_index(ia_sparse *sparse)
+{
+    ia_identifier id;
+
+    if (sparse->count < sparse->dense.len) {
+        /* recycle a removed index, the version was already bumped */
+        id = ia_darray_as(ia_identifier, &sparse->dense)[sparse->count];
+    } else {
+        ia_assert(sparse->max_idx <= IA_IDENTIFIER_INDEX_MASK, "Sparse set ran out of indices.");
+        id = ia_identifier_raw(sparse->max_idx++, 1);
+        sparse_dense_push(sparse, id);
+    }
+    sparse_value_zeroed(sparse, sparse->count++);
+    return id;
+}
+
+void *ia_sparse_insert(
+    ia_sparse      *sparse,
+    ia_identifier   id)
+{
+    ia_dbg_assert(!ia_identifier_is_empty(id), "Can't insert an empty identifier.");
+
+    u32 index = ia_identifier_get_index(id);
+    i32 slot = *sparse_entry_ensure(sparse, index) - 1;
+
+    if (slot < 0) {
+        /* never seen this index */
+        slot = sparse_dense_push(sparse, id);
+        if ((u64)index >= sparse->max_idx)
+            sparse->max_idx = (u64)index + 1;
+    } else if (slot < sparse->count) {
+        ia_assert(ia_darray_as(ia_identifier, &sparse->dense)[slot] == id,
+                "Inserting identifier %u:%u over a different version.", index, ia_identifier_get_version(id));
+        return ia_elem_(sparse->values.v, sparse->stride, slot);
+    } else {
+        /* dead index, adopt the given version */
+        ia_darray_as(ia_identifier, &sparse->dense)[slot] = id;
+    }
+    /* move it to the end of the alive range */
+    if (slot != sparse->count)
+        sparse_swap_ids(sparse, slot, sparse->count);
+    return sparse_value_zeroed(sparse, sparse->count++);
+}
+
+bool ia_sparse_remove(
+    ia_sparse      *sparse,
+    ia_identifier   id)
+{
+    i32 slot = ia_sparse_dense_index(sparse, id);
+    if (slot < 0)
+        return false;
+
+    i32 last = --sparse->count;
+    if (slot != last) {
+        if (sparse->stride > 0) {
+            memcpy(ia_elem_(sparse->values.v, sparse->stride, slot),
+                   ia_elem_(sparse->values.v, sparse->stride, last), sparse->stride);
+        }
+        sparse_swap_ids(sparse, slot, last);
+    }
+    ia_identifier *dense = ia_darray_as(ia_identifier, &sparse->dense);
+    dense[last] = sparse_bump_version(dense[last]);
+    return true;
+}
+
+void ia_bitset_resize(
+    ia_bitset  *bitset,
+    i32         bits)
+{
+    i32 words = ia_bitset_words(bits);
+    i32 old_words = ia_bitset_words(bitset->size);
+
+    ia_san_assert(bits >= 0, "Bitset size must not be negative.");
+    if (words > bitset->alloc) {
+        i32 alloc = ia_max(words, bitset->alloc * 2);
+        u64 *v = ia_drift_alloc_as(u64, alloc);
+        if (old_words > 0)
+            memcpy(v, bitset->v, ia_ssizeof(u64) * old_words);
+        memset(v + old_words, 0, ia_ssizeof(u64) * (alloc - old_words));
+        bitset->v = v;
+        bitset->alloc = alloc;
+    }
+    if (bits < bitset->size) {
+        /* keep the words past the size zeroed */
+        memset(bitset->v + words, 0, ia_ssizeof(u64) * (old_words - words));
+        if (bits & 63)
+            bitset->v[words - 1] &= (1ull << (bits & 63)) - 1;
+    }
+    bitset->size = bits;
+}
+
+/* Word-wise logical operations, 4 words per step with AVX2 and 2 words per step with NEON. */
+#if defined(IA_ARCH_X86_AVX2)
+    #define BITSET_OP_KERNEL(NAME, EXPR, SIMD) \
+        static void NAME(u64 *dst, u64 const *a, u64 const *b, i32 n) \
+        { \
+            i32 i = 0; \
+            for (; i + 4 <= n; i += 4) { \
+                __m256i x = _mm256_loadu_si256((__m256i const *)&a[i]); \
+                __m256i y = _mm256_loadu_si256((__m256i const *)&b[i]); \
+                _mm256_storeu_si256((__m256i *)&dst[i], SIMD); \
+            } \
+            for (; i < n; i++) { u64 x = a[i], y = b[i]; dst[i] = EXPR; } \
+        }
+    #define BITSET_SIMD_AND     _mm256_and_si256(x, y)
+    #define BITSET_SIMD_OR      _mm256_or_si256(x, y)
+    #define BITSET_SIMD_XOR     _mm256_xor_si256(x, y)
+    #define BITSET_SIMD_ANDNOT  _mm256_andnot_si256(y, x)
+#elif defined(IA_ARCH_ARM_NEON)
+    #define BITSET_OP_KERNEL(NAME, EXPR, SIMD) \
+        static void NAME(u64 *dst, u64 const *a, u64 const *b, i32 n) \
+        { \
+            i32 i = 0; \
+            for (; i + 2 <= n; i += 2) { \
+                uint64x2_t x = vld1q_u64(&a[i]); \
+                uint64x2_t y = vld1q_u64(&b[i]); \
+                vst1q_u64(&dst[i], SIMD); \
+            } \
+            for (; i < n; i++) { u64 x = a[i], y = b[i]; dst[i] = EXPR; } \
+        }
+    #define BITSET_SIMD_AND     vandq_u64(x, y)
+    #define BITSET_SIMD_OR      vorrq_u64(x, y)
+    #define BITSET_SIMD_XOR     veorq_u64(x, y)
+    #define BITSET_SIMD_ANDNOT  vbicq_u64(x, y)
+#else
+    #define BITSET_OP_KERNEL(NAME, EXPR, SIMD) \
+        static void NAME(u64 *dst, u64 const *a, u64 const *b, i32 n) \
+        { \
+            for (i32 i = 0; i < n; i++) { u64 x = a[i], y = b[i]; dst[i] = EXPR; } \
+        }
+#endif
+BITSET_OP_KERNEL(bitset_and_words,      x & y,  BITSET_SIMD_AND)
+BITSET_OP_KERNEL(bitset_or_words,       x | y,  BITSET_SIMD_OR)
+BITSET_OP_KERNEL(bitset_xor_words,      x ^ y,  BITSET_SIMD_XOR)
+BITSET_OP_KERNEL(bitset_andnot_words,   x & ~y, BITSET_SIMD_ANDNOT)
+
+void ia_bitset_and(
+    ia_bitset          *dst,
+    ia_bitset const    *a,
+    ia_bitset const    *b)
+{
+    i32 size = ia_min(a->size, b->size);
+    /* read sizes before the resize, dst may alias an operand */
+    ia_bitset_resize(dst, size);
+    bitset_and_words(dst->v, a->v, b->v, ia_bitset_words(size));
+}
+
+/** OR and XOR keep the tail of the longer operand, as x | 0 = x ^ 0 = x. */
+static void bitset_op_longest(
+    ia_bitset          *dst,
+    ia_bitset const    *a,
+    ia_bitset const    *b,
+    void              (*op)(u64 *, u64 const *, u64 const *, i32))
+{
+    i32 wa = ia_bitset_words(a->size), wb = ia_bitset_words(b->size);
+    i32 common = ia_min(wa, wb);
+    ia_bitset const *longer = wa >= wb ? a : b;
+
+    ia_bitset_resize(dst, ia_max(a->size, b->size));
+    op(dst->v, a->v, b->v, common);
+    if (dst != longer && ia_max(wa, wb) > common)
+        memcpy(dst->v + common, longer->v + common, ia_ssizeof(u64) * (ia_max(wa, wb) - common));
+}
+
+void ia_bitset_or(
+    ia_bitset          *dst,
+    ia_bitset const    *a,
+    ia_bitset const    *b)
+{
+    bitset_op_longest(dst, a, b, bitset_or_words);
+}
+
+void ia_bitset_xor(
+    ia_bitset          *dst,
+    ia_bitset const    *a,
+    ia_bitset const    *b)
+{
+    bitset_op_longest(dst, a, b, bitset_xor_words);
+}
+
+void ia_bitset_andnot(
+    ia_bitset          *dst,
+    ia_bitset const    *a,
+    ia_bitset const    *b)
+{
+    i32 wa = ia_bitset_words(a->size), wb = ia_bitset_words(b->size);
+    i32 common = ia_min(wa, wb);
+
+    ia_bitset_resize(dst, a->size);
+    bitset_andnot_words(dst->v, a->v, b->v, common);
+    if (dst != a && wa > common)
+        memcpy(dst->v + common, a->v + common, ia_ssizeof(u64) * (wa - common));
+}
+
+i32 ia_bitset_popcount(ia_bitset const *bitset)
+{
+    i32 words = ia_bitset_words(bitset->size);
+    i32 count0 = 0, count1 = 0, i = 0;
+    /* two accumulators keep popcnt instructions independent */
+    for (; i + 2 <= words; i += 2) {
+        count0 += ia_popcnt64(bitset->v[i]);
+        count1 += ia_popcnt64(bitset->v[i + 1]);
+    }
+    if (i < words)
+        count0 += ia_popcnt64(bitset->v[i]);
+    return count0 + count1;
+}
+
+i32 ia_bitset_rank(
+    ia_bitset const    *bitset,
+    i32                 bit)
+{
+    bit = ia_clamp(bit, 0, bitset->size);
+    i32 w = bit >> 6, rank = 0;
+    for (i32 i = 0; i < w; i++)
+        rank += ia_popcnt64(bitset->v[i]);
+    if (bit & 63)
+        rank += ia_popcnt64(bitset->v[w] & ((1ull << (bit & 63)) - 1));
+    return rank;
+}
+
+/** Finds the k-th set bit starting at a word, k is relative to that word. */
+static i32 bitset_select_from(
+    ia_bitset const    *bitset,
+    i32                 w,
+    i32                 k)
+{
+    i32 words = ia_bitset_words(bitset->size);
+    for (; w < words; w++) {
+        i32 count = ia_popcnt64(bitset->v[w]);
+        if (k < count)
+            return (w << 6) + ia_select64(bitset->v[w], k);
+        k -= count;
+    }
+    return -1;
+}
+
+i32 ia_bitset_select(
+    ia_bitset const    *bitset,
+    i32                 k)
+{
+    return k < 0 ? -1 : bitset_select_from(bitset, 0, k);
+}
+
+void ia_bitset_ranks_build(
+    ia_bitset const    *bitset,
+    ia_bitset_ranks    *ranks)
+{
+    i32 words = ia_bitset_words(bitset->size);
+    i32 count = (words + IA_BITSET_RANK_BLOCK_WORDS - 1) / IA_BITSET_RANK_BLOCK_WORDS;
+    i32 rank = 0;
+
+    ranks->blocks = ia_drift_alloc_as(i32, count + 1);
+    ranks->count = count;
+    for (i32 block = 0; block < count; block++) {
+        ranks->blocks[block] = rank;
+        i32 end = ia_min(words, (block + 1) * IA_BITSET_RANK_BLOCK_WORDS);
+        for (i32 w = block * IA_BITSET_RANK_BLOCK_WORDS; w < end; w++)
+            rank += ia_popcnt64(bitset->v[w]);
+    }
+    ranks->blocks[count] = rank;
+}
+
+i32 ia_bitset_select_indexed(
+    ia_bitset const        *bitset,
+    ia_bitset_ranks const  *ranks,
+    i32                     k)
+{
+    if (k < 0 || k >= ranks->blocks[ranks->count])
+        return -1;
+
+    /* last block whose cumulative count is not above k */
+    i32 lo = 0, hi = ranks->count - 1;
+    while (lo < hi) {
+        i32 mid = (lo + hi + 1) >> 1;
+        if (ranks->blocks[mid] <= k) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return bitset_select_from(bitset, lo * IA_BITSET_RANK_BLOCK_WORDS, k - ranks->blocks[lo]);
+}
+
+/** Copies a bitset into new memory, with room for at least `bits` bits. */
+static ia_bitset bitset_clone(
+    ia_bitset const    *src,
+    i32                 bits)
+{
+    ia_bitset dst = ia_bitset_init;
+    ia_bitset_resize(&dst, ia_max(bits, src->size));
+    if (src->size > 0)
+        memcpy(dst.v, src->v, ia_ssizeof(u64) * ia_bitset_words(src->size));
+    return dst;
+}
+
+#define ecs_archetypes(ecs)     ia_darray_as(ia_ecs_archetype, &(ecs)->archetypes)
+#define ecs_components(ecs)     ia_darray_as(ia_component_info, &(ecs)->components)
+
+static inline u8 *ecs_chunk(
+    ia_ecs_archetype const *archetype,
+    i32                     row)
+{ return ia_darray_as(u8 *, &archetype->chunks)[row / archetype->chunk_capacity]; }
+
+static inline ia_entity *ecs_entity_at(
+    ia_ecs_archetype const *archetype,
+    i32                     row)
+{ return &((ia_entity *)ecs_chunk(archetype, row))[row % archetype->chunk_capacity]; }
+
+static inline void *ecs_column_at(
+    ia_ecs_archetype const *archetype,
+    i32                     column,
+    i32                     row)
+{
+    u8 *chunk = ecs_chunk(archetype, row);
+    return chunk + archetype->column_offsets[column] + (row % archetype->chunk_capacity) * archetype->column_sizes[column];
+}
+
+/** @return Column index of a component within the archetype, or -1. */
+static i32 ecs_column_index(
+    ia_ecs_archetype const *archetype,
+    ia_component            component)
+{
+    i32 lo = 0, hi = archetype->component_count;
+    while (lo < hi) {
+        i32 mid = (lo + hi) >> 1;
+        if (archetype->components[mid] < component) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < archetype->component_count && archetype->components[lo] == component) ? lo : -1;
+}
+
+/** Lays out columns of a chunk, every column begins at a cacheline boundary.
+ *  @return End offset of the last column for the given capacity. */
+static i32 ecs_layout_columns(
+    ia_ecs_archetype   *archetype,
+    i32                 capacity)
+{
+    i32 offset = ia_ssizeof(ia_entity) * capacity;
+    for (i32 i = 0; i < archetype->component_count; i++) {
+        if (archetype->column_sizes[i] == 0) {
+            archetype->column_offsets[i] = 0;
+            continue;
+        }
+        offset = ia_align(offset, IA_CACHELINE_SIZE);
+        archetype->column_offsets[i] = offset;
+        offset += archetype->column_sizes[i] * capacity;
+    }
+    return offset;
+}
+
+static i32 ecs_archetype_create(
+    ia_ecs             *ecs,
+    ia_bitset const    *mask)
+{
+    ia_ecs_archetype archetype = {
+        .mask = bitset_clone(mask, mask->size),
+        .chunks = ia_darray_init,
+        .add_edges = ia_darray_init,
+        .remove_edges = ia_darray_init,
+    };
+    i32 row_size = ia_ssizeof(ia_entity);
+
+    for (i32 bit = 0; bit < mask->size; bit++)
+        archetype.component_count += ia_bitset_test(mask, bit);
+
+    i32 n = archetype.component_count;
+    archetype.components = ia_drift_alloc_as(ia_component, ia_max(n, 1));
+    archetype.column_offsets = ia_drift_alloc_as(i32, ia_max(n, 1));
+    archetype.column_sizes = ia_drift_alloc_as(i32, ia_max(n, 1));
+    for (i32 bit = 0, i = 0; bit < mask->size; bit++) {
+        if (!ia_bitset_test(mask, bit))
+            continue;
+        archetype.components[i] = bit;
+        archetype.column_sizes[i] = ecs_components(ecs)[bit].size;
+        row_size += archetype.column_sizes[i++];
+    }
+
+    /* start from an estimate that ignores alignment padding, then shrink until it fits */
+    i32 capacity = IA_ECS_CHUNK_SIZE / row_size;
+    while (capacity > 0 && ecs_layout_columns(&archetype, capacity) > IA_ECS_CHUNK_SIZE)
+        capacity--;
+    ia_assert(capacity > 0, "Components of an archetype don't fit into a %d byte chunk.", IA_ECS_CHUNK_SIZE);
+    archetype.chunk_capacity = capacity;
+
+    i32 index = ecs->archetypes.len;
+    ia_darray_reserve(ia_ecs_archetype, &ecs->archetypes, index + 1, ia_drift_allocator);
+    ecs_archetypes(ecs)[index] = archetype;
+    ecs->archetypes.len = index + 1;
+    return index;
+}
+
+static i32 ecs_archetype_find_or_create(
+    ia_ecs             *ecs,
+    ia_bitset const    *mask)
+{
+    for (i32 i = 0; i < ecs->archetypes.len; i++)
+        if (ia_bitset_equal(&ecs_archetypes(ecs)[i].mask, mask))
+            return i;
+    return ecs_archetype_create(ecs, mask);
+}
+
+/** @return Edge slot for the component, archetype index plus one or zero if unknown. */
+static i32 *ecs_edge(
+    ia_darray      *edges,
+    ia_component    component)
+{
+    if (component >= edges->len) {
+        ia_darray_reserve(i32, edges, component + 1, ia_drift_allocator);
+        memset(ia_darray_as(i32, edges) + edges->len, 0, ia_ssizeof(i32) * (component + 1 - edges->len));
+        edges->len = component + 1;
+    }
+    return &ia_darray_as(i32, edges)[component];
+}
+
+static i32 ecs_archetype_push_row(
+    ia_ecs_archetype   *archetype,
+    ia_entity           entity)
+{
+    i32 row = archetype->count;
+    i32 chunk = row / archetype->chunk_capacity;
+
+    if (chunk >= archetype->chunks.len) {
+        ia_darray_reserve(u8 *, &archetype->chunks, chunk + 1, ia_drift_allocator);
+        ia_darray_as(u8 *, &archetype->chunks)[chunk] = ia_drift_alloc(IA_ECS_CHUNK_SIZE, IA_CACHELINE_SIZE);
+        archetype->chunks.len = chunk + 1;
+    }
+    *ecs_entity_at(archetype, row) = entity;
+    archetype->count++;
+    return row;
+}
+
+/** Moves the last row into the removed one, chunks are kept for reuse. */
+static void ecs_archetype_remove_row(
+    ia_ecs             *ecs,
+    ia_ecs_archetype   *archetype,
+    i32                 row)
+{
+    i32 last = --archetype->count;
+    if (row == last)
+        return;
+
+    ia_entity moved = *ecs_entity_at(archetype, last);
+    *ecs_entity_at(archetype, row) = moved;
+    for (i32 i = 0; i < archetype->component_count; i++) {
+        if (archetype->column_sizes[i] > 0)
+            memcpy(ecs_column_at(archetype, i, row), ecs_column_at(archetype, i, last), archetype->column_sizes[i]);
+    }
+    ia_ecs_record *record = ia_sparse_get(&ecs->entities, moved.id);
+    record->row = row;
+}
+
+/** Moves an entity with its components into another archetype, new components are zeroed. */
+static void ecs_move(
+    ia_ecs         *ecs,
+    ia_ecs_record  *record,
+    i32             target)
+{
+    ia_ecs_archetype *src = &ecs_archetypes(ecs)[record->archetype];
+    ia_ecs_archetype *dst = &ecs_archetypes(ecs)[target];
+    i32 src_row = record->row;
+    i32 dst_row = ecs_archetype_push_row(dst, *ecs_entity_at(src, src_row));
+
+    /* both component lists are sorted, walk them together */
+    for (i32 i = 0, j = 0; i < dst->component_count; i++) {
+        i32 size = dst->column_sizes[i];
+        while (j < src->component_count && src->components[j] < dst->components[i])
+            j++;
+        if (size == 0)
+            continue;
+        void *to = ecs_column_at(dst, i, dst_row);
+        if (j < src->component_count && src->components[j] == dst->components[i]) {
+            memcpy(to, ecs_column_at(src, j, src_row), size);
+        } else {
+            memset(to, 0, size);
+        }
+    }
+    ecs_archetype_remove_row(ecs, src, src_row);
+    record->archetype = target;
+    record->row = dst_row;
+}
+
+void ia_ecs_init(ia_ecs *ecs)
+{
+    *ecs = (ia_ecs){
+        .components = ia_darray_init,
+        .archetypes = ia_darray_init,
+    };
+    ia_sparse_init(&ecs->entities, ia_ssizeof(ia_ecs_record));
+
+    ia_bitset empty = ia_bitset_init;
+    ecs_archetype_create(ecs, &empty);
+}
+
+void ia_ecs_fini(ia_ecs *ecs)
+{
+    /* memory is owned by the drift allocator */
+    ia_sparse_fini(&ecs->entities);
+    *ecs = (ia_ecs){ .components = ia_darray_init, .archetypes = ia_darray_init };
+}
+
+ia_component ia_ecs_register_component(
+    ia_ecs                     *ecs,
+    ia_component_info const    *info)
+{
+    ia_assert(info->size >= 0 && ia_is_pow2(info->alignment) && info->alignment <= IA_CACHELINE_SIZE,
+            "Invalid layout of component `%s`.", info->name);
+
+    ia_component component = ecs->components.len;
+    ia_darray_reserve(ia_component_info, &ecs->components, component + 1, ia_drift_allocator);
+    ecs_components(ecs)[component] = *info;
+    ecs->components.len = component + 1;
+    return component;
+}
+
+ia_entity ia_ecs_create(ia_ecs *ecs)
+{
+    ia_entity entity = { .id = ia_sparse_new_index(&ecs->entities) };
+    ia_ecs_record *record = ia_sparse_get(&ecs->entities, entity.id);
+
+    record->archetype = 0;
+    record->row = ecs_archetype_push_row(&ecs_archetypes(ecs)[0], entity);
+    return entity;
+}
+
+bool ia_ecs_destroy(
+    ia_ecs         *ecs,
+    ia_entity       entity)
+{
+    ia_ecs_record *record = ia_sparse_get(&ecs->entities, entity.id);
+    if (!record)
+        return false;
+
+    ecs_archetype_remove_row(ecs, &ecs_archetypes(ecs)[record->archetype], record->row);
+    ia_sparse_remove(&ecs->entities, entity.id);
+    return true;
+}
+
+void *ia_ecs_add(
+    ia_ecs         *ecs,
+    ia_entity       entity,
+    ia_component    component)
+{
+    ia_ecs_record *record = ia_sparse_get(&ecs->entities, entity.id);
+    if (!record)
+        return nullptr;
+
+    ia_dbg_assert(component >= 0 && component < ecs->components.len, "Unknown component %d.", component);
+    i32 source = record->archetype;
+    ia_ecs_archetype *archetype = &ecs_archetypes(ecs)[source];
+    if (ia_bitset_test(&archetype->mask, component))
+        return ia_ecs_get(ecs, entity, component);
+
+    i32 target = *ecs_edge(&archetype->add_edges, component) - 1;
+    if (target < 0) {
+        ia_bitset mask = bitset_clone(&archetype->mask, ecs->components.len);
+        ia_bitset_set(&mask, component);
+        target = ecs_archetype_find_or_create(ecs, &mask);
+        /* the archetype array may have been reallocated */
+        *ecs_edge(&ecs_archetypes(ecs)[source].add_edges, component) = target + 1;
+        *ecs_edge(&ecs_archetypes(ecs)[target].remove_edges, component) = source + 1;
+    }
+    ecs_move(ecs, record, target);
+    return ia_ecs_get(ecs, entity, component);
+}
+
+bool ia_ecs_remove(
+    ia_ecs         *ecs,
+    ia_entity       entity,
+    ia_component    component)
+{
+    ia_ecs_record *record = ia_sparse_get(&ecs->entities, entity.id);
+    if (!record)
+        return false;
+
+    i32 source = record->archetype;
+    ia_ecs_archetype *archetype = &ecs_archetypes(ecs)[source];
+    if (!ia_bitset_test(&archetype->mask, component))
+        return false;
+
+    i32 target = *ecs_edge(&archetype->remove_edges, component) - 1;
+    if (target < 0) {
+        ia_bitset mask = bitset_clone(&archetype->mask, archetype->mask.size);
+        ia_bitset_clear(&mask, component);
+        target = ecs_archetype_find_or_create(ecs, &mask);
+        *ecs_edge(&ecs_archetypes(ecs)[source].remove_edges, component) = target + 1;
+        *ecs_edge(&ecs_archetypes(ecs)[target].add_edges, component) = source + 1;
+    }
+    ecs_move(ecs, record, target);
+    return true;
+}
+
+void *ia_ecs_get(
+    ia_ecs const   *ecs,
+    ia_entity       entity,
+    ia_component    component)
+{
+    ia_ecs_record const *record = ia_sparse_get(&ecs->entities, entity.id);
+    if (!record)
+        return nullptr;
+
+    ia_ecs_archetype const *archetype = &ecs_archetypes(ecs)[record->archetype];
+    i32 column = ecs_column_index(archetype, component);
+    if (column < 0 || archetype->column_sizes[column] == 0)
+        return nullptr;
+    return ecs_column_at(archetype, column, record->row);
+}
+
+bool ia_ecs_has(
+    ia_ecs const   *ecs,
+    ia_entity       entity,
+    ia_component    component)
+{
+    ia_ecs_record const *record = ia_sparse_get(&ecs->entities, entity.id);
+    return record && ia_bitset_test(&ecs_archetypes(ecs)[record->archetype].mask, component);
+}
+
+static void ecs_query_mask_set(
+    ia_bitset      *mask,
+    ia_component    component)
+{
+    if (component >= mask->size)
+        ia_bitset_resize(mask, component + 1);
+    ia_bitset_set(mask, component);
+}
+
+bool ia_ecs_query_init(
+    ia_ecs_query       *query,
+    i32                 component_count,
+    ia_component const *components)
+{
+    *query = (ia_ecs_query){
+        .with = ia_bitset_init,
+        .without = ia_bitset_init,
+    };
+    if (component_count < 0 || component_count > IA_ECS_QUERY_MAX_COMPONENTS)
+        return false;
+    query->component_count = component_count;
+    for (i32 i = 0; i < component_count; i++) {
+        query->components[i] = components[i];
+        ecs_query_mask_set(&query->with, components[i]);
+    }
+    return true;
+}
+
+void ia_ecs_query_with(
+    ia_ecs_query       *query,
+    ia_component        component)
+{
+    ecs_query_mask_set(&query->with, component);
+}
+
+void ia_ecs_query_without(
+    ia_ecs_query       *query,
+    ia_component        component)
+{
+    ecs_query_mask_set(&query->without, component);
+}
+
+bool ia_ecs_iter_next(ia_ecs_iter *iter)
+{
+    ia_ecs_query const *query = iter->query;
+    ia_ecs_archetype const *archetypes = ecs_archetypes(iter->ecs);
+
+    iter->chunk++;
+    for (; iter->archetype < iter->ecs->archetypes.len; iter->archetype++, iter->chunk = 0) {
+        ia_ecs_archetype const *archetype = &archetypes[iter->archetype];
+        i32 first = iter->chunk * archetype->chunk_capacity;
+
+        /* matching is tested once, on the first chunk of an archetype */
+        if (iter->chunk == 0 && (!ia_bitset_is_subset(&query->with, &archetype->mask)
+                    || ia_bitset_intersects(&query->without, &archetype->mask)))
+            continue;
+        if (first >= archetype->count)
+            continue;
+
+        u8 *chunk = ecs_chunk(archetype, first);
+        iter->view.entities = (ia_entity const *)chunk;
+        iter->view.count = ia_min(archetype->chunk_capacity, archetype->count - first);
+        for (i32 i = 0; i < query->component_count; i++) {
+            i32 column = ecs_column_index(archetype, query->components[i]);
+            iter->view.columns[i] = archetype->column_sizes[column] ? chunk + archetype->column_offsets[column] : nullptr;
+        }
+        return true;
+    }
+    return false;
+}
+
+/* a job starts from a copy of the iterator positioned at its first chunk, so no views are stored */
+typedef struct ecs_query_job {
+    ia_ecs_system_fn            system;
+    void                       *userdata;
+    ia_ecs_iter                 iter;
+    i32                         count;
+} ecs_query_job;
+
+static IA_WORK_FN(ecs_query_job_run, ecs_query_job *job)
+{
+    for (i32 i = 0; i < job->count; i++) {
+        if (i > 0)
+            ia_ecs_iter_next(&job->iter);
+        job->system(job->userdata, &job->iter.view);
+    }
+}
+
+void ia_ecs_query_parallel(
+    ia_ecs                 *ecs,
+    ia_ecs_query const     *query,
+    ia_ecs_system_fn        system,
+    void                   *userdata,
+    i32                     job_count)
+{
+    i32 chunk_count = 0;
+    ia_ecs_iter iter = ia_ecs_query_iter(ecs, query);
+    while (ia_ecs_iter_next(&iter))
+        chunk_count++;
+    if (chunk_count == 0)
+        return;
+
+    /* contiguous ranges of chunks, the first jobs take the remainder */
+    job_count = ia_clamp(job_count, 1, ia_min(chunk_count, IA_ECS_QUERY_MAX_JOBS));
+    ecs_query_job jobs[IA_ECS_QUERY_MAX_JOBS];
+    ia_work_details details[IA_ECS_QUERY_MAX_JOBS];
+    i32 per_job = chunk_count / job_count, extra = chunk_count % job_count;
+    iter = ia_ecs_query_iter(ecs, query);
+    for (i32 i = 0; i < job_count; i++) {
+        i32 count = per_job + (i < extra);
+        /* skip to the first chunk of this job, the previous job ends right before it */
+        ia_ecs_iter_next(&iter);
+        jobs[i] = (ecs_query_job){ .system = system, .userdata = userdata, .iter = iter, .count = count };
+        details[i] = (ia_work_details){ .fn = (ia_work_fn)ecs_query_job_run, .data = &jobs[i], .name = "ia_ecs_query_parallel" };
+        for (i32 j = 1; j < count; j++)
+            ia_ecs_iter_next(&iter);
+    }
+    ia_yield(ia_submit_work(job_count, details));
+}
@@ -83,6 +83,7 @@ i32 ia_foundation_main(
     void                   *main_data,
     ia_foundation          *foundation)
 {
+    foundation->host.cpu_features = ia_cpufeatures();
     // TODO
     return 0;
 }
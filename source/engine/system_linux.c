@@ -1,4 +1,5 @@
 #include <ia/base/system.h>
+#include <ia/base/atomic.h>
 #include <ia/base/defer.h>
 #include <ia/base/log.h>
 
@@ -8,6 +9,10 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/auxv.h>
+#if defined(IA_ARCH_X86) || defined(IA_ARCH_AMD64)
+#include <cpuid.h>
+#endif
 
 void ia_cpuinfo(
     i32 *out_thread_count, 
@@ -84,6 +89,98 @@ void ia_cpuinfo(
     ia_defer_return;
 }
 
+#if defined(IA_ARCH_X86) || defined(IA_ARCH_AMD64)
+/* the XCR0 register tells which register states the kernel saves on a context switch */
+static u64 xgetbv_xcr0(void)
+{
+    u32 lo, hi;
+    __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((u64)hi << 32) | lo;
+}
+
+static ia_cpu_features cpufeatures_x86(void)
+{
+    ia_cpu_features features = ia_cpu_feature_none;
+    u32 eax, ebx, ecx, edx;
+    u32 max_leaf = __get_cpuid_max(0, nullptr);
+
+    if (max_leaf < 1 || !__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return features;
+    if (edx & (1u << 26)) features |= ia_cpu_feature_x86_sse2;
+    if (ecx & (1u << 0))  features |= ia_cpu_feature_x86_sse3;
+    if (ecx & (1u << 1))  features |= ia_cpu_feature_x86_pclmul;
+    if (ecx & (1u << 9))  features |= ia_cpu_feature_x86_ssse3;
+    if (ecx & (1u << 19)) features |= ia_cpu_feature_x86_sse4_1;
+    if (ecx & (1u << 20)) features |= ia_cpu_feature_x86_sse4_2;
+    if (ecx & (1u << 23)) features |= ia_cpu_feature_x86_popcnt;
+    if (ecx & (1u << 25)) features |= ia_cpu_feature_x86_aes;
+
+    /* AVX needs the XMM and YMM state enabled by the OS, AVX-512 also the opmask and ZMM state */
+    bool os_avx = false, os_avx512 = false;
+    if ((ecx & (1u << 27)) && (ecx & (1u << 28))) {
+        u64 xcr0 = xgetbv_xcr0();
+        os_avx = (xcr0 & 0x06) == 0x06;
+        os_avx512 = os_avx && (xcr0 & 0xe0) == 0xe0;
+    }
+    if (os_avx) {
+        features |= ia_cpu_feature_x86_avx;
+        if (ecx & (1u << 12)) features |= ia_cpu_feature_x86_fma;
+        if (ecx & (1u << 29)) features |= ia_cpu_feature_x86_f16c;
+    }
+    if (max_leaf >= 7 && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        if (ebx & (1u << 3)) features |= ia_cpu_feature_x86_bmi;
+        if (ebx & (1u << 8)) features |= ia_cpu_feature_x86_bmi2;
+        if (os_avx && (ebx & (1u << 5)))
+            features |= ia_cpu_feature_x86_avx2;
+        if (os_avx512 && (ebx & (1u << 16))) {
+            features |= ia_cpu_feature_x86_avx512f;
+            if (ebx & (1u << 17)) features |= ia_cpu_feature_x86_avx512dq;
+            if (ebx & (1u << 28)) features |= ia_cpu_feature_x86_avx512cd;
+            if (ebx & (1u << 30)) features |= ia_cpu_feature_x86_avx512bw;
+            if (ebx & (1u << 31)) features |= ia_cpu_feature_x86_avx512vl;
+        }
+    }
+    if (__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 5)))
+        features |= ia_cpu_feature_x86_lzcnt;
+    return features;
+}
+#endif /* IA_ARCH_X86 || IA_ARCH_AMD64 */
+
+ia_cpu_features ia_cpufeatures(void)
+{
+    /* workers may race on the first call, they all store the same value */
+    static atomic_u64 features = ia_cpu_feature_none;
+
+    ia_cpu_features cached = ia_atomic_read(&features, ia_atomic_model_monotonic);
+    if (cached != ia_cpu_feature_none)
+        return cached; /* query only once per runtime */
+    ia_cpu_features detected = ia_cpu_features_baseline();
+
+#if defined(IA_ARCH_X86) || defined(IA_ARCH_AMD64)
+    detected |= cpufeatures_x86();
+#elif defined(IA_ARCH_AARCH64)
+    /* the HWCAP_* bits of the arm64 kernel ABI, NEON and FMA are mandatory */
+    u64 hwcap = getauxval(AT_HWCAP);
+    detected |= ia_cpu_feature_arm_neon | ia_cpu_feature_arm_fma;
+    if (hwcap & (1ull << 3))  detected |= ia_cpu_feature_arm_aes;
+    if (hwcap & (1ull << 7))  detected |= ia_cpu_feature_arm_crc32;
+    if (hwcap & (1ull << 10)) detected |= ia_cpu_feature_arm_neon_fp16;
+    if (hwcap & (1ull << 20)) detected |= ia_cpu_feature_arm_dotprod;
+    if (hwcap & (1ull << 22)) detected |= ia_cpu_feature_arm_sve;
+#elif defined(IA_ARCH_ARM)
+    /* HWCAP_NEON and HWCAP_VFPv4 of the 32-bit arm kernel ABI */
+    u64 hwcap = getauxval(AT_HWCAP);
+    if (hwcap & (1ull << 12)) detected |= ia_cpu_feature_arm_neon;
+    if (hwcap & (1ull << 16)) detected |= ia_cpu_feature_arm_fma;
+#elif defined(IA_ARCH_RISCV)
+    /* the kernel reports single letter extensions as bits of the alphabet */
+    u64 hwcap = getauxval(AT_HWCAP);
+    if (hwcap & (1ull << ('v' - 'a'))) detected |= ia_cpu_feature_riscv_v;
+#endif
+    ia_atomic_write(&features, detected, ia_atomic_model_monotonic);
+    return detected;
+}
+
 ia_hugepage_sizes ia_hugetlbinfo(usize *out_total_ram)
 {
     static usize total_ram = 0;
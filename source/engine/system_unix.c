@@ -3,6 +3,7 @@
 #endif
 
 #include <ia/base/system.h>
+#include <ia/base/filesystem.h>
 #include <ia/base/log.h>
 
 /* TODO check this from CMake */
@@ -10,7 +11,10 @@
 
 #ifdef IA_PLATFORM_UNIX
 #include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/mman.h>
 #include <pthread.h>
@@ -191,21 +195,18 @@ i32 ia_dump_stack_trace(ia_strbuf *buf)
     void *buffer[STACK_TRACE_BUF_SIZE];
     char **strings;
 
-    if (buf->alloc <= 0) 
-        ia_debugtrap();
-
     nptrs = backtrace(buffer, STACK_TRACE_BUF_SIZE);
     strings = backtrace_symbols(buffer, nptrs);
     if (strings == nullptr)
         return 0;
 
-    buf->len += snprintf(buf->v + buf->len, buf->alloc - buf->len, "\n");
-    for (i32 j = 1; j < nptrs && buf->len < buf->alloc; j++) 
-        buf->len += snprintf(buf->v + buf->len, buf->alloc - buf->len, "%s\n", strings[j]);
-    buf->len += snprintf(buf->v + buf->len, buf->alloc - buf->len, "\n");
+    ia_strbuf_appendc(buf, '\n');
+    for (i32 j = 1; j < nptrs; j++) 
+        ia_strbuf_appendf(buf, "%s\n", strings[j]);
+    ia_strbuf_appendc(buf, '\n');
 
     free(strings);
-    return buf->len - len;;
+    return buf->len - len;
 }
 #else
 i32 ia_dump_stack_trace(ia_strbuf *buf)
@@ -215,6 +216,74 @@ i32 ia_dump_stack_trace(ia_strbuf *buf)
 }
 #endif /* IA_HAS_EXECINFO */
 
+bool ia_file_open(
+    char const     *path,
+    ia_file_mode    mode,
+    ia_file        *out_file)
+{
+    int flags = mode == ia_file_mode_write ? (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY;
+    int fd = open(path, flags | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ia_error("open `%s` failed: %s.", path, strerror(errno));
+        return false;
+    }
+    out_file->handle = fd;
+    return true;
+}
+
+void ia_file_close(ia_file file)
+{
+    close((int)file.handle);
+}
+
+i64 ia_file_size(ia_file file)
+{
+    struct stat st;
+    if (fstat((int)file.handle, &st) != 0)
+        return -1;
+    return (i64)st.st_size;
+}
+
+isize ia_file_read(
+    ia_file         file,
+    void           *dst,
+    isize           size,
+    i64             offset)
+{
+    isize total = 0;
+    while (total < size) {
+        ssize_t res = pread((int)file.handle, (u8 *)dst + total, (usize)(size - total), (off_t)(offset + total));
+        if (res < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (res == 0)
+            break; /* end of file */
+        total += res;
+    }
+    return total;
+}
+
+isize ia_file_write(
+    ia_file         file,
+    void const     *src,
+    isize           size,
+    i64             offset)
+{
+    isize total = 0;
+    while (total < size) {
+        ssize_t res = pwrite((int)file.handle, (u8 const *)src + total, (usize)(size - total), (off_t)(offset + total));
+        if (res < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        total += res;
+    }
+    return total;
+}
+
 void *ia_mmap(void)
 {
     return nullptr;
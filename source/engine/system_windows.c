@@ -1,4 +1,5 @@
 #include <ia/base/system.h>
+#include <ia/base/filesystem.h>
 #include <ia/base/log.h>
 
 #ifdef IA_PLATFORM_WINDOWS
@@ -11,6 +12,12 @@ void ia_cpuinfo(
     // TODO
 }
 
+ia_cpu_features ia_cpufeatures(void)
+{
+    // TODO __cpuidex, _xgetbv and IsProcessorFeaturePresent
+    return ia_cpu_features_baseline();
+}
+
 ia_hugepage_sizes ia_hugetlbinfo(usize *out_total_ram)
 {
     // TODO
@@ -74,6 +81,42 @@ i32 ia_dump_stack_trace(ia_strbuf *buf)
     // TODO
 }
 
+bool ia_file_open(
+    char const     *path,
+    ia_file_mode    mode,
+    ia_file        *out_file)
+{
+    // TODO
+}
+
+void ia_file_close(ia_file file)
+{
+    // TODO
+}
+
+i64 ia_file_size(ia_file file)
+{
+    // TODO
+}
+
+isize ia_file_read(
+    ia_file         file,
+    void           *dst,
+    isize           size,
+    i64             offset)
+{
+    // TODO
+}
+
+isize ia_file_write(
+    ia_file         file,
+    void const     *src,
+    isize           size,
+    i64             offset)
+{
+    // TODO
+}
+
 void *ia_mmap(void)
 {
     // TODO